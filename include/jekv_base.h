@@ -32,10 +32,15 @@ extern "C" {
 
 /**
   * @brief  kv handle max num
-  * Max num of kv handle
+  * Default max num of kv handle, it can be changed by jekv_set_max_handles
   */
 #define JEKV_MAX_HANDLE_NUM     64
 
+/**
+  * @brief  Upper limit of the max num of kv handle set by jekv_set_max_handles
+  */
+#define JEKV_HANDLE_NUM_LIMIT   4096
+
 /**
   * @brief  kv key or group name max size
   * Max size of kv key, maximum 15 valid characters support, not include '\0'
@@ -65,6 +70,7 @@ extern "C" {
 #define JEKV_ERR_INVALID_LENGTH (JEKV_ERR_BASE - 11) /**< invalid data length           */
 #define JEKV_ERR_VALUE_TOO_LONG (JEKV_ERR_BASE - 12) /**< Value is too long             */
 #define JEKV_ERR_CALL_IN_ISR    (JEKV_ERR_BASE - 13) /**< call in isr error             */
+#define JEKV_ERR_NOT_SUPPORT    (JEKV_ERR_BASE - 14) /**< not supported                 */
 
 /**
  * @}
@@ -107,12 +113,22 @@ typedef enum {
     JEKV_TYPE_UINT64, /**< uint64_t             */
     JEKV_TYPE_DOUBLE, /**< float data           */
     JEKV_TYPE_BINARY, /**< small binary data, size from 1~4032, not split to segments */
-    JEKV_TYPE_BLOB,   /**< Binary Large OBject, It will be divided into multiple segments (1~127) for storage.
-                          Except the last piece, other segments are no less than 512 bytes. In addition,
-                          a description item will also be stored ,all the size no larger than 512064 */
+    JEKV_TYPE_BLOB,   /**< Binary Large OBject, It will be divided into multiple segments (1~127 in each of
+                          CONFIG_JEKV_BLOB_SEG_PAGE_NUM pages, 1016 by default) for storage. Except the last
+                          piece, other segments are no less than 512 bytes. In addition, a description item
+                          will also be stored, all the size no larger than 4096512 by default */
     JEKV_TYPE_MAX
 } jekv_type_t;
 
+/**
+* @enum     jekv_ring_start_t
+* @brief    start record of the ring cursor
+*/
+typedef enum {
+    JEKV_RING_OLDEST = 0, /**< the oldest record */
+    JEKV_RING_NEWEST = 1, /**< the newest record */
+} jekv_ring_start_t;
+
 /**
  * @}
  */
@@ -137,6 +153,41 @@ typedef void *jekv_handle_t;
   */
 typedef struct jekv_iterator_info_t *jekv_iterator_t;
 
+/**
+  * @brief  batch , handle for writing multiple items atomically
+  */
+typedef struct jekv_batch_info_t *jekv_batch_t;
+
+/**
+  * @brief  blob writer , handle for writing a blob piece by piece
+  */
+typedef struct jekv_blob_writer_info_t *jekv_blob_writer_t;
+
+/**
+  * @brief  blob reader , handle for reading a blob piece by piece
+  */
+typedef struct jekv_blob_reader_info_t *jekv_blob_reader_t;
+
+/**
+  * @brief  view pin , keeps the value of a view in place
+  */
+typedef struct jekv_view_pin_info_t *jekv_view_pin_t;
+
+/**
+  * @brief  ring , handle for appending records to a ring log
+  */
+typedef struct jekv_ring_info_t *jekv_ring_t;
+
+/**
+  * @brief  ring cursor , handle for reading the records of a ring log forward and backward
+  */
+typedef struct jekv_ring_cursor_info_t *jekv_ring_cursor_t;
+
+/**
+  * @brief  queue , handle for pushing and popping the messages of a persistent queue
+  */
+typedef struct jekv_queue_info_t *jekv_queue_t;
+
 /**
  * @struct  jekv_entry_t
  * @brief   iterator entry information
@@ -144,6 +195,7 @@ typedef struct jekv_iterator_info_t *jekv_iterator_t;
 typedef struct {
     char group[JEKV_MAX_KEY_LEN + 1]; /**< item group     */
     char key[JEKV_MAX_KEY_LEN + 1];   /**< item key       */
+    uint32_t id;                      /**< item id if the key is empty, see jekv_set_by_id */
     jekv_type_t type;                 /**< item type      */
     uint8_t group_id;                   /**< group id       */
     uint32_t length;                      /**< data length    */
@@ -159,9 +211,51 @@ typedef struct {
     uint32_t droped_size; /**< drop item size     */
     uint32_t free_size;   /**< free size          */
     uint8_t group_num;    /**< num of groups      */
-    uint8_t handle_num;   /**< num of the handles */
+    uint16_t handle_num;  /**< num of the handles */
 } jekv_status_t;
 
+/**
+ * @struct  jekv_get_desc_t
+ * @brief   item read descriptor for jekv_get_many
+ */
+typedef struct {
+    jekv_type_t type; /**< [in] item type                                 */
+    void *data;       /**< [in] data buffer                               */
+    uint32_t length;  /**< [in] buffer size, [out] data length            */
+    int err;          /**< [out] read result, the same as jekv_get_xxx    */
+} jekv_get_desc_t;
+
+/**
+ * @struct  jekv_compact_stat_t
+ * @brief   kv compaction statistics
+ */
+typedef struct {
+    uint32_t reclaimed_slices; /**< droped slices reclaimed   */
+    uint32_t written_bytes;    /**< flash bytes written       */
+    uint32_t erased_sectors;   /**< num of erased sectors     */
+    uint32_t idle_sectors;     /**< num of idle sectors after */
+    uint32_t elapsed_ms;       /**< elapsed time, in ms       */
+} jekv_compact_stat_t;
+
+/**
+ * @struct  jekv_record_field_t
+ * @brief   field of the record
+ */
+typedef struct {
+    uint16_t offset; /**< field offset in the record */
+    uint16_t size;   /**< field size                 */
+} jekv_record_field_t;
+
+/**
+ * @struct  jekv_record_schema_t
+ * @brief   fixed layout of the record, see jekv_record_register
+ */
+typedef struct {
+    uint16_t size;                     /**< record size, 9~4032 bytes  */
+    uint16_t field_count;              /**< num of the fields          */
+    const jekv_record_field_t *fields; /**< fields, kept by the caller */
+} jekv_record_schema_t;
+
 /**
  * @}
  */
@@ -197,6 +291,7 @@ int jekv_init(const char *partition_name);
   * @return
   *    - JEKV_ERR_OK: succeed
   *    - JEKV_ERR_FAIL: failed
+  *    - others: the dirty values of write back cache failed to be saved, they are dropped
   * @note The handle open by the api jekv_open must be closed before jekv_deinit called.
   */
 int jekv_deinit(const char *partition_name);
@@ -253,6 +348,19 @@ int jekv_open(const char *partition_name, const char *group_name, jekv_open_mode
   */
 int jekv_close(jekv_handle_t handle);
 
+/**
+  * @brief  set the max num of kv handle
+  *
+  * @param[in]  num max num of kv handle, 1 ~ JEKV_HANDLE_NUM_LIMIT, default JEKV_MAX_HANDLE_NUM
+  *
+  * @return
+  *    - JEKV_ERR_OK: succeed
+  *    - JEKV_ERR_INVALID_PARAM: num is out of range
+  *    - JEKV_ERR_FAIL: there are handles opened
+  * @note It can be called only when all the handles are closed.
+  */
+int jekv_set_max_handles(uint32_t num);
+
 /**
  * @brief  Get string by key name
  *
@@ -335,6 +443,193 @@ int jekv_set_binary(jekv_handle_t handle, const char *key, const void *data, uin
  */
 int jekv_get_blob(jekv_handle_t handle, const char *key, void *blob, uint32_t *blob_len);
 
+/**
+ * @brief  Read a part of binary data
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  key      kv name
+ * @param[in]  offset   offset in the blob data
+ * @param[out] buf      buffer to hold the data
+ * @param[inout]  len   buffer length, returns the read length, it is less than the buffer length
+ *                      at the end of the blob
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_LENGTH offset is out of the blob
+ *         - JEKV_ERR_NOT_FOUND item is not found
+ */
+int jekv_get_blob_range(jekv_handle_t handle, const char *key, uint32_t offset, void *buf, uint32_t *len);
+
+/**
+ * @brief  open a blob reader, the blob data is read piece by piece from the beginning
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  key      kv name
+ * @param[out] reader   blob reader handle
+ * @param[out] size     blob data size, can be NULL
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_NOT_FOUND item is not found
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The reader must be released by jekv_blob_reader_close.
+ */
+int jekv_blob_reader_open(jekv_handle_t handle, const char *key, jekv_blob_reader_t *reader, uint32_t *size);
+
+/**
+ * @brief  read the next part of the blob
+ *
+ * @param[in]  reader   blob reader handle, obtained from jekv_blob_reader_open.
+ * @param[out] buf      buffer to hold the data
+ * @param[inout]  len   buffer length, returns the read length, 0 at the end of the blob
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the reader is closed
+ *         - JEKV_ERR_NOT_FOUND the blob is deleted or rewritten
+ */
+int jekv_blob_reader_read(jekv_blob_reader_t reader, void *buf, uint32_t *len);
+
+/**
+ * @brief  release the blob reader
+ *
+ * @param[in]  reader   blob reader handle, obtained from jekv_blob_reader_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ */
+int jekv_blob_reader_close(jekv_blob_reader_t reader);
+
+/**
+ * @brief  Add to the uint32 counter. The counter keeps a bit for every increment and the bits are cleared
+ *         in place, so it is rewritten only when all the bits are cleared instead of on every change.
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  key      kv name
+ * @param[in]  step     the value added, the bits are used up faster by a bigger step
+ * @param[out] value    the counter value after adding, can be NULL
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY the handle is opened read only
+ *         - JEKV_ERR_NO_SPACE no enough space for saving
+ * @note The counter is read by jekv_get_u32 and reset by jekv_set_u32. A uint32 value of the key is the
+ *       start of the counter, the value of other types is replaced.
+ */
+int jekv_counter_add(jekv_handle_t handle, const char *key, uint32_t step, uint32_t *value);
+
+/**
+ * @brief  register the record schema. A record is a binary value of the schema size, a field of it is
+ *         updated by a small field delta instead of rewriting the whole record.
+ *
+ * @param[in]  schema     record schema, the fields are referenced and must be kept by the caller
+ * @param[out] schema_id  schema id used by the record functions, the same schema gets the same id
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error, the record is not longer than 8 bytes or a field is out of it
+ *         - JEKV_ERR_NO_MEM CONFIG_JEKV_RECORD_SCHEMA_NUM schemas are registered
+ */
+int jekv_record_register(const jekv_record_schema_t *schema, uint8_t *schema_id);
+
+/**
+ * @brief  Save the whole record, the field deltas of the old one are dropped
+ *
+ * @param[in]  handle     kv operation handle,obtained from jekv_open.
+ * @param[in]  key        kv name
+ * @param[in]  schema_id  schema id, obtained from jekv_record_register
+ * @param[in]  record     record data of the schema size
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error or the schema is not registered
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY the handle is opened read only
+ *         - JEKV_ERR_NO_SPACE no enough space for saving
+ */
+int jekv_record_set(jekv_handle_t handle, const char *key, uint8_t schema_id, const void *record);
+
+/**
+ * @brief  Get the record, the field deltas are merged. It is the same as jekv_get_binary with the schema size.
+ *
+ * @param[in]  handle     kv operation handle,obtained from jekv_open.
+ * @param[in]  key        kv name
+ * @param[in]  schema_id  schema id, obtained from jekv_record_register
+ * @param[out] record     buffer of the schema size
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error or the schema is not registered
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_NOT_FOUND item is not found
+ *         - JEKV_ERR_INVALID_LENGTH the saved value is not of the schema size
+ */
+int jekv_record_get(jekv_handle_t handle, const char *key, uint8_t schema_id, void *record);
+
+/**
+ * @brief  Update a field of the record. Only the field is written as a delta, the reads merge the deltas
+ *         and GC folds them back into the record. The whole record is rewritten when the deltas reach
+ *         CONFIG_JEKV_RECORD_DELTA_MAX, so a read looks up CONFIG_JEKV_RECORD_DELTA_MAX deltas at most.
+ *
+ * @param[in]  handle     kv operation handle,obtained from jekv_open.
+ * @param[in]  key        kv name
+ * @param[in]  schema_id  schema id, obtained from jekv_record_register
+ * @param[in]  field      field index in the schema
+ * @param[in]  value      field data of the field size
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error or the schema is not registered
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY the handle is opened read only
+ *         - JEKV_ERR_NOT_FOUND the record is not found
+ *         - JEKV_ERR_INVALID_LENGTH the saved value is not of the schema size
+ *         - JEKV_ERR_NO_SPACE no enough space for saving
+ * @note The record with deltas is read by jekv_get_binary, jekv_get_many and the iterator too,
+ *       jekv_get_view is not supported for it.
+ */
+int jekv_record_update_field(jekv_handle_t handle, const char *key, uint8_t schema_id, uint16_t field,
+                             const void *value);
+
+/**
+ * @brief  get the value in place, the pointer points to the mapped flash (XIP) and no data is copied
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  key      kv name
+ * @param[out] ptr      address of the value
+ * @param[out] len      value length
+ * @param[out] pin      pin of the view, the sector of the value is not erased by GC until it is released
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_NOT_FOUND item is not found
+ *         - JEKV_ERR_INVALID_LENGTH the blob is stored in more than one segment
+ *         - JEKV_ERR_NOT_SUPPORT the flash is not mapped or the partition is encrypted
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The value is read only. It keeps the old data after the key is changed or deleted.
+ *       The pin must be released by jekv_release_view before jekv_deinit.
+ */
+int jekv_get_view(jekv_handle_t handle, const char *key, const void **ptr, uint32_t *len, jekv_view_pin_t *pin);
+
+/**
+ * @brief  release the view, the pointer is not valid any more
+ *
+ * @param[in]  pin      pin of the view, obtained from jekv_get_view.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ */
+int jekv_release_view(jekv_view_pin_t pin);
+
 /**
  * @brief  Save binary data
  *
@@ -349,6 +644,84 @@ int jekv_get_blob(jekv_handle_t handle, const char *key, void *blob, uint32_t *b
  *         - JEKV_ERR_FAIL save item fail
  */
 int jekv_set_blob(jekv_handle_t handle, const char *key, const void *blob, uint32_t blob_len);
+
+/**
+ * @brief  Append binary data to the blob, only the appended data is written. The blob is created if not exist.
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  key      kv name
+ * @param[in]  data     appended data
+ * @param[in]  len      appended data length
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY handle is read only
+ *         - JEKV_ERR_NO_SPACE no enough space or the blob is too large
+ * @note The blob is unchanged if power off before the append is completed.
+ */
+int jekv_blob_append(jekv_handle_t handle, const char *key, const void *data, uint32_t len);
+
+/**
+ * @brief  open a blob writer, the blob data is written piece by piece and only one segment is buffered in RAM.
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  key      kv name
+ * @param[out] writer   blob writer handle
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY handle is read only
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The writer must be ended by jekv_blob_writer_close or jekv_blob_writer_abort.
+ *       The old value is kept until the writer is closed, don't write the key by other ways before that.
+ */
+int jekv_blob_writer_open(jekv_handle_t handle, const char *key, jekv_blob_writer_t *writer);
+
+/**
+ * @brief  append data to the blob writer
+ *
+ * @param[in]  writer   blob writer handle, obtained from jekv_blob_writer_open.
+ * @param[in]  data     blob data
+ * @param[in]  size     data size
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the writer is closed
+ *         - JEKV_ERR_INVALID_LENGTH the blob is too large
+ *         - JEKV_ERR_NO_SPACE no enough space
+ */
+int jekv_blob_writer_write(jekv_blob_writer_t writer, const void *data, uint32_t size);
+
+/**
+ * @brief  write the blob descriptor and release the writer, the new blob replaces the old value.
+ *         The old value is kept if power off before that.
+ *
+ * @param[in]  writer   blob writer handle, obtained from jekv_blob_writer_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the writer is closed
+ *         - JEKV_ERR_INVALID_LENGTH no data written
+ *         - JEKV_ERR_NO_SPACE no enough space
+ * @note The writer is released even if it failed, the written data is dropped.
+ */
+int jekv_blob_writer_close(jekv_blob_writer_t writer);
+
+/**
+ * @brief  drop the written data and release the writer
+ *
+ * @param[in]  writer   blob writer handle, obtained from jekv_blob_writer_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ */
+int jekv_blob_writer_abort(jekv_blob_writer_t writer);
 /**
  * @brief  Save int8 data
  *
@@ -614,6 +987,55 @@ int jekv_get_float(jekv_handle_t handle, const char *key, double *out_value);
  */
 int jekv_del_key(jekv_handle_t handle, const char *key);
 
+/**
+ * @brief  Save the value of an integer key. The id is kept in the item name and hashed by an integer mix,
+ *         so no key string is formatted, measured or compared. Id keys and string keys don't collide.
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  id       integer key
+ * @param[in]  type     data type, JEKV_TYPE_BLOB is not supported
+ * @param[in]  value    data
+ * @param[in]  length   data length, the size of the type for the numbers
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY the handle is opened read only
+ *         - JEKV_ERR_NO_SPACE no enough space for saving
+ */
+int jekv_set_by_id(jekv_handle_t handle, uint32_t id, jekv_type_t type, const void *value, uint32_t length);
+
+/**
+ * @brief  Get the value of an integer key
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  id       integer key
+ * @param[in]  type     data type, JEKV_TYPE_BLOB is not supported
+ * @param[out]  out_value    data
+ * @param[inout]  length     input the buffer length, output the data length
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error or buffer is not enough
+ *         - JEKV_ERR_NOT_FOUND item is not found
+ * @note The items of integer keys are iterated with an empty key and the id in jekv_entry_t.
+ */
+int jekv_get_by_id(jekv_handle_t handle, uint32_t id, jekv_type_t type, void *out_value, uint32_t *length);
+
+/**
+ * @brief  Delete the kv data for the integer key
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  id integer key
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_NOT_FOUND item is not found
+ */
+int jekv_del_by_id(jekv_handle_t handle, uint32_t id);
+
 /**
   * @brief  reset kv. It is usually called at factory settings, and the system is restarted after the kv reset.
   *
@@ -714,6 +1136,21 @@ int jekv_entry_data(jekv_iterator_t iterator, void *data, uint32_t *data_len);
  */
 int jekv_release_iterator(jekv_iterator_t iterator);
 
+/**
+ * @brief  Get multiple items by key names under one lock
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  keys  kv item names
+ * @param[inout]  descs  read descriptors, one for each key, @ref jekv_get_desc_t
+ * @param[in]  count  num of keys
+ * @return
+ *         - JEKV_ERR_OK on success, the result of each key is in descs[i].err
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_NO_MEM no memory
+ */
+int jekv_get_many(jekv_handle_t handle, const char *keys[], jekv_get_desc_t descs[], uint32_t count);
+
 /**
  * @brief  get item type and size
  *
@@ -739,6 +1176,408 @@ int jekv_get_info(jekv_handle_t handle, const char *key, jekv_type_t *type, uint
  */
 int jekv_get_status(const char *partition_name, jekv_status_t *status);
 
+/**
+ * @brief  compact kv partition, merge the using items of the sectors to as few sectors as they fit in
+ *         and erase the merged sectors, they are idle for the writing after.
+ *
+ * @param[in]  partition_name  kv partition name
+ * @param[out]  stat  compaction statistics, @ref jekv_compact_stat_t, can be NULL
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_NOT_INIT partition not initialized
+ *         - JEKV_ERR_READ_ONLY partition is read only
+ * @note It may take a long time, It is better to call it when the system is idle,
+ *       then the writing after it does not need GC for a long time.
+ */
+int jekv_compact(const char *partition_name, jekv_compact_stat_t *stat);
+
+/**
+ * @brief  begin a batch, the items put or deleted by the batch are saved together when committed
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[out]  batch  batch handle
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY handle is read only
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The batch must be ended by jekv_batch_commit or jekv_batch_abort.
+ */
+int jekv_batch_begin(jekv_handle_t handle, jekv_batch_t *batch);
+
+/**
+ * @brief  put an item to the batch, the data is copied.
+ *
+ * @param[in]  batch  batch handle, obtained from jekv_batch_begin.
+ * @param[in]  key  kv item name
+ * @param[in]  type  data type, JEKV_TYPE_BLOB is not supported
+ * @param[in]  data  data
+ * @param[in]  size  data size, the size of string includes the terminating null byte
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_VALUE_TOO_LONG data is too long
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The last operation on the same key in the batch is used.
+ */
+int jekv_batch_put(jekv_batch_t batch, const char *key, jekv_type_t type, const void *data, uint32_t size);
+
+/**
+ * @brief  delete an item in the batch
+ *
+ * @param[in]  batch  batch handle, obtained from jekv_batch_begin.
+ * @param[in]  key  kv item name
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_NO_MEM no memory
+ */
+int jekv_batch_del(jekv_batch_t batch, const char *key);
+
+/**
+ * @brief  commit the batch and release it. All the items of the batch are saved or none of them
+ *         is saved when power off.
+ *
+ * @param[in]  batch  batch handle, obtained from jekv_batch_begin.
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the batch is closed
+ *         - JEKV_ERR_NO_SPACE the batch is larger than a sector or no enough space
+ * @note The batch is released even if the commit failed.
+ */
+int jekv_batch_commit(jekv_batch_t batch);
+
+/**
+ * @brief  drop all the operations of the batch and release it
+ *
+ * @param[in]  batch  batch handle, obtained from jekv_batch_begin.
+ * @return
+ *         - JEKV_ERR_OK on success
+ */
+int jekv_batch_abort(jekv_batch_t batch);
+
+/**
+ * @brief  config write back cache of the partition. The latest values of the non blob items are kept in RAM
+ *         and read from RAM, they are saved to flash when flushed.
+ *
+ * @param[in]  partition_name  kv partition name
+ * @param[in]  dirty_size  flush when the size of the dirty values reaches it, 0 to disable write back
+ * @param[in]  interval_ms  flush when the time from the last flush reaches it, 0 for no time limit
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_NOT_INIT partition not initialized
+ * @note The interval is checked when the items are read or written.
+ *       Each flush is saved all or nothing, the values not flushed are lost when power off.
+ *       The items too large for a batch in one sector are written to flash directly.
+ *       Iterators only see the flushed values.
+ */
+int jekv_set_write_back(const char *partition_name, uint32_t dirty_size, uint32_t interval_ms);
+
+/**
+ * @brief  save the dirty values of write back cache to flash, and program the deferred drop marks
+ *
+ * @param[in]  partition_name  kv partition name
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_NOT_INIT partition not initialized
+ * @note jekv_deinit flushes the dirty values too.
+ *       With CONFIG_JEKV_DEFER_DROP, the marks of the superseded items are kept in RAM until flushed,
+ *       the ones lost at power off are found again at mount.
+ */
+int jekv_flush(const char *partition_name);
+
+/**
+ * @brief  config compression of the partition. The string and binary values are saved compressed
+ *         if it saves flash, they are decompressed when read.
+ *
+ * @param[in]  partition_name  kv partition name
+ * @param[in]  min_size  compress the values not shorter than it, 0 to disable compression
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_NOT_INIT partition not initialized
+ * @note The compressed values are read whether compression is enabled or not.
+ *       Blobs, the values in write back cache and batches are not compressed,
+ *       jekv_get_view is not supported for the compressed values.
+ */
+int jekv_set_compress(const char *partition_name, uint32_t min_size);
+
+/**
+ * @brief  open a ring log, a bounded log of records numbered by their sequences. The records are appended
+ *         to the sectors of the ring, the oldest sector is reused when the ring has max_sectors sectors,
+ *         so the oldest records are dropped a sector at a time.
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  name   ring name, the rings and the keys are named apart
+ * @param[in]  max_sectors  sectors of the ring at most, 2~CONFIG_JEKV_RING_SECTOR_MAX
+ * @param[out] ring   ring handle
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The ring is saved when the first record is appended. The ring must be released by jekv_ring_close.
+ */
+int jekv_ring_open(jekv_handle_t handle, const char *name, uint8_t max_sectors, jekv_ring_t *ring);
+
+/**
+ * @brief  append a record to the ring
+ *
+ * @param[in]  ring   ring handle, obtained from jekv_ring_open.
+ * @param[in]  data   record data
+ * @param[in]  size   record size, 1~4032
+ * @param[out] seq    sequence of the record, one more than the last record, can be NULL
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the ring is closed
+ *         - JEKV_ERR_READ_ONLY the handle of the ring is read only
+ *         - JEKV_ERR_VALUE_TOO_LONG the record is too long
+ *         - JEKV_ERR_NO_SPACE no idle sector for the ring of less than 2 sectors
+ * @note The ring takes an idle sector before it has max_sectors sectors, the KV sectors are merged to
+ *       free one if no idle sector is left for GC, it reuses the oldest one if none is freed.
+ */
+int jekv_ring_append(jekv_ring_t ring, const void *data, uint32_t size, uint32_t *seq);
+
+/**
+ * @brief  release the ring
+ *
+ * @param[in]  ring   ring handle, obtained from jekv_ring_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ */
+int jekv_ring_close(jekv_ring_t ring);
+
+/**
+ * @brief  delete all the records of the ring, its sectors are given back
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  name   ring name
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY handle is read only
+ *         - JEKV_ERR_NOT_FOUND ring is not found
+ */
+int jekv_ring_del(jekv_handle_t handle, const char *name);
+
+/**
+ * @brief  open a cursor at the oldest or the newest record of the ring
+ *
+ * @param[in]  ring   ring handle, obtained from jekv_ring_open.
+ * @param[in]  start  the oldest or the newest record
+ * @param[out] cursor ring cursor
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the ring is closed
+ *         - JEKV_ERR_NOT_FOUND the ring has no record
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The cursor must be released by jekv_ring_cursor_close, it can be used after the ring is closed.
+ */
+int jekv_ring_cursor_open(jekv_ring_t ring, jekv_ring_start_t start, jekv_ring_cursor_t *cursor);
+
+/**
+ * @brief  move the cursor to the record of the sequence
+ *
+ * @param[in]  cursor ring cursor, obtained from jekv_ring_cursor_open.
+ * @param[in]  seq    record sequence
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the cursor is closed
+ *         - JEKV_ERR_NOT_FOUND the record is dropped or not appended, the cursor is not moved
+ */
+int jekv_ring_cursor_seek(jekv_ring_cursor_t cursor, uint32_t seq);
+
+/**
+ * @brief  move the cursor to the next newer record
+ *
+ * @param[in]  cursor ring cursor, obtained from jekv_ring_cursor_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the cursor is closed
+ *         - JEKV_ERR_NOT_FOUND the cursor is at the newest record, the cursor is not moved
+ * @note The cursor moves to the oldest record if the records from the cursor are dropped.
+ */
+int jekv_ring_cursor_next(jekv_ring_cursor_t cursor);
+
+/**
+ * @brief  move the cursor to the next older record
+ *
+ * @param[in]  cursor ring cursor, obtained from jekv_ring_cursor_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the cursor is closed
+ *         - JEKV_ERR_NOT_FOUND the cursor is at the oldest record, the cursor is not moved
+ */
+int jekv_ring_cursor_prev(jekv_ring_cursor_t cursor);
+
+/**
+ * @brief  read the record at the cursor
+ *
+ * @param[in]  cursor ring cursor, obtained from jekv_ring_cursor_open.
+ * @param[out] data   record data
+ * @param[inout]  len buffer length, returns the record size
+ * @param[out] seq    sequence of the record, can be NULL
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the cursor is closed
+ *         - JEKV_ERR_VALUE_TOO_LONG buffer is not enough, len returns the record size
+ *         - JEKV_ERR_NOT_FOUND the record is dropped
+ */
+int jekv_ring_cursor_read(jekv_ring_cursor_t cursor, void *data, uint32_t *len, uint32_t *seq);
+
+/**
+ * @brief  release the ring cursor
+ *
+ * @param[in]  cursor ring cursor, obtained from jekv_ring_cursor_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ */
+int jekv_ring_cursor_close(jekv_ring_cursor_t cursor);
+
+/**
+ * @brief  open a persistent queue, the messages are popped in the order they are pushed. The messages are
+ *         appended to the sectors of the queue, the head is kept by the ack bits of its oldest sector,
+ *         and the sectors of the acked messages are given back without copying.
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  name   queue name, the queues and the keys are named apart
+ * @param[out] queue  queue handle
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_NO_MEM no memory
+ * @note The queue is saved when the first message is pushed. The queue must be released by jekv_queue_close.
+ */
+int jekv_queue_open(jekv_handle_t handle, const char *name, jekv_queue_t *queue);
+
+/**
+ * @brief  push a message to the tail of the queue
+ *
+ * @param[in]  queue  queue handle, obtained from jekv_queue_open.
+ * @param[in]  data   message data
+ * @param[in]  size   message size, 1~4000
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the queue is closed
+ *         - JEKV_ERR_READ_ONLY the handle of the queue is read only
+ *         - JEKV_ERR_VALUE_TOO_LONG the message is too long
+ *         - JEKV_ERR_NO_SPACE the queue has CONFIG_JEKV_QUEUE_SECTOR_MAX sectors, or no idle sector is left
+ *           for the queue after merging the KV sectors
+ */
+int jekv_queue_push(jekv_queue_t queue, const void *data, uint32_t size);
+
+/**
+ * @brief  read the message at the head of the queue, the head is not moved
+ *
+ * @param[in]  queue  queue handle, obtained from jekv_queue_open.
+ * @param[out] data   message data
+ * @param[inout]  len buffer length, returns the message size
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the queue is closed
+ *         - JEKV_ERR_VALUE_TOO_LONG buffer is not enough, len returns the message size
+ *         - JEKV_ERR_NOT_FOUND no message after the head
+ */
+int jekv_queue_peek(jekv_queue_t queue, void *data, uint32_t *len);
+
+/**
+ * @brief  read the message at the head of the queue and move the head to the next message
+ *
+ * @param[in]  queue  queue handle, obtained from jekv_queue_open.
+ * @param[out] data   message data
+ * @param[inout]  len buffer length, returns the message size
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the queue is closed
+ *         - JEKV_ERR_VALUE_TOO_LONG buffer is not enough, len returns the message size, the head is not moved
+ *         - JEKV_ERR_NOT_FOUND no message after the head
+ * @note The head is moved in memory only, the messages popped but not acked are popped again after reboot.
+ */
+int jekv_queue_pop(jekv_queue_t queue, void *data, uint32_t *len);
+
+/**
+ * @brief  save the head of the queue, the popped messages are dropped for good
+ *
+ * @param[in]  queue  queue handle, obtained from jekv_queue_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the queue is closed
+ *         - JEKV_ERR_READ_ONLY the handle of the queue is read only
+ * @note The ack bits of the popped messages are cleared, the sectors of which all the messages are
+ *       popped are erased and given back.
+ */
+int jekv_queue_ack(jekv_queue_t queue);
+
+/**
+ * @brief  get the count of the messages from the head of the queue
+ *
+ * @param[in]  queue  queue handle, obtained from jekv_queue_open.
+ * @param[out] count  message count
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE the handle of the queue is closed
+ */
+int jekv_queue_count(jekv_queue_t queue, uint32_t *count);
+
+/**
+ * @brief  release the queue, the head not acked is kept until reboot
+ *
+ * @param[in]  queue  queue handle, obtained from jekv_queue_open.
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ */
+int jekv_queue_close(jekv_queue_t queue);
+
+/**
+ * @brief  delete all the messages of the queue, its sectors are given back
+ *
+ * @param[in]  handle kv operation handle,obtained from jekv_open.
+ * @param[in]  name   queue name
+ *
+ * @return
+ *         - JEKV_ERR_OK on success
+ *         - JEKV_ERR_INVALID_PARAM param error
+ *         - JEKV_ERR_INVALID_HANDLE invalid handle
+ *         - JEKV_ERR_READ_ONLY handle is read only
+ *         - JEKV_ERR_NOT_FOUND queue is not found
+ */
+int jekv_queue_del(jekv_handle_t handle, const char *name);
+
 /**
  * @}
  */
@@ -26,6 +26,9 @@ typedef struct {
     uint32_t size;                     /**< partition size   */
 } jkvs_partition_item_t;
 
+/* reader-writer lock, the readers hold it together, a writer holds it alone */
+typedef void* jekv_port_rwlock_t;
+
 extern size_t strnlen(const char *s, size_t maxlen);
 
 int jekv_port_init(void);
@@ -34,14 +37,31 @@ int jekv_port_is_init(void);
 int jekv_port_mutex_lock(void);
 int jekv_port_mutex_unlock(void);
 
+/* lock of a partition, the global mutex is only held to look up the partitions and the handles */
+int jekv_port_rwlock_create(jekv_port_rwlock_t* lock);
+int jekv_port_rwlock_delete(jekv_port_rwlock_t lock);
+int jekv_port_rwlock_read_lock(jekv_port_rwlock_t lock);
+int jekv_port_rwlock_read_unlock(jekv_port_rwlock_t lock);
+int jekv_port_rwlock_write_lock(jekv_port_rwlock_t lock);
+int jekv_port_rwlock_write_unlock(jekv_port_rwlock_t lock);
+
+/* id of the calling thread, the epoch readers take the reader slot of it */
+uint32_t jekv_port_thread_id(void);
+/* give the cpu to the other threads while a writer waits for the epoch readers,
+   it must let the lower priority threads run too, a reader may be one of them */
+void jekv_port_yield(void);
+
 /* flash porting interface*/
 void* jekv_partition_open(const char *partition_name);
 int jekv_partition_get_info(const char* partition_name, jkvs_partition_item_t* info);
 int jekv_partition_erase(void* dev, uint32_t offset, uint32_t size);
 int jekv_partition_read(void* dev, uint32_t offset, uint8_t* data, uint32_t length);
 int jekv_partition_write(void* dev, uint32_t offset, uint8_t* data, uint32_t length);
+/* the address the flash is mapped at (XIP), NULL if it can't be read in place */
+const void* jekv_partition_mmap(void* dev, uint32_t offset, uint32_t length);
 
 uint32_t jekv_port_crc32(uint32_t crc, const void *buf, uint32_t len);
+uint32_t jekv_port_get_time_ms(void);
 void jekv_port_power_off(int type, int stage);
 
 #ifdef __cplusplus
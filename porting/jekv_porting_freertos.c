@@ -17,6 +17,8 @@
 #define JKEV_FLASH_ERASE(dev, offset, size)         xx_flash_erase_region(dev, offset, size)
 #define JKEV_FLASH_READ(dev, offset, data, length)  xx_flash_read(dev, offset, data, length)
 #define JKEV_FLASH_WRITE(dev, offset, data, length) xx_flash_write(dev, offset, data, length)
+/* Mapped address of the flash offset if the flash is XIP, e.g. (XX_FLASH_XIP_BASE + (offset)), or NULL */
+#define JKEV_FLASH_MMAP(dev, offset, length)        NULL
 
 #endif
 
@@ -24,6 +26,7 @@
 #define PORTING_WAIT_FOREVER 0xFFFFFFFF
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #endif
 
 /* Config flash offset and size */
@@ -37,6 +40,14 @@ static jkvs_partition_item_t g_part = {
 
 #ifdef JKEV_USE_FREERTOS
 static SemaphoreHandle_t g_jvks_mutex = NULL; /**< global mutex  */
+
+/* the writer waits in the turnstile, the readers coming later wait behind it, so the writer is not starved */
+typedef struct {
+    SemaphoreHandle_t turnstile;  /**< held by the waiting or writing writer  */
+    SemaphoreHandle_t room;       /**< held by the writer or by the readers   */
+    SemaphoreHandle_t count_lock; /**< guards readers                         */
+    uint32_t readers;             /**< readers in the room                    */
+} porting_rwlock_t;
 #endif
 
 static uint8_t g_port_init = 0;
@@ -94,6 +105,135 @@ int jekv_port_mutex_unlock(void)
     return JEKV_ERR_OK;
 }
 
+int jekv_port_rwlock_create(jekv_port_rwlock_t* lock)
+{
+    #ifdef JKEV_USE_FREERTOS
+    porting_rwlock_t* rw = calloc(1, sizeof(*rw));
+
+    if(!rw){
+        return JEKV_ERR_NO_MEM;
+    }
+
+    rw->turnstile  = xSemaphoreCreateMutex();
+    rw->count_lock = xSemaphoreCreateMutex();
+    /* the room is left by a task other than the one entered it, it is a binary semaphore */
+    rw->room       = xSemaphoreCreateBinary();
+
+    if(!(rw->turnstile && rw->count_lock && rw->room)){
+        jekv_port_rwlock_delete(rw);
+        return JEKV_ERR_NO_MEM;
+    }
+
+    xSemaphoreGive(rw->room);
+
+    *lock = rw;
+    #else
+    *lock = NULL;
+    #endif
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_delete(jekv_port_rwlock_t lock)
+{
+    #ifdef JKEV_USE_FREERTOS
+    porting_rwlock_t* rw = (porting_rwlock_t*)lock;
+
+    if(rw){
+        if(rw->turnstile){
+            vSemaphoreDelete(rw->turnstile);
+        }
+        if(rw->count_lock){
+            vSemaphoreDelete(rw->count_lock);
+        }
+        if(rw->room){
+            vSemaphoreDelete(rw->room);
+        }
+        free(rw);
+    }
+    #endif
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_read_lock(jekv_port_rwlock_t lock)
+{
+    #ifdef JKEV_USE_FREERTOS
+    porting_rwlock_t* rw = (porting_rwlock_t*)lock;
+
+    /* pass the turnstile, it is held if a writer is waiting */
+    xSemaphoreTake(rw->turnstile, PORTING_WAIT_FOREVER);
+    xSemaphoreGive(rw->turnstile);
+
+    /* the first reader takes the room for all the readers */
+    xSemaphoreTake(rw->count_lock, PORTING_WAIT_FOREVER);
+    if(++rw->readers == 1){
+        xSemaphoreTake(rw->room, PORTING_WAIT_FOREVER);
+    }
+    xSemaphoreGive(rw->count_lock);
+    #endif
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_read_unlock(jekv_port_rwlock_t lock)
+{
+    #ifdef JKEV_USE_FREERTOS
+    porting_rwlock_t* rw = (porting_rwlock_t*)lock;
+
+    /* the last reader gives the room back */
+    xSemaphoreTake(rw->count_lock, PORTING_WAIT_FOREVER);
+    if(--rw->readers == 0){
+        xSemaphoreGive(rw->room);
+    }
+    xSemaphoreGive(rw->count_lock);
+    #endif
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_write_lock(jekv_port_rwlock_t lock)
+{
+    #ifdef JKEV_USE_FREERTOS
+    porting_rwlock_t* rw = (porting_rwlock_t*)lock;
+
+    xSemaphoreTake(rw->turnstile, PORTING_WAIT_FOREVER);
+    xSemaphoreTake(rw->room, PORTING_WAIT_FOREVER);
+    #endif
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_write_unlock(jekv_port_rwlock_t lock)
+{
+    #ifdef JKEV_USE_FREERTOS
+    porting_rwlock_t* rw = (porting_rwlock_t*)lock;
+
+    xSemaphoreGive(rw->room);
+    xSemaphoreGive(rw->turnstile);
+    #endif
+
+    return JEKV_ERR_OK;
+}
+
+uint32_t jekv_port_thread_id(void)
+{
+    #ifdef JKEV_USE_FREERTOS
+    /*the task control blocks are allocated blocks, the low bits are the same*/
+    return (uint32_t)((uintptr_t)xTaskGetCurrentTaskHandle() >> 4);
+    #else
+    return 0;
+    #endif
+}
+
+void jekv_port_yield(void)
+{
+    #ifdef JKEV_USE_FREERTOS
+    /*block a tick, taskYIELD only runs the tasks of the same priority and the reader may be a lower one*/
+    vTaskDelay(1);
+    #endif
+}
+
 int jekv_partition_get_info(const char* name, jkvs_partition_item_t* info)
 {
     *info = g_part;
@@ -120,6 +260,11 @@ int jekv_partition_write(void* dev, uint32_t offset, uint8_t* data, uint32_t len
     return JKEV_FLASH_WRITE(dev, offset, data, length);
 }
 
+const void* jekv_partition_mmap(void* dev, uint32_t offset, uint32_t length)
+{
+    return JKEV_FLASH_MMAP(dev, offset, length);
+}
+
 /*
  * IEEE 802.11 FCS CRC32
  * G(x) = x^32 + x^26 + x^23 + x^22 + x^16 + x^12 + x^11 + x^10 + x^8 + x^7 +
@@ -189,4 +334,13 @@ uint32_t jekv_port_crc32(uint32_t crc, const void *buf, uint32_t len)
 	return ~crc;
 }
 
+uint32_t jekv_port_get_time_ms(void)
+{
+    #ifdef JKEV_USE_FREERTOS
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    #else
+    return 0;
+    #endif
+}
+
 void jekv_port_power_off(int type, int stage){}
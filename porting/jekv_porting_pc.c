@@ -1,3 +1,4 @@
+#define _GNU_SOURCE /* pthread_rwlockattr_setkind_np */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,6 +6,11 @@
 #include <stdint.h>
 #include <errno.h>
 #include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
 
 #define LOG_TAG "porting"
 #include "jekv_porting.h"
@@ -12,7 +18,10 @@
 #include "jekv_base.h"
 
 #define JKEV_FILE_NAME      "./jekv.db"
+/* the size of the partition file, the tests set a larger one */
+#ifndef JKEV_PARTITION_SIZE
 #define JKEV_PARTITION_SIZE (JEKV_SECTOR_SIZE * 2)
+#endif
 
 static jkvs_partition_item_t g_part = {
     .offset = 0,
@@ -20,6 +29,9 @@ static jkvs_partition_item_t g_part = {
 };
 
 static uint8_t g_port_init = 0;
+static void* g_map = NULL; /**< file mapped as XIP flash */
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;     /**< global mutex */
+static pthread_mutex_t g_map_mutex = PTHREAD_MUTEX_INITIALIZER; /**< the readers of a partition map the file together */
 
 static int jekv_port_create_file(void)
 {
@@ -59,6 +71,10 @@ int jekv_port_deinit(void)
     if(g_port_init){
         g_port_init = 0;
     }
+    if(g_map){
+        munmap(g_map, JKEV_PARTITION_SIZE);
+        g_map = NULL;
+    }
     return JEKV_ERR_OK;
 }
 
@@ -69,14 +85,93 @@ int jekv_port_is_init(void)
 
 int jekv_port_mutex_lock(void)
 {
+    pthread_mutex_lock(&g_mutex);
     return JEKV_ERR_OK;
 }
 
 int jekv_port_mutex_unlock(void)
 {
+    pthread_mutex_unlock(&g_mutex);
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_create(jekv_port_rwlock_t* lock)
+{
+    int err;
+    pthread_rwlockattr_t attr;
+    pthread_rwlock_t* rw = malloc(sizeof(*rw));
+
+    if(!rw){
+        return JEKV_ERR_NO_MEM;
+    }
+
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    /* the glibc default prefers the readers, a writer waits while any reader overlaps it */
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    err = pthread_rwlock_init(rw, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    if(err){
+        free(rw);
+        return JEKV_ERR_FAIL;
+    }
+
+    *lock = rw;
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_delete(jekv_port_rwlock_t lock)
+{
+    if(lock){
+        pthread_rwlock_destroy((pthread_rwlock_t*)lock);
+        free(lock);
+    }
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_read_lock(jekv_port_rwlock_t lock)
+{
+    pthread_rwlock_rdlock((pthread_rwlock_t*)lock);
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_read_unlock(jekv_port_rwlock_t lock)
+{
+    pthread_rwlock_unlock((pthread_rwlock_t*)lock);
+    return JEKV_ERR_OK;
+}
+
+int jekv_port_rwlock_write_lock(jekv_port_rwlock_t lock)
+{
+    pthread_rwlock_wrlock((pthread_rwlock_t*)lock);
     return JEKV_ERR_OK;
 }
 
+int jekv_port_rwlock_write_unlock(jekv_port_rwlock_t lock)
+{
+    pthread_rwlock_unlock((pthread_rwlock_t*)lock);
+    return JEKV_ERR_OK;
+}
+
+uint32_t jekv_port_thread_id(void)
+{
+    static uint32_t next_id = 0;
+    static __thread uint32_t id = 0;
+
+    /*numbered in the order of the first call, so the threads take their own reader slots*/
+    if(!id){
+        id = __atomic_add_fetch(&next_id, 1, __ATOMIC_RELAXED);
+    }
+    return id;
+}
+
+void jekv_port_yield(void)
+{
+    sched_yield();
+}
+
 int jekv_partition_get_info(const char* name, jkvs_partition_item_t* info)
 {
     *info = g_part;
@@ -106,7 +201,7 @@ int jekv_partition_erase(void* dev, uint32_t offset, uint32_t size)
 
     if(fp){
 
-        memset(pbuf,0xff,sizeof(pbuf));
+        memset(pbuf,0xff,size);
 
         fseek(fp,offset,SEEK_SET);
 
@@ -117,6 +212,8 @@ int jekv_partition_erase(void* dev, uint32_t offset, uint32_t size)
         jekv_log_error("erase %s fail",JKEV_FILE_NAME);
     }
 
+    free(pbuf);
+
     return 0;
 }
 
@@ -184,7 +281,7 @@ int jekv_partition_write(void* dev, uint32_t offset, uint8_t* data, uint32_t len
         if(fp){
             fseek(fp,offset,SEEK_SET);
 
-            fwrite(data,1,length,fp);
+            fwrite(pbuf,1,length,fp);
 
             fclose(fp);
         }else{
@@ -196,6 +293,46 @@ int jekv_partition_write(void* dev, uint32_t offset, uint8_t* data, uint32_t len
     return 0;
 }
 
+const void* jekv_partition_mmap(void* dev, uint32_t offset, uint32_t length)
+{
+    int fd;
+    void* map;
+
+    if(!(offset + length <= JKEV_PARTITION_SIZE)){
+        jekv_log_error("bad mmap param");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_map_mutex);
+
+    if(!g_map){
+        /*the shared mapping sees the file writes, as the XIP flash sees the programming*/
+        fd = open(JKEV_FILE_NAME, O_RDONLY);
+        if(fd < 0){
+            jekv_log_error("mmap %s fail,errno=%d,errnostr=%s",JKEV_FILE_NAME,errno,strerror(errno));
+            pthread_mutex_unlock(&g_map_mutex);
+            return NULL;
+        }
+
+        map = mmap(NULL, JKEV_PARTITION_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if(map == MAP_FAILED){
+            jekv_log_error("mmap %s fail,errno=%d,errnostr=%s",JKEV_FILE_NAME,errno,strerror(errno));
+            pthread_mutex_unlock(&g_map_mutex);
+            return NULL;
+        }
+
+        g_map = map;
+    }
+
+    map = g_map;
+
+    pthread_mutex_unlock(&g_map_mutex);
+
+    return (uint8_t*)map + offset;
+}
+
 /*
  * IEEE 802.11 FCS CRC32
  * G(x) = x^32 + x^26 + x^23 + x^22 + x^16 + x^12 + x^11 + x^10 + x^8 + x^7 +
@@ -265,4 +402,13 @@ uint32_t jekv_port_crc32(uint32_t crc, const void *buf, uint32_t len)
 	return ~crc;
 }
 
+uint32_t jekv_port_get_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
 void jekv_port_power_off(int type, int stage){}
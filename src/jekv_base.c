@@ -6,11 +6,191 @@
 #include "jekv_porting.h"
 #include "jekv_base.h"
 #include "jekv_partition_manager.h"
+#include "jekv_record.h"
 #include "jekv_log.h"
 
 #define JEKV_LOCK() jekv_port_mutex_lock()
 #define JEKV_UNLOCK() jekv_port_mutex_unlock()
 
+/*
+    The global mutex guards the storage list, the handle table and the record schemas only, it is held for the look
+    ups. The storage of a partition is guarded by its reader-writer lock, the global mutex may be taken while the
+    storage lock is held, never the reverse.
+*/
+
+/*access of the storage an api takes*/
+typedef enum {
+    API_READ_SHARED, /*read together with the other readers*/
+    API_READ,        /*read, the caches of the storage are changed*/
+    API_WRITE,       /*write, the handle must be opened to write*/
+} api_access_t;
+
+/*called locked, unlock and take the storage, it is not deinitialized until it is left*/
+static void storage_enter(jekv_storage_t *storage, bool shared)
+{
+    storage->users++;
+
+    JEKV_UNLOCK();
+
+    if (shared) {
+        jekv_port_rwlock_read_lock(storage->lock);
+    } else {
+        jekv_port_rwlock_write_lock(storage->lock);
+#if CONFIG_JEKV_EPOCH_READ
+        jekv_epoch_write_begin(&storage->written);
+#endif
+    }
+}
+
+static void storage_leave(jekv_storage_t *storage, bool shared)
+{
+    if (shared) {
+        jekv_port_rwlock_read_unlock(storage->lock);
+    } else {
+#if CONFIG_JEKV_EPOCH_READ
+        jekv_epoch_write_end(&storage->written);
+#endif
+        jekv_port_rwlock_write_unlock(storage->lock);
+    }
+
+    JEKV_LOCK();
+
+    storage->users--;
+
+    JEKV_UNLOCK();
+}
+
+/*take the shared storage exclusively*/
+static void storage_upgrade(jekv_storage_t *storage)
+{
+    jekv_port_rwlock_read_unlock(storage->lock);
+    jekv_port_rwlock_write_lock(storage->lock);
+#if CONFIG_JEKV_EPOCH_READ
+    jekv_epoch_write_begin(&storage->written);
+#endif
+}
+
+/*take the storage of the partition, NULL if it is not initialized*/
+static jekv_storage_t *partition_enter(const char *partition_name, bool shared)
+{
+    jekv_storage_t *storage;
+
+    JEKV_LOCK();
+
+    storage = jekv_ptm_find_storage(partition_name);
+    if (!storage) {
+        JEKV_UNLOCK();
+        return NULL;
+    }
+
+    storage_enter(storage, shared);
+
+    return storage;
+}
+
+/*the handle may be closed before the storage is taken, it is not closed while the storage is held*/
+static int handle_check(jekv_handle_t id, jekv_handle_info_t *handle, jekv_storage_t *storage, bool shared)
+{
+    bool valid;
+
+    JEKV_LOCK();
+
+    valid = (jekv_ptm_get_handle(id) == handle);
+
+    JEKV_UNLOCK();
+
+    if (!valid) {
+        storage_leave(storage, shared);
+        return JEKV_ERR_INVALID_HANDLE;
+    }
+
+    return JEKV_ERR_OK;
+}
+
+/*take the storage of the handle, the handle information is kept until it is left*/
+static int handle_enter(jekv_handle_t id, api_access_t access, jekv_handle_info_t **handle)
+{
+    jekv_handle_info_t *h;
+    jekv_storage_t *storage;
+    bool shared = (access == API_READ_SHARED);
+
+    JEKV_LOCK();
+
+    h = jekv_ptm_get_handle(id);
+    if (!h) {
+        JEKV_UNLOCK();
+        return JEKV_ERR_INVALID_HANDLE;
+    }
+
+    if (access == API_WRITE && h->mode == JEKV_OP_READ_ONLY) {
+        JEKV_UNLOCK();
+        return JEKV_ERR_READ_ONLY;
+    }
+
+    storage = h->storage;
+
+    storage_enter(storage, shared);
+
+    *handle = h;
+
+    return handle_check(id, h, storage, shared);
+}
+
+static void handle_leave(jekv_handle_info_t *handle, api_access_t access)
+{
+    storage_leave(handle->storage, access == API_READ_SHARED);
+}
+
+/*take the shared storage of the handle exclusively, leave it as API_READ then*/
+static int handle_upgrade(jekv_handle_t id, jekv_handle_info_t *handle)
+{
+    jekv_storage_t *storage = handle->storage;
+
+    storage_upgrade(storage);
+
+    return handle_check(id, handle, storage, false);
+}
+
+#if CONFIG_JEKV_EPOCH_READ
+/*look up the handle in the epoch without a lock, NULL if its storage is written, take the locks then*/
+static jekv_handle_info_t *handle_enter_epoch(jekv_handle_t id, uint32_t *slot)
+{
+    jekv_handle_info_t *h;
+    jekv_storage_t *storage;
+
+    *slot = jekv_epoch_enter();
+
+    h       = jekv_ptm_peek_handle(id);
+    storage = h ? JEKV_EPOCH_LOAD(&h->storage) : NULL;
+
+    /*the handle may be closed before the mark is seen, no writer changes it after*/
+    if (storage && !jekv_epoch_is_written(&storage->written) && jekv_ptm_peek_handle(id) == h) {
+        return h;
+    }
+
+    jekv_epoch_leave(*slot);
+
+    return NULL;
+}
+#endif
+
+/*take the storage of the iterator, NULL if its partition is deinitialized*/
+static jekv_storage_t *iterator_enter(jekv_iterator_t iterator, bool shared)
+{
+    jekv_storage_t *storage = ((jekv_iterator_info_t *)iterator)->storage;
+
+    JEKV_LOCK();
+
+    if (!jekv_ptm_has_storage(storage)) {
+        JEKV_UNLOCK();
+        return NULL;
+    }
+
+    storage_enter(storage, shared);
+
+    return storage;
+}
+
 int jekv_init(const char *partition_name)
 {
     int err;
@@ -100,20 +280,39 @@ int jekv_erase(const char *partition_name)
 int jekv_open(const char *partition_name, const char *group_name, jekv_open_mode_t mode, jekv_handle_t *handle)
 {
     int err = JEKV_ERR_FAIL;
+    jekv_storage_t *storage;
+    uint8_t group_id;
 
     if (!(partition_name && group_name && handle && (int)mode >= 0 && (int)mode < JEKV_OP_MAX)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    if (strlen(group_name) > JEKV_MAX_KEY_LEN) {
+    /*the group name is written as an item key, an empty key would be read as an integer key*/
+    if (!group_name[0] || strlen(group_name) > JEKV_MAX_KEY_LEN) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
     JEKV_LOCK();
 
-    err = jekv_ptm_open_handle(partition_name, group_name, mode, (jekv_handle_info_t **)handle);
+    err = jekv_ptm_check_open(partition_name, mode, &storage);
+    if (err != JEKV_ERR_OK) {
+        JEKV_UNLOCK();
+        return err;
+    }
+
+    /*the group may be created*/
+    storage_enter(storage, false);
 
-    JEKV_UNLOCK();
+    err = jekv_storage_open_group(storage, group_name, true, &group_id);
+    if (err == JEKV_ERR_OK) {
+        JEKV_LOCK();
+
+        err = jekv_ptm_open_handle(storage, group_id, mode, handle);
+
+        JEKV_UNLOCK();
+    }
+
+    storage_leave(storage, false);
 
     return err;
 }
@@ -121,80 +320,145 @@ int jekv_open(const char *partition_name, const char *group_name, jekv_open_mode
 int jekv_close(jekv_handle_t handle)
 {
     int err = JEKV_ERR_FAIL;
+    jekv_handle_info_t *h;
+    jekv_storage_t *storage;
 
     if (!handle) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
+    /*no api of the storage is using the handle*/
+    err = handle_enter(handle, API_READ, &h);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    storage = h->storage;
+
     JEKV_LOCK();
 
-    if (jekv_ptm_is_handle_valid(handle)) {
-        err = jekv_ptm_close_handle(handle);
-    } else {
-        err = JEKV_ERR_INVALID_HANDLE;
-    }
+    err = jekv_ptm_close_handle(h);
 
     JEKV_UNLOCK();
 
+    storage_leave(storage, false);
+
     return err;
 }
 
-static int get_item(jekv_handle_t *handle, jekv_type_t type, const char *key, void *out_value, uint32_t *length)
+int jekv_set_max_handles(uint32_t num)
 {
     int err;
-    jekv_handle_info_t *h = (jekv_handle_info_t *)handle;
 
-    if (!(handle && key && out_value && length && *length > 0 && type > JEKV_TYPE_ANY && type < JEKV_TYPE_MAX)) {
+    if (!(num > 0 && num <= JEKV_HANDLE_NUM_LIMIT)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
     JEKV_LOCK();
 
-    if (jekv_ptm_is_handle_valid(h)) {
-        err = jekv_storage_read_item(h->storage, h->group_id, type, key, out_value, length);
-    } else {
-        err = JEKV_ERR_INVALID_HANDLE;
-    }
+    err = jekv_ptm_set_max_handles(num);
 
     JEKV_UNLOCK();
 
-    jekv_log_debug("get item %s, size=%u, err=%d", key, (err == JEKV_ERR_OK ? *length : 0), err);
+    jekv_log_debug("max handles %u, err=%d", num, err);
 
     return err;
 }
 
-static int set_item(jekv_handle_t *handle, jekv_type_t type, const char *key, const void *value, uint32_t length)
+/*the key is checked, a string key or the key buffer of the integer key*/
+static int read_item(jekv_handle_t handle, jekv_type_t type, const char *key, void *out_value, uint32_t *length)
 {
     int err;
-    jekv_handle_info_t *h = (jekv_handle_info_t *)handle;
-    int key_len;
+    jekv_handle_info_t *h;
+#if CONFIG_JEKV_EPOCH_READ
+    uint32_t slot;
+#endif
 
-    if (!(handle && key && value && type > JEKV_TYPE_ANY && type < JEKV_TYPE_MAX)) {
+    if (!(handle && out_value && length && *length > 0 && type > JEKV_TYPE_ANY && type < JEKV_TYPE_MAX)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    key_len = strlen(key);
-    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+#if CONFIG_JEKV_EPOCH_READ
+    h = handle_enter_epoch(handle, &slot);
+    if (h && jekv_storage_is_read_shared(h->storage, type)) {
+        err = jekv_storage_read_item(h->storage, h->group_id, type, key, out_value, length);
+
+        jekv_epoch_leave(slot);
+
+        jekv_log_debug("get item %s, size=%u, err=%d", key, (err == JEKV_ERR_OK ? *length : 0), err);
+
+        return err;
+    } else if (h) {
+        jekv_epoch_leave(slot);
+    }
+#endif
+
+    err = handle_enter(handle, API_READ_SHARED, &h);
+    if (err == JEKV_ERR_OK && jekv_storage_is_read_shared(h->storage, type)) {
+        err = jekv_storage_read_item(h->storage, h->group_id, type, key, out_value, length);
+
+        handle_leave(h, API_READ_SHARED);
+    } else if (err == JEKV_ERR_OK) {
+        err = handle_upgrade(handle, h);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_storage_read_item(h->storage, h->group_id, type, key, out_value, length);
+
+            handle_leave(h, API_READ);
+        }
+    }
+
+    jekv_log_debug("get item %s, size=%u, err=%d", key, (err == JEKV_ERR_OK ? *length : 0), err);
+
+    return err;
+}
+
+static int get_item(jekv_handle_t handle, jekv_type_t type, const char *key, void *out_value, uint32_t *length)
+{
+    if (!(key && key[0])) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    return read_item(handle, type, key, out_value, length);
+}
 
-    if (!jekv_ptm_is_handle_valid(h)) {
-        err = JEKV_ERR_INVALID_HANDLE;
-    } else if (h->mode == JEKV_OP_READ_ONLY) {
-        err = JEKV_ERR_READ_ONLY;
-    } else {
-        err = jekv_storage_write_item(h->storage, h->group_id, type, key, value, length);
+/*the key is checked, a string key or the key buffer of the integer key*/
+static int write_item(jekv_handle_t handle, jekv_type_t type, const char *key, const void *value, uint32_t length)
+{
+    int err;
+    jekv_handle_info_t *h;
+
+    if (!(handle && value && type > JEKV_TYPE_ANY && type < JEKV_TYPE_MAX)) {
+        return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_UNLOCK();
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_write_item(h->storage, h->group_id, type, key, value, length);
+
+        handle_leave(h, API_WRITE);
+    }
 
     jekv_log_debug("write %s, size=%u, err=%d", key, length, err);
 
     return err;
 }
 
+static int set_item(jekv_handle_t handle, jekv_type_t type, const char *key, const void *value, uint32_t length)
+{
+    int key_len;
+
+    if (!key) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    return write_item(handle, type, key, value, length);
+}
+
 int jekv_get_str(jekv_handle_t handle, const char *key, char *out_value, uint32_t *length)
 {
     return get_item(handle, JEKV_TYPE_STRING, key, out_value, length);
@@ -229,330 +493,1461 @@ int jekv_set_blob(jekv_handle_t handle, const char *key, const void *blob, uint3
     return set_item(handle, JEKV_TYPE_BLOB, key, blob, blob_len);
 }
 
-int jekv_set_i8(jekv_handle_t handle, const char *key, int8_t value)
+int jekv_blob_append(jekv_handle_t handle, const char *key, const void *data, uint32_t len)
 {
-    return set_item(handle, JEKV_TYPE_INT8, key, &value, sizeof(value));
-}
+    int err;
+    jekv_handle_info_t *h;
+    int key_len;
 
-int jekv_set_u8(jekv_handle_t handle, const char *key, uint8_t value)
-{
-    return set_item(handle, JEKV_TYPE_UINT8, key, &value, sizeof(value));
-}
+    if (!(handle && key && data && len > 0)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
 
-int jekv_set_i16(jekv_handle_t handle, const char *key, int16_t value)
-{
-    return set_item(handle, JEKV_TYPE_INT16, key, &value, sizeof(value));
-}
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
 
-int jekv_set_u16(jekv_handle_t handle, const char *key, uint16_t value)
-{
-    return set_item(handle, JEKV_TYPE_UINT16, key, &value, sizeof(value));
-}
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_append_blob(h->storage, h->group_id, key, data, len);
 
-int jekv_set_i32(jekv_handle_t handle, const char *key, int32_t value)
-{
-    return set_item(handle, JEKV_TYPE_INT32, key, &value, sizeof(value));
-}
+        handle_leave(h, API_WRITE);
+    }
 
-int jekv_set_u32(jekv_handle_t handle, const char *key, uint32_t value)
-{
-    return set_item(handle, JEKV_TYPE_UINT32, key, &value, sizeof(value));
-}
+    jekv_log_debug("append %s, size=%u, err=%d", key, len, err);
 
-int jekv_set_i64(jekv_handle_t handle, const char *key, int64_t value)
-{
-    return set_item(handle, JEKV_TYPE_INT64, key, &value, sizeof(value));
+    return err;
 }
 
-int jekv_set_u64(jekv_handle_t handle, const char *key, uint64_t value)
+int jekv_get_blob_range(jekv_handle_t handle, const char *key, uint32_t offset, void *buf, uint32_t *len)
 {
-    return set_item(handle, JEKV_TYPE_UINT64, key, &value, sizeof(value));
-}
+    int err;
+    jekv_handle_info_t *h;
+    jekv_blob_cursor_t cursor;
 
-int jekv_set_float(jekv_handle_t handle, const char *key, double value)
-{
-    return set_item(handle, JEKV_TYPE_DOUBLE, key, &value, sizeof(value));
-}
+    if (!(handle && key && key[0] && buf && len && *len > 0)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
 
-int jekv_get_i8(jekv_handle_t handle, const char *key, int8_t *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_INT8, key, out_value, &length);
-}
+    memset(&cursor, 0, sizeof(cursor));
 
-int jekv_get_u8(jekv_handle_t handle, const char *key, uint8_t *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_UINT8, key, out_value, &length);
-}
+    err = handle_enter(handle, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_read_blob_range(h->storage, h->group_id, key, &cursor, offset, buf, len);
 
-int jekv_get_i16(jekv_handle_t handle, const char *key, int16_t *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_INT16, key, out_value, &length);
-}
+        handle_leave(h, API_READ);
+    }
 
-int jekv_get_u16(jekv_handle_t handle, const char *key, uint16_t *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_UINT16, key, out_value, &length);
-}
+    jekv_log_debug("get blob range %s, offset=%u, err=%d", key, offset, err);
 
-int jekv_get_i32(jekv_handle_t handle, const char *key, int32_t *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_INT32, key, out_value, &length);
+    return err;
 }
 
-int jekv_get_u32(jekv_handle_t handle, const char *key, uint32_t *out_value)
+int jekv_blob_reader_open(jekv_handle_t handle, const char *key, jekv_blob_reader_t *reader, uint32_t *size)
 {
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_UINT32, key, out_value, &length);
-}
+    int err;
+    jekv_handle_info_t *h;
 
-int jekv_get_i64(jekv_handle_t handle, const char *key, int64_t *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_INT64, key, out_value, &length);
-}
+    if (!(handle && key && key[0] && reader)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
 
-int jekv_get_u64(jekv_handle_t handle, const char *key, uint64_t *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_UINT64, key, out_value, &length);
-}
+    err = handle_enter(handle, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_blob_reader_info_create(h, key, reader, size);
 
-int jekv_get_float(jekv_handle_t handle, const char *key, double *out_value)
-{
-    uint32_t length = sizeof(*out_value);
-    return get_item(handle, JEKV_TYPE_DOUBLE, key, out_value, &length);
+        handle_leave(h, API_READ);
+    }
+
+    return err;
+}
+
+int jekv_blob_reader_read(jekv_blob_reader_t reader, void *buf, uint32_t *len)
+{
+    int err;
+    jekv_blob_reader_info_t *r = (jekv_blob_reader_info_t *)reader;
+    jekv_handle_info_t *h;
+
+    if (!(reader && buf && len && *len > 0)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(r->handle_id, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_blob_reader_info_read(r, buf, len);
+
+        handle_leave(h, API_READ);
+    }
+
+    return err;
+}
+
+int jekv_blob_reader_close(jekv_blob_reader_t reader)
+{
+    int err;
+
+    if (!reader) {
+        return JEKV_ERR_OK;
+    }
+
+    JEKV_LOCK();
+
+    err = jekv_blob_reader_info_release((jekv_blob_reader_info_t *)reader);
+
+    JEKV_UNLOCK();
+
+    return err;
+}
+
+int jekv_counter_add(jekv_handle_t handle, const char *key, uint32_t step, uint32_t *value)
+{
+    int err;
+    jekv_handle_info_t *h;
+    uint32_t v;
+    int key_len;
+
+    if (!(handle && key)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_add_counter(h->storage, h->group_id, key, step, &v);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    if (err == JEKV_ERR_OK && value) {
+        *value = v;
+    }
+
+    jekv_log_debug("counter add %s, step=%u, err=%d", key, step, err);
+
+    return err;
+}
+
+int jekv_record_register(const jekv_record_schema_t *schema, uint8_t *schema_id)
+{
+    int err;
+
+    if (!(schema && schema_id)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    JEKV_LOCK();
+
+    err = jekv_record_add_schema(schema, schema_id);
+
+    JEKV_UNLOCK();
+
+    jekv_log_debug("record register: size=%u,err=%d", schema->size, err);
+
+    return err;
+}
+
+int jekv_record_set(jekv_handle_t handle, const char *key, uint8_t schema_id, const void *record)
+{
+    int err;
+    jekv_handle_info_t *h;
+    const jekv_record_schema_t *schema;
+    int key_len;
+
+    if (!(handle && key && record)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    /*the schemas are never removed*/
+    JEKV_LOCK();
+
+    schema = jekv_record_get_schema(schema_id);
+
+    JEKV_UNLOCK();
+
+    if (!schema) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_write_record(h->storage, h->group_id, key, record, schema->size);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    jekv_log_debug("record set %s, schema=%u, err=%d", key, schema_id, err);
+
+    return err;
+}
+
+int jekv_record_get(jekv_handle_t handle, const char *key, uint8_t schema_id, void *record)
+{
+    int err;
+    const jekv_record_schema_t *schema;
+    uint32_t length;
+
+    JEKV_LOCK();
+
+    schema = jekv_record_get_schema(schema_id);
+    length = schema ? schema->size : 0;
+
+    JEKV_UNLOCK();
+
+    if (!schema) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = get_item(handle, JEKV_TYPE_BINARY, key, record, &length);
+    if (err == JEKV_ERR_VALUE_TOO_LONG || (err == JEKV_ERR_OK && length != schema->size)) {
+        err = JEKV_ERR_INVALID_LENGTH;
+    }
+
+    return err;
+}
+
+int jekv_record_update_field(jekv_handle_t handle, const char *key, uint8_t schema_id, uint16_t field,
+                             const void *value)
+{
+    int err;
+    jekv_handle_info_t *h;
+    const jekv_record_schema_t *schema;
+    int key_len;
+
+    if (!(handle && key && value)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    JEKV_LOCK();
+
+    schema = jekv_record_get_schema(schema_id);
+
+    JEKV_UNLOCK();
+
+    if (!(schema && field < schema->field_count)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_update_record(h->storage, h->group_id, key, schema->size, schema->fields[field].offset,
+                                         value, schema->fields[field].size);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    jekv_log_debug("record update %s, field=%u, err=%d", key, field, err);
+
+    return err;
+}
+
+int jekv_get_view(jekv_handle_t handle, const char *key, const void **ptr, uint32_t *len, jekv_view_pin_t *pin)
+{
+    int err;
+    jekv_handle_info_t *h;
+
+    if (!(handle && key && key[0] && ptr && len && pin)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_view_pin_info_create(h, key, ptr, len, pin);
+
+        handle_leave(h, API_READ);
+    }
+
+    jekv_log_debug("get view %s, err=%d", key, err);
+
+    return err;
+}
+
+int jekv_release_view(jekv_view_pin_t pin)
+{
+    int err;
+    jekv_storage_t *storage;
+
+    if (!pin) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    storage = partition_enter(((jekv_view_pin_info_t *)pin)->partition, false);
+
+    err = jekv_view_pin_info_release(storage, (jekv_view_pin_info_t *)pin);
+
+    if (storage) {
+        storage_leave(storage, false);
+    }
+
+    return err;
+}
+
+int jekv_blob_writer_open(jekv_handle_t handle, const char *key, jekv_blob_writer_t *writer)
+{
+    int err;
+    jekv_handle_info_t *h;
+    int key_len;
+
+    if (!(handle && key && writer)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_blob_writer_info_create(h, key, writer);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    return err;
+}
+
+int jekv_blob_writer_write(jekv_blob_writer_t writer, const void *data, uint32_t size)
+{
+    int err;
+    jekv_blob_writer_info_t *w = (jekv_blob_writer_info_t *)writer;
+    jekv_handle_info_t *h;
+
+    if (!(writer && data && size > 0)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(w->handle_id, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_blob_writer_info_write(w, data, size);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    return err;
+}
+
+int jekv_blob_writer_close(jekv_blob_writer_t writer)
+{
+    int err;
+    jekv_blob_writer_info_t *w = (jekv_blob_writer_info_t *)writer;
+    jekv_handle_info_t *h;
+
+    if (!writer) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(w->handle_id, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_blob_writer_info_close(w);
+        if (err != JEKV_ERR_OK) {
+            jekv_blob_writer_info_abort(w);
+        }
+
+        handle_leave(h, API_WRITE);
+    }
+
+    jekv_blob_writer_info_release(w);
+
+    jekv_log_debug("blob writer close,err=%d", err);
+
+    return err;
+}
+
+int jekv_blob_writer_abort(jekv_blob_writer_t writer)
+{
+    int err;
+    jekv_blob_writer_info_t *w = (jekv_blob_writer_info_t *)writer;
+    jekv_handle_info_t *h;
+
+    if (!writer) {
+        return JEKV_ERR_OK;
+    }
+
+    if (handle_enter(w->handle_id, API_WRITE, &h) == JEKV_ERR_OK) {
+        jekv_blob_writer_info_abort(w);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    err = jekv_blob_writer_info_release(w);
+
+    return err;
+}
+
+int jekv_set_i8(jekv_handle_t handle, const char *key, int8_t value)
+{
+    return set_item(handle, JEKV_TYPE_INT8, key, &value, sizeof(value));
+}
+
+int jekv_set_u8(jekv_handle_t handle, const char *key, uint8_t value)
+{
+    return set_item(handle, JEKV_TYPE_UINT8, key, &value, sizeof(value));
+}
+
+int jekv_set_i16(jekv_handle_t handle, const char *key, int16_t value)
+{
+    return set_item(handle, JEKV_TYPE_INT16, key, &value, sizeof(value));
+}
+
+int jekv_set_u16(jekv_handle_t handle, const char *key, uint16_t value)
+{
+    return set_item(handle, JEKV_TYPE_UINT16, key, &value, sizeof(value));
+}
+
+int jekv_set_i32(jekv_handle_t handle, const char *key, int32_t value)
+{
+    return set_item(handle, JEKV_TYPE_INT32, key, &value, sizeof(value));
+}
+
+int jekv_set_u32(jekv_handle_t handle, const char *key, uint32_t value)
+{
+    return set_item(handle, JEKV_TYPE_UINT32, key, &value, sizeof(value));
+}
+
+int jekv_set_i64(jekv_handle_t handle, const char *key, int64_t value)
+{
+    return set_item(handle, JEKV_TYPE_INT64, key, &value, sizeof(value));
+}
+
+int jekv_set_u64(jekv_handle_t handle, const char *key, uint64_t value)
+{
+    return set_item(handle, JEKV_TYPE_UINT64, key, &value, sizeof(value));
+}
+
+int jekv_set_float(jekv_handle_t handle, const char *key, double value)
+{
+    return set_item(handle, JEKV_TYPE_DOUBLE, key, &value, sizeof(value));
+}
+
+int jekv_get_i8(jekv_handle_t handle, const char *key, int8_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_INT8, key, out_value, &length);
+}
+
+int jekv_get_u8(jekv_handle_t handle, const char *key, uint8_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_UINT8, key, out_value, &length);
+}
+
+int jekv_get_i16(jekv_handle_t handle, const char *key, int16_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_INT16, key, out_value, &length);
+}
+
+int jekv_get_u16(jekv_handle_t handle, const char *key, uint16_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_UINT16, key, out_value, &length);
+}
+
+int jekv_get_i32(jekv_handle_t handle, const char *key, int32_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_INT32, key, out_value, &length);
+}
+
+int jekv_get_u32(jekv_handle_t handle, const char *key, uint32_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_UINT32, key, out_value, &length);
+}
+
+int jekv_get_i64(jekv_handle_t handle, const char *key, int64_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_INT64, key, out_value, &length);
+}
+
+int jekv_get_u64(jekv_handle_t handle, const char *key, uint64_t *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_UINT64, key, out_value, &length);
+}
+
+int jekv_get_float(jekv_handle_t handle, const char *key, double *out_value)
+{
+    uint32_t length = sizeof(*out_value);
+    return get_item(handle, JEKV_TYPE_DOUBLE, key, out_value, &length);
+}
+
+/*the key is checked, a string key or the key buffer of the integer key*/
+static int del_item(jekv_handle_t handle, const char *key)
+{
+    int err;
+    jekv_handle_info_t *h;
+
+    if (!handle) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_del_item(h->storage, h->group_id, (jekv_type_t)(JEKV_TYPE_ANY_WITHOUT_SEG), key);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    jekv_log_debug("del %s,err=%d", key, err);
+
+    return err;
 }
 
 int jekv_del_key(jekv_handle_t handle, const char *key)
+{
+    if (!(key && key[0])) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    return del_item(handle, key);
+}
+
+int jekv_set_by_id(jekv_handle_t handle, uint32_t id, jekv_type_t type, const void *value, uint32_t length)
+{
+    char key[JEKV_MAX_KEY_LEN + 1];
+
+    if (type == JEKV_TYPE_BLOB) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    jekv_item_make_id_key(key, id);
+
+    return write_item(handle, type, key, value, length);
+}
+
+int jekv_get_by_id(jekv_handle_t handle, uint32_t id, jekv_type_t type, void *out_value, uint32_t *length)
+{
+    char key[JEKV_MAX_KEY_LEN + 1];
+
+    if (type == JEKV_TYPE_BLOB) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    jekv_item_make_id_key(key, id);
+
+    return read_item(handle, type, key, out_value, length);
+}
+
+int jekv_del_by_id(jekv_handle_t handle, uint32_t id)
+{
+    char key[JEKV_MAX_KEY_LEN + 1];
+
+    jekv_item_make_id_key(key, id);
+
+    return del_item(handle, key);
+}
+
+int jekv_del_group(jekv_handle_t handle)
+{
+    int err;
+    jekv_handle_info_t *h;
+    uint8_t new_id;
+
+    if (!handle) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_storage_del_group(h->storage, h->group_id, &new_id);
+        if (err == JEKV_ERR_OK) {
+            /*all the handles of the group follow it*/
+            JEKV_LOCK();
+
+            jekv_ptm_set_group_id(h->storage, h->group_id, new_id);
+
+            JEKV_UNLOCK();
+        }
+
+        handle_leave(h, API_WRITE);
+    }
+
+    jekv_log_debug("del all group, err=%d", err);
+
+    return err;
+}
+
+int jekv_entry_find(const char *partition_name, const char *group, jekv_type_t type, jekv_iterator_t *output_iterator)
+{
+    int err;
+    jekv_storage_t *storage;
+
+    if (!(partition_name && group && (int)type >= JEKV_TYPE_ANY && (int)type < JEKV_TYPE_MAX && output_iterator)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    if (type == JEKV_TYPE_ANY) {
+        type = (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG;
+    }
+
+    storage = partition_enter(partition_name, true);
+    if (!storage) {
+        jekv_log_debug("Not init");
+        return JEKV_ERR_NOT_INIT;
+    }
+
+    err = jekv_iterator_find(storage, group, type, output_iterator);
+
+    storage_leave(storage, true);
+
+    return err;
+}
+
+int jekv_entry_find_by_handle(jekv_handle_t handle, jekv_type_t type, jekv_iterator_t *output_iterator)
+{
+    int err;
+    jekv_handle_info_t *h;
+
+    if (!(handle && (int)type >= JEKV_TYPE_ANY && (int)type < JEKV_TYPE_MAX && output_iterator)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    if (type == JEKV_TYPE_ANY) {
+        type = (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG;
+    }
+
+    err = handle_enter(handle, API_READ_SHARED, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_iterator_find_by_handle(h, type, output_iterator);
+
+        handle_leave(h, API_READ_SHARED);
+    }
+
+    return err;
+}
+
+int jekv_entry_next(jekv_iterator_t *iterator)
+{
+    int err;
+    jekv_storage_t *storage;
+
+    if (!(iterator && *iterator)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    /*the iterator is released at the end*/
+    storage = iterator_enter(*iterator, true);
+    if (!storage) {
+        return JEKV_ERR_NOT_INIT;
+    }
+
+    err = jekv_iterator_next(iterator);
+
+    storage_leave(storage, true);
+
+    return err;
+}
+
+int jekv_entry_info(jekv_iterator_t iterator, jekv_entry_t *info)
+{
+    int err;
+
+    if (!(iterator && info)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    JEKV_LOCK();
+
+    err = jekv_iterator_info(iterator, info);
+
+    JEKV_UNLOCK();
+
+    return err;
+}
+
+int jekv_entry_data(jekv_iterator_t iterator, void *data, uint32_t *data_len)
+{
+    int err;
+    jekv_storage_t *storage;
+    bool shared;
+
+    if (!(iterator && data && data_len && *data_len > 0)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    storage = iterator_enter(iterator, true);
+    if (!storage) {
+        return JEKV_ERR_NOT_INIT;
+    }
+
+    shared = jekv_storage_is_read_shared(storage, ((jekv_iterator_info_t *)iterator)->info.type);
+    if (!shared) {
+        storage_upgrade(storage);
+    }
+
+    err = jekv_iterator_data(iterator, data, data_len);
+
+    storage_leave(storage, shared);
+
+    return err;
+}
+
+int jekv_release_iterator(jekv_iterator_t iterator)
+{
+    int err;
+
+    if (!(iterator)) {
+        return JEKV_ERR_OK;
+    }
+
+    JEKV_LOCK();
+
+    err = jekv_iterator_release(iterator);
+
+    JEKV_UNLOCK();
+
+    return err;
+}
+
+int jekv_print(const char *partition_name, const char *group_name)
+{
+    int err;
+    jekv_storage_t *storage;
+
+    if (!partition_name) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    storage = partition_enter(partition_name, false);
+    if (!storage) {
+        return JEKV_ERR_NOT_INIT;
+    }
+
+    err = jekv_iterator_print(storage, group_name);
+
+    storage_leave(storage, false);
+
+    return err;
+}
+
+int jekv_get_many(jekv_handle_t handle, const char *keys[], jekv_get_desc_t descs[], uint32_t count)
+{
+    int err;
+    uint32_t i;
+    jekv_handle_info_t *h;
+#if CONFIG_JEKV_EPOCH_READ
+    uint32_t slot;
+#endif
+
+    if (!(handle && keys && descs && count > 0)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!(keys[i] && keys[i][0] && descs[i].data && descs[i].length > 0 && descs[i].type > JEKV_TYPE_ANY &&
+              descs[i].type < JEKV_TYPE_MAX)) {
+            return JEKV_ERR_INVALID_PARAM;
+        }
+    }
+
+#if CONFIG_JEKV_EPOCH_READ
+    h = handle_enter_epoch(handle, &slot);
+    if (h) {
+        for (i = 0; i < count && jekv_storage_is_read_shared(h->storage, descs[i].type); i++) {
+        }
+
+        if (i == count) {
+            err = jekv_storage_read_items(h->storage, h->group_id, keys, descs, count);
+
+            jekv_epoch_leave(slot);
+
+            jekv_log_debug("get many, count=%u, err=%d", count, err);
+
+            return err;
+        }
+
+        jekv_epoch_leave(slot);
+    }
+#endif
+
+    err = handle_enter(handle, API_READ_SHARED, &h);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /*a blob or a cache in the keys, read them exclusively*/
+    for (i = 0; i < count && jekv_storage_is_read_shared(h->storage, descs[i].type); i++) {
+    }
+
+    if (i == count) {
+        err = jekv_storage_read_items(h->storage, h->group_id, keys, descs, count);
+
+        handle_leave(h, API_READ_SHARED);
+    } else {
+        err = handle_upgrade(handle, h);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_storage_read_items(h->storage, h->group_id, keys, descs, count);
+
+            handle_leave(h, API_READ);
+        }
+    }
+
+    jekv_log_debug("get many, count=%u, err=%d", count, err);
+
+    return err;
+}
+
+int jekv_get_info(jekv_handle_t handle, const char *key, jekv_type_t *type, uint32_t *size)
+{
+    int err;
+    jekv_handle_info_t *h = NULL;
+    jekv_item_t item;
+#if CONFIG_JEKV_EPOCH_READ
+    uint32_t slot;
+#endif
+
+    if (!(handle && key && key[0] && type && size)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+#if CONFIG_JEKV_EPOCH_READ
+    /*the cached items are found without the timer, nothing is changed*/
+    h = handle_enter_epoch(handle, &slot);
+    if (h) {
+        err = jekv_storage_find_key(h->storage, h->group_id, key, &item);
+
+        jekv_epoch_leave(slot);
+    }
+#endif
+
+    if (!h) {
+        err = handle_enter(handle, API_READ_SHARED, &h);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_storage_find_key(h->storage, h->group_id, key, &item);
+
+            handle_leave(h, API_READ_SHARED);
+        }
+    }
+    if (err == JEKV_ERR_OK) {
+        *type = (jekv_type_t)item.type;
+
+        if (item.type == JEKV_TYPE_BLOB) {
+            *size = item.all_size;
+        } else {
+            *size = JEKV_ITEM_VALUE_SIZE(&item);
+        }
+    }
+
+    jekv_log_debug("get info %s, size=%u, err=%d", key, ((!err) ? *size : 0), err);
+
+    return err;
+}
+
+int jekv_get_status(const char *partition_name, jekv_status_t *status)
+{
+    int err;
+    jekv_storage_t *storage;
+
+    if (!(partition_name && status)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    storage = partition_enter(partition_name, true);
+    if (!storage) {
+        return JEKV_ERR_NOT_INIT;
+    }
+
+    err = jekv_ptm_get_status(storage, status);
+
+    JEKV_LOCK();
+
+    status->handle_num = jekv_ptm_get_handle_num(storage);
+
+    JEKV_UNLOCK();
+
+    storage_leave(storage, true);
+
+    return err;
+}
+
+int jekv_compact(const char *partition_name, jekv_compact_stat_t *stat)
+{
+    int err;
+    jekv_compact_stat_t compact_stat;
+    jekv_storage_t *storage;
+
+    if (!partition_name) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    storage = partition_enter(partition_name, false);
+    if (storage) {
+        err = jekv_ptm_compact(storage, &compact_stat);
+
+        storage_leave(storage, false);
+    } else {
+        memset(&compact_stat, 0, sizeof(compact_stat));
+        err = JEKV_ERR_NOT_INIT;
+    }
+
+    if (stat) {
+        *stat = compact_stat;
+    }
+
+    return err;
+}
+
+int jekv_batch_begin(jekv_handle_t handle, jekv_batch_t *batch)
+{
+    int err;
+    jekv_handle_info_t *h;
+
+    if (!(handle && batch)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_batch_info_create(h, batch);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    return err;
+}
+
+/*the group id of the handle is kept by the operation*/
+static int batch_add(jekv_batch_info_t *batch, const char *key, jekv_type_t type, const void *data, uint32_t size)
+{
+    int err;
+    jekv_handle_info_t *h;
+
+    err = handle_enter(batch->handle_id, API_READ_SHARED, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_batch_info_add(batch, key, type, data, size);
+
+        handle_leave(h, API_READ_SHARED);
+    }
+
+    return err;
+}
+
+int jekv_batch_put(jekv_batch_t batch, const char *key, jekv_type_t type, const void *data, uint32_t size)
 {
     int err;
-    jekv_handle_info_t *h = (jekv_handle_info_t *)handle;
+    int key_len;
 
-    if (!(handle && key)) {
+    if (!(batch && key && data && size > 0 && type > JEKV_TYPE_ANY && type < JEKV_TYPE_MAX && type != JEKV_TYPE_BLOB)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
 
-    if (!jekv_ptm_is_handle_valid(h)) {
-        err = JEKV_ERR_INVALID_HANDLE;
-    } else if (h->mode == JEKV_OP_READ_ONLY) {
-        err = JEKV_ERR_READ_ONLY;
-    } else {
-        err = jekv_storage_del_item(h->storage, h->group_id, (jekv_type_t)(JEKV_TYPE_ANY_WITHOUT_SEG), key);
+    if (size > JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
+        return JEKV_ERR_VALUE_TOO_LONG;
     }
 
-    JEKV_UNLOCK();
+    err = batch_add((jekv_batch_info_t *)batch, key, type, data, size);
 
-    jekv_log_debug("del %s,err=%d", key, err);
+    return err;
+}
+
+int jekv_batch_del(jekv_batch_t batch, const char *key)
+{
+    int err;
+    int key_len;
+
+    if (!(batch && key)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    key_len = strlen(key);
+    if (!(key_len > 0 && key_len <= JEKV_MAX_KEY_LEN)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = batch_add((jekv_batch_info_t *)batch, key, JEKV_TYPE_ANY, NULL, 0);
 
     return err;
 }
 
-int jekv_del_group(jekv_handle_t handle)
+int jekv_batch_commit(jekv_batch_t batch)
 {
     int err;
-    jekv_handle_info_t *h = (jekv_handle_info_t *)handle;
+    jekv_batch_info_t *b = (jekv_batch_info_t *)batch;
+    jekv_handle_info_t *h;
 
-    if (!(handle && h->valid)) {
+    if (!batch) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    err = handle_enter(b->handle_id, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_batch_info_commit(b);
 
-    if (!jekv_ptm_is_handle_valid(h)) {
-        err = JEKV_ERR_INVALID_HANDLE;
-    } else if (h->mode == JEKV_OP_READ_ONLY) {
-        err = JEKV_ERR_READ_ONLY;
-    } else {
-        err = jekv_storage_del_group(h->storage, h->group_id);
+        handle_leave(h, API_WRITE);
     }
 
-    JEKV_UNLOCK();
+    jekv_batch_info_release(b);
 
-    jekv_log_debug("del all group, id=%d", h->group_id);
+    jekv_log_debug("batch commit,err=%d", err);
 
     return err;
 }
 
-int jekv_entry_find(const char *partition_name, const char *group, jekv_type_t type, jekv_iterator_t *output_iterator)
+int jekv_batch_abort(jekv_batch_t batch)
 {
     int err;
 
-    if (!(partition_name && group && (int)type >= JEKV_TYPE_ANY && (int)type < JEKV_TYPE_MAX && output_iterator)) {
-        return JEKV_ERR_INVALID_PARAM;
+    if (!batch) {
+        return JEKV_ERR_OK;
     }
 
     JEKV_LOCK();
 
-    if (type == JEKV_TYPE_ANY) {
-        type = (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG;
-    }
-
-    err = jekv_iterator_find(partition_name, group, type, output_iterator);
+    err = jekv_batch_info_release((jekv_batch_info_t *)batch);
 
     JEKV_UNLOCK();
 
     return err;
 }
 
-int jekv_entry_find_by_handle(jekv_handle_t handle, jekv_type_t type, jekv_iterator_t *output_iterator)
+int jekv_set_write_back(const char *partition_name, uint32_t dirty_size, uint32_t interval_ms)
 {
     int err;
+    jekv_storage_t *storage;
 
-    if (!(handle && (int)type >= JEKV_TYPE_ANY && (int)type < JEKV_TYPE_MAX && output_iterator)) {
+    if (!partition_name) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    storage = partition_enter(partition_name, false);
+    if (storage) {
+        err = jekv_cache_config(storage, dirty_size, interval_ms);
+
+        storage_leave(storage, false);
+    } else {
+        err = JEKV_ERR_NOT_INIT;
+    }
+
+    return err;
+}
+
+int jekv_flush(const char *partition_name)
+{
+    int err;
+    jekv_storage_t *storage;
+
+    if (!partition_name) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
 
-    if (jekv_ptm_is_handle_valid((jekv_handle_info_t *)handle)) {
-        if (type == JEKV_TYPE_ANY) {
-            type = (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG;
+    storage = partition_enter(partition_name, false);
+    if (storage) {
+        err = jekv_cache_flush(storage);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_sm_flush_drops(&storage->sm);
         }
-        err = jekv_iterator_find_by_handle(handle, type, output_iterator);
+
+        storage_leave(storage, false);
     } else {
-        err = JEKV_ERR_INVALID_HANDLE;
+        err = JEKV_ERR_NOT_INIT;
     }
 
-    JEKV_UNLOCK();
+    return err;
+}
+
+int jekv_set_compress(const char *partition_name, uint32_t min_size)
+{
+    int err = JEKV_ERR_OK;
+    jekv_storage_t *storage;
+
+    if (!partition_name) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    storage = partition_enter(partition_name, false);
+    if (storage) {
+        storage->compress_size = min_size;
+
+        storage_leave(storage, false);
+    } else {
+        err = JEKV_ERR_NOT_INIT;
+    }
+
+    jekv_log_debug("set compress %s: min_size=%u,err=%d", partition_name, min_size, err);
 
     return err;
 }
 
-int jekv_entry_next(jekv_iterator_t *iterator)
+/*the name of the ring is checked as a key*/
+static bool ring_name_valid(const char *name)
+{
+    int len;
+
+    if (!name) {
+        return false;
+    }
+
+    len = strlen(name);
+
+    return len > 0 && len <= JEKV_MAX_KEY_LEN;
+}
+
+int jekv_ring_open(jekv_handle_t handle, const char *name, uint8_t max_sectors, jekv_ring_t *ring)
 {
     int err;
+    jekv_handle_info_t *h;
 
-    if (!(iterator)) {
+    if (!(handle && ring_name_valid(name) && max_sectors >= 2 && max_sectors <= CONFIG_JEKV_RING_SECTOR_MAX &&
+          ring)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    err = handle_enter(handle, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_ring_info_create(h, name, max_sectors, ring);
 
-    err = jekv_iterator_next(iterator);
+        handle_leave(h, API_READ);
+    }
 
-    JEKV_UNLOCK();
+    jekv_log_debug("ring open %s,max_sectors=%u,err=%d", name, max_sectors, err);
 
     return err;
 }
 
-int jekv_entry_info(jekv_iterator_t iterator, jekv_entry_t *info)
+int jekv_ring_append(jekv_ring_t ring, const void *data, uint32_t size, uint32_t *seq)
 {
     int err;
+    jekv_ring_info_t *r = (jekv_ring_info_t *)ring;
+    jekv_handle_info_t *h;
+    uint32_t s;
 
-    if (!(iterator && info)) {
+    if (!(ring && data && size > 0)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
+    err = handle_enter(r->handle_id, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_ring_info_append(r, data, size, &s);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    if (err == JEKV_ERR_OK && seq) {
+        *seq = s;
+    }
+
+    jekv_log_debug("ring append %s,size=%u,err=%d", r->name, size, err);
+
+    return err;
+}
+
+int jekv_ring_close(jekv_ring_t ring)
+{
+    int err;
+
+    if (!ring) {
+        return JEKV_ERR_OK;
+    }
+
     JEKV_LOCK();
 
-    err = jekv_iterator_info(iterator, info);
+    err = jekv_ring_info_release((jekv_ring_info_t *)ring);
 
     JEKV_UNLOCK();
 
     return err;
 }
 
-int jekv_entry_data(jekv_iterator_t iterator, void *data, uint32_t *data_len)
+int jekv_ring_del(jekv_handle_t handle, const char *name)
 {
     int err;
+    jekv_handle_info_t *h;
 
-    if (!(iterator && data && data_len && *data_len > 0)) {
+    if (!(handle && ring_name_valid(name))) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_ring_info_del(h, name);
 
-    err = jekv_iterator_data(iterator, data, data_len);
+        handle_leave(h, API_WRITE);
+    }
 
-    JEKV_UNLOCK();
+    jekv_log_debug("ring del %s,err=%d", name, err);
 
     return err;
 }
 
-int jekv_release_iterator(jekv_iterator_t iterator)
+int jekv_ring_cursor_open(jekv_ring_t ring, jekv_ring_start_t start, jekv_ring_cursor_t *cursor)
 {
     int err;
+    jekv_ring_info_t *r = (jekv_ring_info_t *)ring;
+    jekv_handle_info_t *h;
 
-    if (!(iterator)) {
+    if (!(ring && (start == JEKV_RING_OLDEST || start == JEKV_RING_NEWEST) && cursor)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(r->handle_id, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_ring_cursor_info_create(r, start, cursor);
+
+        handle_leave(h, API_READ);
+    }
+
+    return err;
+}
+
+int jekv_ring_cursor_seek(jekv_ring_cursor_t cursor, uint32_t seq)
+{
+    int err;
+    jekv_ring_cursor_info_t *c = (jekv_ring_cursor_info_t *)cursor;
+    jekv_handle_info_t *h;
+
+    if (!cursor) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(c->handle_id, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_ring_cursor_info_seek(c, seq);
+
+        handle_leave(h, API_READ);
+    }
+
+    return err;
+}
+
+static int ring_cursor_move(jekv_ring_cursor_t cursor, bool newer)
+{
+    int err;
+    jekv_ring_cursor_info_t *c = (jekv_ring_cursor_info_t *)cursor;
+    jekv_handle_info_t *h;
+
+    if (!cursor) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(c->handle_id, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_ring_cursor_info_move(c, newer);
+
+        handle_leave(h, API_READ);
+    }
+
+    return err;
+}
+
+int jekv_ring_cursor_next(jekv_ring_cursor_t cursor)
+{
+    return ring_cursor_move(cursor, true);
+}
+
+int jekv_ring_cursor_prev(jekv_ring_cursor_t cursor)
+{
+    return ring_cursor_move(cursor, false);
+}
+
+int jekv_ring_cursor_read(jekv_ring_cursor_t cursor, void *data, uint32_t *len, uint32_t *seq)
+{
+    int err;
+    jekv_ring_cursor_info_t *c = (jekv_ring_cursor_info_t *)cursor;
+    jekv_handle_info_t *h;
+
+    if (!(cursor && data && len && *len > 0)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(c->handle_id, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_ring_cursor_info_read(c, data, len, seq);
+
+        handle_leave(h, API_READ);
+    }
+
+    return err;
+}
+
+int jekv_ring_cursor_close(jekv_ring_cursor_t cursor)
+{
+    int err;
+
+    if (!cursor) {
         return JEKV_ERR_OK;
     }
 
     JEKV_LOCK();
 
-    err = jekv_iterator_release(iterator);
+    err = jekv_ring_cursor_info_release((jekv_ring_cursor_info_t *)cursor);
 
     JEKV_UNLOCK();
 
     return err;
 }
 
-int jekv_print(const char *partition_name, const char *group_name)
+int jekv_queue_open(jekv_handle_t handle, const char *name, jekv_queue_t *queue)
 {
     int err;
+    jekv_handle_info_t *h;
 
-    if (!partition_name) {
+    /*the queues are named as the rings*/
+    if (!(handle && ring_name_valid(name) && queue)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    err = handle_enter(handle, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_queue_info_create(h, name, queue);
 
-    err = jekv_iterator_print(partition_name, group_name);
+        handle_leave(h, API_READ);
+    }
 
-    JEKV_UNLOCK();
+    jekv_log_debug("queue open %s,err=%d", name, err);
 
     return err;
 }
 
-int jekv_get_info(jekv_handle_t handle, const char *key, jekv_type_t *type, uint32_t *size)
+int jekv_queue_push(jekv_queue_t queue, const void *data, uint32_t size)
 {
     int err;
-    jekv_handle_info_t *h = (jekv_handle_info_t *)handle;
-    jekv_item_t item;
+    jekv_queue_info_t *q = (jekv_queue_info_t *)queue;
+    jekv_handle_info_t *h;
 
-    if (!(handle && key && type && size)) {
+    if (!(queue && data && size > 0)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
-    JEKV_LOCK();
+    err = handle_enter(q->handle_id, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_queue_info_push(q, data, size);
+
+        handle_leave(h, API_WRITE);
+    }
 
-    err = jekv_storage_find_key(h->storage, h->group_id, key, &item);
+    jekv_log_debug("queue push %s,size=%u,err=%d", q->name, size, err);
+
+    return err;
+}
+
+static int queue_read(jekv_queue_t queue, void *data, uint32_t *len, bool pop)
+{
+    int err;
+    jekv_queue_info_t *q = (jekv_queue_info_t *)queue;
+    jekv_handle_info_t *h;
+
+    if (!(queue && data && len)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(q->handle_id, API_READ, &h);
     if (err == JEKV_ERR_OK) {
-        *type = (jekv_type_t)item.type;
+        err = jekv_queue_info_read(q, data, len, pop);
 
-        if (item.type == JEKV_TYPE_BLOB) {
-            *size = item.all_size;
-        } else {
-            *size = item.length;
-        }
+        handle_leave(h, API_READ);
     }
 
-    JEKV_UNLOCK();
+    return err;
+}
 
-    jekv_log_debug("get info %s, size=%u, err=%d", key, ((!err) ? *size : 0), err);
+int jekv_queue_peek(jekv_queue_t queue, void *data, uint32_t *len)
+{
+    return queue_read(queue, data, len, false);
+}
+
+int jekv_queue_pop(jekv_queue_t queue, void *data, uint32_t *len)
+{
+    return queue_read(queue, data, len, true);
+}
+
+int jekv_queue_ack(jekv_queue_t queue)
+{
+    int err;
+    jekv_queue_info_t *q = (jekv_queue_info_t *)queue;
+    jekv_handle_info_t *h;
+
+    if (!queue) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(q->handle_id, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_queue_info_ack(q);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    jekv_log_debug("queue ack %s,err=%d", q->name, err);
 
     return err;
 }
 
-int jekv_get_status(const char *partition_name, jekv_status_t *status)
+int jekv_queue_count(jekv_queue_t queue, uint32_t *count)
 {
     int err;
+    jekv_queue_info_t *q = (jekv_queue_info_t *)queue;
+    jekv_handle_info_t *h;
 
-    if (!(partition_name && status)) {
+    if (!(queue && count)) {
         return JEKV_ERR_INVALID_PARAM;
     }
 
+    err = handle_enter(q->handle_id, API_READ, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_queue_info_count(q, count);
+
+        handle_leave(h, API_READ);
+    }
+
+    return err;
+}
+
+int jekv_queue_close(jekv_queue_t queue)
+{
+    int err;
+
+    if (!queue) {
+        return JEKV_ERR_OK;
+    }
+
     JEKV_LOCK();
 
-    err = jekv_ptm_get_status(partition_name, status);
+    err = jekv_queue_info_release((jekv_queue_info_t *)queue);
 
     JEKV_UNLOCK();
 
     return err;
 }
+
+int jekv_queue_del(jekv_handle_t handle, const char *name)
+{
+    int err;
+    jekv_handle_info_t *h;
+
+    if (!(handle && ring_name_valid(name))) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = handle_enter(handle, API_WRITE, &h);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_queue_info_del(h, name);
+
+        handle_leave(h, API_WRITE);
+    }
+
+    jekv_log_debug("queue del %s,err=%d", name, err);
+
+    return err;
+}
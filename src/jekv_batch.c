@@ -0,0 +1,98 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_batch"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_batch.h"
+#include "jekv_cache.h"
+#include "jekv_log.h"
+
+int jekv_batch_info_create(jekv_handle_info_t *handle, jekv_batch_t *batch)
+{
+    jekv_batch_info_t *b = JEKV_CALLOC(1, sizeof(*b));
+
+    if (!b) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    b->handle    = handle;
+    b->handle_id = handle->id;
+    dl_list_init(&b->ops);
+
+    *batch = (jekv_batch_t)b;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_batch_info_add(jekv_batch_info_t *batch, const char *key, jekv_type_t type, const void *data, uint32_t size)
+{
+    jekv_batch_op_t *op;
+    jekv_batch_op_t *entry = NULL;
+    jekv_batch_op_t *next  = NULL;
+
+    /*data is saved after the operation*/
+    op = JEKV_CALLOC(1, sizeof(*op) + size);
+    if (!op) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    snprintf(op->key, sizeof(op->key), "%s", key);
+    op->group_id = batch->handle->group_id;
+    op->type     = type;
+    op->size     = size;
+    op->data     = (uint8_t *)(op + 1);
+
+    if (size > 0) {
+        memcpy(op->data, data, size);
+    }
+
+    /*the last operation on the same key wins*/
+    dl_list_for_each_safe(entry, next, &batch->ops, jekv_batch_op_t, list)
+    {
+        if (!strncmp(entry->key, key, JEKV_MAX_KEY_LEN)) {
+            dl_list_del(&entry->list);
+            JEKV_FREE(entry);
+            break;
+        }
+    }
+
+    dl_list_add_tail(&batch->ops, &op->list);
+
+    jekv_log_debug("batch add %s,type=%d,size=%u", key, type, size);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_batch_info_commit(jekv_batch_info_t *batch)
+{
+    jekv_batch_op_t *entry = NULL;
+
+    if (dl_list_empty(&batch->ops)) {
+        return JEKV_ERR_OK;
+    }
+
+    /*the batch is newer than the cached values*/
+    dl_list_for_each(entry, &batch->ops, jekv_batch_op_t, list)
+    {
+        jekv_cache_remove(batch->handle->storage, entry->group_id, entry->key);
+    }
+
+    return jekv_storage_write_batch(batch->handle->storage, &batch->ops);
+}
+
+int jekv_batch_info_release(jekv_batch_info_t *batch)
+{
+    jekv_batch_op_t *entry = NULL;
+    jekv_batch_op_t *next  = NULL;
+
+    dl_list_for_each_safe(entry, next, &batch->ops, jekv_batch_op_t, list)
+    {
+        dl_list_del(&entry->list);
+        JEKV_FREE(entry);
+    }
+
+    JEKV_FREE(batch);
+
+    return JEKV_ERR_OK;
+}
@@ -0,0 +1,38 @@
+#ifndef __JEKV_BATCH_H__
+#define __JEKV_BATCH_H__
+
+#include <stdint.h>
+
+#include "dlist.h"
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_storage.h"
+#include "jekv_handler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief  kv batch information structure
+  */
+typedef struct jekv_batch_info_t {
+    jekv_handle_info_t *handle; /**< handle the batch belongs to */
+    jekv_handle_t handle_id;    /**< id of the handle            */
+    struct dl_list ops;         /**< batch operation list        */
+} jekv_batch_info_t;
+
+int jekv_batch_info_create(jekv_handle_info_t *handle, jekv_batch_t *batch);
+
+/*type JEKV_TYPE_ANY for delete*/
+int jekv_batch_info_add(jekv_batch_info_t *batch, const char *key, jekv_type_t type, const void *data, uint32_t size);
+
+int jekv_batch_info_commit(jekv_batch_info_t *batch);
+
+int jekv_batch_info_release(jekv_batch_info_t *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,353 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_blob_map"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_blob_map.h"
+#include "jekv_log.h"
+
+static jekv_blob_map_t *blob_map_create(jekv_storage_t *storage, jekv_sector_t *sec, int index, jekv_item_t *desc,
+                                        const uint8_t *ver)
+{
+    jekv_blob_map_t *map;
+
+    int seg_count = JEKV_ITEM_BLOB_SEG_COUNT(desc);
+
+    map = JEKV_CALLOC(1, sizeof(*map) + seg_count * sizeof(map->segs[0]));
+    if (!map) {
+        return NULL;
+    }
+
+    memcpy(map->name, desc->name, JEKV_MAX_KEY_LEN);
+    map->group_id   = desc->group_id;
+    map->seg_count  = seg_count;
+    map->index      = index;
+    map->sec        = sec;
+    map->generation = sec->generation;
+
+    memcpy(map->ver, ver, sizeof(map->ver));
+
+    dl_list_add_tail(&storage->blob_maps, &map->list);
+
+    return map;
+}
+
+static void blob_map_set_seg(jekv_blob_map_t *map, int seg, jekv_sector_t *sec, int index, jekv_item_t *item)
+{
+    map->segs[seg].sec        = sec;
+    map->segs[seg].generation = sec->generation;
+    map->segs[seg].length     = item->length;
+    map->segs[seg].crc        = item->length > 8 ? item->crc_data : jekv_port_crc32(UINT32_MAX, item->data, item->length);
+    map->segs[seg].index      = index;
+}
+
+static void blob_map_delete(jekv_blob_map_t *map)
+{
+    dl_list_del(&map->list);
+    JEKV_FREE(map);
+}
+
+static bool blob_map_is_valid(jekv_blob_map_t *map)
+{
+    int i;
+
+    if (map->generation != map->sec->generation) {
+        return false;
+    }
+
+    for (i = 0; i < map->seg_count; i++) {
+        if (!map->segs[i].sec || map->segs[i].generation != map->segs[i].sec->generation) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*check the segments count and size match the descriptor*/
+static int blob_map_check(jekv_blob_map_t *map, jekv_item_t *desc)
+{
+    uint32_t size = 0;
+    int i;
+
+    for (i = 0; i < map->seg_count; i++) {
+        if (!map->segs[i].sec) {
+            return i > 0 ? JEKV_ERR_INVALID_LENGTH : JEKV_ERR_NOT_FOUND;
+        }
+
+        size += map->segs[i].length;
+    }
+
+    return size == desc->all_size ? JEKV_ERR_OK : JEKV_ERR_INVALID_LENGTH;
+}
+
+static int blob_map_build(jekv_storage_t *storage, jekv_sector_t *sec, int index, jekv_item_t *desc,
+                          jekv_blob_map_t **map)
+{
+    int err;
+    jekv_blob_map_t *m;
+    jekv_item_t seg;
+    jekv_sector_t *seg_sec;
+    int seg_index;
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE];
+    int i;
+
+    err = jekv_sector_read_blob_ver(sec, index, desc, ver);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    m = blob_map_create(storage, sec, index, desc, ver);
+    if (!m) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    for (i = 0; i < m->seg_count; i++) {
+        seg_sec = NULL;
+
+        /*look for segments*/
+        err = jekv_sm_find_blob_seg(&storage->sm, desc->group_id, desc->name, ver, i, &seg_index, &seg_sec, &seg);
+        if (err != JEKV_ERR_OK) {
+            jekv_log_debug("find seg %d, err=%d", i, err);
+            break;
+        }
+
+        blob_map_set_seg(m, i, seg_sec, seg_index, &seg);
+    }
+
+    err = blob_map_check(m, desc);
+    if (err != JEKV_ERR_OK) {
+        blob_map_delete(m);
+        return err;
+    }
+
+    jekv_log_debug("build map %.*s, seg_count=%d", JEKV_MAX_KEY_LEN, desc->name, m->seg_count);
+
+    *map = m;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_blob_map_load(jekv_storage_t *storage)
+{
+    int err;
+    jekv_sector_t *it = NULL;
+    jekv_item_t item;
+    int item_index;
+    jekv_blob_map_t *map;
+    jekv_blob_map_t *next;
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE];
+
+    /*create maps for all the descriptors*/
+    dl_list_for_each(it, &storage->sm.active, jekv_sector_t, list)
+    {
+        item_index = 0;
+
+        while (1) {
+            err = jekv_sector_find_item(it, JEKV_GROUP_ID_ANY, JEKV_TYPE_BLOB, NULL, &item_index, &item,
+                                        JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+            if (err != JEKV_ERR_OK) {
+                break;
+            }
+
+            if (jekv_sm_is_group_retired(&storage->sm, item.group_id)) {
+                /*left to GC*/
+                item_index += jekv_item_get_span(&item);
+                continue;
+            }
+
+            if (jekv_sector_read_blob_ver(it, item_index, &item, ver) == JEKV_ERR_OK &&
+                !blob_map_create(storage, it, item_index, &item, ver)) {
+                return JEKV_ERR_NO_MEM;
+            }
+
+            item_index += jekv_item_get_span(&item);
+        }
+    }
+
+    /*fill the segments in one pass*/
+    dl_list_for_each(it, &storage->sm.active, jekv_sector_t, list)
+    {
+        item_index = 0;
+
+        while (1) {
+            err = jekv_sector_find_item(it, JEKV_GROUP_ID_ANY, JEKV_TYPE_BLOB_SEG, NULL, &item_index, &item,
+                                        JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+            if (err != JEKV_ERR_OK) {
+                break;
+            }
+
+            dl_list_for_each(map, &storage->blob_maps, jekv_blob_map_t, list)
+            {
+                if (!strncmp(item.name, map->name, JEKV_MAX_KEY_LEN) && item.group_id == map->group_id &&
+                    jekv_blob_ver_match(map->ver, map->seg_count, &item)) {
+                    blob_map_set_seg(map, JEKV_ITEM_SEG_INDEX(&item), it, item_index, &item);
+                    break;
+                }
+            }
+
+            item_index += jekv_item_get_span(&item);
+        }
+    }
+
+    /*the incomplete ones are built when used*/
+    dl_list_for_each_safe(map, next, &storage->blob_maps, jekv_blob_map_t, list)
+    {
+        if (!blob_map_is_valid(map)) {
+            blob_map_delete(map);
+        }
+    }
+
+    jekv_log_debug("load blob maps, num=%d", dl_list_len(&storage->blob_maps));
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_blob_map_get(jekv_storage_t *storage, jekv_sector_t *sec, int index, jekv_item_t *desc,
+                      jekv_blob_map_t **map)
+{
+    jekv_blob_map_t *entry = NULL;
+    jekv_blob_map_t *next;
+
+    dl_list_for_each_safe(entry, next, &storage->blob_maps, jekv_blob_map_t, list)
+    {
+        if (entry->generation != entry->sec->generation) {
+            /*the descriptor is moved*/
+            blob_map_delete(entry);
+            continue;
+        }
+
+        if (entry->sec == sec && entry->index == index) {
+            if (blob_map_is_valid(entry)) {
+                *map = entry;
+                return JEKV_ERR_OK;
+            }
+
+            /*some segments are moved*/
+            blob_map_delete(entry);
+            break;
+        }
+    }
+
+    return blob_map_build(storage, sec, index, desc, map);
+}
+
+int jekv_blob_map_read(jekv_blob_map_t *map, int seg, uint32_t offset, void *data, uint32_t size)
+{
+    int err;
+    jekv_blob_seg_loc_t *loc = &map->segs[seg];
+    jekv_item_t item;
+
+    if (offset + size > loc->length) {
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    if (loc->length <= 8) {
+        /*data is in the item*/
+        err = jekv_pt_read_item(loc->sec->pt, loc->sec->address + (loc->index + 1) * JEKV_SLICE_SIZE, &item);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        memcpy(data, item.data + offset, size);
+        return JEKV_ERR_OK;
+    }
+
+    /*skip sector header and item itself*/
+    return jekv_pt_read(loc->sec->pt, loc->sec->address + (loc->index + 2) * JEKV_SLICE_SIZE + offset, data, size);
+}
+
+int jekv_blob_map_erase_segs(jekv_blob_map_t *map, const uint8_t *keep)
+{
+    jekv_blob_seg_loc_t *loc;
+    jekv_item_t seg;
+    int i;
+
+    for (i = 0; i < map->seg_count; i++) {
+        loc = &map->segs[i];
+
+        if (keep && JEKV_BLOB_SEG_VER(keep, i) == JEKV_BLOB_SEG_VER(map->ver, i)) {
+            /*referenced by the new descriptor*/
+            continue;
+        }
+
+        /*the span is calculated by the length*/
+        jekv_item_init(&seg, JEKV_ITEM_STATE_USING, map->group_id, (jekv_type_t)JEKV_TYPE_BLOB_SEG, map->name, NULL,
+                       loc->length, JEKV_BLOB_SEG_ID(map->ver, i));
+
+        jekv_log_debug("erase seg %.*s:%d ", JEKV_MAX_KEY_LEN, map->name, i);
+        jekv_sector_erase_item(loc->sec, loc->index, &seg, true);
+    }
+
+    return JEKV_ERR_OK;
+}
+
+void jekv_blob_map_remove(jekv_storage_t *storage, jekv_sector_t *sec, int index)
+{
+    jekv_blob_map_t *entry = NULL;
+
+    dl_list_for_each(entry, &storage->blob_maps, jekv_blob_map_t, list)
+    {
+        if (entry->sec == sec && entry->index == index) {
+            blob_map_delete(entry);
+            return;
+        }
+    }
+}
+
+void jekv_blob_map_remove_group(jekv_storage_t *storage, uint8_t group_id)
+{
+    jekv_blob_map_t *entry = NULL;
+    jekv_blob_map_t *next;
+
+    dl_list_for_each_safe(entry, next, &storage->blob_maps, jekv_blob_map_t, list)
+    {
+        if (entry->group_id == group_id) {
+            blob_map_delete(entry);
+        }
+    }
+}
+
+void jekv_blob_map_deinit(jekv_storage_t *storage)
+{
+    jekv_blob_map_t *entry = NULL;
+    jekv_blob_map_t *next;
+
+    dl_list_for_each_safe(entry, next, &storage->blob_maps, jekv_blob_map_t, list)
+    {
+        blob_map_delete(entry);
+    }
+}
+
+bool jekv_blob_ver_match(const uint8_t *ver, int seg_count, const jekv_item_t *seg)
+{
+    int i = JEKV_ITEM_SEG_INDEX(seg);
+
+    return i < seg_count && JEKV_BLOB_SEG_ID(ver, i) == seg->seg_id;
+}
+
+void jekv_blob_ver_next(const uint8_t *old, int old_count, uint8_t *ver)
+{
+    int i;
+
+    memset(ver, 0, JEKV_BLOB_VER_MAP_SIZE);
+
+    if (old_count == 0) {
+        return;
+    }
+
+    for (i = 0; i < JEKV_BLOB_SEG_NUM_MAX; i++) {
+        /*the segments after the old ones use the same version as the first one*/
+        jekv_blob_ver_set(ver, i, !JEKV_BLOB_SEG_VER(old, i < old_count ? i : 0));
+    }
+}
+
+void jekv_blob_ver_set(uint8_t *ver, int seg, int v)
+{
+    if (v) {
+        ver[seg / 8] |= 1 << (seg % 8);
+    } else {
+        ver[seg / 8] &= ~(1 << (seg % 8));
+    }
+}
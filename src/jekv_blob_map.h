@@ -0,0 +1,84 @@
+#ifndef __JEKV_BLOB_MAP_H__
+#define __JEKV_BLOB_MAP_H__
+
+#include <stdint.h>
+
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_item.h"
+#include "jekv_sector.h"
+#include "jekv_storage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Blob segment map: the location of every segment of a blob is kept in RAM, so the blob is read, compared
+    and erased without looking up the segments in every sector. A map is bound to the location of the blob
+    descriptor, a location is valid until its sector is erased (by GC), then the map is built again.
+*/
+
+/**
+  * @brief  blob segment location
+  */
+typedef struct {
+    jekv_sector_t *sec;  /**< sector of the segment           */
+    uint32_t generation; /**< erase count of the sector       */
+    uint32_t crc;        /**< crc32 for segment data          */
+    uint16_t length;     /**< segment data length             */
+    uint8_t index;       /**< slice index of the segment      */
+} jekv_blob_seg_loc_t;
+
+/**
+  * @brief  blob segment map
+  */
+typedef struct {
+    struct dl_list list;            /**< blob map link node             */
+    char name[JEKV_MAX_KEY_LEN];    /**< blob name                      */
+    uint8_t group_id;               /**< group id                       */
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE]; /**< segment version bits       */
+    uint16_t seg_count;             /**< segment count                  */
+    uint8_t index;                  /**< slice index of the descriptor  */
+    jekv_sector_t *sec;             /**< sector of the descriptor       */
+    uint32_t generation;            /**< erase count of the sector      */
+    jekv_blob_seg_loc_t segs[];     /**< segment locations              */
+} jekv_blob_map_t;
+
+/*build the maps of all the blobs, called at mount*/
+int jekv_blob_map_load(jekv_storage_t *storage);
+
+/*get the map of the blob descriptor, build it if not found or out of date*/
+int jekv_blob_map_get(jekv_storage_t *storage, jekv_sector_t *sec, int index, jekv_item_t *desc,
+                      jekv_blob_map_t **map);
+
+/*read a part of the segment data*/
+int jekv_blob_map_read(jekv_blob_map_t *map, int seg, uint32_t offset, void *data, uint32_t size);
+
+/*drop the segments of the map, except the ones of the same version in keep, which are shared with the new blob*/
+int jekv_blob_map_erase_segs(jekv_blob_map_t *map, const uint8_t *keep);
+
+/*remove the map of the blob descriptor*/
+void jekv_blob_map_remove(jekv_storage_t *storage, jekv_sector_t *sec, int index);
+
+/*remove the maps of the group*/
+void jekv_blob_map_remove_group(jekv_storage_t *storage, uint8_t group_id);
+
+void jekv_blob_map_deinit(jekv_storage_t *storage);
+
+/*check the segment belongs to the blob of the version bits*/
+bool jekv_blob_ver_match(const uint8_t *ver, int seg_count, const jekv_item_t *seg);
+
+/*
+    get the version bits of the new blob, every segment uses the version not used by the old one,
+    so the old blob is kept until the new descriptor is written.
+*/
+void jekv_blob_ver_next(const uint8_t *old, int old_count, uint8_t *ver);
+
+void jekv_blob_ver_set(uint8_t *ver, int seg, int v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
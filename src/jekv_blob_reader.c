@@ -0,0 +1,60 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_blob_r"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_blob_reader.h"
+#include "jekv_log.h"
+
+int jekv_blob_reader_info_create(jekv_handle_info_t *handle, const char *key, jekv_blob_reader_t *reader,
+                                 uint32_t *size)
+{
+    int err;
+    uint32_t len = 0;
+    jekv_blob_reader_info_t *r;
+
+    r = JEKV_CALLOC(1, sizeof(*r));
+    if (!r) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    r->handle    = handle;
+    r->handle_id = handle->id;
+    snprintf(r->key, sizeof(r->key), "%s", key);
+
+    /*read nothing, just locate the blob*/
+    err = jekv_storage_read_blob_range(handle->storage, handle->group_id, r->key, &r->cursor, 0, NULL, &len);
+    if (err != JEKV_ERR_OK) {
+        JEKV_FREE(r);
+        return err;
+    }
+
+    if (size) {
+        *size = r->cursor.all_size;
+    }
+
+    *reader = (jekv_blob_reader_t)r;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_blob_reader_info_read(jekv_blob_reader_info_t *reader, void *data, uint32_t *size)
+{
+    int err;
+    jekv_handle_info_t *h = reader->handle;
+
+    err = jekv_storage_read_blob_range(h->storage, h->group_id, reader->key, &reader->cursor, reader->offset, data, size);
+    if (err == JEKV_ERR_OK) {
+        reader->offset += *size;
+    }
+
+    return err;
+}
+
+int jekv_blob_reader_info_release(jekv_blob_reader_info_t *reader)
+{
+    JEKV_FREE(reader);
+
+    return JEKV_ERR_OK;
+}
@@ -0,0 +1,37 @@
+#ifndef __JEKV_BLOB_READER_H__
+#define __JEKV_BLOB_READER_H__
+
+#include <stdint.h>
+
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_storage.h"
+#include "jekv_handler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief  kv blob reader information structure
+  */
+typedef struct jekv_blob_reader_info_t {
+    jekv_handle_info_t *handle;      /**< handle the reader belongs to */
+    jekv_handle_t handle_id;         /**< id of the handle             */
+    char key[JEKV_MAX_KEY_LEN + 1];  /**< blob key                     */
+    uint32_t offset;                 /**< next read position           */
+    jekv_blob_cursor_t cursor;       /**< blob reading position        */
+} jekv_blob_reader_info_t;
+
+int jekv_blob_reader_info_create(jekv_handle_info_t *handle, const char *key, jekv_blob_reader_t *reader,
+                                 uint32_t *size);
+
+int jekv_blob_reader_info_read(jekv_blob_reader_info_t *reader, void *data, uint32_t *size);
+
+int jekv_blob_reader_info_release(jekv_blob_reader_info_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_blob_w"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_item.h"
+#include "jekv_blob_writer.h"
+#include "jekv_log.h"
+
+int jekv_blob_writer_info_create(jekv_handle_info_t *handle, const char *key, jekv_blob_writer_t *writer)
+{
+    int err;
+    jekv_blob_writer_info_t *w;
+
+    /*one segment is buffered after the writer*/
+    w = JEKV_CALLOC(1, sizeof(*w) + JEKV_SINGLE_ITEM_MAX_DATA_SIZE);
+    if (!w) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    w->handle    = handle;
+    w->handle_id = handle->id;
+
+    snprintf(w->stream.key, sizeof(w->stream.key), "%s", key);
+    w->stream.group_id = handle->group_id;
+    w->stream.buf      = (uint8_t *)(w + 1);
+
+    err = jekv_storage_blob_stream_open(handle->storage, &w->stream);
+    if (err != JEKV_ERR_OK) {
+        JEKV_FREE(w);
+        return err;
+    }
+
+    *writer = (jekv_blob_writer_t)w;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_blob_writer_info_write(jekv_blob_writer_info_t *writer, const void *data, uint32_t size)
+{
+    return jekv_storage_blob_stream_write(writer->handle->storage, &writer->stream, data, size);
+}
+
+int jekv_blob_writer_info_close(jekv_blob_writer_info_t *writer)
+{
+    return jekv_storage_blob_stream_close(writer->handle->storage, &writer->stream);
+}
+
+int jekv_blob_writer_info_abort(jekv_blob_writer_info_t *writer)
+{
+    return jekv_storage_blob_stream_abort(writer->handle->storage, &writer->stream);
+}
+
+int jekv_blob_writer_info_release(jekv_blob_writer_info_t *writer)
+{
+    JEKV_FREE(writer);
+
+    return JEKV_ERR_OK;
+}
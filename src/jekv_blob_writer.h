@@ -0,0 +1,39 @@
+#ifndef __JEKV_BLOB_WRITER_H__
+#define __JEKV_BLOB_WRITER_H__
+
+#include <stdint.h>
+
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_storage.h"
+#include "jekv_handler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief  kv blob writer information structure
+  */
+typedef struct jekv_blob_writer_info_t {
+    jekv_handle_info_t *handle; /**< handle the writer belongs to */
+    jekv_handle_t handle_id;    /**< id of the handle             */
+    jekv_blob_stream_t stream;  /**< blob stream writing state    */
+} jekv_blob_writer_info_t;
+
+int jekv_blob_writer_info_create(jekv_handle_info_t *handle, const char *key, jekv_blob_writer_t *writer);
+
+int jekv_blob_writer_info_write(jekv_blob_writer_info_t *writer, const void *data, uint32_t size);
+
+int jekv_blob_writer_info_close(jekv_blob_writer_info_t *writer);
+
+/*drop the written segments*/
+int jekv_blob_writer_info_abort(jekv_blob_writer_info_t *writer);
+
+int jekv_blob_writer_info_release(jekv_blob_writer_info_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
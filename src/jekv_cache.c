@@ -0,0 +1,252 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_cache"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_cache.h"
+#include "jekv_log.h"
+
+static void cache_free_entry(jekv_cache_t *cache, jekv_batch_op_t *op)
+{
+    cache->dirty_size -= op->size;
+
+    dl_list_del(&op->list);
+    JEKV_FREE(op);
+}
+
+int jekv_cache_config(jekv_storage_t *storage, uint32_t threshold, uint32_t interval_ms)
+{
+    int err             = JEKV_ERR_OK;
+    jekv_cache_t *cache = &storage->cache;
+
+    if (!cache->enabled) {
+        dl_list_init(&cache->entries);
+        cache->dirty_size = 0;
+    }
+
+    if (threshold == 0) {
+        /*disable, save the dirty items first*/
+        err = jekv_cache_flush(storage);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_cache_deinit(storage);
+        }
+    } else {
+        cache->threshold   = threshold;
+        cache->interval_ms = interval_ms;
+        cache->last_flush  = jekv_port_get_time_ms();
+        cache->enabled     = true;
+    }
+
+    jekv_log_debug("cache config, threshold=%u,interval=%u,err=%d", threshold, interval_ms, err);
+
+    return err;
+}
+
+int jekv_cache_flush(jekv_storage_t *storage)
+{
+    int err             = JEKV_ERR_OK;
+    jekv_cache_t *cache = &storage->cache;
+    jekv_batch_op_t *entry;
+    jekv_batch_op_t *next;
+    struct dl_list ops;
+    int slices;
+    int span;
+
+    if (!cache->enabled) {
+        return JEKV_ERR_OK;
+    }
+
+    cache->last_flush = jekv_port_get_time_ms();
+
+    while (!dl_list_empty(&cache->entries)) {
+        dl_list_init(&ops);
+        slices = 2;
+
+        /*move the entries to a batch until it is as large as a sector*/
+        dl_list_for_each_safe(entry, next, &cache->entries, jekv_batch_op_t, list)
+        {
+            span = jekv_storage_get_batch_span(entry);
+            if (slices + span > JEKV_ENTRY_COUNT && !dl_list_empty(&ops)) {
+                break;
+            }
+
+            slices += span;
+            dl_list_del(&entry->list);
+            dl_list_add_tail(&ops, &entry->list);
+        }
+
+        err = jekv_storage_write_batch(storage, &ops);
+        if (err != JEKV_ERR_OK) {
+            /*keep them dirty, try again in the next flush*/
+            jekv_log_error("cache flush fail, err=%d", err);
+
+            /*back to the head from the last one, so they are still written in order*/
+            while ((entry = dl_list_last(&ops, jekv_batch_op_t, list)) != NULL) {
+                dl_list_del(&entry->list);
+                dl_list_add(&cache->entries, &entry->list);
+            }
+            break;
+        }
+
+        dl_list_for_each_safe(entry, next, &ops, jekv_batch_op_t, list)
+        {
+            cache_free_entry(cache, entry);
+        }
+    }
+
+    jekv_log_debug("cache flush, left=%u,err=%d", cache->dirty_size, err);
+
+    return err;
+}
+
+int jekv_cache_check_timer(jekv_storage_t *storage)
+{
+    jekv_cache_t *cache = &storage->cache;
+
+    if (cache->enabled && cache->interval_ms > 0 && !dl_list_empty(&cache->entries) &&
+        jekv_port_get_time_ms() - cache->last_flush >= cache->interval_ms) {
+        return jekv_cache_flush(storage);
+    }
+
+    return JEKV_ERR_OK;
+}
+
+bool jekv_cache_fit(jekv_type_t type, uint32_t size)
+{
+    jekv_batch_op_t op = {.type = type, .size = size};
+
+    /*a batch is in one sector with the begin and commit records*/
+    return type != JEKV_TYPE_BLOB && 2 + jekv_storage_get_batch_span(&op) <= JEKV_ENTRY_COUNT;
+}
+
+jekv_batch_op_t *jekv_cache_find(jekv_storage_t *storage, uint8_t group_id, const char *key)
+{
+    jekv_batch_op_t *entry = NULL;
+
+    if (!storage->cache.enabled) {
+        return NULL;
+    }
+
+    dl_list_for_each(entry, &storage->cache.entries, jekv_batch_op_t, list)
+    {
+        if (entry->group_id == group_id && !jekv_item_key_cmp(entry->key, key)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+int jekv_cache_write(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key, const void *data,
+                     uint32_t size)
+{
+    jekv_cache_t *cache = &storage->cache;
+    jekv_batch_op_t *op = jekv_cache_find(storage, group_id, key);
+
+    if (!jekv_cache_fit(type, size)) {
+        return JEKV_ERR_VALUE_TOO_LONG;
+    }
+
+    if (op && op->size == size) {
+        /*update in place*/
+        op->type = type;
+        memcpy(op->data, data, size);
+    } else {
+        if (op) {
+            cache_free_entry(cache, op);
+        }
+
+        /*data is saved after the entry*/
+        op = JEKV_CALLOC(1, sizeof(*op) + size);
+        if (!op) {
+            return JEKV_ERR_NO_MEM;
+        }
+
+        jekv_item_key_copy(op->key, key);
+        op->group_id = group_id;
+        op->type     = type;
+        op->size     = size;
+        op->data     = (uint8_t *)(op + 1);
+        memcpy(op->data, data, size);
+
+        dl_list_add_tail(&cache->entries, &op->list);
+        cache->dirty_size += size;
+    }
+
+    if (cache->dirty_size >= cache->threshold) {
+        return jekv_cache_flush(storage);
+    }
+
+    return jekv_cache_check_timer(storage);
+}
+
+int jekv_cache_read(jekv_batch_op_t *op, jekv_type_t type, void *data, uint32_t *size)
+{
+    if (op->type != type) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    if (*size < op->size) {
+        *size = op->size;
+        return JEKV_ERR_VALUE_TOO_LONG;
+    }
+
+    *size = op->size;
+    memcpy(data, op->data, op->size);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_cache_remove(jekv_storage_t *storage, uint8_t group_id, const char *key)
+{
+    jekv_batch_op_t *op = jekv_cache_find(storage, group_id, key);
+
+    if (!op) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    cache_free_entry(&storage->cache, op);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_cache_remove_group(jekv_storage_t *storage, uint8_t group_id)
+{
+    jekv_batch_op_t *entry = NULL;
+    jekv_batch_op_t *next  = NULL;
+
+    if (!storage->cache.enabled) {
+        return JEKV_ERR_OK;
+    }
+
+    dl_list_for_each_safe(entry, next, &storage->cache.entries, jekv_batch_op_t, list)
+    {
+        if (entry->group_id == group_id) {
+            cache_free_entry(&storage->cache, entry);
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_cache_deinit(jekv_storage_t *storage)
+{
+    int err;
+    jekv_batch_op_t *entry = NULL;
+    jekv_batch_op_t *next  = NULL;
+
+    err = jekv_cache_flush(storage);
+
+    if (storage->cache.enabled) {
+        /*the items failed to be saved are dropped, the flush error is returned*/
+        dl_list_for_each_safe(entry, next, &storage->cache.entries, jekv_batch_op_t, list)
+        {
+            cache_free_entry(&storage->cache, entry);
+        }
+    }
+
+    storage->cache.enabled = false;
+
+    return err;
+}
@@ -0,0 +1,51 @@
+#ifndef __JEKV_CACHE_H__
+#define __JEKV_CACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_storage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Write back cache: keep the latest value of the non blob items in RAM, write them to flash in batches.
+    Each flush is written as one batch, so it is saved all or nothing. If the dirty items are larger than a sector,
+    they are split to several batches.
+*/
+
+/*threshold 0 disables the cache, the dirty items are flushed first*/
+int jekv_cache_config(jekv_storage_t *storage, uint32_t threshold, uint32_t interval_ms);
+
+int jekv_cache_flush(jekv_storage_t *storage);
+
+/*flush if the flush interval is reached*/
+int jekv_cache_check_timer(jekv_storage_t *storage);
+
+/*can the item be cached, the blobs and the items too large for a batch are written to flash directly*/
+bool jekv_cache_fit(jekv_type_t type, uint32_t size);
+
+jekv_batch_op_t *jekv_cache_find(jekv_storage_t *storage, uint8_t group_id, const char *key);
+
+int jekv_cache_write(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key, const void *data,
+                     uint32_t size);
+
+int jekv_cache_read(jekv_batch_op_t *op, jekv_type_t type, void *data, uint32_t *size);
+
+/*return JEKV_ERR_NOT_FOUND if the key is not cached*/
+int jekv_cache_remove(jekv_storage_t *storage, uint8_t group_id, const char *key);
+
+int jekv_cache_remove_group(jekv_storage_t *storage, uint8_t group_id);
+
+/*flush and disable, the dirty items failed to be saved are dropped and the flush error is returned*/
+int jekv_cache_deinit(jekv_storage_t *storage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
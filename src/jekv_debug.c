@@ -68,6 +68,25 @@ int jekv_debug_print_status(const char *partition_name)
     return err;
 }
 
+int jekv_debug_compact(const char *partition_name)
+{
+    jekv_compact_stat_t stat;
+    int err;
+
+    err = jekv_compact(partition_name, &stat);
+    if (err == JEKV_ERR_OK) {
+        jekv_log_error("reclaimed_slices=%u", stat.reclaimed_slices);
+        jekv_log_error("written_bytes=%u", stat.written_bytes);
+        jekv_log_error("erased_sectors=%u", stat.erased_sectors);
+        jekv_log_error("idle_sectors=%u", stat.idle_sectors);
+        jekv_log_error("elapsed_ms=%u", stat.elapsed_ms);
+    } else {
+        jekv_log_error("compact err=%d", err);
+    }
+
+    return err;
+}
+
 static int jekv_debug_jekv_get_user_id(jekv_handle_t handle)
 {
     int ret = -1;
@@ -88,9 +107,10 @@ int jekv_debug_print_storage(int storage_detail, int sec_detail)
     jekv_sector_t *sec;
     jekv_group_t *group;
     jekv_handle_info_t *hinfo = NULL;
+    uint32_t handle_count;
 
-    struct dl_list *storage     = jekv_get_storage_list();
-    struct dl_list *handle_list = jekv_get_handle_list();
+    struct dl_list *storage   = jekv_get_storage_list();
+    jekv_handle_info_t *table = jekv_get_handle_table(&handle_count);
 
     if (dl_list_empty(storage)) {
         jekv_log_error("%s","Not init!");
@@ -105,7 +125,8 @@ int jekv_debug_print_storage(int storage_detail, int sec_detail)
 
         if (storage_detail) {
             jekv_log_error("active : %d", dl_list_len(&it->sm.active));
-            jekv_log_error("idle : %d\r\n", dl_list_len(&it->sm.idle));
+            jekv_log_error("idle : %d", dl_list_len(&it->sm.idle));
+            jekv_log_error("rings : %d\r\n", dl_list_len(&it->sm.rings));
             jekv_log_error("serial_number %u", it->sm.serial_number);
 
             jekv_debug_print_status(it->pt.name);
@@ -117,13 +138,12 @@ int jekv_debug_print_storage(int storage_detail, int sec_detail)
             {
                 JEKV_RAWE("group id=%02d : %s\r\n", group->id, group->name);
 
-                dl_list_for_each(hinfo, handle_list, jekv_handle_info_t, list)
-                {
-                    int use_id = jekv_debug_jekv_get_user_id((jekv_handle_t)hinfo);
+                for (uint32_t i = 0; i < handle_count; i++) {
+                    hinfo = &table[i];
 
-                    if (hinfo->group_id == group->id) {
-                        JEKV_RAWE("   handle %p: valid=%d,mode=%d, user_id=%d\r\n", hinfo, hinfo->valid, hinfo->mode,
-                                        use_id);
+                    if (hinfo->id && hinfo->storage == it && hinfo->group_id == group->id) {
+                        JEKV_RAWE("   handle %p: slot=%u,mode=%d, user_id=%d\r\n", hinfo->id, i, hinfo->mode,
+                                        jekv_debug_jekv_get_user_id(hinfo->id));
                     }
                 }
             }
@@ -170,16 +190,19 @@ int jekv_debug_print_handle(void)
 {
     jekv_handle_info_t *it;
     int cnt = 0;
-    struct dl_list *handle_list;
+    uint32_t handle_count;
+    jekv_handle_info_t *table;
 
-    handle_list = jekv_get_handle_list();
+    table = jekv_get_handle_table(&handle_count);
 
-    JEKV_RAWE("handler list:\r\n");
+    JEKV_RAWE("handler table:\r\n");
 
-    dl_list_for_each(it, handle_list, jekv_handle_info_t, list)
-    {
-        JEKV_RAWE("handler %d,%p: pt=%s, group_id=%d,valid=%d,mode=%d\r\n", cnt++, it, it->storage->pt.name, it->group_id,
-                        it->valid, it->mode);
+    for (uint32_t i = 0; i < handle_count; i++) {
+        it = &table[i];
+        if (it->id) {
+            JEKV_RAWE("handler %d,%p: pt=%s, group_id=%d,slot=%u,mode=%d\r\n", cnt++, it->id, it->storage->pt.name,
+                            it->group_id, i, it->mode);
+        }
     }
 
     return JEKV_ERR_OK;
@@ -248,9 +271,10 @@ int jekv_debug_clear_partiton_handle(const char *partition)
     jekv_handle_info_t *info;
 
     for (int i = 0; i < JEKV_DEBUG_HANDLER_NUM; i++) {
-        info = (jekv_handle_info_t *)g_cmd_handle[i];
-        if (info) {
-            if (!strcmp(info->storage->pt.name, partition)) {
+        info = jekv_ptm_get_handle(g_cmd_handle[i]);
+        if (g_cmd_handle[i]) {
+            /*the closed handles are cleared too*/
+            if (!info || !strcmp(info->storage->pt.name, partition)) {
                 jekv_log_debug("clear %d", i);
                 g_cmd_handle[i] = NULL;
             }
@@ -720,6 +744,9 @@ void jekv_debug_cmd(int argc, char *argv[])
     } else if (argc == 3 && !strcmp(argv[1], "status")) {
         jekv_debug_print_status(argv[2]);
 
+    } else if (argc == 3 && !strcmp(argv[1], "compact")) {
+        jekv_debug_compact(argv[2]);
+
     } else {
         goto usage;
     }
@@ -747,6 +774,7 @@ usage:
                     "  del group      : kv delgroup <handle_index> \n"
                     "  dump sector    : kv dump     <partition> <sec_index> <size>\n"
                     "  status         : kv status\n"
+                    "  compact        : kv compact  <partition>\n"
                     "  debug          : kv debug\n");
 
     return;
@@ -15,6 +15,8 @@ enum {
     JEKV_TRACE_TYPE_WRITE,
     JEKV_TRACE_TYPE_BLOB,
     JEKV_TRACE_TYPE_GC,
+    JEKV_TRACE_TYPE_BATCH,
+    JEKV_TRACE_TYPE_REWRITE,
 };
 
 /*power off stage for normal write type*/
@@ -39,9 +41,23 @@ enum {
     JEKV_TRACE_GC_4_ERASE_OLD,
 };
 
+/*power off stage for batch write*/
+enum {
+    JEKV_TRACE_BATCH_BEFORE_COMMIT,
+    JEKV_TRACE_BATCH_AFTER_COMMIT,
+    JEKV_TRACE_BATCH_AFTER_DROP_OLD,
+};
+
+/*power off stage for rewrite in place*/
+enum {
+    JEKV_TRACE_REWRITE_AFTER_CRC,
+    JEKV_TRACE_REWRITE_AFTER_VALUE,
+};
+
 int jekv_debug_print_sector(const char *partition_name, int index, int size);
 
 int jekv_debug_print_status(const char *partition_name);
+int jekv_debug_compact(const char *partition_name);
 
 int jekv_debug_print_storage(int storage_detail, int sec_detail);
 
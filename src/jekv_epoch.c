@@ -0,0 +1,85 @@
+#include "jekv_porting.h"
+#include "jekv_epoch.h"
+
+#if CONFIG_JEKV_EPOCH_READ
+
+#define EPOCH_LINE_SIZE 64
+
+/**
+  * @brief  reader slot, a cache line
+  */
+typedef struct {
+    uint32_t readers[2];                             /**< readers in the epoch, by the parity of the epoch entered */
+    uint8_t reserved[EPOCH_LINE_SIZE - 2 * sizeof(uint32_t)];
+} epoch_slot_t;
+
+static epoch_slot_t g_epoch_slots[CONFIG_JEKV_EPOCH_SLOTS] __attribute__((aligned(EPOCH_LINE_SIZE)));
+
+static uint32_t g_epoch;      /**< bumped by every synchronization */
+static uint32_t g_epoch_lock; /**< one synchronization at a time */
+
+uint32_t jekv_epoch_enter(void)
+{
+    uint32_t slot   = jekv_port_thread_id() % CONFIG_JEKV_EPOCH_SLOTS;
+    uint32_t parity = __atomic_load_n(&g_epoch, __ATOMIC_SEQ_CST) & 1;
+
+    /*the writer marking later sees the reader, or the reader sees the mark*/
+    __atomic_add_fetch(&g_epoch_slots[slot].readers[parity], 1, __ATOMIC_SEQ_CST);
+
+    return (slot << 1) | parity;
+}
+
+void jekv_epoch_leave(uint32_t slot)
+{
+    __atomic_sub_fetch(&g_epoch_slots[slot >> 1].readers[slot & 1], 1, __ATOMIC_RELEASE);
+}
+
+/*wait for the readers entered with the parity to leave*/
+static void epoch_wait_readers(uint32_t parity)
+{
+    uint32_t i;
+
+    for (i = 0; i < CONFIG_JEKV_EPOCH_SLOTS; i++) {
+        while (__atomic_load_n(&g_epoch_slots[i].readers[parity], __ATOMIC_SEQ_CST)) {
+            jekv_port_yield();
+        }
+    }
+}
+
+void jekv_epoch_synchronize(void)
+{
+    uint32_t parity;
+
+    while (__atomic_exchange_n(&g_epoch_lock, 1, __ATOMIC_ACQUIRE)) {
+        jekv_port_yield();
+    }
+
+    parity = __atomic_load_n(&g_epoch, __ATOMIC_SEQ_CST) & 1;
+
+    /*
+        a reader reading the epoch before the last bump may count itself in the old parity after it was waited for,
+        it is waited for before the parity is used again
+    */
+    epoch_wait_readers(parity ^ 1);
+
+    /*the readers entering from now on are counted in the other parity, they are not waited for*/
+    __atomic_add_fetch(&g_epoch, 1, __ATOMIC_SEQ_CST);
+
+    epoch_wait_readers(parity);
+
+    __atomic_store_n(&g_epoch_lock, 0, __ATOMIC_RELEASE);
+}
+
+void jekv_epoch_write_begin(uint32_t *mark)
+{
+    __atomic_store_n(mark, 1, __ATOMIC_SEQ_CST);
+
+    jekv_epoch_synchronize();
+}
+
+void jekv_epoch_write_end(uint32_t *mark)
+{
+    __atomic_store_n(mark, 0, __ATOMIC_RELEASE);
+}
+
+#endif
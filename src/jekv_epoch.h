@@ -0,0 +1,72 @@
+#ifndef __JEKV_EPOCH_H__
+#define __JEKV_EPOCH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "jekv_porting.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Epoch read: a get looks up the handle and the sector index without taking a lock. The reader counts itself in
+    the reader slot of its thread, each slot is a cache line of its own so the readers don't share a written line.
+    A writer marks the storage, then waits for the readers in the slots to leave before it changes anything, so
+    the index is not changed and the sectors are not erased or reused under a reader. A reader finding the storage
+    marked leaves and takes the storage lock instead.
+    The writer bumps the epoch and waits for the readers entered before only, each slot counts the readers by the
+    parity of the epoch they entered, so the readers entering all the time don't hold the writer.
+    The slots and the marks are GCC atomics.
+*/
+#ifndef CONFIG_JEKV_EPOCH_READ
+#define CONFIG_JEKV_EPOCH_READ 0
+#endif
+
+/*reader slots, the threads of the same slot share its counter*/
+#ifndef CONFIG_JEKV_EPOCH_SLOTS
+#define CONFIG_JEKV_EPOCH_SLOTS 16
+#endif
+
+#if CONFIG_JEKV_EPOCH_SLOTS < 1 || CONFIG_JEKV_EPOCH_SLOTS > 256
+#error "CONFIG_JEKV_EPOCH_SLOTS out of range"
+#endif
+
+#if CONFIG_JEKV_EPOCH_READ
+
+/*the pointers read by the readers without a lock are published and read with these*/
+#define JEKV_EPOCH_LOAD(ptr)       __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define JEKV_EPOCH_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+
+/*enter the epoch, give the slot and the parity returned back to leave*/
+uint32_t jekv_epoch_enter(void);
+
+void jekv_epoch_leave(uint32_t slot);
+
+/*wait for the readers entered before to leave*/
+void jekv_epoch_synchronize(void);
+
+/*mark: the storage is written, the readers entered before are waited for*/
+void jekv_epoch_write_begin(uint32_t *mark);
+
+void jekv_epoch_write_end(uint32_t *mark);
+
+/*is the storage of the mark written, the reader is in the epoch*/
+inline static bool jekv_epoch_is_written(uint32_t *mark)
+{
+    return __atomic_load_n(mark, __ATOMIC_SEQ_CST) != 0;
+}
+
+#else
+
+#define JEKV_EPOCH_LOAD(ptr)       (*(ptr))
+#define JEKV_EPOCH_STORE(ptr, val) (*(ptr) = (val))
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
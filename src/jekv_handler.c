@@ -1,23 +1,22 @@
 #include "jekv_handler.h"
 
-int jekv_handler_open(jekv_storage_t *storage, uint8_t group_id, jekv_open_mode_t mode, jekv_handle_info_t **handle)
+int jekv_handler_open(jekv_handle_info_t *handle, jekv_handle_t id, jekv_storage_t *storage, uint8_t group_id,
+                      jekv_open_mode_t mode)
 {
-    jekv_handle_info_t *ctx = JEKV_CALLOC(1, sizeof(*ctx));
-    if (ctx) {
-        dl_list_init(&ctx->list);
-        ctx->storage  = storage;
-        ctx->group_id = group_id;
-        ctx->mode     = mode;
-        ctx->valid    = 1;
-        *handle       = ctx;
-        return JEKV_ERR_OK;
-    } else {
-        return JEKV_ERR_NO_MEM;
-    }
+    JEKV_EPOCH_STORE(&handle->storage, storage);
+    handle->group_id = group_id;
+    handle->mode     = mode;
+
+    /*the epoch readers match the id, it is set last*/
+    JEKV_EPOCH_STORE(&handle->id, id);
+    return JEKV_ERR_OK;
 }
 
 int jekv_handler_close(jekv_handle_info_t *handle)
 {
-    JEKV_FREE(handle);
+    JEKV_EPOCH_STORE(&handle->id, NULL);
+    JEKV_EPOCH_STORE(&handle->storage, NULL);
+    handle->group_id = 0;
+    handle->mode     = (jekv_open_mode_t)0;
     return JEKV_ERR_OK;
 }
@@ -15,14 +15,15 @@ extern "C" {
   * @brief  kv open handle information structure
   */
 typedef struct jekv_handle_info_t {
-    struct dl_list list;       /**< handle list         */
+    jekv_handle_t id;          /**< handle given to the user, NULL if the slot is free */
     jekv_storage_t *storage;   /**< storage information */
     uint8_t group_id;          /**< group id            */
-    uint8_t valid;             /**< handle is valid     */
     jekv_open_mode_t mode;     /**< open mode           */
 } jekv_handle_info_t;
 
-int jekv_handler_open(jekv_storage_t *storage, uint8_t group_id, jekv_open_mode_t mode, jekv_handle_info_t **handle);
+/*fill the free slot of the handle table, id is the handle given to the user*/
+int jekv_handler_open(jekv_handle_info_t *handle, jekv_handle_t id, jekv_storage_t *storage, uint8_t group_id,
+                      jekv_open_mode_t mode);
 int jekv_handler_close(jekv_handle_info_t *handle);
 
 #ifdef __cplusplus
@@ -21,7 +21,7 @@ int jekv_hash_append(jekv_hash_t *h, const jekv_item_t *item, uint32_t index)
     int new_num;
 
     /*full*/
-    if (h->count >= JEKV_ENTRY_COUNT) {
+    if (h->count >= JEKV_HASH_NODE_MAX) {
         return JEKV_ERR_NO_SPACE;
     }
 
@@ -39,6 +39,7 @@ int jekv_hash_append(jekv_hash_t *h, const jekv_item_t *item, uint32_t index)
     /*add to last*/
     h->hash_table[h->count].hash = jekv_item_crc_hash(item);
     h->hash_table[h->count].id   = (uint8_t)index;
+    h->groups |= (uint64_t)1 << item->group_id;
 
     jekv_log_debug("insert %.*s --> %d", JEKV_MAX_KEY_LEN, item->name, h->count);
 
@@ -47,22 +48,44 @@ int jekv_hash_append(jekv_hash_t *h, const jekv_item_t *item, uint32_t index)
     return JEKV_ERR_OK;
 }
 
+static void hash_remove(jekv_hash_t *h, int i)
+{
+    /*Not the last one*/
+    if (i != h->count - 1) {
+        /* Move the following items to the front , keep the index order*/
+        memmove(&h->hash_table[i], &h->hash_table[i + 1], (h->count - i - 1) * sizeof(jekv_hash_node_t));
+    }
+
+    h->count--;
+
+    jekv_log_debug("erase %d", i);
+}
+
 int jekv_hash_erase(jekv_hash_t *h, const uint32_t index)
 {
     int i;
 
     for (i = 0; i < h->count; i++) {
         if (h->hash_table[i].index == index) {
-            /*Not the last one*/
-            if (i != h->count - 1) {
-                /* Move the following items to the front , keep the index order*/
-                memcpy(&h->hash_table[i], &h->hash_table[i + 1], (h->count - i - 1) * sizeof(jekv_hash_node_t));
-            }
+            hash_remove(h, i);
+            return JEKV_ERR_OK;
+        }
+    }
 
-            h->count--;
+    return JEKV_ERR_NOT_FOUND;
+}
 
-            jekv_log_debug("erase %d", i);
+/*erase the node of the item at the index, the records of a packed item share its index*/
+int jekv_hash_erase_item(jekv_hash_t *h, const jekv_item_t *item, uint32_t index)
+{
+    int i;
+    uint32_t crc;
 
+    crc = jekv_item_crc_hash(item) & 0xffffff;
+
+    for (i = 0; i < h->count; i++) {
+        if (h->hash_table[i].index == index && h->hash_table[i].hash == crc) {
+            hash_remove(h, i);
             return JEKV_ERR_OK;
         }
     }
@@ -96,5 +119,8 @@ void jekv_hash_clear(jekv_hash_t *h)
         JEKV_FREE(h->hash_table);
         memset(h, 0, sizeof(*h));
     }
+
+    h->groups = 0;
+
     return;
 }
@@ -12,6 +12,9 @@ extern "C" {
 
 #define JEKV_HASH_INVALID -1
 
+/*nodes of a sector, every item or record of the packed items has a node, a record takes 5 bytes at least*/
+#define JEKV_HASH_NODE_MAX (JEKV_SECTOR_SIZE / 4)
+
 /**
   * @brief  kv hash table node
   */
@@ -31,13 +34,15 @@ typedef union {
   */
 typedef struct {
     jekv_hash_node_t *hash_table; /**< hash table array */
-    uint8_t count;                /**< item entry num   */
-    uint8_t size;                 /**< hash table size  */
+    uint16_t count;               /**< item entry num   */
+    uint16_t size;                /**< hash table size  */
+    uint64_t groups;              /**< bits of the group ids appended, kept until cleared */
 } jekv_hash_t;
 
 int jekv_hash_init(jekv_hash_t *h);
 int jekv_hash_append(jekv_hash_t *h, const jekv_item_t *item, uint32_t index);
 int jekv_hash_erase(jekv_hash_t *h, const uint32_t index);
+int jekv_hash_erase_item(jekv_hash_t *h, const jekv_item_t *item, uint32_t index);
 int jekv_hash_find(jekv_hash_t *h, uint32_t start, const jekv_item_t *item);
 void jekv_hash_clear(jekv_hash_t *h);
 
@@ -17,12 +17,104 @@ int jekv_item_get_span(jekv_item_t *item)
         span += (item->length + (JEKV_SLICE_SIZE - 1)) / JEKV_SLICE_SIZE;
     }
 
+    if (JEKV_ITEM_IS_REWRITE(item)) {
+        /*rewrite slice*/
+        span++;
+    }
+
     return span;
 }
 
+void jekv_item_make_id_key(char *key, uint32_t id)
+{
+    int i;
+
+    memset(key, 0, JEKV_MAX_KEY_LEN + 1);
+
+    for (i = 0; i < (int)sizeof(id); i++) {
+        key[1 + i] = (char)(id >> (i * 8));
+    }
+}
+
+uint32_t jekv_item_get_key_id(const char *key)
+{
+    const uint8_t *p = (const uint8_t *)key + 1;
+
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int jekv_item_key_len(const char *key)
+{
+    return JEKV_KEY_IS_ID(key) ? JEKV_KEY_ID_LEN : strnlen(key, JEKV_MAX_KEY_LEN);
+}
+
+void jekv_item_key_copy(char *dst, const char *key)
+{
+    int key_len = jekv_item_key_len(key);
+
+    memcpy(dst, key, key_len);
+    dst[key_len] = 0;
+}
+
+int jekv_item_key_cmp(const char *a, const char *b)
+{
+    int key_len = jekv_item_key_len(a);
+
+    if (key_len != jekv_item_key_len(b)) {
+        return 1;
+    }
+
+    return memcmp(a, b, key_len);
+}
+
+bool jekv_item_match(const jekv_item_t *item, uint8_t group_id, jekv_type_t type, const char *key, uint8_t seg_index,
+                     jekv_seg_start_t seg_start)
+{
+    int key_len = key ? jekv_item_key_len(key) : 0;
+
+    return item->state == JEKV_ITEM_STATE_USING && (group_id == JEKV_GROUP_ID_ANY || group_id == item->group_id) &&
+           ((type == JEKV_TYPE_ANY || type == item->type) ||
+            (type == JEKV_TYPE_ANY_WITHOUT_SEG && item->type != JEKV_TYPE_BLOB_SEG)) &&
+           (seg_index == JEKV_SEG_ID_ANY ? !(key && JEKV_ITEM_IS_DELTA(item)) : seg_index == item->seg_id) &&
+           (seg_start == JEKV_SEG_START_ANY || (item->seg_id >= seg_start && item->seg_id - seg_start < 0x80)) &&
+           (!key || (JEKV_KEY_IS_ID(key) ? !memcmp(item->name, key, key_len) : !strncmp(item->name, key, key_len)));
+}
+
+/*the descriptor has an extension if the segments are of different versions*/
+int jekv_item_get_blob_desc_span(const uint8_t *ver, int seg_count)
+{
+    int i;
+
+    for (i = 1; i < seg_count; i++) {
+        if (JEKV_BLOB_SEG_VER(ver, i) != JEKV_BLOB_SEG_VER(ver, 0)) {
+            return 1 + (JEKV_BLOB_EXT_SIZE(seg_count) + JEKV_SLICE_SIZE - 1) / JEKV_SLICE_SIZE;
+        }
+    }
+
+    return 1;
+}
+
+/*the attribute bits are not hashed, the key is found by the item inited without them*/
 uint32_t jekv_item_crc_hash(const jekv_item_t *item)
 {
-    return jekv_port_crc32(UINT32_MAX, &item->name, sizeof(item->name) + 2);
+    uint8_t id[2] = {item->group_id, item->seg_id};
+    uint32_t crc;
+
+    if (JEKV_KEY_IS_ID(item->name)) {
+        /*murmur3 finalizer of the integer key*/
+        crc = jekv_item_get_key_id(item->name) ^ ((uint32_t)item->group_id << 24) ^ ((uint32_t)item->seg_id << 16);
+        crc ^= crc >> 16;
+        crc *= 0x85ebca6b;
+        crc ^= crc >> 13;
+        crc *= 0xc2b2ae35;
+        crc ^= crc >> 16;
+
+        return crc;
+    }
+
+    crc = jekv_port_crc32(UINT32_MAX, &item->name, sizeof(item->name));
+
+    return jekv_port_crc32(crc, id, sizeof(id));
 }
 
 uint32_t jekv_item_crc_head(const jekv_item_t *item)
@@ -30,7 +122,11 @@ uint32_t jekv_item_crc_head(const jekv_item_t *item)
     uint32_t crc;
 
     crc = jekv_port_crc32(UINT32_MAX, &item->name, sizeof(item->name) + 4);
-    crc = jekv_port_crc32(crc, &item->data, 8);
+
+    /*the value of rewritable item changes in place*/
+    if (!JEKV_ITEM_IS_REWRITE(item)) {
+        crc = jekv_port_crc32(crc, &item->data, 8);
+    }
 
     return crc;
 }
@@ -39,7 +135,7 @@ uint32_t jekv_item_crc_head(const jekv_item_t *item)
 int jekv_item_init(jekv_item_t *item, uint8_t state, uint8_t group_id, jekv_type_t type, const char *key,
                      const void *data, int size, uint8_t seg_id)
 {
-    int key_len = strnlen(key, JEKV_MAX_KEY_LEN);
+    int key_len = jekv_item_key_len(key);
 
     memset(item, 0xff, sizeof(*item));
 
@@ -85,7 +181,7 @@ void jekv_item_print_item_head(jekv_item_t *item)
 
     if (item->type == JEKV_TYPE_BLOB) {
         jekv_log_debug("all_size=0x%x", item->all_size);
-        jekv_log_debug("seg_count=0x%x", item->seg_count);
+        jekv_log_debug("seg_count=0x%x", JEKV_ITEM_BLOB_SEG_COUNT(item));
         jekv_log_debug("seg_start=0x%x", item->seg_start);
     }
 
@@ -2,6 +2,7 @@
 #define __JEKV_ITEM_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "jekv_base.h"
 #include "jekv_porting.h"
 
@@ -14,6 +15,7 @@ extern "C" {
 #define JEKV_ENTRY_COUNT               (JEKV_SLICE_NUM - 1)
 
 #define JEKV_SECTOR_STATE_OFF_SET      2
+#define JEKV_SECTOR_MERGED_OFF_SET     3
 
 #define JEKV_SINGLE_ITEM_MAX_DATA_SIZE ((JEKV_ENTRY_COUNT - 1) * JEKV_SLICE_SIZE)
 #define JEKV_ENTRY_DATA_OFFSET         JEKV_SLICE_SIZE
@@ -23,13 +25,75 @@ extern "C" {
 #define JEKV_GROUP_ITSELF_ID           0x0                 /* id for group itself  */
 
 #define JEKV_SEG_ID_ANY                0xff /* Not use as valid seg id    */
-#define JEKV_SEG_NUM_MAX               127
+#define JEKV_SEG_NUM_MAX               127  /* segments of one seg id page */
+
+/*seg id pages of a blob, the seg ids are reused in every page of JEKV_SEG_NUM_MAX segments*/
+#ifndef CONFIG_JEKV_BLOB_SEG_PAGE_NUM
+#define CONFIG_JEKV_BLOB_SEG_PAGE_NUM  8
+#endif
+
+#if CONFIG_JEKV_BLOB_SEG_PAGE_NUM < 1 || CONFIG_JEKV_BLOB_SEG_PAGE_NUM > 253
+#error "CONFIG_JEKV_BLOB_SEG_PAGE_NUM out of range"
+#endif
+
+#define JEKV_BLOB_SEG_NUM_MAX          (JEKV_SEG_NUM_MAX * CONFIG_JEKV_BLOB_SEG_PAGE_NUM)
+
+/*the segments out of the first page keep the page after crc_data, their data can't be in the item*/
+#define JEKV_BLOB_PAGE_SEG_MIN_SIZE    9
+
+/*data slices of a counter, every bit of them is an increment*/
+#ifndef CONFIG_JEKV_COUNTER_SLICE_NUM
+#define CONFIG_JEKV_COUNTER_SLICE_NUM  3
+#endif
+
+#if CONFIG_JEKV_COUNTER_SLICE_NUM < 1 || CONFIG_JEKV_COUNTER_SLICE_NUM > JEKV_ENTRY_COUNT - 1
+#error "CONFIG_JEKV_COUNTER_SLICE_NUM out of range"
+#endif
+
+#define JEKV_COUNTER_BITS_SIZE         (CONFIG_JEKV_COUNTER_SLICE_NUM * JEKV_SLICE_SIZE)
+
+/*item attribute bits, saved in recv1*/
+#define JEKV_ITEM_ATTR_REWRITE         0x1 /* value is rewritten in place, followed by a rewrite slice */
+#define JEKV_ITEM_ATTR_LZ              0x2 /* value is compressed, raw_length is the value size         */
+
+#define JEKV_REWRITE_SLOT_NUM          7   /* crc slots of the rewrite slice */
+
+/*field deltas of a record read after the record, a full record is written when they reach it*/
+#ifndef CONFIG_JEKV_RECORD_DELTA_MAX
+#define CONFIG_JEKV_RECORD_DELTA_MAX   8
+#endif
+
+#if CONFIG_JEKV_RECORD_DELTA_MAX < 1 || CONFIG_JEKV_RECORD_DELTA_MAX > 64
+#error "CONFIG_JEKV_RECORD_DELTA_MAX out of range"
+#endif
+
+#define JEKV_RECORD_SEQ_MAX            0xfe /* delta sequence is the seg id, JEKV_SEG_ID_ANY is the record */
+#define JEKV_RECORD_DELTA_HEAD_SIZE    3    /* generation and little endian field offset */
 
 /**
   * @brief  kv type internal
   */
 #define JEKV_TYPE_BLOB_SEG             JEKV_TYPE_MAX       /**< BLOB data segment */
 #define JEKV_TYPE_ANY_WITHOUT_SEG      (JEKV_TYPE_MAX + 1) /**< Type any and not exclude blog segment */
+#define JEKV_TYPE_BATCH                (JEKV_TYPE_MAX + 2) /**< batch record, the kind is saved in seg_id */
+#define JEKV_TYPE_PACK                 JEKV_TYPE_ANY       /**< packed small items, type any is never saved */
+
+/**
+  * @brief  batch record kind
+  */
+typedef enum {
+    JEKV_BATCH_REC_BEGIN  = 0x0, /* batch start, data: op count and slice span  */
+    JEKV_BATCH_REC_COMMIT = 0x1, /* batch commit marker, follow the last op     */
+    JEKV_BATCH_REC_DEL    = 0x2, /* delete the key after commit                 */
+} jekv_batch_rec_t;
+
+/*
+    name of the BEGIN and COMMIT records, they are found by the type and the kind only. It must not be empty:
+    an empty key starts with 0 and would be read as an integer key of JEKV_KEY_ID_LEN bytes.
+*/
+#define JEKV_BATCH_REC_NAME "batch"
+
+typedef char jekv_batch_rec_name_check_t[sizeof(JEKV_BATCH_REC_NAME) > 1 ? 1 : -1];
 
 /**
   * @brief  kv item state
@@ -65,23 +129,144 @@ typedef struct {
             uint32_t all_size; /**< for blob segs all size     */
             uint8_t seg_count; /**< for blob desc      */
             uint8_t seg_start; /**< for seg start      */
-            uint16_t resv2;
+            uint8_t seg_count_hi; /**< segment count high byte, inverted */
+            uint8_t resv2;
         };
 
         struct {               /**< string(len > 8) or blob data   */
             uint32_t crc_data; /**< for data                       */
-            uint32_t resv3;
+            uint8_t seg_page;  /**< blob segment page, inverted    */
+            uint8_t resv3;
+            uint16_t raw_length; /**< value size of compressed item */
+        };
+
+        struct {                 /**< record of field deltas       */
+            uint32_t resv5;      /**< crc_data                     */
+            uint8_t rec_gen;     /**< delta generation, inverted   */
+            uint8_t rec_folded;  /**< folded delta count, inverted */
+            uint16_t resv6;
+        };
+
+        struct {                 /**< counter                      */
+            uint32_t count_base; /**< value before the cleared bits */
+            uint32_t resv4;
         };
+
         uint8_t data[8]; /**< primitive data or (string <= 8) */
     };
 } jekv_item_t;
 
+/*
+    rewrite slice, the last slice of a rewritable item. Every version of the value programmed in place
+    takes a crc slot: the crc is written first, then the value, then the commit bit of the slot is cleared.
+    The slot 0 is the crc of the value written with the item.
+*/
+typedef struct {
+    uint32_t crc[JEKV_REWRITE_SLOT_NUM]; /**< crc32 of the value versions        */
+    uint8_t commit;                      /**< commit bits, cleared for each slot */
+    uint8_t resv[3];
+} jekv_item_rewrite_t;
+
+#define JEKV_BLOB_VER_MAP_SIZE ((JEKV_BLOB_SEG_NUM_MAX + 7) / 8)
+
+/*
+    blob descriptor extension, written after the descriptor when its segments are of different versions,
+    the seg_start of the descriptor is JEKV_SEG_START_ANY then. It is the version bits (1: JEKV_SEG_START_VER_1)
+    of the segments followed by the crc32 of them, the bits of the first page are always saved.
+*/
+#define JEKV_BLOB_EXT_SIZE(seg_count)                                                                          \
+    (((seg_count) > JEKV_SEG_NUM_MAX ? ((seg_count) + 7) / 8 : (JEKV_SEG_NUM_MAX + 7) / 8) + sizeof(uint32_t))
+
+/*version, seg id and page of the segment i in the version bits*/
+#define JEKV_BLOB_SEG_VER(ver, i)  (((ver)[(i) / 8] >> ((i) % 8)) & 1)
+#define JEKV_BLOB_SEG_ID(ver, i)   ((JEKV_BLOB_SEG_VER(ver, i) ? JEKV_SEG_START_VER_1 : JEKV_SEG_START_VER_0) + \
+                                    (i) % JEKV_SEG_NUM_MAX)
+#define JEKV_BLOB_SEG_PAGE(i)      ((i) / JEKV_SEG_NUM_MAX)
+
+/*page and index of the blob segment item, the page is saved inverted so 0xff is the first page*/
+#define JEKV_ITEM_SEG_PAGE(item)   ((item)->length > 8 ? (uint8_t)~(item)->seg_page : 0)
+#define JEKV_ITEM_SEG_INDEX(item)  (JEKV_ITEM_SEG_PAGE(item) * JEKV_SEG_NUM_MAX + \
+                                    ((item)->seg_id & ~JEKV_SEG_START_VER_1))
+
+/*segment count of the blob descriptor, the high byte is saved inverted*/
+#define JEKV_ITEM_BLOB_SEG_COUNT(desc) ((desc)->seg_count | ((uint8_t)~(desc)->seg_count_hi << 8))
+
+/*
+    counter: a uint32 item with data slices, the value is the base in the item plus the cleared bits of the data.
+    The bits are cleared in place one by one, the item is rewritten only when all the bits are cleared.
+*/
+#define JEKV_ITEM_IS_COUNTER(item) ((item)->type == JEKV_TYPE_UINT32 && (item)->length > 8)
+
+/*
+    rewritable item: the value is programmed over the old one when it only clears bits. The value is not
+    covered by crc_item and crc_data, the crc slots of the rewrite slice are checked instead.
+*/
+#define JEKV_ITEM_IS_REWRITE(item) ((item)->recv1 & JEKV_ITEM_ATTR_REWRITE)
+
+/*compressed item: a string or binary, the data slices are the LZ4 block of the value*/
+#define JEKV_ITEM_IS_LZ(item)      ((item)->recv1 & JEKV_ITEM_ATTR_LZ)
+
+/*
+    record: a binary value updated by field deltas. A delta is a binary item of the same key, its seg id is
+    the sequence from rec_folded of the record, and its value is the record generation, the field offset
+    and the field data. The deltas of the other generation are stale, the record of generation 0 is
+    written as a plain binary and has no delta.
+*/
+#define JEKV_ITEM_IS_DELTA(item)   ((item)->type == JEKV_TYPE_BINARY && (item)->seg_id != JEKV_SEG_ID_ANY)
+#define JEKV_ITEM_HAS_REC(item)    ((item)->type == JEKV_TYPE_BINARY && (item)->seg_id == JEKV_SEG_ID_ANY && \
+                                    (item)->length > 8 && !JEKV_ITEM_IS_LZ(item))
+#define JEKV_ITEM_REC_GEN(item)    (JEKV_ITEM_HAS_REC(item) ? (uint8_t)~(item)->rec_gen : 0)
+#define JEKV_ITEM_REC_FOLDED(item) (JEKV_ITEM_HAS_REC(item) ? (uint8_t)~(item)->rec_folded : 0)
+#define JEKV_ITEM_IS_RECORD(item)  (JEKV_ITEM_REC_GEN(item) != 0)
+
+/*value size of the non-blob item*/
+#define JEKV_ITEM_VALUE_SIZE(item)                                                                             \
+    (JEKV_ITEM_IS_COUNTER(item) ? sizeof(uint32_t) : JEKV_ITEM_IS_LZ(item) ? (item)->raw_length : (item)->length)
+
+/*
+    index of a record in the packed item, encoded from the slice index of the packed item and the data offset
+    of the record. The next record is found from the index + 1 as the next item from the index + span.
+*/
+#define JEKV_PACK_INDEX_BASE          (JEKV_ENTRY_COUNT + 1)
+#define JEKV_PACK_INDEX(slice, off)   (JEKV_PACK_INDEX_BASE + (slice) * JEKV_SECTOR_SIZE + (off))
+#define JEKV_INDEX_IS_PACKED(index)   ((index) >= JEKV_PACK_INDEX_BASE)
+#define JEKV_PACK_INDEX_SLICE(index)  (((index) - JEKV_PACK_INDEX_BASE) / JEKV_SECTOR_SIZE)
+#define JEKV_PACK_INDEX_OFFSET(index) (((index) - JEKV_PACK_INDEX_BASE) % JEKV_SECTOR_SIZE)
+
+/*
+    integer key: 0 followed by the little endian id, a string key never starts with 0. The key buffer is
+    JEKV_MAX_KEY_LEN + 1 bytes as a string key, the item of it is hashed by an integer mix instead of crc32.
+*/
+#define JEKV_KEY_ID_LEN     (1 + sizeof(uint32_t))
+#define JEKV_KEY_IS_ID(key) ((key)[0] == 0)
+
 #define JEKV_ITEM_CRC_LEN (JEKV_SLICE_SIZE - 1)
 
 uint32_t jekv_item_crc_hash(const jekv_item_t *item);
 uint32_t jekv_item_crc_head(const jekv_item_t *item);
 
 int jekv_item_get_span(jekv_item_t *item);
+int jekv_item_get_blob_desc_span(const uint8_t *ver, int seg_count);
+
+/*make the key buffer of the integer key*/
+void jekv_item_make_id_key(char *key, uint32_t id);
+
+/*get the id of the integer key*/
+uint32_t jekv_item_get_key_id(const char *key);
+
+/*bytes of the key saved in the name, the string key is not terminated if it is JEKV_MAX_KEY_LEN*/
+int jekv_item_key_len(const char *key);
+
+/*copy the key or the name to the key buffer, terminated*/
+void jekv_item_key_copy(char *dst, const char *key);
+
+/*compare the keys or the names, 0 if they are the same*/
+int jekv_item_key_cmp(const char *a, const char *b);
+
+/*check the using item matches the look up conditions, the record delta of the key is matched by its seg id*/
+bool jekv_item_match(const jekv_item_t *item, uint8_t group_id, jekv_type_t type, const char *key, uint8_t seg_index,
+                     jekv_seg_start_t seg_start);
+
 void jekv_item_print_item_head(jekv_item_t *item);
 
 /*
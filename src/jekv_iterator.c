@@ -29,19 +29,12 @@ static int iterator_find(jekv_storage_t *storage, uint8_t group_id, jekv_type_t
     return jekv_iterator_next(output_iterator);
 }
 
-int jekv_iterator_find(const char *partition_name, const char *group, jekv_type_t type, jekv_iterator_t *output_iterator)
+int jekv_iterator_find(jekv_storage_t *storage, const char *group, jekv_type_t type, jekv_iterator_t *output_iterator)
 {
     jekv_group_t *group_node;
-    jekv_storage_t *storage;
 
     uint8_t group_id = JEKV_GROUP_ID_ANY;
 
-    storage = jekv_ptm_find_storage(partition_name);
-    if (!storage) {
-        jekv_log_debug("Not init");
-        return JEKV_ERR_NOT_INIT;
-    }
-
     if (group) {
         group_node = jekv_storage_find_group_by_name(storage, group);
         if (group_node) {
@@ -55,11 +48,9 @@ int jekv_iterator_find(const char *partition_name, const char *group, jekv_type_
     return iterator_find(storage, group_id, type, output_iterator);
 }
 
-int jekv_iterator_find_by_handle(jekv_handle_t handle, jekv_type_t type, jekv_iterator_t *output_iterator)
+int jekv_iterator_find_by_handle(jekv_handle_info_t *handle, jekv_type_t type, jekv_iterator_t *output_iterator)
 {
-    jekv_handle_info_t *h = (jekv_handle_info_t *)handle;
-
-    return iterator_find(h->storage, h->group_id, type, output_iterator);
+    return iterator_find(handle->storage, handle->group_id, type, output_iterator);
 }
 
 int jekv_iterator_next(jekv_iterator_t *iterator)
@@ -90,6 +81,16 @@ int jekv_iterator_next(jekv_iterator_t *iterator)
         if (err == JEKV_ERR_OK) {
             it->slice_index += jekv_item_get_span(&item);
 
+            if (JEKV_ITEM_IS_DELTA(&item)) {
+                /*read with its record*/
+                continue;
+            }
+
+            if (jekv_sm_is_group_retired(sm, item.group_id)) {
+                /*the group is deleted*/
+                continue;
+            }
+
             /*found*/
 
             /*get group*/
@@ -105,10 +106,11 @@ int jekv_iterator_next(jekv_iterator_t *iterator)
                 it->info.group[0] = 0;
             }
 
-            snprintf(it->info.key, sizeof(it->info.key), "%.*s", JEKV_MAX_KEY_LEN, item.name);
+            jekv_item_key_copy(it->info.key, item.name);
+            it->info.id = JEKV_KEY_IS_ID(item.name) ? jekv_item_get_key_id(item.name) : 0;
 
             it->info.type     = (jekv_type_t)item.type;
-            it->info.length   = (item.type == JEKV_TYPE_BLOB ? item.all_size : item.length);
+            it->info.length   = (item.type == JEKV_TYPE_BLOB ? item.all_size : JEKV_ITEM_VALUE_SIZE(&item));
             it->info.group_id = item.group_id;
 
             return err;
@@ -224,7 +226,7 @@ static void iterator_print_value(const char *group, const char *key, jekv_type_t
     }
 }
 
-int jekv_iterator_print(const char *partition_name, const char *group_name)
+int jekv_iterator_print(jekv_storage_t *storage, const char *group_name)
 {
     int err;
     jekv_iterator_t iterator = NULL;
@@ -232,15 +234,11 @@ int jekv_iterator_print(const char *partition_name, const char *group_name)
     uint8_t buf[32];
     uint32_t length;
 
-    if (!partition_name) {
-        return JEKV_ERR_INVALID_PARAM;
-    }
-
-    jekv_log_debug("start print,pt=%s,group=%s", partition_name, group_name ? group_name : "NULL");
+    jekv_log_debug("start print,pt=%s,group=%s", storage->pt.name, group_name ? group_name : "NULL");
 
-    err = jekv_iterator_find(partition_name, group_name, (jekv_type_t)(JEKV_TYPE_ANY_WITHOUT_SEG), &iterator);
+    err = jekv_iterator_find(storage, group_name, (jekv_type_t)(JEKV_TYPE_ANY_WITHOUT_SEG), &iterator);
     if (err == JEKV_ERR_OK) {
-        jekv_log_debug("find %s iterator=%p", partition_name, iterator);
+        jekv_log_debug("find %s iterator=%p", storage->pt.name, iterator);
         while (iterator) {
             jekv_iterator_info(iterator, &entry);
 
@@ -269,7 +267,7 @@ int jekv_iterator_print(const char *partition_name, const char *group_name)
         }
         jekv_iterator_release(iterator);
     } else {
-        jekv_log_debug("find %s error", partition_name);
+        jekv_log_debug("find %s error", storage->pt.name);
     }
 
     return JEKV_ERR_OK;
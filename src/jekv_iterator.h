@@ -6,6 +6,7 @@
 #include "jekv_base.h"
 #include "jekv_porting.h"
 #include "jekv_storage.h"
+#include "jekv_handler.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,9 +24,9 @@ typedef struct {
     jekv_entry_t info;       /**< item information      */
 } jekv_iterator_info_t;
 
-int jekv_iterator_find(const char *partition_name, const char *group, jekv_type_t type, jekv_iterator_t *output_iterator);
+int jekv_iterator_find(jekv_storage_t *storage, const char *group, jekv_type_t type, jekv_iterator_t *output_iterator);
 
-int jekv_iterator_find_by_handle(jekv_handle_t handle, jekv_type_t type, jekv_iterator_t *output_iterator);
+int jekv_iterator_find_by_handle(jekv_handle_info_t *handle, jekv_type_t type, jekv_iterator_t *output_iterator);
 
 int jekv_iterator_next(jekv_iterator_t *iterator);
 
@@ -35,7 +36,7 @@ int jekv_iterator_data(jekv_iterator_t iterator, void *data, uint32_t *data_len)
 
 int jekv_iterator_release(jekv_iterator_t iterator);
 
-int jekv_iterator_print(const char *partition_name, const char *group_name);
+int jekv_iterator_print(jekv_storage_t *storage, const char *group_name);
 
 #ifdef __cplusplus
 }
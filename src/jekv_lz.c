@@ -0,0 +1,267 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_lz"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_lz.h"
+#include "jekv_log.h"
+
+#define LZ_MIN_MATCH    4
+#define LZ_LAST_LITERAL 5  /* the last bytes are always literals */
+#define LZ_MATCH_LIMIT  12 /* no match starts in the last bytes  */
+#define LZ_MAX_OFFSET   0xffff
+#define LZ_RUN_MASK     0xf
+
+/**
+  * @brief  input of the decompressor
+  */
+typedef struct {
+    jekv_lz_read_t read;            /**< read function           */
+    void *ctx;                      /**< read context            */
+    uint32_t in_len;                /**< compressed size         */
+    uint32_t offset;                /**< offset of the next read */
+    uint8_t buf[JEKV_LZ_READ_SIZE]; /**< data read               */
+    uint32_t buf_len;               /**< size of the data read   */
+    uint32_t buf_pos;               /**< position in buf         */
+} lz_input_t;
+
+static uint32_t lz_read32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+static uint32_t lz_hash(uint32_t seq)
+{
+    return (seq * 2654435761u) >> (32 - CONFIG_JEKV_LZ_HASH_BITS);
+}
+
+/*write the length over the token run, 255 for each byte but the last*/
+static uint32_t lz_put_len(uint8_t *dst, uint32_t len)
+{
+    uint32_t n = 0;
+
+    for (; len >= 255; len -= 255) {
+        dst[n++] = 255;
+    }
+
+    dst[n++] = (uint8_t)len;
+
+    return n;
+}
+
+/*write a sequence of the literals and the match, offset 0: the last sequence without match*/
+static uint32_t lz_put_seq(const uint8_t *lit, uint32_t lit_len, uint32_t offset, uint32_t match_len, uint8_t *dst,
+                           uint32_t op, uint32_t max)
+{
+    uint8_t *token;
+    uint32_t need = 1 + lit_len + lit_len / 255 + 1;
+
+    if (offset) {
+        match_len -= LZ_MIN_MATCH;
+        need += 2 + match_len / 255 + 1;
+    }
+
+    if (op + need > max) {
+        return 0;
+    }
+
+    token = dst + op++;
+
+    if (lit_len >= LZ_RUN_MASK) {
+        *token = LZ_RUN_MASK << 4;
+        op += lz_put_len(dst + op, lit_len - LZ_RUN_MASK);
+    } else {
+        *token = (uint8_t)(lit_len << 4);
+    }
+
+    memcpy(dst + op, lit, lit_len);
+    op += lit_len;
+
+    if (offset) {
+        dst[op++] = (uint8_t)offset;
+        dst[op++] = (uint8_t)(offset >> 8);
+
+        if (match_len >= LZ_RUN_MASK) {
+            *token |= LZ_RUN_MASK;
+            op += lz_put_len(dst + op, match_len - LZ_RUN_MASK);
+        } else {
+            *token |= (uint8_t)match_len;
+        }
+    }
+
+    return op;
+}
+
+uint32_t jekv_lz_compress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t max)
+{
+    uint16_t table[1 << CONFIG_JEKV_LZ_HASH_BITS]; /* position + 1 of the sequences, 0: none */
+    uint32_t ip     = 0;
+    uint32_t anchor = 0;
+    uint32_t op     = 0;
+    uint32_t ref;
+    uint32_t seq;
+    uint32_t h;
+    uint32_t match_len;
+
+    if (len > LZ_MAX_OFFSET) {
+        return 0;
+    }
+
+    memset(table, 0, sizeof(table));
+
+    while (ip + LZ_MATCH_LIMIT < len) {
+        seq      = lz_read32(src + ip);
+        h        = lz_hash(seq);
+        ref      = table[h];
+        table[h] = (uint16_t)(ip + 1);
+
+        if (ref == 0 || lz_read32(src + ref - 1) != seq) {
+            ip++;
+            continue;
+        }
+
+        ref--;
+
+        /*extend the match, keep the last literals*/
+        match_len = LZ_MIN_MATCH;
+        while (ip + match_len < len - LZ_LAST_LITERAL && src[ref + match_len] == src[ip + match_len]) {
+            match_len++;
+        }
+
+        op = lz_put_seq(src + anchor, ip - anchor, ip - ref, match_len, dst, op, max);
+        if (op == 0) {
+            return 0;
+        }
+
+        ip += match_len;
+        anchor = ip;
+    }
+
+    return lz_put_seq(src + anchor, len - anchor, 0, 0, dst, op, max);
+}
+
+static int lz_get(lz_input_t *in, uint8_t *c)
+{
+    int err;
+
+    if (in->buf_pos == in->buf_len) {
+        if (in->offset >= in->in_len) {
+            return JEKV_ERR_FAIL;
+        }
+
+        in->buf_len = in->in_len - in->offset < sizeof(in->buf) ? in->in_len - in->offset : sizeof(in->buf);
+        in->buf_pos = 0;
+
+        err = in->read(in->ctx, in->offset, in->buf, in->buf_len);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        in->offset += in->buf_len;
+    }
+
+    *c = in->buf[in->buf_pos++];
+
+    return JEKV_ERR_OK;
+}
+
+/*read the length over the token run*/
+static int lz_get_len(lz_input_t *in, uint32_t *len)
+{
+    int err;
+    uint8_t c;
+
+    do {
+        err = lz_get(in, &c);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        *len += c;
+    } while (c == 255);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_lz_decompress(jekv_lz_read_t read, void *ctx, uint32_t in_len, uint8_t *dst, uint32_t dst_len)
+{
+    int err;
+    lz_input_t in;
+    uint32_t op = 0;
+    uint32_t len;
+    uint32_t offset;
+    uint8_t token;
+    uint8_t c;
+
+    in.read    = read;
+    in.ctx     = ctx;
+    in.in_len  = in_len;
+    in.offset  = 0;
+    in.buf_len = 0;
+    in.buf_pos = 0;
+
+    while (1) {
+        err = lz_get(&in, &token);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        /*literals*/
+        len = token >> 4;
+        if (len == LZ_RUN_MASK && (err = lz_get_len(&in, &len)) != JEKV_ERR_OK) {
+            return err;
+        }
+
+        if (len > dst_len - op) {
+            return JEKV_ERR_FAIL;
+        }
+
+        for (; len > 0; len--) {
+            err = lz_get(&in, &dst[op++]);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+        }
+
+        /*the last sequence has no match*/
+        if (in.buf_pos == in.buf_len && in.offset >= in.in_len) {
+            break;
+        }
+
+        err = lz_get(&in, &c);
+        if (err == JEKV_ERR_OK) {
+            offset = c;
+            err    = lz_get(&in, &c);
+        }
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        offset |= (uint32_t)c << 8;
+        if (offset == 0 || offset > op) {
+            return JEKV_ERR_FAIL;
+        }
+
+        len = token & LZ_RUN_MASK;
+        if (len == LZ_RUN_MASK && (err = lz_get_len(&in, &len)) != JEKV_ERR_OK) {
+            return err;
+        }
+
+        len += LZ_MIN_MATCH;
+        if (len > dst_len - op) {
+            return JEKV_ERR_FAIL;
+        }
+
+        /*the match may overlap the output*/
+        for (; len > 0; len--, op++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+
+    return op == dst_len ? JEKV_ERR_OK : JEKV_ERR_FAIL;
+}
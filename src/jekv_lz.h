@@ -0,0 +1,39 @@
+#ifndef __JEKV_LZ_H__
+#define __JEKV_LZ_H__
+
+#include <stdint.h>
+#include "jekv_base.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    LZ4 block format codec, no memory is allocated. The compressor keeps a hash table of
+    (1 << CONFIG_JEKV_LZ_HASH_BITS) positions on the stack, the decompressor reads the input
+    in pieces of JEKV_LZ_READ_SIZE and uses the output as the history.
+*/
+#ifndef CONFIG_JEKV_LZ_HASH_BITS
+#define CONFIG_JEKV_LZ_HASH_BITS 9
+#endif
+
+#if CONFIG_JEKV_LZ_HASH_BITS < 4 || CONFIG_JEKV_LZ_HASH_BITS > 14
+#error "CONFIG_JEKV_LZ_HASH_BITS out of range"
+#endif
+
+#define JEKV_LZ_READ_SIZE 32 /* input read at once, one slice */
+
+/*read the compressed data at offset, ctx: the reader context*/
+typedef int (*jekv_lz_read_t)(void *ctx, uint32_t offset, void *buf, uint32_t len);
+
+/*compress the data no longer than 0xffff, return the compressed size, 0 if it doesn't fit in max*/
+uint32_t jekv_lz_compress(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t max);
+
+/*decompress in_len bytes got from read to dst, JEKV_ERR_FAIL if they are not dst_len bytes compressed*/
+int jekv_lz_decompress(jekv_lz_read_t read, void *ctx, uint32_t in_len, uint8_t *dst, uint32_t dst_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
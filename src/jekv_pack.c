@@ -0,0 +1,474 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_pack"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_item.h"
+#include "jekv_hash.h"
+#include "jekv_sector.h"
+#include "jekv_pack.h"
+#include "jekv_log.h"
+
+/**
+  * @brief  record cursor of the packed data, in RAM or read from flash by window
+  */
+typedef struct {
+    jekv_sector_t *sec;                    /**< sector of the packed item       */
+    const uint8_t *data;                   /**< data in RAM, NULL: in flash     */
+    uint32_t address;                      /**< data address in flash           */
+    uint32_t length;                       /**< data size                       */
+    uint32_t offset;                       /**< offset of the current record    */
+    uint32_t win_offset;                   /**< data offset of the window       */
+    uint32_t win_len;                      /**< read size of the window         */
+    uint8_t win[JEKV_PACK_REC_MAX * 4];    /**< window of the data in flash     */
+    const jekv_pack_rec_t *rec;            /**< current record                  */
+} pack_cursor_t;
+
+static void pack_cursor_init(pack_cursor_t *c, jekv_sector_t *sec, int index, const jekv_item_t *pack,
+                             const uint8_t *data)
+{
+    c->sec        = sec;
+    c->data       = data;
+    c->address    = sec->address + (index + 2) * JEKV_SLICE_SIZE;
+    c->length     = pack->length;
+    c->offset     = 0;
+    c->win_offset = 0;
+    c->win_len    = 0;
+    c->rec        = NULL;
+}
+
+/*get the record at the cursor offset, JEKV_ERR_NOT_FOUND at the end, JEKV_ERR_FAIL if it is broken*/
+static int pack_cursor_get(pack_cursor_t *c)
+{
+    const jekv_pack_rec_t *rec;
+    uint32_t left = c->length - c->offset;
+    uint32_t need = left < JEKV_PACK_REC_MAX ? left : JEKV_PACK_REC_MAX;
+    int err;
+
+    if (c->offset >= c->length) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    if (left < sizeof(jekv_pack_rec_t)) {
+        return JEKV_ERR_FAIL;
+    }
+
+    if (c->data) {
+        rec = (const jekv_pack_rec_t *)(c->data + c->offset);
+    } else {
+        /*read the window again if the record may be out of it*/
+        if (c->offset < c->win_offset || c->offset + need > c->win_offset + c->win_len) {
+            c->win_offset = c->offset;
+            c->win_len    = left < sizeof(c->win) ? left : sizeof(c->win);
+
+            err = jekv_pt_read(c->sec->pt, c->address + c->win_offset, c->win, c->win_len);
+            if (err != JEKV_ERR_OK) {
+                c->sec->state = JEKV_SECTOR_STATE_INVALID;
+                return err;
+            }
+        }
+
+        rec = (const jekv_pack_rec_t *)(c->win + c->offset - c->win_offset);
+    }
+
+    if ((rec->state != JEKV_ITEM_STATE_USING && rec->state != JEKV_ITEM_STATE_DROPED) || rec->key_len == 0 ||
+        rec->key_len > JEKV_MAX_KEY_LEN || JEKV_PACK_REC_LENGTH(rec) > 8 || JEKV_PACK_REC_TYPE(rec) == JEKV_TYPE_ANY ||
+        JEKV_PACK_REC_TYPE(rec) >= JEKV_TYPE_BLOB || JEKV_PACK_REC_SIZE(rec) > left ||
+        (JEKV_KEY_IS_ID((const char *)(rec + 1)) && rec->key_len != JEKV_KEY_ID_LEN)) {
+        jekv_log_debug("bad record at %u", c->offset);
+        return JEKV_ERR_FAIL;
+    }
+
+    c->rec = rec;
+
+    return JEKV_ERR_OK;
+}
+
+static void pack_cursor_next(pack_cursor_t *c)
+{
+    c->offset += JEKV_PACK_REC_SIZE(c->rec);
+}
+
+/*get the record as an item*/
+static void pack_rec_to_item(const jekv_pack_rec_t *rec, jekv_item_t *item)
+{
+    char key[JEKV_MAX_KEY_LEN + 1];
+    const uint8_t *p = (const uint8_t *)(rec + 1);
+
+    memcpy(key, p, rec->key_len);
+    key[rec->key_len] = 0;
+
+    jekv_item_init(item, JEKV_ITEM_STATE_USING, rec->group_id, (jekv_type_t)JEKV_PACK_REC_TYPE(rec), key,
+                   p + rec->key_len, JEKV_PACK_REC_LENGTH(rec), JEKV_SEG_ID_ANY);
+}
+
+/*put the using item as a record, return the record size*/
+static uint32_t pack_item_to_rec(const jekv_item_t *item, uint8_t *buf)
+{
+    jekv_pack_rec_t *rec = (jekv_pack_rec_t *)buf;
+
+    rec->state    = JEKV_ITEM_STATE_USING;
+    rec->group_id = item->group_id;
+    rec->type_len = (uint8_t)((item->type << 4) | item->length);
+    rec->key_len  = (uint8_t)jekv_item_key_len(item->name);
+
+    memcpy(buf + sizeof(*rec), item->name, rec->key_len);
+    memcpy(buf + sizeof(*rec) + rec->key_len, item->data, item->length);
+
+    return JEKV_PACK_REC_SIZE(rec);
+}
+
+bool jekv_pack_is_packable(const jekv_item_t *item)
+{
+    return item->state == JEKV_ITEM_STATE_USING && item->type != JEKV_TYPE_ANY && item->type < JEKV_TYPE_BLOB &&
+           item->length <= 8 && item->recv1 == 0 && item->seg_id == JEKV_SEG_ID_ANY;
+}
+
+void jekv_pack_count(jekv_sector_t *sec, const jekv_item_t *item, bool add)
+{
+    uint16_t size;
+
+    if (sec->pt->encrypted || !jekv_pack_is_packable(item)) {
+        return;
+    }
+
+    size = sizeof(jekv_pack_rec_t) + jekv_item_key_len(item->name) + item->length;
+
+    if (add) {
+        sec->small_slice++;
+        sec->small_size += size;
+    } else if (sec->small_slice > 0 && sec->small_size >= size) {
+        sec->small_slice--;
+        sec->small_size -= size;
+    }
+}
+
+int jekv_pack_find(jekv_sector_t *sec, int index, const jekv_item_t *pack, uint32_t *offset, uint8_t group_id,
+                   jekv_type_t type, const char *key, uint8_t seg_index, jekv_seg_start_t seg_start, jekv_item_t *item)
+{
+    pack_cursor_t c;
+    int err;
+
+    pack_cursor_init(&c, sec, index, pack, NULL);
+
+    while ((err = pack_cursor_get(&c)) == JEKV_ERR_OK) {
+        if (c.offset >= *offset && c.rec->state == JEKV_ITEM_STATE_USING &&
+            (!key || (c.rec->key_len == jekv_item_key_len(key) &&
+                      !memcmp(c.rec + 1, key, c.rec->key_len)))) {
+            pack_rec_to_item(c.rec, item);
+
+            if (jekv_item_match(item, group_id, type, key, seg_index, seg_start)) {
+                *offset = c.offset;
+                return JEKV_ERR_OK;
+            }
+        }
+
+        pack_cursor_next(&c);
+    }
+
+    return err;
+}
+
+int jekv_pack_erase(jekv_sector_t *sec, int index, jekv_item_t *item, bool erase_hash)
+{
+    int slice       = JEKV_PACK_INDEX_SLICE(index);
+    uint32_t offset = JEKV_PACK_INDEX_OFFSET(index);
+    uint8_t state   = JEKV_ITEM_STATE_DROPED;
+    jekv_item_t pack;
+    pack_cursor_t c;
+    int err;
+
+    err = jekv_pt_read_item(sec->pt, sec->address + (slice + 1) * JEKV_SLICE_SIZE, &pack);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (pack.state != JEKV_ITEM_STATE_USING || pack.type != JEKV_TYPE_PACK || offset >= pack.length) {
+        return JEKV_ERR_FAIL;
+    }
+
+    jekv_log_debug("erase record %.*s at %d,%u", JEKV_MAX_KEY_LEN, item->name, slice, offset);
+
+    err = jekv_pt_write_raw(sec->pt, sec->address + (slice + 2) * JEKV_SLICE_SIZE + offset, &state, sizeof(state));
+
+    if (erase_hash) {
+        jekv_hash_erase_item(&sec->hash, item, slice);
+    }
+
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /*drop the packed item if it was the last live record*/
+    pack_cursor_init(&c, sec, slice, &pack, NULL);
+
+    while ((err = pack_cursor_get(&c)) == JEKV_ERR_OK) {
+        if (c.rec->state == JEKV_ITEM_STATE_USING) {
+            return JEKV_ERR_OK;
+        }
+
+        pack_cursor_next(&c);
+    }
+
+    if (err != JEKV_ERR_NOT_FOUND) {
+        return err;
+    }
+
+    return jekv_sector_erase_item(sec, slice, &pack, false);
+}
+
+int jekv_pack_load(jekv_sector_t *sec, int index, const jekv_item_t *pack, const uint8_t *data)
+{
+    jekv_item_t item;
+    pack_cursor_t c;
+    int live = 0;
+    int err;
+
+    pack_cursor_init(&c, sec, index, pack, data);
+
+    while ((err = pack_cursor_get(&c)) == JEKV_ERR_OK) {
+        if (c.rec->state == JEKV_ITEM_STATE_USING) {
+            pack_rec_to_item(c.rec, &item);
+
+            jekv_hash_append(&sec->hash, &item, index);
+            live++;
+        }
+
+        pack_cursor_next(&c);
+    }
+
+    if (err == JEKV_ERR_NOT_FOUND && live > 0) {
+        return JEKV_ERR_OK;
+    }
+
+    /*remove the nodes of the broken or droped packed item*/
+    while (jekv_hash_erase(&sec->hash, index) == JEKV_ERR_OK) {
+    }
+
+    return err;
+}
+
+uint32_t jekv_pack_get_value_address(jekv_sector_t *sec, int index, const jekv_item_t *item)
+{
+    return sec->address + (JEKV_PACK_INDEX_SLICE(index) + 2) * JEKV_SLICE_SIZE + JEKV_PACK_INDEX_OFFSET(index) +
+           sizeof(jekv_pack_rec_t) + jekv_item_key_len(item->name);
+}
+
+/*get the size of the packed item data from the record offset and its record count*/
+static uint32_t pack_gc_next(const jekv_pack_gc_t *gc, uint32_t offset, uint32_t *count)
+{
+    const jekv_pack_rec_t *rec;
+    uint32_t len = 0;
+
+    *count = 0;
+
+    while (offset + len < gc->size) {
+        rec = (const jekv_pack_rec_t *)(gc->recs + offset + len);
+        if (len + JEKV_PACK_REC_SIZE(rec) > JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
+            break;
+        }
+
+        len += JEKV_PACK_REC_SIZE(rec);
+        (*count)++;
+    }
+
+    return len;
+}
+
+/*slices of the collected records written packed, a packed item of one record is written as a single item*/
+static uint32_t pack_gc_packed_slices(const jekv_pack_gc_t *gc)
+{
+    uint32_t offset = 0;
+    uint32_t slices = 0;
+    uint32_t count;
+    uint32_t len;
+
+    while (offset < gc->size) {
+        len = pack_gc_next(gc, offset, &count);
+        slices += count == 1 ? 1 : 1 + (len + JEKV_SLICE_SIZE - 1) / JEKV_SLICE_SIZE;
+        offset += len;
+    }
+
+    return slices;
+}
+
+void jekv_pack_gc_drop_groups(jekv_sector_t *src, int index, jekv_item_t *pack, uint64_t groups)
+{
+    pack_cursor_t c;
+
+    pack_cursor_init(&c, src, index, pack, (const uint8_t *)(pack + 1));
+
+    while (pack_cursor_get(&c) == JEKV_ERR_OK) {
+        if (c.rec->state == JEKV_ITEM_STATE_USING && c.rec->group_id <= JEKV_GROUP_ID_MAX &&
+            (groups & ((uint64_t)1 << c.rec->group_id))) {
+            /*the record is in the image*/
+            ((jekv_pack_rec_t *)c.rec)->state = JEKV_ITEM_STATE_DROPED;
+        }
+
+        pack_cursor_next(&c);
+    }
+}
+
+int jekv_pack_gc_begin(jekv_sector_t *src, const uint8_t *pblock, uint32_t dst_start, jekv_pack_gc_t *gc)
+{
+    const jekv_item_t *item;
+    pack_cursor_t c;
+    uint32_t index;
+    uint32_t slices = 0; /*slices of the other items*/
+    uint32_t need;
+    bool has_pack = false;
+    int span;
+    int err;
+
+    memset(gc, 0, sizeof(*gc));
+
+    /*the records are not encrypted*/
+    if (src->pt->encrypted) {
+        return JEKV_ERR_NOT_SUPPORT;
+    }
+
+    /*size the records first, then collect them*/
+    for (index = 0; index < JEKV_ENTRY_COUNT; index += span) {
+        item = (const jekv_item_t *)(pblock + (index + 1) * JEKV_SLICE_SIZE);
+        span = jekv_item_get_span((jekv_item_t *)item);
+
+        if ((item->state != JEKV_ITEM_STATE_USING && item->state != JEKV_ITEM_STATE_DROPED) ||
+            index + span > JEKV_ENTRY_COUNT) {
+            break;
+        } else if (item->state == JEKV_ITEM_STATE_DROPED) {
+            continue;
+        }
+
+        if (item->type == JEKV_TYPE_BATCH) {
+            /*the batch recovery looks up the items by slice*/
+            return JEKV_ERR_NOT_SUPPORT;
+        } else if (jekv_pack_is_packable(item)) {
+            gc->size += sizeof(jekv_pack_rec_t) + jekv_item_key_len(item->name) + item->length;
+            gc->count++;
+        } else if (item->type == JEKV_TYPE_PACK) {
+            pack_cursor_init(&c, src, index, item, (const uint8_t *)(item + 1));
+
+            while ((err = pack_cursor_get(&c)) == JEKV_ERR_OK) {
+                if (c.rec->state == JEKV_ITEM_STATE_USING) {
+                    gc->size += JEKV_PACK_REC_SIZE(c.rec);
+                    gc->count++;
+                }
+
+                pack_cursor_next(&c);
+            }
+
+            if (err != JEKV_ERR_NOT_FOUND) {
+                return err;
+            }
+
+            has_pack = true;
+        } else {
+            slices += span;
+        }
+    }
+
+    if (gc->count == 0) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    gc->recs = JEKV_MALLOC(gc->size);
+    if (!gc->recs) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    gc->size = 0;
+
+    for (index = 0; index < JEKV_ENTRY_COUNT; index += span) {
+        item = (const jekv_item_t *)(pblock + (index + 1) * JEKV_SLICE_SIZE);
+        span = jekv_item_get_span((jekv_item_t *)item);
+
+        if ((item->state != JEKV_ITEM_STATE_USING && item->state != JEKV_ITEM_STATE_DROPED) ||
+            index + span > JEKV_ENTRY_COUNT) {
+            break;
+        } else if (jekv_pack_is_packable(item)) {
+            gc->size += pack_item_to_rec(item, gc->recs + gc->size);
+        } else if (item->state == JEKV_ITEM_STATE_USING && item->type == JEKV_TYPE_PACK) {
+            pack_cursor_init(&c, src, index, item, (const uint8_t *)(item + 1));
+
+            while (pack_cursor_get(&c) == JEKV_ERR_OK) {
+                if (c.rec->state == JEKV_ITEM_STATE_USING) {
+                    memcpy(gc->recs + gc->size, c.rec, JEKV_PACK_REC_SIZE(c.rec));
+                    gc->size += JEKV_PACK_REC_SIZE(c.rec);
+                }
+
+                pack_cursor_next(&c);
+            }
+        }
+    }
+
+    /*pack them only if it saves slices, a single item takes one slice*/
+    need       = pack_gc_packed_slices(gc);
+    gc->packed = need < gc->count;
+    if (!gc->packed) {
+        need = gc->count;
+    }
+
+    if ((!gc->packed && !has_pack) || dst_start + slices + need > JEKV_ENTRY_COUNT) {
+        /*nothing to be saved, copy them as they are*/
+        JEKV_FREE(gc->recs);
+        gc->recs = NULL;
+        return JEKV_ERR_NOT_SUPPORT;
+    }
+
+    jekv_log_debug("gc pack: count=%u,size=%u,slices=%u,packed=%d", gc->count, gc->size, need, gc->packed);
+
+    return JEKV_ERR_OK;
+}
+
+bool jekv_pack_gc_is_collected(const jekv_pack_gc_t *gc, const jekv_item_t *item)
+{
+    return gc->recs && (jekv_pack_is_packable(item) || item->type == JEKV_TYPE_PACK);
+}
+
+void jekv_pack_gc_end(jekv_sector_t *dst, jekv_pack_gc_t *gc, uint8_t *pblock, uint32_t dst_start, uint32_t *dst_index)
+{
+    const jekv_pack_rec_t *rec;
+    jekv_item_t *item;
+    char key[JEKV_MAX_KEY_LEN + 1] = {0}; /*the packed item has no key*/
+    uint32_t offset = 0;
+    uint32_t count;
+    uint32_t len;
+
+    if (!gc->recs) {
+        return;
+    }
+
+    while (offset < gc->size) {
+        item = (jekv_item_t *)(pblock + (*dst_index - dst_start + 1) * JEKV_SLICE_SIZE);
+
+        len = pack_gc_next(gc, offset, &count);
+        if (!gc->packed || count == 1) {
+            /*single item of the first record*/
+            rec = (const jekv_pack_rec_t *)(gc->recs + offset);
+            len = JEKV_PACK_REC_SIZE(rec);
+
+            pack_rec_to_item(rec, item);
+            jekv_hash_append(&dst->hash, item, *dst_index);
+            jekv_pack_count(dst, item, true);
+
+            *dst_index += 1;
+        } else {
+            jekv_item_init(item, JEKV_ITEM_STATE_USING, JEKV_GROUP_ID_ANY, JEKV_TYPE_PACK, key, gc->recs + offset, len,
+                           JEKV_SEG_ID_ANY);
+
+            /*the tail of the last data slice is left erased*/
+            memset(item + 1, 0xff, (len + JEKV_SLICE_SIZE - 1) / JEKV_SLICE_SIZE * JEKV_SLICE_SIZE);
+            memcpy(item + 1, gc->recs + offset, len);
+
+            jekv_pack_load(dst, *dst_index, item, (const uint8_t *)(item + 1));
+
+            *dst_index += jekv_item_get_span(item);
+        }
+
+        offset += len;
+    }
+
+    JEKV_FREE(gc->recs);
+    gc->recs = NULL;
+}
@@ -0,0 +1,93 @@
+#ifndef __JEKV_PACK_H__
+#define __JEKV_PACK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "jekv_base.h"
+#include "jekv_item.h"
+#include "jekv_sector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    packed item: the small items are packed as records in the data of one item when GC copies a sector,
+    the item is of JEKV_TYPE_PACK and has no key. Every live record has a hash node of the packed item index,
+    a record is found as an item of the index JEKV_PACK_INDEX(slice, offset) and droped by clearing its state.
+*/
+
+/**
+  * @brief  record head in the packed item, followed by the key and the value
+  */
+typedef struct {
+    uint8_t state;    /**< JEKV_ITEM_STATE_USING or JEKV_ITEM_STATE_DROPED */
+    uint8_t group_id; /**< group id                                        */
+    uint8_t type_len; /**< type in the high 4 bits, value size in the low   */
+    uint8_t key_len;  /**< key size, the key is not terminated             */
+} jekv_pack_rec_t;
+
+#define JEKV_PACK_REC_TYPE(rec)   ((rec)->type_len >> 4)
+#define JEKV_PACK_REC_LENGTH(rec) ((rec)->type_len & 0xf)
+#define JEKV_PACK_REC_SIZE(rec)   (sizeof(jekv_pack_rec_t) + (rec)->key_len + JEKV_PACK_REC_LENGTH(rec))
+#define JEKV_PACK_REC_MAX         (sizeof(jekv_pack_rec_t) + JEKV_MAX_KEY_LEN + 8)
+
+/**
+  * @brief  small items of the sector repacked by GC
+  */
+typedef struct {
+    uint8_t *recs;   /**< records of the small items, NULL: copy them as they are */
+    uint32_t size;   /**< size of the records                                     */
+    uint32_t count;  /**< record count                                            */
+    bool packed;     /**< write them packed, or as single items                   */
+} jekv_pack_gc_t;
+
+/*check the item can be packed*/
+bool jekv_pack_is_packable(const jekv_item_t *item);
+
+/*count the small item written to or droped from the sector*/
+void jekv_pack_count(jekv_sector_t *sec, const jekv_item_t *item, bool add);
+
+/*slices GC saves by packing the small items of the sector, estimated*/
+inline static int jekv_pack_get_gc_gain(const jekv_sector_t *sec)
+{
+    int need = (sec->small_size + JEKV_SLICE_SIZE - 1) / JEKV_SLICE_SIZE +
+               (sec->small_size + JEKV_SINGLE_ITEM_MAX_DATA_SIZE - JEKV_PACK_REC_MAX) /
+                   (JEKV_SINGLE_ITEM_MAX_DATA_SIZE - JEKV_PACK_REC_MAX + 1);
+
+    return sec->small_slice > need ? sec->small_slice - need : 0;
+}
+
+/*find the matching record from the data offset of the packed item, the record is got as an item*/
+int jekv_pack_find(jekv_sector_t *sec, int index, const jekv_item_t *pack, uint32_t *offset, uint8_t group_id,
+                   jekv_type_t type, const char *key, uint8_t seg_index, jekv_seg_start_t seg_start, jekv_item_t *item);
+
+/*drop the record, the packed item is droped with its last record*/
+int jekv_pack_erase(jekv_sector_t *sec, int index, jekv_item_t *item, bool erase_hash);
+
+/*
+    append the hash nodes of the live records, data: the packed data in RAM, NULL to read it from flash.
+    JEKV_ERR_NOT_FOUND if no record is live.
+*/
+int jekv_pack_load(jekv_sector_t *sec, int index, const jekv_item_t *pack, const uint8_t *data);
+
+/*flash address of the record value*/
+uint32_t jekv_pack_get_value_address(jekv_sector_t *sec, int index, const jekv_item_t *item);
+
+/*drop the records of the groups in the packed item of the sector image*/
+void jekv_pack_gc_drop_groups(jekv_sector_t *src, int index, jekv_item_t *pack, uint64_t groups);
+
+/*collect the small items and the records of the sector image, JEKV_ERR_OK if they are to be repacked*/
+int jekv_pack_gc_begin(jekv_sector_t *src, const uint8_t *pblock, uint32_t dst_start, jekv_pack_gc_t *gc);
+
+/*check the item of the sector image is collected*/
+bool jekv_pack_gc_is_collected(const jekv_pack_gc_t *gc, const jekv_item_t *item);
+
+/*put the collected records to the sector image from dst_index, the image starts at the slice dst_start*/
+void jekv_pack_gc_end(jekv_sector_t *dst, jekv_pack_gc_t *gc, uint8_t *pblock, uint32_t dst_start, uint32_t *dst_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -133,3 +133,19 @@ int jekv_pt_write_item(jekv_partition_t *pt, uint32_t address, const jekv_item_t
 
     return jekv_partition_write(pt->dev, pt->offset + address, (uint8_t *)item, sizeof(*item));
 }
+
+const void *jekv_pt_mmap(jekv_partition_t *pt, uint32_t address, uint32_t length)
+{
+    jekv_log_debug("mmap %s, off=0x%x,len=%u", pt->name, address, length);
+
+    if (!(address + length <= pt->size)) {
+        return NULL;
+    }
+
+    if (pt->encrypted) {
+        /*the flash keeps the cipher text*/
+        return NULL;
+    }
+
+    return jekv_partition_mmap(pt->dev, pt->offset + address, length);
+}
@@ -45,6 +45,9 @@ int jekv_pt_write_raw(jekv_partition_t *pt, uint32_t address, const void *data,
 /*read item, The first 16 bytes are encrypted, and the last 16 bytes are not encrypted*/
 int jekv_pt_read_item(jekv_partition_t *pt, uint32_t address, jekv_item_t *item);
 
+/*get the address of the mapped flash, NULL if not mapped or encrypted*/
+const void *jekv_pt_mmap(jekv_partition_t *pt, uint32_t address, uint32_t length);
+
 /*write item, The first 16 bytes are encrypted, and the last 16 bytes are not encrypted*/
 int jekv_pt_write_item(jekv_partition_t *pt, uint32_t address, const jekv_item_t *item);
 
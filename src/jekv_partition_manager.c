@@ -13,10 +13,36 @@
  */
 static struct dl_list g_storage_list = DL_LIST_HEAD_INIT(g_storage_list);
 
+/*handle given to the user: the generation of the open above the index of its slot in the handle table*/
+#define PTM_HANDLE_INDEX_BITS 12
+#define PTM_HANDLE_INDEX_MASK ((1u << PTM_HANDLE_INDEX_BITS) - 1)
+#define PTM_HANDLE_GEN_MAX    (UINT32_MAX >> PTM_HANDLE_INDEX_BITS)
+
+#if JEKV_HANDLE_NUM_LIMIT > (1 << PTM_HANDLE_INDEX_BITS)
+#error "JEKV_HANDLE_NUM_LIMIT out of range"
+#endif
+
 /**
- * @brief   handle list
+ * @brief   handle table, allocated by the first open
  */
-static struct dl_list g_handle_list = DL_LIST_HEAD_INIT(g_handle_list);
+static jekv_handle_info_t *g_handle_table;
+static uint32_t g_handle_max = JEKV_MAX_HANDLE_NUM; /**< slots of the handle table */
+static uint32_t g_handle_num;                       /**< opened handles            */
+static uint32_t g_handle_gen;                       /**< generation of the last open, never 0 */
+
+static void ptm_free_handle_table(void)
+{
+    jekv_handle_info_t *table = g_handle_table;
+
+    JEKV_EPOCH_STORE(&g_handle_table, NULL);
+
+#if CONFIG_JEKV_EPOCH_READ
+    /*the epoch readers may be looking up the old table*/
+    jekv_epoch_synchronize();
+#endif
+
+    JEKV_FREE(table);
+}
 
 int jekv_ptm_is_in_using(void)
 {
@@ -28,9 +54,10 @@ struct dl_list *jekv_get_storage_list(void)
     return &g_storage_list;
 }
 
-struct dl_list *jekv_get_handle_list(void)
+jekv_handle_info_t *jekv_get_handle_table(uint32_t *count)
 {
-    return &g_handle_list;
+    *count = g_handle_table ? g_handle_max : 0;
+    return g_handle_table;
 }
 
 jekv_storage_t *jekv_ptm_find_storage(const char *partition_name)
@@ -47,6 +74,19 @@ jekv_storage_t *jekv_ptm_find_storage(const char *partition_name)
     return NULL;
 }
 
+bool jekv_ptm_has_storage(jekv_storage_t *storage)
+{
+    jekv_storage_t *entry = NULL;
+
+    dl_list_for_each(entry, &g_storage_list, jekv_storage_t, list)
+    {
+        if (entry == storage) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int jekv_ptm_init(const char *partition_name)
 {
     int err;
@@ -81,9 +121,8 @@ int jekv_ptm_deinit(const char *partition_name)
 {
     int err;
 
-    jekv_storage_t *storage   = NULL;
-    jekv_handle_info_t *entry = NULL;
-    jekv_handle_info_t *next;
+    jekv_storage_t *storage = NULL;
+    uint32_t i;
 
     if (!g_storage_list.next) {
         jekv_log_error("%s","Not Init");
@@ -97,17 +136,31 @@ int jekv_ptm_deinit(const char *partition_name)
         return JEKV_ERR_NOT_FOUND;
     }
 
+    /*an operation is still running in the storage*/
+    if (storage->users) {
+        jekv_log_error("%s busy", partition_name);
+        return JEKV_ERR_FAIL;
+    }
+
+#if CONFIG_JEKV_EPOCH_READ
+    /*the epoch readers take the storage lock from now on*/
+    jekv_epoch_write_begin(&storage->written);
+#endif
+
     /*delete all handle*/
-    dl_list_for_each_safe(entry, next, &g_handle_list, jekv_handle_info_t, list)
-    {
-        if (entry->storage == storage) {
-            jekv_log_debug("Destroy handle: %p, group=%d", entry, entry->group_id);
+    for (i = 0; g_handle_table && i < g_handle_max; i++) {
+        if (g_handle_table[i].id && g_handle_table[i].storage == storage) {
+            jekv_log_debug("Destroy handle: %p, group=%d", g_handle_table[i].id, g_handle_table[i].group_id);
 
-            dl_list_del(&entry->list);
-            jekv_handler_close(entry);
+            jekv_ptm_close_handle(&g_handle_table[i]);
         }
     }
 
+#if CONFIG_JEKV_EPOCH_READ
+    /*no reader has the storage of the closed handles*/
+    jekv_epoch_synchronize();
+#endif
+
     /*deteach from list*/
     dl_list_del(&storage->list);
 
@@ -117,117 +170,185 @@ int jekv_ptm_deinit(const char *partition_name)
     /*free storage*/
     JEKV_FREE(storage);
 
+    if (dl_list_empty(&g_storage_list) && !g_handle_num) {
+        ptm_free_handle_table();
+    }
+
     jekv_log_info("ptm deinit, err=%d", err);
 
     return err;
 }
 
-int jekv_ptm_open_handle(const char *partition_name, const char *group, jekv_open_mode_t mode,
-                           jekv_handle_info_t **handle)
+int jekv_ptm_check_open(const char *partition_name, jekv_open_mode_t mode, jekv_storage_t **storage)
 {
-    int err;
-    jekv_storage_t *storage = NULL;
-    uint8_t group_id;
-
     /*check init*/
     if (dl_list_empty(&g_storage_list)) {
         jekv_log_error("%s","not init");
         return JEKV_ERR_NOT_INIT;
     }
 
-    if (dl_list_len(&g_handle_list) >= JEKV_MAX_HANDLE_NUM) {
+    if (g_handle_num >= g_handle_max) {
         return JEKV_ERR_FAIL;
     }
 
     /* find partition*/
-    storage = jekv_ptm_find_storage(partition_name);
-    if (!storage) {
+    *storage = jekv_ptm_find_storage(partition_name);
+    if (!*storage) {
         jekv_log_warning("%s not init", partition_name);
         return JEKV_ERR_NOT_FOUND;
     }
 
     /* check write allowed*/
-    if (mode == JEKV_OP_READ_WRITE && storage->pt.readonly) {
+    if (mode == JEKV_OP_READ_WRITE && (*storage)->pt.readonly) {
         jekv_log_warning("%s can't be written", partition_name);
         return JEKV_ERR_READ_ONLY;
     }
 
-    /* get group id*/
-    err = jekv_storage_open_group(storage, group, true, &group_id);
-    if (err != JEKV_ERR_OK) {
-        return err;
+    return JEKV_ERR_OK;
+}
+
+int jekv_ptm_open_handle(jekv_storage_t *storage, uint8_t group_id, jekv_open_mode_t mode, jekv_handle_t *handle)
+{
+    int err;
+    uint32_t index;
+    jekv_handle_info_t *table;
+
+    /*the others may open handles while the group is opened*/
+    if (g_handle_num >= g_handle_max) {
+        return JEKV_ERR_FAIL;
+    }
+
+    if (!g_handle_table) {
+        table = JEKV_CALLOC(g_handle_max, sizeof(*table));
+        if (!table) {
+            return JEKV_ERR_NO_MEM;
+        }
+        JEKV_EPOCH_STORE(&g_handle_table, table);
+    }
+
+    /* take a free slot, there is one at least*/
+    for (index = 0; g_handle_table[index].id; index++) {
     }
 
+    /* a new generation, the closed handles of the slot are not matched*/
+    g_handle_gen = g_handle_gen < PTM_HANDLE_GEN_MAX ? g_handle_gen + 1 : 1;
+
     /* create handler*/
-    err = jekv_handler_open(storage, group_id, mode, handle);
+    err = jekv_handler_open(&g_handle_table[index], (jekv_handle_t)(((uintptr_t)g_handle_gen << PTM_HANDLE_INDEX_BITS) | index),
+                            storage, group_id, mode);
     if (err != JEKV_ERR_OK) {
         return err;
     }
 
-    /* add to handler list */
-    dl_list_add_tail(&g_handle_list, &(*handle)->list);
+    g_handle_num++;
+    *handle = g_handle_table[index].id;
 
-    jekv_log_debug("open %p", handle);
+    jekv_log_debug("open %p", *handle);
 
     return JEKV_ERR_OK;
 }
 
 int jekv_ptm_close_handle(jekv_handle_info_t *handle)
 {
-    jekv_handle_info_t *entry = NULL;
-    jekv_handle_info_t *next;
+    jekv_log_debug("close %p", handle->id);
 
-    jekv_log_debug("close %p", handle);
+    g_handle_num--;
+    return jekv_handler_close(handle);
+}
 
-    /*look up storage from storage list*/
-    dl_list_for_each_safe(entry, next, &g_handle_list, jekv_handle_info_t, list)
-    {
-        if (entry == handle) {
-            dl_list_del(&entry->list);
-            return jekv_handler_close(handle);
-        }
+jekv_handle_info_t *jekv_ptm_get_handle(jekv_handle_t handle)
+{
+    uint32_t index = (uint32_t)((uintptr_t)handle & PTM_HANDLE_INDEX_MASK);
+
+    /*a bounds check and a compare, the id of a free slot is NULL*/
+    if (!(handle && g_handle_table && index < g_handle_max && g_handle_table[index].id == handle)) {
+        return NULL;
     }
-    return JEKV_ERR_INVALID_HANDLE;
+    return &g_handle_table[index];
 }
 
-bool jekv_ptm_is_handle_valid(jekv_handle_info_t *handle)
+#if CONFIG_JEKV_EPOCH_READ
+jekv_handle_info_t *jekv_ptm_peek_handle(jekv_handle_t handle)
 {
-    bool found = false;
+    uint32_t index = (uint32_t)((uintptr_t)handle & PTM_HANDLE_INDEX_MASK);
+    jekv_handle_info_t *table = JEKV_EPOCH_LOAD(&g_handle_table);
 
-    jekv_handle_info_t *entry = NULL;
+    /*the max is not changed while the table is allocated*/
+    if (!(handle && table && index < g_handle_max && JEKV_EPOCH_LOAD(&table[index].id) == handle)) {
+        return NULL;
+    }
+    return &table[index];
+}
+#endif
 
-    /*look up storage from storage list*/
-    dl_list_for_each(entry, &g_handle_list, jekv_handle_info_t, list)
-    {
-        if (entry == handle) {
-            found = (entry->valid ? true : false);
-            break;
-        }
+int jekv_ptm_set_max_handles(uint32_t num)
+{
+    if (g_handle_num) {
+        jekv_log_warning("%u handles opened", g_handle_num);
+        return JEKV_ERR_FAIL;
     }
 
-    return found;
+    /*the table of the new size is allocated by the next open*/
+    ptm_free_handle_table();
+    g_handle_max = num;
+
+    return JEKV_ERR_OK;
 }
 
-int jekv_ptm_get_status(const char *partition_name, jekv_status_t *status)
+void jekv_ptm_set_group_id(jekv_storage_t *storage, uint8_t old_id, uint8_t new_id)
 {
-    jekv_handle_info_t *entry = NULL;
-    jekv_storage_t *storage   = jekv_ptm_find_storage(partition_name);
+    uint32_t i;
 
-    if (!storage) {
-        return JEKV_ERR_NOT_INIT;
+    for (i = 0; g_handle_table && i < g_handle_max; i++) {
+        if (g_handle_table[i].id && g_handle_table[i].storage == storage && g_handle_table[i].group_id == old_id) {
+            g_handle_table[i].group_id = new_id;
+        }
+    }
+}
+
+uint16_t jekv_ptm_get_handle_num(jekv_storage_t *storage)
+{
+    uint32_t i;
+    uint16_t num = 0;
+
+    /*look up handle table*/
+    for (i = 0; g_handle_table && i < g_handle_max; i++) {
+        if (g_handle_table[i].id && g_handle_table[i].storage == storage) {
+            num++;
+        }
     }
 
+    return num;
+}
+
+int jekv_ptm_get_status(jekv_storage_t *storage, jekv_status_t *status)
+{
     memset(status, 0, sizeof(*status));
 
     status->group_num = dl_list_len(&storage->group_list);
 
-    /*look up handler list*/
-    dl_list_for_each(entry, &g_handle_list, jekv_handle_info_t, list)
-    {
-        if (entry->storage == storage) {
-            status->handle_num++;
-        }
+    return jekv_sm_get_status(&storage->sm, status);
+}
+
+int jekv_ptm_compact(jekv_storage_t *storage, jekv_compact_stat_t *stat)
+{
+    int err;
+    uint32_t start;
+
+    memset(stat, 0, sizeof(*stat));
+
+    if (storage->pt.readonly) {
+        return JEKV_ERR_READ_ONLY;
     }
 
-    return jekv_sm_get_status(&storage->sm, status);
+    start = jekv_port_get_time_ms();
+
+    err = jekv_sm_compact(&storage->sm, stat);
+
+    stat->elapsed_ms = jekv_port_get_time_ms() - start;
+
+    jekv_log_debug("compact %s: err=%d,reclaimed=%u,written=%u,erased=%u,idle=%u,time=%u", storage->pt.name, err,
+                stat->reclaimed_slices, stat->written_bytes, stat->erased_sectors, stat->idle_sectors, stat->elapsed_ms);
+
+    return err;
 }
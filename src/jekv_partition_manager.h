@@ -11,6 +11,13 @@
 #include "jekv_storage.h"
 #include "jekv_handler.h"
 #include "jekv_iterator.h"
+#include "jekv_batch.h"
+#include "jekv_blob_reader.h"
+#include "jekv_blob_writer.h"
+#include "jekv_view.h"
+#include "jekv_cache.h"
+#include "jekv_ring.h"
+#include "jekv_queue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,10 +43,14 @@ int jekv_ptm_deinit(const char *partition_name);
 int jekv_ptm_is_in_using(void);
 
 /**
-  * @brief  open handle
+  * @brief  check a handle can be opened in the partition, get the partition storage
   */
-int jekv_ptm_open_handle(const char *partition_name, const char *group, jekv_open_mode_t mode,
-                           jekv_handle_info_t **handle);
+int jekv_ptm_check_open(const char *partition_name, jekv_open_mode_t mode, jekv_storage_t **storage);
+
+/**
+  * @brief  open handle of the opened group
+  */
+int jekv_ptm_open_handle(jekv_storage_t *storage, uint8_t group_id, jekv_open_mode_t mode, jekv_handle_t *handle);
 
 /**
   * @brief  close handle
@@ -47,19 +58,48 @@ int jekv_ptm_open_handle(const char *partition_name, const char *group, jekv_ope
 int jekv_ptm_close_handle(jekv_handle_info_t *handle);
 
 /**
-  * @brief  is handle valid
+  * @brief  get the opened handle information, NULL if the handle is closed or invalid
+  */
+jekv_handle_info_t *jekv_ptm_get_handle(jekv_handle_t handle);
+
+#if CONFIG_JEKV_EPOCH_READ
+/**
+  * @brief  get the opened handle information without the global lock, the reader is in the epoch
+  */
+jekv_handle_info_t *jekv_ptm_peek_handle(jekv_handle_t handle);
+#endif
+
+/**
+  * @brief  resize the handle table, no handle can be opened
   */
-bool jekv_ptm_is_handle_valid(jekv_handle_info_t *handle);
+int jekv_ptm_set_max_handles(uint32_t num);
+
+/**
+  * @brief  move the opened handles of the group to the new group id
+  */
+void jekv_ptm_set_group_id(jekv_storage_t *storage, uint8_t old_id, uint8_t new_id);
 
 /**
   * @brief  find parition storage by parition name
   */
 jekv_storage_t *jekv_ptm_find_storage(const char *partition_name);
 
+/**
+  * @brief  is the storage still in the storage list
+  */
+bool jekv_ptm_has_storage(jekv_storage_t *storage);
+
 struct dl_list *jekv_get_storage_list(void);
-struct dl_list *jekv_get_handle_list(void);
+jekv_handle_info_t *jekv_get_handle_table(uint32_t *count);
+
+/**
+  * @brief  num of the opened handles of the storage
+  */
+uint16_t jekv_ptm_get_handle_num(jekv_storage_t *storage);
+
+int jekv_ptm_get_status(jekv_storage_t *storage, jekv_status_t *status);
 
-int jekv_ptm_get_status(const char *partition_name, jekv_status_t *status);
+int jekv_ptm_compact(jekv_storage_t *storage, jekv_compact_stat_t *stat);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,439 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_queue"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_item.h"
+#include "jekv_sector_manager.h"
+#include "jekv_queue.h"
+#include "jekv_log.h"
+
+static jekv_queue_desc_t *queue_find(jekv_storage_t *storage, uint8_t group_id, const char *name)
+{
+    jekv_queue_desc_t *desc;
+
+    dl_list_for_each(desc, &storage->queues, jekv_queue_desc_t, list)
+    {
+        if (desc->group_id == group_id && !jekv_item_key_cmp(desc->name, name)) {
+            return desc;
+        }
+    }
+
+    return NULL;
+}
+
+static jekv_queue_desc_t *queue_create(jekv_storage_t *storage, uint8_t group_id, const char *name)
+{
+    jekv_queue_desc_t *desc;
+
+    desc = JEKV_CALLOC(1, sizeof(*desc));
+    if (!desc) {
+        return NULL;
+    }
+
+    jekv_item_key_copy(desc->name, name);
+    desc->group_id = group_id;
+
+    dl_list_add_tail(&storage->queues, &desc->list);
+
+    return desc;
+}
+
+/*give back the oldest sector of the queue, the sector is left to the next mount if the partition is read only*/
+static int queue_drop_oldest(jekv_storage_t *storage, jekv_queue_desc_t *desc)
+{
+    jekv_sector_t *sec = desc->secs[0];
+
+    desc->sec_count--;
+    memmove(desc->secs, desc->secs + 1, desc->sec_count * sizeof(desc->secs[0]));
+
+    if (desc->pop_sec > 0) {
+        desc->pop_sec--;
+    } else {
+        desc->pop_count = 0;
+        desc->pop_index = 0;
+    }
+
+    desc->acked = 0;
+
+    jekv_log_debug("drop sector 0x%x of %s,seq=%u", sec->address, desc->name, sec->ring_seq);
+
+    if (storage->pt.readonly) {
+        return JEKV_ERR_OK;
+    }
+
+    return jekv_sm_release_ring_sector(&storage->sm, sec);
+}
+
+/*drop the sectors of the queue, then the queue itself*/
+static int queue_del(jekv_storage_t *storage, jekv_queue_desc_t *desc)
+{
+    int err;
+
+    while (desc->sec_count > 0) {
+        err = queue_drop_oldest(storage, desc);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    dl_list_del(&desc->list);
+    JEKV_FREE(desc);
+
+    return JEKV_ERR_OK;
+}
+
+/*move the head to the first message after the acked ones, the sectors of all messages acked are given back*/
+static int queue_load_head(jekv_storage_t *storage, jekv_queue_desc_t *desc)
+{
+    int err;
+    jekv_item_t item;
+    int index = 0;
+    int i;
+
+    while (1) {
+        err = jekv_sector_read_queue_acked(desc->secs[0], &desc->acked);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        if (desc->acked < desc->secs[0]->ring_count || desc->sec_count == 1) {
+            break;
+        }
+
+        err = queue_drop_oldest(storage, desc);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    for (i = 0; i < desc->acked; i++) {
+        err = jekv_sector_read_ring_record(desc->secs[0], &index, &item);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        index += jekv_item_get_span(&item);
+    }
+
+    desc->pop_sec   = 0;
+    desc->pop_count = desc->acked;
+    desc->pop_index = (uint8_t)index;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_queue_load(jekv_storage_t *storage)
+{
+    int err;
+    jekv_sector_t *sec;
+    jekv_sector_t *next;
+    jekv_queue_desc_t *desc;
+    jekv_item_t item;
+    int index;
+
+    /*the queue sectors are in the serial order, so the sectors of a queue are added from the oldest*/
+    dl_list_for_each_safe(sec, next, &storage->sm.rings, jekv_sector_t, list)
+    {
+        if (sec->kind != JEKV_SECTOR_KIND_QUEUE) {
+            continue;
+        }
+
+        index = 0;
+
+        err = jekv_sector_read_ring_record(sec, &index, &item);
+        if (err == JEKV_ERR_NOT_FOUND) {
+            /*the power was off before the first message of the sector*/
+            jekv_log_debug("empty queue sector 0x%x", sec->address);
+
+            if (!storage->pt.readonly) {
+                jekv_sm_release_ring_sector(&storage->sm, sec);
+            }
+            continue;
+        } else if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        desc = queue_find(storage, item.group_id, item.name);
+        if (!desc) {
+            desc = queue_create(storage, item.group_id, item.name);
+            if (!desc) {
+                return JEKV_ERR_NO_MEM;
+            }
+        }
+
+        if (desc->sec_count == CONFIG_JEKV_QUEUE_SECTOR_MAX) {
+            /*the queue was written with a bigger CONFIG_JEKV_QUEUE_SECTOR_MAX*/
+            jekv_log_warning("too many sectors of %s", desc->name);
+
+            err = queue_drop_oldest(storage, desc);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+        }
+
+        desc->secs[desc->sec_count++] = sec;
+    }
+
+    dl_list_for_each(desc, &storage->queues, jekv_queue_desc_t, list)
+    {
+        err = jekv_sector_check_ring_last(desc->secs[desc->sec_count - 1]);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        err = queue_load_head(storage, desc);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        jekv_log_debug("queue %d:%s,sectors=%d,acked=%d", desc->group_id, desc->name, desc->sec_count,
+                       desc->acked);
+    }
+
+    return JEKV_ERR_OK;
+}
+
+void jekv_queue_deinit(jekv_storage_t *storage)
+{
+    jekv_queue_desc_t *desc;
+    jekv_queue_desc_t *next;
+
+    dl_list_for_each_safe(desc, next, &storage->queues, jekv_queue_desc_t, list)
+    {
+        dl_list_del(&desc->list);
+        JEKV_FREE(desc);
+    }
+}
+
+int jekv_queue_del_group(jekv_storage_t *storage, uint8_t group_id)
+{
+    int err;
+    jekv_queue_desc_t *desc;
+    jekv_queue_desc_t *next;
+
+    dl_list_for_each_safe(desc, next, &storage->queues, jekv_queue_desc_t, list)
+    {
+        if (desc->group_id == group_id) {
+            err = queue_del(storage, desc);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_queue_info_create(jekv_handle_info_t *handle, const char *name, jekv_queue_t *queue)
+{
+    jekv_queue_info_t *q;
+
+    q = JEKV_CALLOC(1, sizeof(*q));
+    if (!q) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    q->handle    = handle;
+    q->handle_id = handle->id;
+    snprintf(q->name, sizeof(q->name), "%s", name);
+
+    *queue = (jekv_queue_t)q;
+
+    return JEKV_ERR_OK;
+}
+
+/*
+    take an idle sector for the next messages, the queue never drops its messages.
+    The KV sectors are merged to free one if no other sector is idle.
+*/
+static int queue_new_sector(jekv_storage_t *storage, jekv_queue_desc_t *desc, jekv_sector_t **sector)
+{
+    int err;
+    uint32_t seq = 0;
+    jekv_sector_t *sec;
+
+    if (desc->sec_count == CONFIG_JEKV_QUEUE_SECTOR_MAX) {
+        jekv_log_debug("queue %s is full", desc->name);
+        return JEKV_ERR_NO_SPACE;
+    }
+
+    if (desc->sec_count > 0) {
+        sec = desc->secs[desc->sec_count - 1];
+        seq = sec->ring_seq + sec->ring_count;
+    }
+
+    err = jekv_sm_request_ring_sector(&storage->sm, &sec);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    err = jekv_sector_init_queue(sec, seq);
+
+    /*the sector without message is given back at mount if the header is not written*/
+    desc->secs[desc->sec_count++] = sec;
+
+    *sector = sec;
+
+    return err;
+}
+
+int jekv_queue_info_push(jekv_queue_info_t *queue, const void *data, uint32_t size)
+{
+    int err                 = JEKV_ERR_SECTOR_FULL;
+    jekv_storage_t *storage = queue->handle->storage;
+    jekv_queue_desc_t *desc;
+    jekv_sector_t *sec = NULL;
+
+    if (size > JEKV_QUEUE_MAX_DATA_SIZE) {
+        return JEKV_ERR_VALUE_TOO_LONG;
+    }
+
+    desc = queue_find(storage, queue->handle->group_id, queue->name);
+    if (!desc) {
+        desc = queue_create(storage, queue->handle->group_id, queue->name);
+        if (!desc) {
+            return JEKV_ERR_NO_MEM;
+        }
+    }
+
+    if (desc->sec_count > 0) {
+        sec = desc->secs[desc->sec_count - 1];
+        err = jekv_sector_write_ring_record(sec, desc->group_id, desc->name, data, size);
+    }
+
+    if (err == JEKV_ERR_SECTOR_FULL) {
+        err = queue_new_sector(storage, desc, &sec);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_sector_write_ring_record(sec, desc->group_id, desc->name, data, size);
+        }
+    }
+
+    return err;
+}
+
+/*move the head over the sectors of all messages popped*/
+static void queue_skip_popped(jekv_queue_desc_t *desc)
+{
+    while (desc->pop_sec + 1 < desc->sec_count && desc->pop_count >= desc->secs[desc->pop_sec]->ring_count) {
+        desc->pop_sec++;
+        desc->pop_count = 0;
+        desc->pop_index = 0;
+    }
+}
+
+int jekv_queue_info_read(jekv_queue_info_t *queue, void *data, uint32_t *size, bool pop)
+{
+    int err;
+    jekv_queue_desc_t *desc = queue_find(queue->handle->storage, queue->handle->group_id, queue->name);
+    jekv_sector_t *sec;
+    jekv_item_t item;
+    int index;
+
+    if (!desc || desc->sec_count == 0) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    queue_skip_popped(desc);
+
+    sec = desc->secs[desc->pop_sec];
+    if (desc->pop_count >= sec->ring_count) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    /*the dropped items before the head message are skipped*/
+    index = desc->pop_index;
+
+    err = jekv_sector_read_ring_record(sec, &index, &item);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    desc->pop_index = (uint8_t)index;
+
+    if (*size < item.length) {
+        *size = item.length;
+        return JEKV_ERR_VALUE_TOO_LONG;
+    }
+
+    *size = item.length;
+
+    err = jekv_sector_read_item_data(sec, index, &item, data, item.length);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (pop) {
+        desc->pop_index = (uint8_t)(index + jekv_item_get_span(&item));
+        desc->pop_count++;
+    }
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_queue_info_ack(jekv_queue_info_t *queue)
+{
+    int err;
+    jekv_storage_t *storage = queue->handle->storage;
+    jekv_queue_desc_t *desc = queue_find(storage, queue->handle->group_id, queue->name);
+
+    if (!desc || desc->sec_count == 0) {
+        return JEKV_ERR_OK;
+    }
+
+    queue_skip_popped(desc);
+
+    /*the sectors before the head are drained*/
+    while (desc->pop_sec > 0) {
+        err = queue_drop_oldest(storage, desc);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    err = jekv_sector_write_queue_acked(desc->secs[0], desc->acked, desc->pop_count);
+    if (err == JEKV_ERR_OK) {
+        desc->acked = desc->pop_count;
+    }
+
+    return err;
+}
+
+int jekv_queue_info_count(jekv_queue_info_t *queue, uint32_t *count)
+{
+    jekv_queue_desc_t *desc = queue_find(queue->handle->storage, queue->handle->group_id, queue->name);
+    int i;
+
+    *count = 0;
+
+    if (!desc || desc->sec_count == 0) {
+        return JEKV_ERR_OK;
+    }
+
+    for (i = desc->pop_sec; i < desc->sec_count; i++) {
+        *count += desc->secs[i]->ring_count;
+    }
+
+    *count -= desc->pop_count;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_queue_info_release(jekv_queue_info_t *queue)
+{
+    JEKV_FREE(queue);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_queue_info_del(jekv_handle_info_t *handle, const char *name)
+{
+    jekv_queue_desc_t *desc = queue_find(handle->storage, handle->group_id, name);
+
+    if (!desc) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    return queue_del(handle->storage, desc);
+}
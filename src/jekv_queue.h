@@ -0,0 +1,91 @@
+#ifndef __JEKV_QUEUE_H__
+#define __JEKV_QUEUE_H__
+
+#include <stdint.h>
+
+#include "dlist.h"
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_item.h"
+#include "jekv_sector.h"
+#include "jekv_storage.h"
+#include "jekv_handler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Queue: the messages of a queue are appended to queue sectors of its own, which are not collected by GC.
+    A pop only moves the head in memory, an ack clears the bits of the popped messages in the ack map of the
+    oldest sector, so the head is kept without writing the messages again. The sectors before the head are
+    erased and given back to the idle list when acked, the messages are never copied.
+*/
+
+/*sectors of a queue at most*/
+#ifndef CONFIG_JEKV_QUEUE_SECTOR_MAX
+#define CONFIG_JEKV_QUEUE_SECTOR_MAX 16
+#endif
+
+#if CONFIG_JEKV_QUEUE_SECTOR_MAX < 1 || CONFIG_JEKV_QUEUE_SECTOR_MAX > 255
+#error "CONFIG_JEKV_QUEUE_SECTOR_MAX out of range"
+#endif
+
+/*max message size, the last slice of the queue sector is the ack map*/
+#define JEKV_QUEUE_MAX_DATA_SIZE ((JEKV_QUEUE_ACK_SLICE - 1) * JEKV_SLICE_SIZE)
+
+/**
+  * @brief  queue, shared by the opened queues of the same name
+  */
+typedef struct {
+    struct dl_list list;             /**< queue link node                        */
+    char name[JEKV_MAX_KEY_LEN + 1]; /**< queue name                             */
+    uint8_t group_id;                /**< group id                               */
+    uint8_t sec_count;               /**< sector count                           */
+    uint8_t acked;                   /**< acked messages of the oldest sector    */
+    uint8_t pop_sec;                 /**< sector of the head, index of secs      */
+    uint8_t pop_count;               /**< popped messages of the head sector     */
+    uint8_t pop_index;               /**< slice index of the head message        */
+    jekv_sector_t *secs[CONFIG_JEKV_QUEUE_SECTOR_MAX]; /**< sectors, from the oldest */
+} jekv_queue_desc_t;
+
+/**
+  * @brief  kv queue information structure
+  */
+typedef struct jekv_queue_info_t {
+    jekv_handle_info_t *handle;      /**< handle the queue belongs to */
+    jekv_handle_t handle_id;         /**< id of the handle            */
+    char name[JEKV_MAX_KEY_LEN + 1]; /**< queue name                  */
+} jekv_queue_info_t;
+
+/*build the queues from the queue sectors, called at mount*/
+int jekv_queue_load(jekv_storage_t *storage);
+
+void jekv_queue_deinit(jekv_storage_t *storage);
+
+/*drop the queues of the group*/
+int jekv_queue_del_group(jekv_storage_t *storage, uint8_t group_id);
+
+int jekv_queue_info_create(jekv_handle_info_t *handle, const char *name, jekv_queue_t *queue);
+
+int jekv_queue_info_push(jekv_queue_info_t *queue, const void *data, uint32_t size);
+
+/*read the head message, pop: move the head to the next message*/
+int jekv_queue_info_read(jekv_queue_info_t *queue, void *data, uint32_t *size, bool pop);
+
+/*keep the head in flash, the sectors before it are given back*/
+int jekv_queue_info_ack(jekv_queue_info_t *queue);
+
+/*messages from the head*/
+int jekv_queue_info_count(jekv_queue_info_t *queue, uint32_t *count);
+
+int jekv_queue_info_release(jekv_queue_info_t *queue);
+
+/*drop all the messages of the queue*/
+int jekv_queue_info_del(jekv_handle_info_t *handle, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
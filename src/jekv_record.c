@@ -0,0 +1,193 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_record"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_item.h"
+#include "jekv_sector.h"
+#include "jekv_record.h"
+#include "jekv_log.h"
+
+#define RECORD_GC_ITEM(pblock, index) ((jekv_item_t *)((pblock) + ((index) + 1) * JEKV_SLICE_SIZE))
+
+static jekv_record_schema_t record_schemas[CONFIG_JEKV_RECORD_SCHEMA_NUM];
+static uint8_t record_schema_count;
+
+int jekv_record_add_schema(const jekv_record_schema_t *schema, uint8_t *schema_id)
+{
+    uint16_t i;
+
+    if (schema->size <= 8 || schema->size > JEKV_SINGLE_ITEM_MAX_DATA_SIZE || schema->field_count == 0 ||
+        !schema->fields) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    for (i = 0; i < schema->field_count; i++) {
+        if (schema->fields[i].size == 0 || schema->fields[i].offset + schema->fields[i].size > schema->size) {
+            return JEKV_ERR_INVALID_PARAM;
+        }
+    }
+
+    /*the same schema is registered once*/
+    for (i = 0; i < record_schema_count; i++) {
+        if (!memcmp(&record_schemas[i], schema, sizeof(*schema))) {
+            *schema_id = (uint8_t)i;
+            return JEKV_ERR_OK;
+        }
+    }
+
+    if (record_schema_count >= CONFIG_JEKV_RECORD_SCHEMA_NUM) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    record_schemas[record_schema_count] = *schema;
+    *schema_id                          = record_schema_count++;
+
+    jekv_log_debug("schema %u: size=%u,fields=%u", *schema_id, schema->size, schema->field_count);
+
+    return JEKV_ERR_OK;
+}
+
+const jekv_record_schema_t *jekv_record_get_schema(uint8_t schema_id)
+{
+    return schema_id < record_schema_count ? &record_schemas[schema_id] : NULL;
+}
+
+uint32_t jekv_record_make_delta(uint8_t *delta, uint8_t gen, uint16_t offset, const void *data, uint32_t size)
+{
+    delta[0] = gen;
+    delta[1] = (uint8_t)offset;
+    delta[2] = (uint8_t)(offset >> 8);
+
+    memcpy(delta + JEKV_RECORD_DELTA_HEAD_SIZE, data, size);
+
+    return JEKV_RECORD_DELTA_HEAD_SIZE + size;
+}
+
+int jekv_record_apply_delta(uint8_t *rec, uint32_t size, uint8_t gen, const uint8_t *delta, uint32_t len)
+{
+    uint32_t offset;
+
+    if (len <= JEKV_RECORD_DELTA_HEAD_SIZE || delta[0] != gen) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    offset = delta[1] | (delta[2] << 8);
+    len -= JEKV_RECORD_DELTA_HEAD_SIZE;
+
+    if (offset + len > size) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    if (rec) {
+        memcpy(rec + offset, delta + JEKV_RECORD_DELTA_HEAD_SIZE, len);
+    }
+
+    return JEKV_ERR_OK;
+}
+
+/*value of the item in the sector image*/
+static uint8_t *record_gc_value(jekv_item_t *item)
+{
+    return item->length > 8 ? (uint8_t *)(item + 1) : item->data;
+}
+
+/*fold the deltas of the record at index, from its folded sequence until one is not in the image*/
+static void record_gc_fold_one(uint8_t *pblock, int index, const uint8_t *deltas, int count)
+{
+    jekv_item_t *rec = RECORD_GC_ITEM(pblock, index);
+    jekv_item_t *delta;
+    uint8_t gen     = JEKV_ITEM_REC_GEN(rec);
+    uint8_t folded  = JEKV_ITEM_REC_FOLDED(rec);
+    uint8_t seq     = folded;
+    bool plain      = gen == 0 || JEKV_ITEM_IS_REWRITE(rec);
+    bool found      = true;
+    int i;
+
+    /*drop the stale deltas of the record*/
+    for (i = 0; i < count; i++) {
+        delta = RECORD_GC_ITEM(pblock, deltas[i]);
+
+        if (delta->group_id == rec->group_id && !jekv_item_key_cmp(delta->name, rec->name) &&
+            (gen == 0 || delta->seg_id < folded ||
+             jekv_record_apply_delta(NULL, rec->length, gen, record_gc_value(delta), delta->length) != JEKV_ERR_OK)) {
+            jekv_log_debug("gc: drop stale delta %d of %.*s", delta->seg_id, JEKV_MAX_KEY_LEN, rec->name);
+            delta->state = JEKV_ITEM_STATE_DROPED;
+        }
+    }
+
+    /*the value of the rewritable item is checked by its rewrite slice, it is not folded*/
+    while (!plain && found && seq < JEKV_RECORD_SEQ_MAX) {
+        found = false;
+
+        for (i = 0; i < count; i++) {
+            delta = RECORD_GC_ITEM(pblock, deltas[i]);
+
+            if (delta->state == JEKV_ITEM_STATE_USING && delta->seg_id == seq && delta->group_id == rec->group_id &&
+                !jekv_item_key_cmp(delta->name, rec->name)) {
+                jekv_record_apply_delta((uint8_t *)(rec + 1), rec->length, gen, record_gc_value(delta), delta->length);
+
+                delta->state = JEKV_ITEM_STATE_DROPED;
+                found        = true;
+                seq++;
+                break;
+            }
+        }
+    }
+
+    if (seq != folded) {
+        jekv_log_debug("gc: fold %.*s deltas %u~%u", JEKV_MAX_KEY_LEN, rec->name, folded, seq - 1);
+
+        rec->rec_folded = (uint8_t)~seq;
+        rec->crc_data   = jekv_port_crc32(UINT32_MAX, rec + 1, rec->length);
+        rec->crc_item   = jekv_item_crc_head(rec);
+    }
+}
+
+void jekv_record_gc_fold(jekv_sector_t *src, uint8_t *pblock)
+{
+    uint8_t deltas[JEKV_ENTRY_COUNT];
+    jekv_item_t *item;
+    int count = 0;
+    int index;
+    int span;
+
+    /*the values are encrypted in the image*/
+    if (src->pt->encrypted) {
+        return;
+    }
+
+    for (index = 0; index < JEKV_ENTRY_COUNT; index += span) {
+        item = RECORD_GC_ITEM(pblock, index);
+        span = jekv_item_get_span(item);
+
+        if (!(item->state == JEKV_ITEM_STATE_USING || item->state == JEKV_ITEM_STATE_DROPED) ||
+            index + span > JEKV_ENTRY_COUNT) {
+            break;
+        }
+
+        if (item->state == JEKV_ITEM_STATE_USING && JEKV_ITEM_IS_DELTA(item)) {
+            deltas[count++] = (uint8_t)index;
+        }
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    for (index = 0; index < JEKV_ENTRY_COUNT; index += span) {
+        item = RECORD_GC_ITEM(pblock, index);
+        span = jekv_item_get_span(item);
+
+        if (!(item->state == JEKV_ITEM_STATE_USING || item->state == JEKV_ITEM_STATE_DROPED) ||
+            index + span > JEKV_ENTRY_COUNT) {
+            break;
+        }
+
+        if (item->state == JEKV_ITEM_STATE_USING && item->type == JEKV_TYPE_BINARY &&
+            item->seg_id == JEKV_SEG_ID_ANY) {
+            record_gc_fold_one(pblock, index, deltas, count);
+        }
+    }
+}
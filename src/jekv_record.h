@@ -0,0 +1,50 @@
+#ifndef __JEKV_RECORD_H__
+#define __JEKV_RECORD_H__
+
+#include <stdint.h>
+#include "jekv_base.h"
+#include "jekv_item.h"
+#include "jekv_sector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*registered record schemas*/
+#ifndef CONFIG_JEKV_RECORD_SCHEMA_NUM
+#define CONFIG_JEKV_RECORD_SCHEMA_NUM 8
+#endif
+
+#if CONFIG_JEKV_RECORD_SCHEMA_NUM < 1 || CONFIG_JEKV_RECORD_SCHEMA_NUM > 255
+#error "CONFIG_JEKV_RECORD_SCHEMA_NUM out of range"
+#endif
+
+/*register the schema, the fields are referenced and not copied*/
+int jekv_record_add_schema(const jekv_record_schema_t *schema, uint8_t *schema_id);
+
+/*get the registered schema, NULL if the id is not registered*/
+const jekv_record_schema_t *jekv_record_get_schema(uint8_t schema_id);
+
+/*generation of the record written over the one of gen, never 0*/
+inline static uint8_t jekv_record_next_gen(uint8_t gen)
+{
+    return gen % JEKV_RECORD_SEQ_MAX + 1;
+}
+
+/*make the delta of the field at offset in delta, return the delta size*/
+uint32_t jekv_record_make_delta(uint8_t *delta, uint8_t gen, uint16_t offset, const void *data, uint32_t size);
+
+/*
+    apply the delta to the record of size bytes, rec: NULL to check the delta only.
+    JEKV_ERR_NOT_FOUND if the delta is stale or out of the record.
+*/
+int jekv_record_apply_delta(uint8_t *rec, uint32_t size, uint8_t gen, const uint8_t *delta, uint32_t len);
+
+/*fold the deltas in the sector image to their records in it, the stale deltas of the records are dropped*/
+void jekv_record_gc_fold(jekv_sector_t *src, uint8_t *pblock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
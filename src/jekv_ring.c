@@ -0,0 +1,501 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_ring"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_item.h"
+#include "jekv_sector_manager.h"
+#include "jekv_ring.h"
+#include "jekv_log.h"
+
+static jekv_ring_desc_t *ring_find(jekv_storage_t *storage, uint8_t group_id, const char *name)
+{
+    jekv_ring_desc_t *desc;
+
+    dl_list_for_each(desc, &storage->rings, jekv_ring_desc_t, list)
+    {
+        if (desc->group_id == group_id && !jekv_item_key_cmp(desc->name, name)) {
+            return desc;
+        }
+    }
+
+    return NULL;
+}
+
+static jekv_ring_desc_t *ring_create(jekv_storage_t *storage, uint8_t group_id, const char *name)
+{
+    jekv_ring_desc_t *desc;
+
+    desc = JEKV_CALLOC(1, sizeof(*desc));
+    if (!desc) {
+        return NULL;
+    }
+
+    jekv_item_key_copy(desc->name, name);
+    desc->group_id = group_id;
+
+    dl_list_add_tail(&storage->rings, &desc->list);
+
+    return desc;
+}
+
+/*sequence of the next record*/
+static uint32_t ring_next_seq(jekv_ring_desc_t *desc)
+{
+    jekv_sector_t *last;
+
+    if (desc->sec_count == 0) {
+        return 0;
+    }
+
+    last = desc->secs[desc->sec_count - 1];
+
+    return last->ring_seq + last->ring_count;
+}
+
+/*sector of the record of the sequence, NULL if the record is dropped or not written*/
+static jekv_sector_t *ring_find_sector(jekv_ring_desc_t *desc, uint32_t seq)
+{
+    int i;
+
+    for (i = desc->sec_count - 1; i >= 0; i--) {
+        if (seq - desc->secs[i]->ring_seq < desc->secs[i]->ring_count) {
+            return desc->secs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*drop the oldest sector of the ring, the sector is left to the next mount if the partition is read only*/
+static int ring_drop_oldest(jekv_storage_t *storage, jekv_ring_desc_t *desc)
+{
+    jekv_sector_t *sec = desc->secs[0];
+
+    desc->sec_count--;
+    memmove(desc->secs, desc->secs + 1, desc->sec_count * sizeof(desc->secs[0]));
+
+    jekv_log_debug("drop sector 0x%x of %s,seq=%u", sec->address, desc->name, sec->ring_seq);
+
+    if (storage->pt.readonly) {
+        return JEKV_ERR_OK;
+    }
+
+    return jekv_sm_release_ring_sector(&storage->sm, sec);
+}
+
+/*drop the sectors of the ring from the oldest, then the ring itself*/
+static int ring_del(jekv_storage_t *storage, jekv_ring_desc_t *desc)
+{
+    int err;
+
+    while (desc->sec_count > 0) {
+        err = ring_drop_oldest(storage, desc);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    dl_list_del(&desc->list);
+    JEKV_FREE(desc);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_ring_load(jekv_storage_t *storage)
+{
+    int err;
+    jekv_sector_t *sec;
+    jekv_sector_t *next;
+    jekv_ring_desc_t *desc;
+    jekv_item_t item;
+    int index;
+
+    /*the ring sectors are in the serial order, so the sectors of a ring are added from the oldest*/
+    dl_list_for_each_safe(sec, next, &storage->sm.rings, jekv_sector_t, list)
+    {
+        if (sec->kind != JEKV_SECTOR_KIND_RING) {
+            continue;
+        }
+
+        index = 0;
+
+        err = jekv_sector_read_ring_record(sec, &index, &item);
+        if (err == JEKV_ERR_NOT_FOUND) {
+            /*the power was off before the first record of the sector*/
+            jekv_log_debug("empty ring sector 0x%x", sec->address);
+
+            if (!storage->pt.readonly) {
+                jekv_sm_release_ring_sector(&storage->sm, sec);
+            }
+            continue;
+        } else if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        desc = ring_find(storage, item.group_id, item.name);
+        if (!desc) {
+            desc = ring_create(storage, item.group_id, item.name);
+            if (!desc) {
+                return JEKV_ERR_NO_MEM;
+            }
+        }
+
+        if (desc->sec_count == CONFIG_JEKV_RING_SECTOR_MAX) {
+            err = ring_drop_oldest(storage, desc);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+        }
+
+        desc->secs[desc->sec_count++] = sec;
+    }
+
+    dl_list_for_each(desc, &storage->rings, jekv_ring_desc_t, list)
+    {
+        err = jekv_sector_check_ring_last(desc->secs[desc->sec_count - 1]);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        jekv_log_debug("ring %d:%s,sectors=%d,next=%u", desc->group_id, desc->name, desc->sec_count,
+                       ring_next_seq(desc));
+    }
+
+    return JEKV_ERR_OK;
+}
+
+void jekv_ring_deinit(jekv_storage_t *storage)
+{
+    jekv_ring_desc_t *desc;
+    jekv_ring_desc_t *next;
+
+    dl_list_for_each_safe(desc, next, &storage->rings, jekv_ring_desc_t, list)
+    {
+        dl_list_del(&desc->list);
+        JEKV_FREE(desc);
+    }
+}
+
+int jekv_ring_del_group(jekv_storage_t *storage, uint8_t group_id)
+{
+    int err;
+    jekv_ring_desc_t *desc;
+    jekv_ring_desc_t *next;
+
+    dl_list_for_each_safe(desc, next, &storage->rings, jekv_ring_desc_t, list)
+    {
+        if (desc->group_id == group_id) {
+            err = ring_del(storage, desc);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
+/*
+    get the sector for the next records, an idle sector is taken until the ring has max_sectors sectors,
+    then the oldest sector is reused. The sectors over max_sectors are left by the ring opened of a bigger one.
+*/
+static int ring_new_sector(jekv_storage_t *storage, jekv_ring_desc_t *desc, uint8_t max_sectors,
+                           jekv_sector_t **sector)
+{
+    int err;
+    uint32_t seq = ring_next_seq(desc);
+    jekv_sector_t *sec;
+
+    while (desc->sec_count > max_sectors) {
+        err = ring_drop_oldest(storage, desc);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    if (desc->sec_count < max_sectors) {
+        err = jekv_sm_request_ring_sector(&storage->sm, &sec);
+    } else {
+        err = JEKV_ERR_NO_SPACE;
+    }
+
+    if (err == JEKV_ERR_NO_SPACE && desc->sec_count >= 2) {
+        /*drop the oldest records*/
+        sec = desc->secs[0];
+
+        desc->sec_count--;
+        memmove(desc->secs, desc->secs + 1, desc->sec_count * sizeof(desc->secs[0]));
+
+        jekv_log_debug("reuse sector 0x%x of %s,seq=%u", sec->address, desc->name, sec->ring_seq);
+
+        err = jekv_sm_recycle_ring_sector(&storage->sm, sec);
+    }
+
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    err = jekv_sector_init_ring(sec, seq);
+
+    /*the sector without record is given back at mount if the header is not written*/
+    desc->secs[desc->sec_count++] = sec;
+
+    *sector = sec;
+
+    return err;
+}
+
+int jekv_ring_info_create(jekv_handle_info_t *handle, const char *name, uint8_t max_sectors, jekv_ring_t *ring)
+{
+    jekv_ring_info_t *r;
+
+    r = JEKV_CALLOC(1, sizeof(*r));
+    if (!r) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    r->handle      = handle;
+    r->handle_id   = handle->id;
+    r->max_sectors = max_sectors;
+    snprintf(r->name, sizeof(r->name), "%s", name);
+
+    *ring = (jekv_ring_t)r;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_ring_info_append(jekv_ring_info_t *ring, const void *data, uint32_t size, uint32_t *seq)
+{
+    int err                 = JEKV_ERR_SECTOR_FULL;
+    jekv_storage_t *storage = ring->handle->storage;
+    jekv_ring_desc_t *desc;
+    jekv_sector_t *sec = NULL;
+
+    if (size > JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
+        return JEKV_ERR_VALUE_TOO_LONG;
+    }
+
+    desc = ring_find(storage, ring->handle->group_id, ring->name);
+    if (!desc) {
+        desc = ring_create(storage, ring->handle->group_id, ring->name);
+        if (!desc) {
+            return JEKV_ERR_NO_MEM;
+        }
+    }
+
+    if (desc->sec_count > 0) {
+        sec = desc->secs[desc->sec_count - 1];
+        err = jekv_sector_write_ring_record(sec, desc->group_id, desc->name, data, size);
+    }
+
+    if (err == JEKV_ERR_SECTOR_FULL) {
+        err = ring_new_sector(storage, desc, ring->max_sectors, &sec);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_sector_write_ring_record(sec, desc->group_id, desc->name, data, size);
+        }
+    }
+
+    if (err == JEKV_ERR_OK) {
+        *seq = sec->ring_seq + sec->ring_count - 1;
+    }
+
+    return err;
+}
+
+int jekv_ring_info_release(jekv_ring_info_t *ring)
+{
+    JEKV_FREE(ring);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_ring_info_del(jekv_handle_info_t *handle, const char *name)
+{
+    jekv_ring_desc_t *desc = ring_find(handle->storage, handle->group_id, name);
+
+    if (!desc) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    return ring_del(handle->storage, desc);
+}
+
+/*keep the slice indexes of the records of the sector*/
+static int ring_cursor_load(jekv_ring_cursor_info_t *cursor, jekv_sector_t *sec)
+{
+    int err;
+    int index = 0;
+    jekv_item_t item;
+
+    cursor->sec        = sec;
+    cursor->generation = sec->generation;
+    cursor->count      = 0;
+
+    while (1) {
+        err = jekv_sector_read_ring_record(sec, &index, &item);
+        if (err != JEKV_ERR_OK) {
+            break;
+        }
+
+        cursor->index[cursor->count++] = (uint8_t)index;
+        index += jekv_item_get_span(&item);
+    }
+
+    if (err != JEKV_ERR_NOT_FOUND) {
+        cursor->sec = NULL;
+        return err;
+    }
+
+    return JEKV_ERR_OK;
+}
+
+/*move the cursor to the record of the sequence, the indexes are kept again when it is in another sector*/
+static int ring_cursor_seek(jekv_ring_cursor_info_t *cursor, jekv_ring_desc_t *desc, uint32_t seq)
+{
+    int err;
+    jekv_sector_t *sec = ring_find_sector(desc, seq);
+
+    if (!sec) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    /*the sector is erased or its new records are not kept*/
+    if (sec != cursor->sec || sec->generation != cursor->generation || seq - sec->ring_seq >= cursor->count) {
+        err = ring_cursor_load(cursor, sec);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        if (seq - sec->ring_seq >= cursor->count) {
+            return JEKV_ERR_NOT_FOUND;
+        }
+    }
+
+    cursor->seq = seq;
+
+    return JEKV_ERR_OK;
+}
+
+static jekv_ring_desc_t *ring_cursor_find(jekv_ring_cursor_info_t *cursor)
+{
+    jekv_ring_desc_t *desc = ring_find(cursor->handle->storage, cursor->handle->group_id, cursor->name);
+
+    return desc && desc->sec_count > 0 ? desc : NULL;
+}
+
+int jekv_ring_cursor_info_create(jekv_ring_info_t *ring, jekv_ring_start_t start, jekv_ring_cursor_t *cursor)
+{
+    int err;
+    jekv_ring_cursor_info_t *c;
+    jekv_ring_desc_t *desc;
+
+    c = JEKV_CALLOC(1, sizeof(*c));
+    if (!c) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    c->handle    = ring->handle;
+    c->handle_id = ring->handle_id;
+    memcpy(c->name, ring->name, sizeof(c->name));
+
+    desc = ring_cursor_find(c);
+    if (!desc) {
+        err = JEKV_ERR_NOT_FOUND;
+    } else if (start == JEKV_RING_OLDEST) {
+        err = ring_cursor_seek(c, desc, desc->secs[0]->ring_seq);
+    } else {
+        err = ring_cursor_seek(c, desc, ring_next_seq(desc) - 1);
+    }
+
+    if (err != JEKV_ERR_OK) {
+        JEKV_FREE(c);
+        return err;
+    }
+
+    *cursor = (jekv_ring_cursor_t)c;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_ring_cursor_info_seek(jekv_ring_cursor_info_t *cursor, uint32_t seq)
+{
+    jekv_ring_desc_t *desc = ring_cursor_find(cursor);
+
+    if (!desc) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    return ring_cursor_seek(cursor, desc, seq);
+}
+
+int jekv_ring_cursor_info_move(jekv_ring_cursor_info_t *cursor, bool newer)
+{
+    jekv_ring_desc_t *desc = ring_cursor_find(cursor);
+    uint32_t oldest;
+    uint32_t seq;
+
+    if (!desc) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    if (newer) {
+        seq    = cursor->seq + 1;
+        oldest = desc->secs[0]->ring_seq;
+
+        /*the records from the cursor are dropped, go on from the oldest one*/
+        if ((int32_t)(seq - oldest) < 0) {
+            seq = oldest;
+        }
+    } else {
+        seq = cursor->seq - 1;
+    }
+
+    return ring_cursor_seek(cursor, desc, seq);
+}
+
+int jekv_ring_cursor_info_read(jekv_ring_cursor_info_t *cursor, void *data, uint32_t *size, uint32_t *seq)
+{
+    int err;
+    jekv_ring_desc_t *desc = ring_cursor_find(cursor);
+    jekv_item_t item;
+    int index;
+
+    if (!desc) {
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    /*the record may be dropped after the cursor moved to it*/
+    err = ring_cursor_seek(cursor, desc, cursor->seq);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    index = cursor->index[cursor->seq - cursor->sec->ring_seq];
+
+    err = jekv_pt_read_item(cursor->sec->pt, cursor->sec->address + (index + 1) * JEKV_SLICE_SIZE, &item);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (*size < item.length) {
+        *size = item.length;
+        return JEKV_ERR_VALUE_TOO_LONG;
+    }
+
+    *size = item.length;
+
+    if (seq) {
+        *seq = cursor->seq;
+    }
+
+    return jekv_sector_read_item_data(cursor->sec, index, &item, data, item.length);
+}
+
+int jekv_ring_cursor_info_release(jekv_ring_cursor_info_t *cursor)
+{
+    JEKV_FREE(cursor);
+
+    return JEKV_ERR_OK;
+}
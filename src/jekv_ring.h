@@ -0,0 +1,101 @@
+#ifndef __JEKV_RING_H__
+#define __JEKV_RING_H__
+
+#include <stdint.h>
+
+#include "dlist.h"
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_item.h"
+#include "jekv_sector.h"
+#include "jekv_storage.h"
+#include "jekv_handler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Ring log: the records of a ring are appended to ring sectors of its own, which are not collected by GC.
+    The header of a ring sector keeps the sequence of its first record, the other records follow it one by
+    one. When the last sector is full, the ring takes an idle sector until it has its max sectors, then the
+    oldest sector is erased and written again, so the oldest records are dropped a whole sector at a time.
+*/
+
+/*sectors of a ring at most*/
+#ifndef CONFIG_JEKV_RING_SECTOR_MAX
+#define CONFIG_JEKV_RING_SECTOR_MAX 8
+#endif
+
+#if CONFIG_JEKV_RING_SECTOR_MAX < 2 || CONFIG_JEKV_RING_SECTOR_MAX > 255
+#error "CONFIG_JEKV_RING_SECTOR_MAX out of range"
+#endif
+
+/**
+  * @brief  ring log, shared by the opened rings of the same name
+  */
+typedef struct {
+    struct dl_list list;             /**< ring link node          */
+    char name[JEKV_MAX_KEY_LEN + 1]; /**< ring name               */
+    uint8_t group_id;                /**< group id                */
+    uint8_t sec_count;               /**< sector count            */
+    jekv_sector_t *secs[CONFIG_JEKV_RING_SECTOR_MAX]; /**< sectors, from the oldest */
+} jekv_ring_desc_t;
+
+/**
+  * @brief  kv ring information structure
+  */
+typedef struct jekv_ring_info_t {
+    jekv_handle_info_t *handle;      /**< handle the ring belongs to */
+    jekv_handle_t handle_id;         /**< id of the handle           */
+    char name[JEKV_MAX_KEY_LEN + 1]; /**< ring name                  */
+    uint8_t max_sectors;             /**< sectors of the ring at most */
+} jekv_ring_info_t;
+
+/**
+  * @brief  kv ring cursor information structure, the record indexes of one sector are kept
+  */
+typedef struct jekv_ring_cursor_info_t {
+    jekv_handle_info_t *handle;      /**< handle the cursor belongs to */
+    jekv_handle_t handle_id;         /**< id of the handle             */
+    char name[JEKV_MAX_KEY_LEN + 1]; /**< ring name                    */
+    uint32_t seq;                    /**< sequence of the record       */
+    jekv_sector_t *sec;              /**< sector of the kept indexes   */
+    uint32_t generation;             /**< erase count of the sector    */
+    uint8_t count;                   /**< kept index count             */
+    uint8_t index[JEKV_ENTRY_COUNT]; /**< slice indexes of the records */
+} jekv_ring_cursor_info_t;
+
+/*build the rings from the ring sectors, called at mount*/
+int jekv_ring_load(jekv_storage_t *storage);
+
+void jekv_ring_deinit(jekv_storage_t *storage);
+
+/*drop the rings of the group*/
+int jekv_ring_del_group(jekv_storage_t *storage, uint8_t group_id);
+
+int jekv_ring_info_create(jekv_handle_info_t *handle, const char *name, uint8_t max_sectors, jekv_ring_t *ring);
+
+int jekv_ring_info_append(jekv_ring_info_t *ring, const void *data, uint32_t size, uint32_t *seq);
+
+int jekv_ring_info_release(jekv_ring_info_t *ring);
+
+/*drop all the records of the ring*/
+int jekv_ring_info_del(jekv_handle_info_t *handle, const char *name);
+
+int jekv_ring_cursor_info_create(jekv_ring_info_t *ring, jekv_ring_start_t start, jekv_ring_cursor_t *cursor);
+
+int jekv_ring_cursor_info_seek(jekv_ring_cursor_info_t *cursor, uint32_t seq);
+
+/*move to the newer record, or the older one*/
+int jekv_ring_cursor_info_move(jekv_ring_cursor_info_t *cursor, bool newer);
+
+int jekv_ring_cursor_info_read(jekv_ring_cursor_info_t *cursor, void *data, uint32_t *size, uint32_t *seq);
+
+int jekv_ring_cursor_info_release(jekv_ring_cursor_info_t *cursor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #define LOG_TAG "jekv_sec"
 #include "jekv_porting.h"
@@ -7,10 +8,22 @@
 #include "jekv_sector_manager.h"
 #include "jekv_sector.h"
 #include "jekv_debug.h"
+#include "jekv_lz.h"
+#include "jekv_pack.h"
+#include "jekv_record.h"
 #include "jekv_log.h"
 
 #define JEKV_SECTOR_CRC_LEN 24
 
+/*flash program page size, GC copy writes in bursts of this size*/
+#ifndef CONFIG_JEKV_COPY_BURST_SIZE
+#define CONFIG_JEKV_COPY_BURST_SIZE 256
+#endif
+
+#if CONFIG_JEKV_DEFER_DROP
+#define SECTOR_DROP_IS_PENDING(sec, index) ((sec)->drop_pending[(index) >> 3] & (1 << ((index) & 7)))
+#endif
+
 static uint32_t sector_crc32(jekv_sector_header_t *header)
 {
     return jekv_port_crc32(UINT32_MAX, &header->serial_number, JEKV_SECTOR_CRC_LEN);
@@ -22,6 +35,24 @@ int jekv_sector_set_state(jekv_sector_t *sec, jekv_sector_state_t state)
     return jekv_pt_write_raw(sec->pt, sec->address + JEKV_SECTOR_STATE_OFF_SET, &sec->state, sizeof(sec->state));
 }
 
+int jekv_sector_set_merged(jekv_sector_t *sec)
+{
+    uint8_t merged = JEKV_SECTOR_MERGED;
+
+    return jekv_pt_write_raw(sec->pt, sec->address + JEKV_SECTOR_MERGED_OFF_SET, &merged, sizeof(merged));
+}
+
+bool jekv_sector_is_merged(jekv_sector_t *sec)
+{
+    uint8_t merged;
+
+    if (jekv_pt_read_raw(sec->pt, sec->address + JEKV_SECTOR_MERGED_OFF_SET, &merged, sizeof(merged)) != JEKV_ERR_OK) {
+        return false;
+    }
+
+    return merged == JEKV_SECTOR_MERGED;
+}
+
 int jekv_sector_erase(jekv_sector_t *sec)
 {
     int err;
@@ -35,12 +66,23 @@ int jekv_sector_erase(jekv_sector_t *sec)
     }
 
     /*reset sector attibute*/
+    sec->generation++;
     sec->state   = JEKV_SECTOR_STATE_UNINIT;
     sec->version = CONFIG_NVS_VER_NUM;
+    sec->kind    = JEKV_SECTOR_KIND_KV;
 
     sec->next_free_slice = 0;
     sec->used_slice      = 0;
     sec->droped_slice    = 0;
+    sec->small_slice     = 0;
+    sec->small_size      = 0;
+    sec->ring_count      = 0;
+
+#if CONFIG_JEKV_DEFER_DROP
+    /*the items are gone, so are their marks*/
+    sec->drop_count = 0;
+    memset(sec->drop_pending, 0, sizeof(sec->drop_pending));
+#endif
 
     jekv_hash_clear(&sec->hash);
 
@@ -52,28 +94,158 @@ static uint32_t sector_get_next_address(jekv_sector_t *sec)
     return sec->address + JEKV_ENTRY_DATA_OFFSET + sec->next_free_slice * JEKV_SLICE_SIZE;
 }
 
-int jekv_sector_init(jekv_sector_t *sec)
+static int sector_init_header(jekv_sector_t *sec, jekv_sector_kind_t kind, uint32_t ring_seq)
 {
     jekv_sector_header_t header;
 
     sec->state   = JEKV_SECTOR_STATE_USING;
     sec->version = CONFIG_NVS_VER_NUM;
+    sec->kind    = kind;
 
     sec->next_free_slice = 0;
     sec->used_slice      = 0;
     sec->droped_slice    = 0;
+    sec->small_slice     = 0;
+    sec->small_size      = 0;
+    sec->ring_count      = 0;
+    sec->ring_seq        = ring_seq;
 
     memset(&header, 0xff, sizeof(header));
 
     header.magic         = JEKV_SECTOR_MAGIC;
     header.state         = JEKV_SECTOR_STATE_USING;
     header.version       = CONFIG_NVS_VER_NUM;
+    header.kind          = kind;
+    header.ring_seq      = ring_seq;
     header.serial_number = sec->serial_number;
     header.crc32         = sector_crc32(&header);
 
     return jekv_pt_write_raw(sec->pt, sec->address, &header, sizeof(header));
 }
 
+int jekv_sector_init(jekv_sector_t *sec)
+{
+    return sector_init_header(sec, JEKV_SECTOR_KIND_KV, UINT32_MAX);
+}
+
+int jekv_sector_init_ring(jekv_sector_t *sec, uint32_t seq)
+{
+    return sector_init_header(sec, JEKV_SECTOR_KIND_RING, seq);
+}
+
+int jekv_sector_init_queue(jekv_sector_t *sec, uint32_t seq)
+{
+    return sector_init_header(sec, JEKV_SECTOR_KIND_QUEUE, seq);
+}
+
+/*slices for the items, the ack map of the queue sector is not an item*/
+static int sector_get_entry_count(jekv_sector_t *sec)
+{
+    return sec->kind == JEKV_SECTOR_KIND_QUEUE ? JEKV_QUEUE_ACK_SLICE : JEKV_ENTRY_COUNT;
+}
+
+/*address of the rewrite slice, the last slice of the item*/
+static uint32_t sector_get_rewrite_address(jekv_sector_t *sec, int index, jekv_item_t *item)
+{
+    return sec->address + (index + jekv_item_get_span(item)) * JEKV_SLICE_SIZE;
+}
+
+/*crc32 of the item value in flash*/
+static int sector_crc_value(jekv_sector_t *sec, int index, jekv_item_t *item, uint32_t *crc)
+{
+    int err;
+    uint8_t *p;
+
+    if (item->length <= 8) {
+        *crc = jekv_port_crc32(UINT32_MAX, item->data, item->length);
+        return JEKV_ERR_OK;
+    }
+
+    p = JEKV_MALLOC(item->length);
+    if (!p) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    err = jekv_pt_read(sec->pt, sec->address + (index + 2) * JEKV_SLICE_SIZE, p, item->length);
+    if (err == JEKV_ERR_OK) {
+        *crc = jekv_port_crc32(UINT32_MAX, p, item->length);
+    }
+
+    JEKV_FREE(p);
+
+    return err;
+}
+
+/*
+    check the value of the rewritable item by the crc slots, the latest version matching the value is
+    committed if the power was off before its commit bit. JEKV_ERR_FAIL: the value matches no version,
+    the power was off while programming it.
+*/
+static int sector_check_rewrite(jekv_sector_t *sec, int index, jekv_item_t *item)
+{
+    int err;
+    jekv_item_rewrite_t rw;
+    uint32_t address;
+    uint32_t crc;
+    uint8_t commit;
+    int slot;
+
+    if (!JEKV_ITEM_IS_REWRITE(item)) {
+        return JEKV_ERR_OK;
+    }
+
+    address = sector_get_rewrite_address(sec, index, item);
+
+    err = jekv_pt_read_raw(sec->pt, address, &rw, sizeof(rw));
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    err = sector_crc_value(sec, index, item, &crc);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    for (slot = JEKV_REWRITE_SLOT_NUM - 1; slot >= 0; slot--) {
+        if (rw.crc[slot] == crc) {
+            break;
+        }
+    }
+
+    if (slot < 0) {
+        jekv_log_debug("rewrite: no version of %.*s", JEKV_MAX_KEY_LEN, item->name);
+        return JEKV_ERR_FAIL;
+    }
+
+    if (rw.commit & (1 << slot)) {
+        jekv_log_debug("rewrite: commit %.*s,slot=%d", JEKV_MAX_KEY_LEN, item->name, slot);
+
+        commit = rw.commit & ~(1 << slot);
+        err    = jekv_pt_write_raw(sec->pt, address + offsetof(jekv_item_rewrite_t, commit), &commit, sizeof(commit));
+    }
+
+    return err;
+}
+
+/*append the hash node of the using item, the packed item has the nodes of its live records, count the ring record*/
+static int sector_append_hash(jekv_sector_t *sec, int index, jekv_item_t *item)
+{
+    if (sec->kind != JEKV_SECTOR_KIND_KV) {
+        /*the records of the ring and the queue are read in order*/
+        sec->ring_count++;
+        return JEKV_ERR_OK;
+    }
+
+    if (item->type == JEKV_TYPE_PACK) {
+        return jekv_pack_load(sec, index, item, NULL);
+    }
+
+    jekv_hash_append(&sec->hash, item, index);
+    jekv_pack_count(sec, item, true);
+
+    return JEKV_ERR_OK;
+}
+
 /*
     update the follow 3 attribute and hash list
     sec->next_free_slice
@@ -84,6 +256,7 @@ static int sector_update_slice_and_hash(jekv_sector_t *sec)
 {
     jekv_item_t item;
     uint32_t offset;
+    int entry_count = sector_get_entry_count(sec);
     int err;
     int i;
 
@@ -92,7 +265,7 @@ static int sector_update_slice_and_hash(jekv_sector_t *sec)
     /*point to first item, skip sector header */
     offset = sec->address + JEKV_SLICE_SIZE;
 
-    for (i = 0; i < JEKV_ENTRY_COUNT;) {
+    for (i = 0; i < entry_count;) {
         err = jekv_pt_read_raw(sec->pt, offset, &item, sizeof(item));
         if (err != JEKV_ERR_OK) {
             sec->state = JEKV_SECTOR_STATE_INVALID;
@@ -109,15 +282,15 @@ static int sector_update_slice_and_hash(jekv_sector_t *sec)
             int span = jekv_item_get_span(&item);
 
             if (item.state == JEKV_ITEM_STATE_USING) {
-                if (item.crc_item == jekv_item_crc_head(&item)) {
-                    jekv_hash_append(&sec->hash, &item, i);
+                if (item.crc_item == jekv_item_crc_head(&item) && sector_check_rewrite(sec, i, &item) != JEKV_ERR_FAIL &&
+                    sector_append_hash(sec, i, &item) == JEKV_ERR_OK) {
 
                     /*using slice*/
                     sec->used_slice += span;
                     jekv_log_debug("add using %.*s", JEKV_MAX_KEY_LEN, item.name);
 
                 } else {
-                    /*crc fail: drop the item not write done, droped_slice will change in function*/
+                    /*crc fail or no live record: drop the item, droped_slice will change in function*/
                     sec->used_slice += span;
                     sec->droped_slice += span;
 
@@ -143,9 +316,9 @@ static int sector_update_slice_and_hash(jekv_sector_t *sec)
         }
     }
 
-    if (i >= JEKV_ENTRY_COUNT) {
+    if (i >= entry_count) {
         /*to the sector end*/
-        sec->next_free_slice = JEKV_ENTRY_COUNT;
+        sec->next_free_slice = entry_count;
     }
 
     jekv_log_debug("end update == %d %d %d", sec->next_free_slice, sec->used_slice, sec->droped_slice);
@@ -202,6 +375,17 @@ int jekv_sector_erase_item(jekv_sector_t *sec, int index, jekv_item_t *item, boo
     uint8_t state   = JEKV_ITEM_STATE_DROPED;
     int span        = jekv_item_get_span(item);
 
+    if (JEKV_INDEX_IS_PACKED(index)) {
+        return jekv_pack_erase(sec, index, item, erase_hash);
+    }
+
+#if CONFIG_JEKV_DEFER_DROP
+    if (SECTOR_DROP_IS_PENDING(sec, index)) {
+        /*droped already*/
+        return JEKV_ERR_OK;
+    }
+#endif
+
     jekv_log_debug("erase %.*s,span=%d", JEKV_MAX_KEY_LEN, item->name, span);
     sec->droped_slice += span;
 
@@ -209,11 +393,64 @@ int jekv_sector_erase_item(jekv_sector_t *sec, int index, jekv_item_t *item, boo
 
     if (erase_hash) {
         jekv_hash_erase(&sec->hash, index);
+        jekv_pack_count(sec, item, false);
     }
 
     return err;
 }
 
+int jekv_sector_supersede_item(jekv_sector_t *sec, int index, jekv_item_t *item)
+{
+#if CONFIG_JEKV_DEFER_DROP
+    if (!JEKV_INDEX_IS_PACKED(index) && JEKV_ITEM_CAN_DEFER_DROP(item)) {
+        if (SECTOR_DROP_IS_PENDING(sec, index)) {
+            return JEKV_ERR_OK;
+        }
+
+        jekv_log_debug("defer drop %.*s,index=%d", JEKV_MAX_KEY_LEN, item->name, index);
+
+        sec->drop_pending[index >> 3] |= 1 << (index & 7);
+        sec->drop_count++;
+        sec->droped_slice += jekv_item_get_span(item);
+
+        jekv_hash_erase(&sec->hash, index);
+        jekv_pack_count(sec, item, false);
+
+        return sec->drop_count >= CONFIG_JEKV_DEFER_DROP_MAX ? jekv_sector_flush_drops(sec) : JEKV_ERR_OK;
+    }
+#endif
+
+    return jekv_sector_erase_item(sec, index, item, true);
+}
+
+int jekv_sector_flush_drops(jekv_sector_t *sec)
+{
+#if CONFIG_JEKV_DEFER_DROP
+    int err;
+    uint8_t state = JEKV_ITEM_STATE_DROPED;
+    int index;
+
+    /*in the address order*/
+    for (index = 0; index < JEKV_ENTRY_COUNT && sec->drop_count > 0; index++) {
+        if (!SECTOR_DROP_IS_PENDING(sec, index)) {
+            continue;
+        }
+
+        err = jekv_pt_write_raw(sec->pt, sec->address + (index + 1) * JEKV_SLICE_SIZE, &state, sizeof(state));
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        sec->drop_pending[index >> 3] &= ~(1 << (index & 7));
+        sec->drop_count--;
+    }
+
+    jekv_log_debug("flush drops 0x%x", sec->address);
+#endif
+
+    return JEKV_ERR_OK;
+}
+
 int jekv_sector_load(jekv_partition_t *pt, jekv_sector_t *sec, int sec_index)
 {
     int err;
@@ -222,7 +459,15 @@ int jekv_sector_load(jekv_partition_t *pt, jekv_sector_t *sec, int sec_index)
     sec->address      = sec_index * pt->sec_size;
     sec->used_slice   = 0;
     sec->droped_slice = 0;
+    sec->small_slice  = 0;
+    sec->small_size   = 0;
+    sec->kind         = JEKV_SECTOR_KIND_KV;
+    sec->ring_count   = 0;
     sec->pt           = pt;
+#if CONFIG_JEKV_DEFER_DROP
+    sec->drop_count   = 0;
+    memset(sec->drop_pending, 0, sizeof(sec->drop_pending));
+#endif
 
     jekv_hash_init(&sec->hash);
 
@@ -254,6 +499,11 @@ int jekv_sector_load(jekv_partition_t *pt, jekv_sector_t *sec, int sec_index)
         /* good sector */
         sec->serial_number = header.serial_number;
         sec->state         = header.state;
+        sec->kind          = header.kind;
+        if (sec->kind != JEKV_SECTOR_KIND_RING && sec->kind != JEKV_SECTOR_KIND_QUEUE) {
+            sec->kind = JEKV_SECTOR_KIND_KV;
+        }
+        sec->ring_seq      = header.ring_seq;
         jekv_log_debug("check %d ok", sec_index);
     }
 
@@ -285,9 +535,78 @@ int jekv_sector_write_item_data(jekv_sector_t *sec, jekv_item_t *item, const voi
     return JEKV_ERR_OK;
 }
 
+/*read the counter bits, get the count of the cleared ones*/
+static int sector_read_counter_bits(jekv_sector_t *sec, int index, jekv_item_t *item, uint8_t *bits, uint32_t *cleared)
+{
+    int err;
+    uint32_t i;
+    uint8_t b;
+
+    err = jekv_pt_read_raw(sec->pt, sec->address + (index + 2) * JEKV_SLICE_SIZE, bits, item->length);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    *cleared = 0;
+
+    for (i = 0; i < item->length; i++) {
+        for (b = ~bits[i]; b; b &= b - 1) {
+            (*cleared)++;
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
+/**
+  * @brief  compressed data of the item, read by the decompressor
+  */
+typedef struct {
+    jekv_sector_t *sec; /**< sector of the item  */
+    uint32_t address;   /**< address of the data */
+} sector_lz_src_t;
+
+static int sector_lz_read(void *ctx, uint32_t offset, void *buf, uint32_t len)
+{
+    sector_lz_src_t *src = ctx;
+
+    return jekv_pt_read(src->sec->pt, src->address + offset, buf, len);
+}
+
 int jekv_sector_read_item_data(jekv_sector_t *sec, int found_slice_index, jekv_item_t *item, void *data, uint32_t size)
 {
-    if (size <= 8) {
+    if (JEKV_ITEM_IS_COUNTER(item)) {
+        uint8_t bits[JEKV_SINGLE_ITEM_MAX_DATA_SIZE];
+        uint32_t cleared;
+        uint32_t value;
+        int err;
+
+        if (size != sizeof(value) || item->length > sizeof(bits)) {
+            return JEKV_ERR_INVALID_LENGTH;
+        }
+
+        err = sector_read_counter_bits(sec, found_slice_index, item, bits, &cleared);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        value = item->count_base + cleared;
+        memcpy(data, &value, sizeof(value));
+
+        return JEKV_ERR_OK;
+    } else if (JEKV_ITEM_IS_LZ(item)) {
+        sector_lz_src_t src;
+
+        if (size != item->raw_length) {
+            return JEKV_ERR_INVALID_LENGTH;
+        }
+
+        /*decompress while reading the data slices*/
+        src.sec     = sec;
+        src.address = sec->address + (found_slice_index + 2) * JEKV_SLICE_SIZE;
+
+        return jekv_lz_decompress(sector_lz_read, &src, item->length, data, size);
+    } else if (size <= 8) {
         memcpy(data, item->data, size);
         return JEKV_ERR_OK;
     } else {
@@ -298,12 +617,10 @@ int jekv_sector_read_item_data(jekv_sector_t *sec, int found_slice_index, jekv_i
     }
 }
 
-int jekv_sector_write_item(jekv_sector_t *sec, uint8_t gid, jekv_type_t type, const char *key, const void *data,
-                             uint32_t size, uint8_t seg_id)
+/*check the item with data size can be written, get the slice count of it*/
+static int sector_check_write(jekv_sector_t *sec, uint32_t size, uint32_t *entry_cnt)
 {
     int err;
-    jekv_item_t item;
-    int write_cntry;
 
     if (sec->state == JEKV_SECTOR_STATE_INVALID) {
         jekv_log_debug("w:bad state");
@@ -328,42 +645,46 @@ int jekv_sector_write_item(jekv_sector_t *sec, uint8_t gid, jekv_type_t type, co
         return JEKV_ERR_VALUE_TOO_LONG;
     }
 
-    uint32_t totalSize = JEKV_SLICE_SIZE;
-    uint32_t entry_cnt = 1;
+    *entry_cnt = 1;
 
     /*calculate use entrys*/
     if (size > 8) {
         uint32_t roundedSize = (size + JEKV_SLICE_SIZE - 1) & (~(JEKV_SLICE_SIZE - 1));
-        totalSize += roundedSize;
-        entry_cnt += roundedSize / JEKV_SLICE_SIZE;
+        *entry_cnt += roundedSize / JEKV_SLICE_SIZE;
     }
 
-    if (sec->next_free_slice + entry_cnt > JEKV_ENTRY_COUNT) {
+    if (sec->next_free_slice + *entry_cnt > sector_get_entry_count(sec)) {
         /*data size out of sector free size*/
-        jekv_log_debug("w:bad cnt,free=%d,entry_cnt=%d", sec->next_free_slice, entry_cnt);
+        jekv_log_debug("w:bad cnt,free=%d,entry_cnt=%d", sec->next_free_slice, *entry_cnt);
         return JEKV_ERR_SECTOR_FULL;
     }
 
-    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, type, key, data, size, seg_id);
+    return JEKV_ERR_OK;
+}
 
-    write_cntry = sec->next_free_slice;
+/*write the inited item with its data*/
+static int sector_write(jekv_sector_t *sec, jekv_item_t *item, const void *data, uint32_t size, uint32_t entry_cnt)
+{
+    int err;
+    int write_cntry = sec->next_free_slice;
 
     if (size > 8) {
         /*multi entry item, write item head and data*/
-        err = jekv_sector_write_item_data(sec, &item, data, size, entry_cnt);
+        err = jekv_sector_write_item_data(sec, item, data, size, entry_cnt);
 
     } else {
         /*one entry item*/
-        err = jekv_sector_write_item_data(sec, &item, NULL, 0, entry_cnt);
+        err = jekv_sector_write_item_data(sec, item, NULL, 0, entry_cnt);
     }
 
     /*write OK, add to hash table*/
     if (err == JEKV_ERR_OK) {
-        jekv_hash_append(&sec->hash, &item, write_cntry);
+        jekv_hash_append(&sec->hash, item, write_cntry);
+        jekv_pack_count(sec, item, true);
     }
 
-    jekv_log_debug("write 0x%x | gid=%d,type=%d,key=%.*s,size=%d,err=%d", sec->address, item.group_id, item.type,
-                JEKV_MAX_KEY_LEN, item.name, item.length, err);
+    jekv_log_debug("write 0x%x | gid=%d,type=%d,key=%.*s,size=%d,err=%d", sec->address, item->group_id, item->type,
+                JEKV_MAX_KEY_LEN, item->name, item->length, err);
 
     if (err == JEKV_ERR_SECTOR_FULL && sec->state != JEKV_SECTOR_STATE_FULL) {
         jekv_sector_set_state(sec, JEKV_SECTOR_STATE_FULL);
@@ -372,95 +693,682 @@ int jekv_sector_write_item(jekv_sector_t *sec, uint8_t gid, jekv_type_t type, co
     return err;
 }
 
-int jekv_sector_find_item(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type, const char *key, int *item_index,
-                            jekv_item_t *item, uint8_t seg_index, jekv_seg_start_t seg_start)
+int jekv_sector_write_item(jekv_sector_t *sec, uint8_t gid, jekv_type_t type, const char *key, const void *data,
+                             uint32_t size, uint8_t seg_id)
 {
-    uint32_t start = *item_index;
-    uint32_t end   = sec->next_free_slice;
-
-    uint32_t offset;
-    int slice_index;
-    int span;
     int err;
-    int key_len = 0;
-
-    jekv_log_debug("sec find: gid=%d,type=%d,key=%.*s,index=%d, seg=%d,%d", group_id, type, JEKV_MAX_KEY_LEN,
-                (key ? key : "null"), *item_index, seg_index, seg_start);
+    jekv_item_t item;
+    uint32_t entry_cnt;
 
-    if (sec->state == JEKV_SECTOR_STATE_CRASH || sec->state == JEKV_SECTOR_STATE_INVALID ||
-        sec->state == JEKV_SECTOR_STATE_UNINIT) {
-        jekv_log_debug("find: bad state");
-        return JEKV_ERR_NOT_FOUND;
+    err = sector_check_write(sec, size, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
     }
 
-    if (start >= JEKV_ENTRY_COUNT) {
-        jekv_log_debug("find err: start=%d", start);
-        return JEKV_ERR_NOT_FOUND;
-    }
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, type, key, data, size, seg_id);
 
-    if (end > JEKV_ENTRY_COUNT) {
-        end = JEKV_ENTRY_COUNT;
+    return sector_write(sec, &item, data, size, entry_cnt);
+}
+
+int jekv_sector_write_ring_record(jekv_sector_t *sec, uint8_t gid, const char *name, const void *data,
+                                  uint32_t size)
+{
+    int err;
+    jekv_item_t item;
+    uint32_t entry_cnt;
+
+    err = sector_check_write(sec, size, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
     }
 
-    jekv_log_debug("read item start =%d,end=%d", start, end);
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, JEKV_TYPE_BINARY, name, data, size, JEKV_SEG_ID_ANY);
 
-    while (start < end) {
-        if (key) {
-            /*The key is valid, so the hash value can be calculated and compared*/
+    err = jekv_sector_write_item_data(sec, &item, size > 8 ? data : NULL, size, entry_cnt);
+    if (err == JEKV_ERR_OK) {
+        sec->ring_count++;
+    }
 
-            jekv_item_init(item, JEKV_ITEM_STATE_USING, group_id, type, key, NULL, 0, seg_index);
+    jekv_log_debug("ring 0x%x | gid=%d,name=%.*s,seq=%u,size=%d,err=%d", sec->address, gid, JEKV_MAX_KEY_LEN, name,
+                   sec->ring_seq + sec->ring_count - 1, size, err);
 
-            jekv_log_debug("start =%d", start);
+    return err;
+}
 
-            slice_index = jekv_hash_find(&sec->hash, start, item);
-            if (slice_index < 0) {
-                return JEKV_ERR_NOT_FOUND;
-            }
+int jekv_sector_read_ring_record(jekv_sector_t *sec, int *index, jekv_item_t *item)
+{
+    int err;
 
-            /*found hash match*/
-            start = slice_index;
-            jekv_log_debug("found start =%d", start);
+    while (*index < sec->next_free_slice) {
+        err = jekv_pt_read_item(sec->pt, sec->address + (*index + 1) * JEKV_SLICE_SIZE, item);
+        if (err != JEKV_ERR_OK) {
+            return err;
         }
 
-        /*point to first item, skip sector header */
-        offset = sec->address + (start + 1) * JEKV_SLICE_SIZE;
+        if (item->state == JEKV_ITEM_STATE_USING) {
+            return JEKV_ERR_OK;
+        }
 
-        jekv_log_debug("read item start =%d,offset=%d", start, offset);
+        *index += jekv_item_get_span(item);
+    }
 
-        err = jekv_pt_read_item(sec->pt, offset, item);
-        if (err != JEKV_ERR_OK) {
-            sec->state = JEKV_SECTOR_STATE_INVALID;
+    return JEKV_ERR_NOT_FOUND;
+}
+
+int jekv_sector_check_ring_last(jekv_sector_t *sec)
+{
+    int err;
+    jekv_item_t item;
+    jekv_item_t last;
+    int last_index = -1;
+    int index      = 0;
+    uint8_t *p;
+
+    while (1) {
+        err = jekv_sector_read_ring_record(sec, &index, &item);
+        if (err == JEKV_ERR_NOT_FOUND) {
+            break;
+        } else if (err != JEKV_ERR_OK) {
             return err;
         }
 
-        span = jekv_item_get_span(item);
+        last       = item;
+        last_index = index;
+        index += jekv_item_get_span(&item);
+    }
 
-        jekv_log_debug("found start =%d,span=%d", start, span);
+    if (last_index < 0 || last.length <= 8) {
+        return JEKV_ERR_OK;
+    }
 
-        if (item->state == JEKV_ITEM_STATE_DROPED) {
-            /*droped*/
-            start += span;
+    p = JEKV_MALLOC(last.length);
+    if (!p) {
+        return JEKV_ERR_NO_MEM;
+    }
 
-            jekv_log_debug("found drop");
+    err = jekv_pt_read(sec->pt, sec->address + (last_index + 2) * JEKV_SLICE_SIZE, p, last.length);
+    if (err == JEKV_ERR_OK && jekv_port_crc32(UINT32_MAX, p, last.length) != last.crc_data) {
+        jekv_log_warning("crc:drop last record of %.*s", JEKV_MAX_KEY_LEN, last.name);
 
-        } else if (item->state == JEKV_ITEM_STATE_USING) {
-            if (key) {
-                key_len = strnlen(key, JEKV_MAX_KEY_LEN);
-            }
+        jekv_sector_erase_item(sec, last_index, &last, false);
+        sec->ring_count--;
+    }
 
-            /*using, check item match*/
-            if (item->state == JEKV_ITEM_STATE_USING && (group_id == JEKV_GROUP_ID_ANY || group_id == item->group_id) &&
-                ((type == JEKV_TYPE_ANY || type == item->type) ||
-                 (type == JEKV_TYPE_ANY_WITHOUT_SEG && item->type != JEKV_TYPE_BLOB_SEG)) &&
-                (seg_index == JEKV_SEG_ID_ANY || seg_index == item->seg_id) &&
-                (seg_start == JEKV_SEG_START_ANY || (item->seg_id >= seg_start && item->seg_id - seg_start < 0x80)) &&
-                (!key || !strncmp(item->name, key, key_len))) {
-                *item_index = start;
-                jekv_log_debug("found match,start=%d,type=%d,item.type=%d", start, type, item->type);
+    JEKV_FREE(p);
 
-                return JEKV_ERR_OK;
+    return err;
+}
 
-            } else {
+static uint32_t sector_get_ack_address(jekv_sector_t *sec)
+{
+    return sec->address + (JEKV_QUEUE_ACK_SLICE + 1) * JEKV_SLICE_SIZE;
+}
+
+int jekv_sector_read_queue_acked(jekv_sector_t *sec, uint8_t *acked)
+{
+    int err;
+    uint8_t map[JEKV_SLICE_SIZE];
+    int count = 0;
+    int i;
+
+    err = jekv_pt_read_raw(sec->pt, sector_get_ack_address(sec), map, sizeof(map));
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /*the bits are cleared in order, a torn write only leaves some of its bits*/
+    for (i = 0; i < JEKV_SLICE_SIZE * 8 && !(map[i / 8] & (1 << (i % 8))); i++) {
+        count++;
+    }
+
+    *acked = count < sec->ring_count ? (uint8_t)count : sec->ring_count;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_sector_write_queue_acked(jekv_sector_t *sec, uint8_t old, uint8_t acked)
+{
+    uint8_t map[JEKV_SLICE_SIZE];
+    int first = old / 8;
+    int last;
+    int bits;
+    int i;
+
+    if (acked <= old) {
+        return JEKV_ERR_OK;
+    }
+
+    last = (acked - 1) / 8;
+
+    for (i = first; i <= last; i++) {
+        bits   = acked - i * 8;
+        map[i] = bits >= 8 ? 0 : (uint8_t)(0xff << bits);
+    }
+
+    jekv_log_debug("queue 0x%x | ack %d~%d", sec->address, old, acked);
+
+    return jekv_pt_write_raw(sec->pt, sector_get_ack_address(sec) + first, map + first, last - first + 1);
+}
+
+int jekv_sector_write_rewrite_item(jekv_sector_t *sec, uint8_t gid, jekv_type_t type, const char *key,
+                                   const void *data, uint32_t size)
+{
+    int err;
+    jekv_item_t item;
+    jekv_item_rewrite_t rw;
+    uint32_t entry_cnt;
+    int index;
+
+    if (size > 8 && sec->pt->encrypted) {
+        /*the cleared bits of the value are not kept by the encrypted data*/
+        return JEKV_ERR_NOT_SUPPORT;
+    }
+
+    err = sector_check_write(sec, size, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /*rewrite slice*/
+    entry_cnt++;
+
+    if (sec->next_free_slice + entry_cnt > JEKV_ENTRY_COUNT) {
+        jekv_log_debug("w:bad cnt,free=%d,entry_cnt=%d", sec->next_free_slice, entry_cnt);
+        return JEKV_ERR_SECTOR_FULL;
+    }
+
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, type, key, data, size, JEKV_SEG_ID_ANY);
+
+    item.recv1    = JEKV_ITEM_ATTR_REWRITE;
+    item.crc_item = jekv_item_crc_head(&item);
+
+    memset(&rw, 0xff, sizeof(rw));
+    rw.crc[0] = jekv_port_crc32(UINT32_MAX, data, size);
+    rw.commit = (uint8_t)~0x1;
+
+    index = sec->next_free_slice;
+
+    err = sector_write(sec, &item, data, size, entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /*the item is dropped at loading until the slot 0 is written*/
+    return jekv_pt_write_raw(sec->pt, sector_get_rewrite_address(sec, index, &item), &rw, sizeof(rw));
+}
+
+int jekv_sector_write_lz_item(jekv_sector_t *sec, uint8_t gid, jekv_type_t type, const char *key, const void *data,
+                              uint32_t size, uint32_t raw_length)
+{
+    int err;
+    jekv_item_t item;
+    uint32_t entry_cnt;
+
+    if (size <= 8) {
+        /*no room for the raw length in the item*/
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    err = sector_check_write(sec, size, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, type, key, data, size, JEKV_SEG_ID_ANY);
+
+    item.recv1      = JEKV_ITEM_ATTR_LZ;
+    item.raw_length = (uint16_t)raw_length;
+    item.crc_item   = jekv_item_crc_head(&item);
+
+    return sector_write(sec, &item, data, size, entry_cnt);
+}
+
+int jekv_sector_write_record(jekv_sector_t *sec, uint8_t gid, const char *key, const void *data, uint32_t size,
+                             uint8_t gen)
+{
+    int err;
+    jekv_item_t item;
+    uint32_t entry_cnt;
+
+    if (size <= 8) {
+        /*no room for the generation in the item*/
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    err = sector_check_write(sec, size, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, JEKV_TYPE_BINARY, key, data, size, JEKV_SEG_ID_ANY);
+
+    item.rec_gen  = (uint8_t)~gen;
+    item.crc_item = jekv_item_crc_head(&item);
+
+    return sector_write(sec, &item, data, size, entry_cnt);
+}
+
+int jekv_sector_rewrite_item(jekv_sector_t *sec, int index, jekv_item_t *item, const void *data, uint32_t size)
+{
+    int err;
+    jekv_item_rewrite_t rw;
+    uint8_t buf[JEKV_SLICE_SIZE];
+    const uint8_t *p = data;
+    uint32_t address = sec->address + (index + 1) * JEKV_SLICE_SIZE;
+    uint32_t rw_address;
+    uint32_t offset;
+    uint32_t len;
+    uint32_t crc;
+    uint32_t i;
+    int slot;
+
+    if (size != item->length || JEKV_ITEM_IS_COUNTER(item) || JEKV_ITEM_IS_LZ(item)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    if (size > 8 && sec->pt->encrypted) {
+        return JEKV_ERR_NOT_SUPPORT;
+    }
+
+    /*the new value can be programmed only if it clears bits of the old one*/
+    for (offset = 0; offset < size; offset += len) {
+        len = size - offset < sizeof(buf) ? size - offset : sizeof(buf);
+
+        if (size <= 8) {
+            memcpy(buf, item->data, size);
+        } else {
+            err = jekv_pt_read(sec->pt, address + JEKV_SLICE_SIZE + offset, buf, len);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+        }
+
+        for (i = 0; i < len; i++) {
+            if ((buf[i] & p[offset + i]) != p[offset + i]) {
+                return JEKV_ERR_FAIL;
+            }
+        }
+    }
+
+    /*the value of the pinned sector is read in place, keep it*/
+    if (!JEKV_ITEM_IS_REWRITE(item) || sec->pin_count > 0) {
+        return JEKV_ERR_NO_SPACE;
+    }
+
+    rw_address = sector_get_rewrite_address(sec, index, item);
+
+    err = jekv_pt_read_raw(sec->pt, rw_address, &rw, sizeof(rw));
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /*the slot after the last written one, the slots of interrupted rewrites are skipped*/
+    for (slot = JEKV_REWRITE_SLOT_NUM; slot > 0 && rw.crc[slot - 1] == UINT32_MAX; slot--) {
+    }
+
+    if (slot >= JEKV_REWRITE_SLOT_NUM) {
+        jekv_log_debug("rewrite: no slot of %.*s", JEKV_MAX_KEY_LEN, item->name);
+        return JEKV_ERR_NO_SPACE;
+    }
+
+    crc = jekv_port_crc32(UINT32_MAX, data, size);
+
+    err = jekv_pt_write_raw(sec->pt, rw_address + slot * sizeof(crc), &crc, sizeof(crc));
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_REWRITE, JEKV_TRACE_REWRITE_AFTER_CRC);
+
+    if (size <= 8) {
+        /*the value in the item is not encrypted*/
+        err = jekv_pt_write_raw(sec->pt, address + offsetof(jekv_item_t, data), data, size);
+    } else {
+        err = jekv_pt_write(sec->pt, address + JEKV_SLICE_SIZE, data, size);
+    }
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_REWRITE, JEKV_TRACE_REWRITE_AFTER_VALUE);
+
+    rw.commit &= ~(1 << slot);
+
+    err = jekv_pt_write_raw(sec->pt, rw_address + offsetof(jekv_item_rewrite_t, commit), &rw.commit,
+                            sizeof(rw.commit));
+
+    jekv_log_debug("rewrite %.*s: slot=%d,size=%u,err=%d", JEKV_MAX_KEY_LEN, item->name, slot, size, err);
+
+    return err;
+}
+
+int jekv_sector_write_blob_seg(jekv_sector_t *sec, uint8_t gid, const char *key, const void *data, uint32_t size,
+                               const uint8_t *ver, int seg)
+{
+    int err;
+    jekv_item_t item;
+    uint32_t entry_cnt;
+    int page = JEKV_BLOB_SEG_PAGE(seg);
+
+    if (page == 0) {
+        return jekv_sector_write_item(sec, gid, JEKV_TYPE_BLOB_SEG, key, data, size, JEKV_BLOB_SEG_ID(ver, seg));
+    }
+
+    if (size < JEKV_BLOB_PAGE_SEG_MIN_SIZE) {
+        jekv_log_debug("w:seg %d too small, size=%u", seg, size);
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    err = sector_check_write(sec, size, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, JEKV_TYPE_BLOB_SEG, key, NULL, size, JEKV_BLOB_SEG_ID(ver, seg));
+
+    item.crc_data = jekv_port_crc32(UINT32_MAX, data, size);
+    item.seg_page = (uint8_t)~page;
+    item.crc_item = jekv_item_crc_head(&item);
+
+    return sector_write(sec, &item, data, size, entry_cnt);
+}
+
+int jekv_sector_write_counter(jekv_sector_t *sec, uint8_t gid, const char *key, uint32_t base)
+{
+    int err;
+    jekv_item_t item;
+    uint32_t entry_cnt;
+
+    err = sector_check_write(sec, JEKV_COUNTER_BITS_SIZE, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, JEKV_TYPE_UINT32, key, NULL, JEKV_COUNTER_BITS_SIZE,
+                   JEKV_SEG_ID_ANY);
+
+    /*the data slices are left erased, every bit is cleared by an increment*/
+    item.count_base = base;
+    item.crc_item   = jekv_item_crc_head(&item);
+
+    return sector_write(sec, &item, NULL, 0, entry_cnt);
+}
+
+int jekv_sector_add_counter(jekv_sector_t *sec, int index, jekv_item_t *item, uint32_t step, uint32_t *value)
+{
+    int err;
+    uint8_t bits[JEKV_SINGLE_ITEM_MAX_DATA_SIZE];
+    uint32_t cleared;
+    uint32_t first = 0;
+    uint32_t last  = 0;
+    uint32_t i;
+    uint32_t left = step;
+
+    if (!JEKV_ITEM_IS_COUNTER(item) || item->length > sizeof(bits)) {
+        return JEKV_ERR_INVALID_PARAM;
+    }
+
+    err = sector_read_counter_bits(sec, index, item, bits, &cleared);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (step > item->length * 8 - cleared) {
+        return JEKV_ERR_NO_SPACE;
+    }
+
+    /*clear the bits in order, skip the ones cleared before*/
+    for (i = 0; i < item->length && left > 0; i++) {
+        if (bits[i] == 0) {
+            continue;
+        }
+
+        if (left == step) {
+            first = i;
+        }
+
+        while (bits[i] && left > 0) {
+            bits[i] &= bits[i] - 1;
+            left--;
+        }
+
+        last = i;
+    }
+
+    if (step > 0) {
+        /*program the changed bytes only, the cleared bits are kept by the flash*/
+        err = jekv_pt_write_raw(sec->pt, sec->address + (index + 2) * JEKV_SLICE_SIZE + first, bits + first,
+                                last - first + 1);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    *value = item->count_base + cleared + step;
+
+    jekv_log_debug("counter %.*s: base=%u,cleared=%u,step=%u", JEKV_MAX_KEY_LEN, item->name, item->count_base, cleared,
+                   step);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_sector_write_blob_desc(jekv_sector_t *sec, uint8_t gid, const char *key, uint32_t all_size, int seg_count,
+                                const uint8_t *ver)
+{
+    int err;
+    jekv_item_t item;
+    uint32_t entry_cnt;
+    int write_cntry;
+    int ver_len  = JEKV_BLOB_EXT_SIZE(seg_count) - sizeof(uint32_t);
+    bool has_ext = jekv_item_get_blob_desc_span(ver, seg_count) > 1;
+    uint8_t *ext;
+    uint32_t crc;
+
+    err = sector_check_write(sec, has_ext ? JEKV_BLOB_EXT_SIZE(seg_count) : 8, &entry_cnt);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    jekv_item_init(&item, JEKV_ITEM_STATE_USING, gid, JEKV_TYPE_BLOB, key, NULL, 8, JEKV_SEG_ID_ANY);
+
+    item.all_size     = all_size;
+    item.seg_count    = seg_count & 0xff;
+    item.seg_count_hi = (uint8_t)~(seg_count >> 8);
+    item.resv2        = 0xff;
+
+    write_cntry = sec->next_free_slice;
+
+    if (has_ext) {
+        ext = JEKV_MALLOC(JEKV_BLOB_EXT_SIZE(seg_count));
+        if (!ext) {
+            return JEKV_ERR_NO_MEM;
+        }
+
+        crc = jekv_port_crc32(UINT32_MAX, ver, ver_len);
+        memcpy(ext, ver, ver_len);
+        memcpy(ext + ver_len, &crc, sizeof(crc));
+
+        item.length    = JEKV_BLOB_EXT_SIZE(seg_count);
+        item.seg_start = JEKV_SEG_START_ANY;
+        item.crc_item  = jekv_item_crc_head(&item);
+
+        err = jekv_sector_write_item_data(sec, &item, ext, item.length, entry_cnt);
+
+        JEKV_FREE(ext);
+    } else {
+        item.seg_start = JEKV_BLOB_SEG_VER(ver, 0) ? JEKV_SEG_START_VER_1 : JEKV_SEG_START_VER_0;
+        item.crc_item  = jekv_item_crc_head(&item);
+
+        err = jekv_sector_write_item_data(sec, &item, NULL, 0, entry_cnt);
+    }
+
+    if (err == JEKV_ERR_OK) {
+        jekv_hash_append(&sec->hash, &item, write_cntry);
+    }
+
+    jekv_log_debug("write desc 0x%x | gid=%d,key=%.*s,size=%u,seg_count=%d,seg_start=%d,err=%d", sec->address, gid,
+                   JEKV_MAX_KEY_LEN, item.name, all_size, seg_count, item.seg_start, err);
+
+    return err;
+}
+
+int jekv_sector_read_blob_ver(jekv_sector_t *sec, int index, jekv_item_t *desc, uint8_t *ver)
+{
+    int err;
+    int seg_count = JEKV_ITEM_BLOB_SEG_COUNT(desc);
+    int ver_len   = desc->length - (int)sizeof(uint32_t);
+    uint32_t offset;
+    uint32_t crc;
+
+    if (seg_count > JEKV_BLOB_SEG_NUM_MAX) {
+        return JEKV_ERR_FAIL;
+    }
+
+    if (desc->seg_start != JEKV_SEG_START_ANY) {
+        memset(ver, desc->seg_start == JEKV_SEG_START_VER_1 ? 0xff : 0, JEKV_BLOB_VER_MAP_SIZE);
+        return JEKV_ERR_OK;
+    }
+
+    /*the extension may have more version bits than the segments*/
+    if (desc->length < JEKV_BLOB_EXT_SIZE(seg_count) || ver_len > JEKV_BLOB_VER_MAP_SIZE) {
+        return JEKV_ERR_FAIL;
+    }
+
+    memset(ver, 0, JEKV_BLOB_VER_MAP_SIZE);
+
+    /*skip sector header and item itself*/
+    offset = sec->address + (index + 2) * JEKV_SLICE_SIZE;
+
+    err = jekv_pt_read(sec->pt, offset, ver, ver_len);
+    if (err == JEKV_ERR_OK) {
+        err = jekv_pt_read(sec->pt, offset + ver_len, &crc, sizeof(crc));
+    }
+
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (jekv_port_crc32(UINT32_MAX, ver, ver_len) != crc) {
+        jekv_log_debug("blob ext crc err, %.*s", JEKV_MAX_KEY_LEN, desc->name);
+        return JEKV_ERR_FAIL;
+    }
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_sector_find_item(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type, const char *key, int *item_index,
+                            jekv_item_t *item, uint8_t seg_index, jekv_seg_start_t seg_start)
+{
+    uint32_t start = *item_index;
+    uint32_t end   = sec->next_free_slice;
+    uint32_t from  = 0; /*record offset in the packed item at start*/
+
+    uint32_t offset;
+    int slice_index;
+    int span;
+    int err;
+
+    jekv_log_debug("sec find: gid=%d,type=%d,key=%.*s,index=%d, seg=%d,%d", group_id, type, JEKV_MAX_KEY_LEN,
+                (key ? key : "null"), *item_index, seg_index, seg_start);
+
+    if (sec->state == JEKV_SECTOR_STATE_CRASH || sec->state == JEKV_SECTOR_STATE_INVALID ||
+        sec->state == JEKV_SECTOR_STATE_UNINIT) {
+        jekv_log_debug("find: bad state");
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    if (JEKV_INDEX_IS_PACKED(start)) {
+        from  = JEKV_PACK_INDEX_OFFSET(start);
+        start = JEKV_PACK_INDEX_SLICE(start);
+    }
+
+    if (start >= JEKV_ENTRY_COUNT) {
+        jekv_log_debug("find err: start=%d", start);
+        return JEKV_ERR_NOT_FOUND;
+    }
+
+    if (end > JEKV_ENTRY_COUNT) {
+        end = JEKV_ENTRY_COUNT;
+    }
+
+    jekv_log_debug("read item start =%d,end=%d", start, end);
+
+    while (start < end) {
+        if (key) {
+            /*The key is valid, so the hash value can be calculated and compared*/
+
+            jekv_item_init(item, JEKV_ITEM_STATE_USING, group_id, type, key, NULL, 0, seg_index);
+
+            jekv_log_debug("start =%d", start);
+
+            slice_index = jekv_hash_find(&sec->hash, start, item);
+            if (slice_index < 0) {
+                return JEKV_ERR_NOT_FOUND;
+            }
+
+            /*found hash match*/
+            if (slice_index != start) {
+                from = 0;
+            }
+
+            start = slice_index;
+            jekv_log_debug("found start =%d", start);
+        }
+
+        /*point to first item, skip sector header */
+        offset = sec->address + (start + 1) * JEKV_SLICE_SIZE;
+
+        jekv_log_debug("read item start =%d,offset=%d", start, offset);
+
+        err = jekv_pt_read_item(sec->pt, offset, item);
+        if (err != JEKV_ERR_OK) {
+            sec->state = JEKV_SECTOR_STATE_INVALID;
+            return err;
+        }
+
+        span = jekv_item_get_span(item);
+
+#if CONFIG_JEKV_DEFER_DROP
+        if (item->state == JEKV_ITEM_STATE_USING && SECTOR_DROP_IS_PENDING(sec, start)) {
+            /*the mark is not programmed yet*/
+            item->state = JEKV_ITEM_STATE_DROPED;
+        }
+#endif
+
+        jekv_log_debug("found start =%d,span=%d", start, span);
+
+        if (item->state == JEKV_ITEM_STATE_DROPED) {
+            /*droped*/
+            start += span;
+
+            jekv_log_debug("found drop");
+
+        } else if (item->state == JEKV_ITEM_STATE_USING && item->type == JEKV_TYPE_PACK) {
+            jekv_item_t pack = *item;
+
+            /*look up the records of the packed item*/
+            err = jekv_pack_find(sec, start, &pack, &from, group_id, type, key, seg_index, seg_start, item);
+            if (err == JEKV_ERR_OK) {
+                *item_index = JEKV_PACK_INDEX(start, from);
+                jekv_log_debug("found record,start=%d,offset=%u", start, from);
+
+                return JEKV_ERR_OK;
+            } else if (err != JEKV_ERR_NOT_FOUND) {
+                return err;
+            }
+
+            from = 0;
+            start += span;
+
+        } else if (item->state == JEKV_ITEM_STATE_USING) {
+            /*using, check item match*/
+            if (jekv_item_match(item, group_id, type, key, seg_index, seg_start)) {
+                *item_index = start;
+                jekv_log_debug("found match,start=%d,type=%d,item.type=%d", start, type, item->type);
+
+                return JEKV_ERR_OK;
+
+            } else {
                 if (type == JEKV_TYPE_BLOB_SEG && item->type == JEKV_TYPE_BLOB_SEG) {
                     jekv_log_debug("for: group_id=%d,type=%d,seg_index=%d,seg_start=%d,key=%.*s", group_id, type, seg_index,
                                 seg_start, JEKV_MAX_KEY_LEN, key ? key : "NULL");
@@ -484,7 +1392,25 @@ int jekv_sector_find_item(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type
     return JEKV_ERR_NOT_FOUND;
 }
 
-int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src)
+int jekv_sector_find_blob_seg(jekv_sector_t *sec, uint8_t group_id, const char *key, int *item_index, jekv_item_t *item,
+                              uint8_t seg_id, int page)
+{
+    int err;
+
+    while (1) {
+        err = jekv_sector_find_item(sec, group_id, (jekv_type_t)JEKV_TYPE_BLOB_SEG, key, item_index, item, seg_id,
+                                    (jekv_seg_start_t)(seg_id & JEKV_SEG_START_VER_1));
+        if (err != JEKV_ERR_OK || JEKV_ITEM_SEG_PAGE(item) == page) {
+            return err;
+        }
+
+        /*the same seg id of another page*/
+        *item_index += jekv_item_get_span(item);
+    }
+}
+
+/*copy item by item, used when there is no memory for a whole sector*/
+static int sector_copy_by_item(jekv_sector_t *dst, jekv_sector_t *src, uint64_t drop_groups)
 {
     int err;
 
@@ -492,7 +1418,7 @@ int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src)
     int span;
 
     uint32_t src_index = 0;
-    uint32_t dst_index = 0;
+    uint32_t dst_index = dst->next_free_slice;
 
     while (src_index < JEKV_ENTRY_COUNT) {
         /*read item form source sector*/
@@ -505,8 +1431,16 @@ int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src)
         /*get item span*/
 
         span = jekv_item_get_span(&item);
-        if (item.state == JEKV_ITEM_STATE_DROPED) {
-            /*droped item, skip it*/
+
+#if CONFIG_JEKV_DEFER_DROP
+        if (item.state == JEKV_ITEM_STATE_USING && SECTOR_DROP_IS_PENDING(src, src_index)) {
+            item.state = JEKV_ITEM_STATE_DROPED;
+        }
+#endif
+
+        if (item.state == JEKV_ITEM_STATE_DROPED ||
+            (item.state == JEKV_ITEM_STATE_USING && (drop_groups & ((uint64_t)1 << item.group_id)))) {
+            /*droped item or item of the deleted group, skip it*/
             src_index += span;
 
             jekv_log_debug("found drop");
@@ -522,7 +1456,7 @@ int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src)
             }
 
             /*need copy item data*/
-            if (span > 1) {
+            if (item.length > 8) {
                 /*malloc memory for item data*/
                 int data_size = item.length;
                 uint8_t *p    = JEKV_MALLOC(data_size);
@@ -549,8 +1483,25 @@ int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src)
                 JEKV_FREE(p);
             }
 
+            if (JEKV_ITEM_IS_REWRITE(&item)) {
+                /*copy the rewrite slice*/
+                jekv_item_rewrite_t rw;
+
+                err = jekv_pt_read_raw(src->pt, sector_get_rewrite_address(src, src_index, &item), &rw, sizeof(rw));
+                if (err != JEKV_ERR_OK) {
+                    src->state = JEKV_SECTOR_STATE_INVALID;
+                    return err;
+                }
+
+                err = jekv_pt_write_raw(dst->pt, sector_get_rewrite_address(dst, dst_index, &item), &rw, sizeof(rw));
+                if (err != JEKV_ERR_OK) {
+                    dst->state = JEKV_SECTOR_STATE_INVALID;
+                    return err;
+                }
+            }
+
             /*update dst sector info*/
-            jekv_hash_append(&dst->hash, &item, dst_index);
+            sector_append_hash(dst, dst_index, &item);
             dst->used_slice += span;
             dst->next_free_slice += span;
 
@@ -560,7 +1511,6 @@ int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src)
 
         } else {
             /*unusing, copy end*/
-            dst->next_free_slice = dst->used_slice;
             jekv_log_debug("copy to end,src_index=0x%x,dst_used=%d,dst_next_free=%d", src_index, dst->used_slice,
                         dst->next_free_slice);
             break;
@@ -571,3 +1521,193 @@ int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src)
 
     return JEKV_ERR_OK;
 }
+
+/*write the compacted slices to flash, split at program page boundary*/
+static int sector_write_burst(jekv_sector_t *dst, uint32_t address, const uint8_t *data, uint32_t len)
+{
+    int err;
+    uint32_t chunk;
+
+    while (len > 0) {
+        chunk = CONFIG_JEKV_COPY_BURST_SIZE - (address % CONFIG_JEKV_COPY_BURST_SIZE);
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        err = jekv_pt_write_raw(dst->pt, address, data, chunk);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        address += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+
+    return JEKV_ERR_OK;
+}
+
+#if CONFIG_JEKV_DEFER_DROP
+/*apply the drop marks kept in RAM to the sector image, the superseded items are not copied*/
+static void sector_gc_apply_drops(jekv_sector_t *src, uint8_t *pblock)
+{
+    jekv_item_t *item;
+    int index;
+
+    if (!src->drop_count) {
+        return;
+    }
+
+    for (index = 0; index < JEKV_ENTRY_COUNT; index++) {
+        if (SECTOR_DROP_IS_PENDING(src, index)) {
+            item        = (jekv_item_t *)(pblock + (index + 1) * JEKV_SLICE_SIZE);
+            item->state = JEKV_ITEM_STATE_DROPED;
+        }
+    }
+}
+#endif
+
+/*drop the items of the deleted groups in the sector image, they are not copied*/
+static void sector_gc_drop_groups(jekv_sector_t *src, uint8_t *pblock, uint64_t drop_groups)
+{
+    jekv_item_t *item;
+    int index;
+    int span;
+
+    if (!drop_groups) {
+        return;
+    }
+
+    for (index = 0; index < JEKV_ENTRY_COUNT; index += span) {
+        item = (jekv_item_t *)(pblock + (index + 1) * JEKV_SLICE_SIZE);
+        span = jekv_item_get_span(item);
+
+        if (!(item->state == JEKV_ITEM_STATE_USING || item->state == JEKV_ITEM_STATE_DROPED) ||
+            index + span > JEKV_ENTRY_COUNT) {
+            break;
+        }
+
+        if (item->state != JEKV_ITEM_STATE_USING) {
+            continue;
+        }
+
+        if (item->type == JEKV_TYPE_PACK) {
+            jekv_pack_gc_drop_groups(src, index, item, drop_groups);
+        } else if (drop_groups & ((uint64_t)1 << item->group_id)) {
+            item->state = JEKV_ITEM_STATE_DROPED;
+        }
+    }
+}
+
+int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src, uint64_t drop_groups)
+{
+    int err;
+
+    uint8_t *pblock;
+    jekv_item_t *item;
+    jekv_pack_gc_t pack;
+    int span;
+
+    uint32_t src_index = 0;
+    uint32_t dst_start = dst->next_free_slice;
+    uint32_t dst_index = dst_start;
+
+    /*the using slices are put after the items of the destination*/
+    if (dst_start + src->used_slice - src->droped_slice > JEKV_ENTRY_COUNT) {
+        jekv_log_error("copy: no space,dst=%d,src used=%d,droped=%d", dst_start, src->used_slice, src->droped_slice);
+        return JEKV_ERR_NO_SPACE;
+    }
+
+    pblock = JEKV_MALLOC(src->pt->sec_size);
+    if (!pblock) {
+        jekv_log_debug("copy: no mem, copy by item");
+        return sector_copy_by_item(dst, src, drop_groups);
+    }
+
+    /*read the whole source sector at once*/
+    err = jekv_pt_read_raw(src->pt, src->address, pblock, src->pt->sec_size);
+    if (err != JEKV_ERR_OK) {
+        src->state = JEKV_SECTOR_STATE_INVALID;
+        JEKV_FREE(pblock);
+        return err;
+    }
+
+#if CONFIG_JEKV_DEFER_DROP
+    sector_gc_apply_drops(src, pblock);
+#endif
+
+    sector_gc_drop_groups(src, pblock, drop_groups);
+
+    /*the deltas are folded to their records before the small items are collected*/
+    jekv_record_gc_fold(src, pblock);
+
+    /*the small items are repacked after the other items*/
+    jekv_pack_gc_begin(src, pblock, dst_start, &pack);
+
+    /*
+        compact using items in RAM from the image start, the image slot never passes the source slot. The items
+        are put after the items of the destination, from the slice dst_start.
+    */
+    while (src_index < JEKV_ENTRY_COUNT) {
+        item = (jekv_item_t *)(pblock + (src_index + 1) * JEKV_SLICE_SIZE);
+        span = jekv_item_get_span(item);
+
+        if (item->state == JEKV_ITEM_STATE_DROPED) {
+            /*droped item, skip it*/
+            src_index += span;
+
+        } else if (item->state == JEKV_ITEM_STATE_USING) {
+            if (src_index + span > JEKV_ENTRY_COUNT || dst_index + span > JEKV_ENTRY_COUNT) {
+                jekv_log_debug("copy: bad span=%d,src_index=%d,dst_index=%d", span, src_index, dst_index);
+                break;
+            }
+
+            if (jekv_pack_gc_is_collected(&pack, item)) {
+                /*written by jekv_pack_gc_end*/
+                src_index += span;
+                continue;
+            }
+
+            if (dst_index - dst_start != src_index) {
+                memmove(pblock + (dst_index - dst_start + 1) * JEKV_SLICE_SIZE, item, span * JEKV_SLICE_SIZE);
+                item = (jekv_item_t *)(pblock + (dst_index - dst_start + 1) * JEKV_SLICE_SIZE);
+            }
+
+            if (item->type == JEKV_TYPE_PACK) {
+                jekv_pack_load(dst, dst_index, item, (const uint8_t *)(item + 1));
+            } else {
+                jekv_hash_append(&dst->hash, item, dst_index);
+                jekv_pack_count(dst, item, true);
+            }
+
+            src_index += span;
+            dst_index += span;
+
+        } else {
+            /*unusing, copy end*/
+            break;
+        }
+    }
+
+    jekv_pack_gc_end(dst, &pack, pblock, dst_start, &dst_index);
+
+    /*program the live slices in page sized bursts*/
+    err = sector_write_burst(dst, dst->address + (dst_start + 1) * JEKV_SLICE_SIZE, pblock + JEKV_SLICE_SIZE,
+                             (dst_index - dst_start) * JEKV_SLICE_SIZE);
+
+    JEKV_FREE(pblock);
+
+    if (err != JEKV_ERR_OK) {
+        dst->state = JEKV_SECTOR_STATE_INVALID;
+        return err;
+    }
+
+    /*update dst sector info*/
+    dst->used_slice += dst_index - dst_start;
+    dst->next_free_slice = dst_index;
+
+    jekv_log_debug("copy end,src_index=%d,dst_used=%d,dst_next_free=%d", src_index, dst->used_slice,
+                dst->next_free_slice);
+
+    return JEKV_ERR_OK;
+}
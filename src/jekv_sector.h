@@ -21,6 +21,28 @@ extern "C" {
 #define CONFIG_NVS_VER_NUM 1
 #endif
 
+/*
+    the superseded items are marked droped in RAM, the marks are programmed in batches of a sector.
+    The marks not programmed are lost at power off, the newest item of the key wins at mount.
+*/
+#ifndef CONFIG_JEKV_DEFER_DROP
+#define CONFIG_JEKV_DEFER_DROP 0
+#endif
+
+/*pending drop marks of a sector, they are programmed when reached*/
+#ifndef CONFIG_JEKV_DEFER_DROP_MAX
+#define CONFIG_JEKV_DEFER_DROP_MAX 16
+#endif
+
+#if CONFIG_JEKV_DEFER_DROP_MAX < 1 || CONFIG_JEKV_DEFER_DROP_MAX > JEKV_ENTRY_COUNT
+#error "CONFIG_JEKV_DEFER_DROP_MAX out of range"
+#endif
+
+/*the plain value superseded by the newer one of the key, the records, deltas and blobs are dropped at once*/
+#define JEKV_ITEM_CAN_DEFER_DROP(item)                                                                         \
+    ((item)->type >= JEKV_TYPE_STRING && (item)->type <= JEKV_TYPE_BINARY && !JEKV_ITEM_IS_DELTA(item) &&       \
+     !JEKV_ITEM_IS_RECORD(item))
+
 #define JEKV_SECTOR_MAGIC 0x4D57
 
 /**
@@ -35,17 +57,38 @@ typedef enum {
     JEKV_SECTOR_STATE_INVALID   = 0x00, /* 0000 0000 invalid  */
 } jekv_sector_state_t;
 
+/**
+  * @brief  kv sector kind
+  */
+typedef enum {
+    JEKV_SECTOR_KIND_KV    = 0xff, /* key value items        */
+    JEKV_SECTOR_KIND_RING  = 0xfe, /* records of a ring log  */
+    JEKV_SECTOR_KIND_QUEUE = 0xfc, /* records of a queue     */
+} jekv_sector_kind_t;
+
+/*
+    programmed to the destination sector of a merge when the using items of all the sources are copied, the sources
+    still deleting are erased then, their items are not copied again
+*/
+#define JEKV_SECTOR_MERGED 0x00
+
+/*the last slice of the queue sector is the ack map, a bit is cleared for every acked record from bit 0*/
+#define JEKV_QUEUE_ACK_SLICE (JEKV_ENTRY_COUNT - 1)
+
 /**
   * @brief  kv sector header structure
   */
 typedef struct {
     uint16_t magic;         /**< sector header magic  */
     uint8_t state;          /**< sector state         */
-    uint8_t reserve_1;      /**< sector reserve1      */
+    uint8_t merged;         /**< merged mark, not in the crc */
     uint32_t crc32;         /**< sector crc32         */
     uint32_t serial_number; /**< sector serial number */
     uint8_t version;        /**< sector version       */
-    uint8_t reserve_2[19];  /**< sector reserve2      */
+    uint8_t kind;           /**< sector kind          */
+    uint8_t reserve_2[2];   /**< sector reserve2      */
+    uint32_t ring_seq;      /**< first record sequence of the ring or queue sector */
+    uint8_t reserve_3[12];  /**< sector reserve3      */
 } jekv_sector_header_t;
 
 /**
@@ -55,26 +98,55 @@ typedef struct {
     struct dl_list list; /* for list manager */
     uint8_t state;       /* sector state     */
     uint8_t version;     /* sector version   */
+    uint8_t kind;        /* sector kind      */
 
     uint8_t next_free_slice; /* next free slice id       */
     uint8_t used_slice;      /* used num : using + droped*/
     uint8_t droped_slice;    /* erased num               */
+    uint8_t small_slice;     /* single small items, GC packs them */
+    uint16_t small_size;     /* record size of the small items    */
 
     uint32_t address;       /* offset address from partition start position */
     uint32_t serial_number; /* sector serial number */
+    uint32_t generation;    /* erase count, the item locations are changed when erased */
+    uint16_t pin_count;     /* views reading the sector in place, not collected while pinned */
+    uint8_t ring_count;     /* records of the ring or queue sector, their sequences follow ring_seq */
+    uint32_t ring_seq;      /* sequence of the first record of the ring or queue sector */
+#if CONFIG_JEKV_DEFER_DROP
+    uint8_t drop_count;     /* drop marks not programmed */
+    uint8_t drop_pending[(JEKV_ENTRY_COUNT + 7) / 8]; /* bits of the items droped in RAM only */
+#endif
     jekv_hash_t hash;     /* hash list            */
     jekv_partition_t *pt; /* partition info       */
 } jekv_sector_t;
 
 int jekv_sector_init(jekv_sector_t *sec);
 
+/*write the header of the ring sector, its first record is of the sequence seq*/
+int jekv_sector_init_ring(jekv_sector_t *sec, uint32_t seq);
+
+/*write the header of the queue sector, its first record is of the sequence seq*/
+int jekv_sector_init_queue(jekv_sector_t *sec, uint32_t seq);
+
 int jekv_sector_set_state(jekv_sector_t *sec, jekv_sector_state_t state);
 
+/*mark the merge to the sector complete*/
+int jekv_sector_set_merged(jekv_sector_t *sec);
+
+/*is the merge to the sector complete*/
+bool jekv_sector_is_merged(jekv_sector_t *sec);
+
 int jekv_sector_erase(jekv_sector_t *sec);
 
 /*index start from 0. not include header */
 int jekv_sector_erase_item(jekv_sector_t *sec, int index, jekv_item_t *item, bool erase_hash);
 
+/*drop the item superseded by a newer one of the key, the mark may be programmed later*/
+int jekv_sector_supersede_item(jekv_sector_t *sec, int index, jekv_item_t *item);
+
+/*program the drop marks kept in RAM*/
+int jekv_sector_flush_drops(jekv_sector_t *sec);
+
 int jekv_sector_load(jekv_partition_t *pt, jekv_sector_t *sec, int index);
 
 int jekv_sector_write_item_data(jekv_sector_t *sec, jekv_item_t *pitem, const void *extra_data, uint32_t len,
@@ -83,12 +155,72 @@ int jekv_sector_write_item_data(jekv_sector_t *sec, jekv_item_t *pitem, const vo
 int jekv_sector_write_item(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type, const char *key, const void *data,
                              uint32_t size, uint8_t seg_id);
 
+/*write the segment seg of the blob, the segments out of the first page are not smaller than JEKV_BLOB_PAGE_SEG_MIN_SIZE*/
+int jekv_sector_write_blob_seg(jekv_sector_t *sec, uint8_t group_id, const char *key, const void *data, uint32_t size,
+                               const uint8_t *ver, int seg);
+
+/*write the blob descriptor, the version bits are written as its extension if the segments versions differ*/
+int jekv_sector_write_blob_desc(jekv_sector_t *sec, uint8_t group_id, const char *key, uint32_t all_size,
+                                int seg_count, const uint8_t *ver);
+
+/*read the version bits of the blob descriptor segments*/
+int jekv_sector_read_blob_ver(jekv_sector_t *sec, int index, jekv_item_t *desc, uint8_t *ver);
+
+/*write a counter of the base value, all the bits of its data are not cleared*/
+int jekv_sector_write_counter(jekv_sector_t *sec, uint8_t group_id, const char *key, uint32_t base);
+
+/*clear step bits of the counter in place, JEKV_ERR_NO_SPACE if not enough bits left*/
+int jekv_sector_add_counter(jekv_sector_t *sec, int index, jekv_item_t *item, uint32_t step, uint32_t *value);
+
+/*write a rewritable item, its value can be programmed in place later*/
+int jekv_sector_write_rewrite_item(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type, const char *key,
+                                   const void *data, uint32_t size);
+
+/*write the compressed value of raw_length bytes, size: the compressed size*/
+int jekv_sector_write_lz_item(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type, const char *key,
+                              const void *data, uint32_t size, uint32_t raw_length);
+
+/*write the binary record of the delta generation gen, its deltas are not folded*/
+int jekv_sector_write_record(jekv_sector_t *sec, uint8_t group_id, const char *key, const void *data, uint32_t size,
+                             uint8_t gen);
+
+/*append the record of the ring, the records are not looked up by key*/
+int jekv_sector_write_ring_record(jekv_sector_t *sec, uint8_t group_id, const char *name, const void *data,
+                                  uint32_t size);
+
+/*read the using record of the ring or queue sector from the slice index, JEKV_ERR_NOT_FOUND at the sector end*/
+int jekv_sector_read_ring_record(jekv_sector_t *sec, int *index, jekv_item_t *item);
+
+/*drop the last record of the ring or queue sector if the power was off while writing its data*/
+int jekv_sector_check_ring_last(jekv_sector_t *sec);
+
+/*read the count of the acked records of the queue sector*/
+int jekv_sector_read_queue_acked(jekv_sector_t *sec, uint8_t *acked);
+
+/*clear the ack bits of the queue sector from the acked count old to acked*/
+int jekv_sector_write_queue_acked(jekv_sector_t *sec, uint8_t old, uint8_t acked);
+
+/*
+    program the new value over the item if it only clears bits of the old one.
+    JEKV_ERR_NO_SPACE: the item can't be rewritten (not rewritable, no crc slot left or pinned), write a new
+    rewritable item; JEKV_ERR_FAIL: some bits are set by the new value.
+*/
+int jekv_sector_rewrite_item(jekv_sector_t *sec, int index, jekv_item_t *item, const void *data, uint32_t size);
+
 int jekv_sector_read_item_data(jekv_sector_t *sec, int found_slice_index, jekv_item_t *item, void *data, uint32_t size);
 
 int jekv_sector_find_item(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type, const char *key, int *item_index,
                             jekv_item_t *item, uint8_t seg_index, jekv_seg_start_t seg_start);
 
-int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src);
+/*find the blob segment of the seg id in the page*/
+int jekv_sector_find_blob_seg(jekv_sector_t *sec, uint8_t group_id, const char *key, int *item_index, jekv_item_t *item,
+                              uint8_t seg_id, int page);
+
+/*
+    copy the using items of src after the items of dst, the items of the groups in drop_groups (bits of group ids)
+    are not copied. JEKV_ERR_NO_SPACE if the using slices of src don't fit
+*/
+int jekv_sector_copy(jekv_sector_t *dst, jekv_sector_t *src, uint64_t drop_groups);
 
 #ifdef __cplusplus
 }
@@ -8,6 +8,12 @@
 #include "jekv_debug.h"
 #include "jekv_log.h"
 
+/*sources of a merge*/
+#define SM_MERGE_SRC_MAX 16
+
+/*slices of the using items of the sector, the items of the retired groups are counted*/
+#define SM_USING_SLICE(sec) ((sec)->used_slice - (sec)->droped_slice)
+
 static int sm_init_default(jekv_sector_manager_t *sm, jekv_partition_t *pt)
 {
     sm->sec_arr = JEKV_CALLOC(1, pt->sec_num * sizeof(jekv_sector_t));
@@ -15,6 +21,7 @@ static int sm_init_default(jekv_sector_manager_t *sm, jekv_partition_t *pt)
 
     dl_list_init(&sm->active);
     dl_list_init(&sm->idle);
+    dl_list_init(&sm->rings);
 
     return JEKV_ERR_OK;
 }
@@ -41,16 +48,40 @@ static int sm_active_sector(jekv_sector_manager_t *sm)
     return JEKV_ERR_OK;
 }
 
+/*insert the sector to the list in the serial order*/
+static void sm_insert_sector(struct dl_list *list, jekv_sector_t *sec)
+{
+    jekv_sector_t *entry      = NULL;
+    jekv_sector_t *entry_next = NULL;
+    int found                 = 0;
+
+    dl_list_for_each_safe(entry, entry_next, list, jekv_sector_t, list)
+    {
+        if (entry->serial_number > sec->serial_number) {
+            found = 1;
+            break;
+        }
+    }
+
+    if (found && entry) {
+        /*insert sector before entry, entry's SN is larger than current sector*/
+        dl_list_add_tail(&entry->list, &sec->list);
+        jekv_log_debug("insert sn=%u before sn=%u", sec->serial_number, entry->serial_number);
+    } else {
+        /*add to the and of the list*/
+        dl_list_add_tail(list, &sec->list);
+        jekv_log_debug("add sn=%u to tail", sec->serial_number);
+    }
+}
+
 static int sm_load_sectors(jekv_sector_manager_t *sm, jekv_partition_t *pt)
 {
     int err = JEKV_ERR_OK;
     int i;
 
     jekv_sector_state_t state;
-    jekv_sector_t *sec        = NULL;
-    jekv_sector_t *entry      = NULL;
-    jekv_sector_t *entry_next = NULL;
-    int found;
+    jekv_sector_t *sec   = NULL;
+    jekv_sector_t *entry = NULL;
 
     jekv_log_debug("load sectors");
 
@@ -68,38 +99,33 @@ static int sm_load_sectors(jekv_sector_manager_t *sm, jekv_partition_t *pt)
             /* invalid, unuse, crash sectors */
             jekv_log_debug("add %d 0x%x, state=%x, add to idle", i, sec->address, state);
             dl_list_add_tail(&(sm->idle), &sec->list);
+        } else if (sec->kind != JEKV_SECTOR_KIND_KV) {
+            /* ring and queue sectors, not collected by GC */
+            jekv_log_debug("add sec_id=%d,sn=%u, state=%x, to rings", i, sec->serial_number, state);
+            sm_insert_sector(&sm->rings, sec);
         } else {
             /* using, full, deleting sectors */
-            /* look up the position */
-            found = 0;
-            dl_list_for_each_safe(entry, entry_next, &sm->active, jekv_sector_t, list)
-            {
-                if (entry->serial_number > sec->serial_number) {
-                    found = 1;
-                    break;
-                }
-            }
-
-            if (found && entry) {
-                /*insert sector before entry, entry's SN is larger than current sector*/
-                dl_list_add_tail(&entry->list, &sec->list);
-                jekv_log_debug("insert sec_id=%d,sn=%u, state=%x, to active", i, entry->serial_number, state);
-            } else {
-                /*add to the and of active list*/
-                dl_list_add_tail(&sm->active, &sec->list);
-                jekv_log_debug("add sec_id=%d,sn=%u, state=%x, to active tail", i, entry->serial_number, state);
-            }
+            jekv_log_debug("add sec_id=%d,sn=%u, state=%x, to active", i, sec->serial_number, state);
+            sm_insert_sector(&sm->active, sec);
         }
     }
 
-    /* update global serial number */
-    if (dl_list_empty(&sm->active)) {
+    /* update global serial number, the ring and queue sectors share it */
+    if (!dl_list_empty(&sm->rings)) {
+        entry             = dl_list_last(&sm->rings, jekv_sector_t, list);
+        sm->serial_number = entry->serial_number + 1;
+    } else {
         sm->serial_number = 1;
-        err               = sm_active_sector(sm);
+    }
+
+    if (dl_list_empty(&sm->active)) {
+        err = sm_active_sector(sm);
         return err;
     } else {
-        entry             = dl_list_last(&sm->active, jekv_sector_t, list);
-        sm->serial_number = entry->serial_number + 1;
+        entry = dl_list_last(&sm->active, jekv_sector_t, list);
+        if (entry->serial_number >= sm->serial_number) {
+            sm->serial_number = entry->serial_number + 1;
+        }
         jekv_log_debug("last sn=%u", entry->serial_number);
     }
 
@@ -116,8 +142,9 @@ static int sm_check_item_data(jekv_sector_t *sec, int index, jekv_item_t *item)
     int err = JEKV_ERR_OK;
 
     /*check have additional data*/
+    /*the value of rewritable item is checked by its crc slots at loading*/
     if ((item->type == JEKV_TYPE_STRING || item->type == JEKV_TYPE_BINARY || item->type == JEKV_TYPE_BLOB_SEG) &&
-        item->length > 8) {
+        item->length > 8 && !JEKV_ITEM_IS_REWRITE(item)) {
         uint8_t *p = JEKV_MALLOC(item->length);
 
         if (p) {
@@ -139,11 +166,138 @@ static int sm_check_item_data(jekv_sector_t *sec, int index, jekv_item_t *item)
 
             JEKV_FREE(p);
         }
+    } else if (item->type == JEKV_TYPE_BLOB && item->seg_start == JEKV_SEG_START_ANY) {
+        uint8_t ver[JEKV_BLOB_VER_MAP_SIZE];
+
+        /*check the descriptor extension*/
+        if (jekv_sector_read_blob_ver(sec, index, item, ver) != JEKV_ERR_OK) {
+            jekv_log_warning("ext:drop last item %d:%.*s", item->group_id, JEKV_MAX_KEY_LEN, item->name);
+
+            jekv_sector_erase_item(sec, index, item, true);
+
+            err = JEKV_ERR_FAIL;
+        }
     }
 
     return err;
 }
 
+/*drop the using items with the same key outside the batch records*/
+static void sm_drop_batch_key(jekv_sector_manager_t *sm, jekv_sector_t *batch_sec, int begin_index, int commit_index,
+                              jekv_item_t *rec)
+{
+    int err;
+    jekv_sector_t *entry = NULL;
+    jekv_item_t old;
+    int index;
+
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        index = 0;
+
+        while (1) {
+            err = jekv_sector_find_item(entry, rec->group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, rec->name, &index, &old,
+                                        JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+            if (err != JEKV_ERR_OK) {
+                break;
+            }
+
+            if (!(entry == batch_sec && index > begin_index && index < commit_index) && old.type != JEKV_TYPE_BATCH) {
+                jekv_log_debug("batch: drop old %.*s", JEKV_MAX_KEY_LEN, old.name);
+                jekv_sector_erase_item(entry, index, &old, true);
+            }
+
+            index += jekv_item_get_span(&old);
+        }
+    }
+}
+
+static int sm_check_batch_records(jekv_sector_manager_t *sm, jekv_sector_t *sec, int begin_index, jekv_item_t *begin)
+{
+    int err;
+    int index;
+    int commit_index = begin_index + 1 + begin->data[1];
+    bool committed   = false;
+    jekv_item_t item;
+
+    if (commit_index < JEKV_ENTRY_COUNT) {
+        err = jekv_pt_read_item(sec->pt, sec->address + (commit_index + 1) * JEKV_SLICE_SIZE, &item);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        committed = (item.state == JEKV_ITEM_STATE_USING && item.type == JEKV_TYPE_BATCH &&
+                     item.seg_id == JEKV_BATCH_REC_COMMIT && item.crc_item == jekv_item_crc_head(&item));
+    }
+
+    jekv_log_warning("batch at 0x%x:%d, committed=%d", sec->address, begin_index, committed);
+
+    for (index = begin_index + 1; index < commit_index && index < sec->next_free_slice;) {
+        err = jekv_pt_read_item(sec->pt, sec->address + (index + 1) * JEKV_SLICE_SIZE, &item);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        if (item.state == JEKV_ITEM_STATE_USING) {
+            if (committed) {
+                /*finish the droping after commit*/
+                sm_drop_batch_key(sm, sec, begin_index, commit_index, &item);
+
+                if (item.type == JEKV_TYPE_BATCH) {
+                    jekv_sector_erase_item(sec, index, &item, true);
+                }
+            } else {
+                /*roll back*/
+                jekv_sector_erase_item(sec, index, &item, true);
+            }
+        }
+
+        index += jekv_item_get_span(&item);
+    }
+
+    jekv_sector_erase_item(sec, begin_index, begin, true);
+
+    return JEKV_ERR_OK;
+}
+
+/* Check the batch not finished because of power off*/
+static int sm_check_imcomplete_batch(jekv_sector_manager_t *sm)
+{
+    int err;
+    jekv_sector_t *entry = NULL;
+    jekv_item_t item;
+    int index;
+
+    jekv_log_debug("power off batch check");
+
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        index = 0;
+
+        while (1) {
+            err = jekv_sector_find_item(entry, JEKV_GROUP_ID_ANY, (jekv_type_t)JEKV_TYPE_BATCH, NULL, &index, &item,
+                                        JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+            if (err != JEKV_ERR_OK) {
+                break;
+            }
+
+            if (item.seg_id == JEKV_BATCH_REC_BEGIN) {
+                err = sm_check_batch_records(sm, entry, index, &item);
+                if (err != JEKV_ERR_OK) {
+                    return err;
+                }
+            } else {
+                /*record left after the batch begin droped*/
+                jekv_sector_erase_item(entry, index, &item, true);
+            }
+
+            index += jekv_item_get_span(&item);
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
 static int sm_check_imcomplete_write(jekv_sector_manager_t *sm)
 {
     int err;
@@ -154,6 +308,7 @@ static int sm_check_imcomplete_write(jekv_sector_manager_t *sm)
     jekv_seg_start_t seg_start;
     uint8_t seg_id;
     jekv_item_t item;
+    jekv_item_t next;
 
     jekv_sector_t *last = dl_list_last(&sm->active, jekv_sector_t, list);
 
@@ -163,15 +318,16 @@ static int sm_check_imcomplete_write(jekv_sector_manager_t *sm)
 
     jekv_log_debug("power off imcomplete_write check");
 
-    /*find last item*/
+    /*find last item, the failed search overwrites the read item*/
     while (1) {
-        err = jekv_sector_find_item(last, JEKV_GROUP_ID_ANY, JEKV_TYPE_ANY, NULL, &next_index, &item, JEKV_SEG_ID_ANY,
+        err = jekv_sector_find_item(last, JEKV_GROUP_ID_ANY, JEKV_TYPE_ANY, NULL, &next_index, &next, JEKV_SEG_ID_ANY,
                                       JEKV_SEG_START_ANY);
         if (err != JEKV_ERR_OK) {
             break;
         } else {
             found      = true;
             last_index = next_index;
+            item       = next;
             next_index += jekv_item_get_span(&item);
         }
     }
@@ -193,7 +349,7 @@ static int sm_check_imcomplete_write(jekv_sector_manager_t *sm)
                     last->address / JEKV_SECTOR_SIZE, item.group_id, item.type, JEKV_MAX_KEY_LEN, item.name, item.length,
                     item.seg_id, item.seg_start);
 
-        seg_id    = (item.type == JEKV_TYPE_BLOB_SEG ? item.seg_id : JEKV_SEG_ID_ANY);
+        seg_id    = (item.type == JEKV_TYPE_BLOB_SEG || JEKV_ITEM_IS_DELTA(&item) ? item.seg_id : JEKV_SEG_ID_ANY);
         seg_start = JEKV_SEG_START_ANY;
 
         /*find old items*/
@@ -201,7 +357,21 @@ static int sm_check_imcomplete_write(jekv_sector_manager_t *sm)
         {
             old_index = 0;
 
-            if (entry != last) {
+            if (entry->state == JEKV_SECTOR_STATE_DELETTING) {
+                /*its items are being copied to the last sector by GC, they are not old*/
+                continue;
+            }
+
+            if (item.type == JEKV_TYPE_BLOB_SEG) {
+                /*the seg id is reused in the pages of the blob*/
+                err = jekv_sector_find_blob_seg(entry, item.group_id, item.name, &old_index, &old, seg_id,
+                                                JEKV_ITEM_SEG_PAGE(&item));
+                if (err == JEKV_ERR_OK && (entry != last || old_index != last_index)) {
+                    jekv_log_debug("found double seg in sec 0x%x,del old", entry->address);
+                    jekv_sector_erase_item(entry, old_index, &old, true);
+                    break;
+                }
+            } else if (entry != last) {
                 /*check other sector*/
                 err = jekv_sector_find_item(entry, item.group_id, (jekv_type_t)item.type, item.name, &old_index, &old, seg_id, seg_start);
                 if (err == JEKV_ERR_OK) {
@@ -226,34 +396,146 @@ static int sm_check_imcomplete_write(jekv_sector_manager_t *sm)
     return JEKV_ERR_OK;
 }
 
+/*
+    merge: copy the using items of the sources to a new sector one after another, then erase the sources.
+    STEP1 : write the header of the new sector
+    STEP2 : set the source deleting, STEP3 : copy it, for every source
+    then mark the new sector merged
+    STEP4 : erase the sources
+    If the power is off before the mark, the new sector is erased and the deleting sources are merged again at
+    loading, after the mark they are only erased. The single sector GC is the merge of one source.
+*/
+static int sm_merge_sectors(jekv_sector_manager_t *sm, jekv_sector_t **srcs, int num)
+{
+    int err;
+    int i;
+    jekv_sector_t *new_sec;
+
+    jekv_log_debug("GC:active new sector");
+
+    /*prepare the GC sector*/
+    err = sm_active_sector(sm);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /* STEP1 : Set new sector status to using*/
+    jekv_log_debug("GC-1:set new using");
+    new_sec = dl_list_last(&sm->active, jekv_sector_t, list);
+    if (new_sec->state == JEKV_SECTOR_STATE_UNINIT) {
+        /*write sector header*/
+        err = jekv_sector_init(new_sec);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_1_NEW_SECTOR);
+
+    for (i = 0; i < num; i++) {
+        if (srcs[i]->state != JEKV_SECTOR_STATE_DELETTING) {
+            if (num > 1) {
+                /*the sources are copied again after power off, the drop marks in RAM would be lost and the items
+                  would not fit*/
+                err = jekv_sector_flush_drops(srcs[i]);
+                if (err != JEKV_ERR_OK) {
+                    return err;
+                }
+            }
+
+            /* STEP2 : Set dirst sector status to deleting*/
+            jekv_log_debug("GC-2:set deletting");
+            err = jekv_sector_set_state(srcs[i], JEKV_SECTOR_STATE_DELETTING);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+        }
+
+        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_2_SET_OLD_DELETING);
+
+        /* STEP3 : Copy dirtiest sector to the GC sector*/
+        jekv_log_debug("GC-3:copy 0x%x", srcs[i]->address);
+        err = jekv_sector_copy(new_sec, srcs[i], sm->retired_groups);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_3_COPY);
+    }
+
+    err = jekv_sector_set_merged(new_sec);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    jekv_log_debug("GC-4:erase old");
+
+    for (i = 0; i < num; i++) {
+        /* STEP4 : erase the dirtiest secto*/
+        err = jekv_sector_erase(srcs[i]);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        /*remove the dirtiest sector from active*/
+        dl_list_del(&srcs[i]->list);
+
+        /*Add the dirtiest sector to idle list*/
+        dl_list_add_tail(&sm->idle, &srcs[i]->list);
+
+        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_4_ERASE_OLD);
+    }
+
+    jekv_log_debug("GC:ok");
+
+    return JEKV_ERR_OK;
+}
+
 static int sm_check_imcomplete_gc(jekv_sector_manager_t *sm)
 {
     int err;
-    jekv_sector_t *it    = NULL;
+    int num = 0;
+    int i;
     jekv_sector_t *entry = NULL;
+    jekv_sector_t *srcs[SM_MERGE_SRC_MAX];
 
     jekv_sector_t *last;
-    jekv_sector_t *new_sec;
 
     jekv_log_debug("power off GC check");
 
     dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
     {
-        if (entry->state == JEKV_SECTOR_STATE_DELETTING) {
-            /*found the deleting sector*/
-            it = entry;
-            jekv_log_debug("it=0x%x", it->address);
-            break;
+        if (entry->state == JEKV_SECTOR_STATE_DELETTING && num < SM_MERGE_SRC_MAX) {
+            /*found the deleting sector, in the serial order*/
+            srcs[num++] = entry;
+            jekv_log_debug("it=0x%x", entry->address);
         }
     }
 
-    if (!it) {
+    if (num == 0) {
         /*No deleting sector*/
         return JEKV_ERR_OK;
     }
 
     last = dl_list_last(&sm->active, jekv_sector_t, list);
 
+    if (last->state == JEKV_SECTOR_STATE_USING && jekv_sector_is_merged(last)) {
+        /*all copied, erase the sources left*/
+        jekv_log_debug("GC-4: erase the merged");
+
+        for (i = 0; i < num; i++) {
+            err = jekv_sector_erase(srcs[i]);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+
+            dl_list_del(&srcs[i]->list);
+            dl_list_add_tail(&sm->idle, &srcs[i]->list);
+        }
+
+        return JEKV_ERR_OK;
+    }
+
     if (last->state == JEKV_SECTOR_STATE_USING) {
         /* STEP0 : erase not complete sector*/
 
@@ -268,62 +550,142 @@ static int sm_check_imcomplete_gc(jekv_sector_manager_t *sm)
         dl_list_add_tail(&sm->idle, &last->list);
     }
 
-    /*make a new sector to the active list end*/
-    err = sm_active_sector(sm);
-    if (err != JEKV_ERR_OK) {
-        return err;
+    /*copy the deleting sectors to a new sector again*/
+    return sm_merge_sectors(sm, srcs, num);
+}
+
+/*move the using items of the sector to a new sector, then erase it*/
+static int sm_gc_sector(jekv_sector_manager_t *sm, jekv_sector_t *dirtiest)
+{
+    return sm_merge_sectors(sm, &dirtiest, 1);
+}
+
+static bool sm_is_picked(jekv_sector_t **srcs, int num, jekv_sector_t *sec)
+{
+    int i;
+
+    for (i = 0; i < num; i++) {
+        if (srcs[i] == sec) {
+            return true;
+        }
     }
 
-    /* STEP1 : Set new sector status to using*/
-    jekv_log_debug("GC-1:set new using");
-    new_sec = dl_list_last(&sm->active, jekv_sector_t, list);
-    if (new_sec->state == JEKV_SECTOR_STATE_UNINIT) {
-        /*write sector header*/
-        err = jekv_sector_init(new_sec);
-        if (err != JEKV_ERR_OK) {
-            return err;
+    return false;
+}
+
+/*pick the sectors of the fewest using slices, their items fit in one sector*/
+static int sm_pick_merge(jekv_sector_manager_t *sm, jekv_sector_t **srcs)
+{
+    jekv_sector_t *entry = NULL;
+    jekv_sector_t *least;
+    int num  = 0;
+    int used = 0;
+
+    while (num < SM_MERGE_SRC_MAX) {
+        least = NULL;
+
+        dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+        {
+            if (entry->pin_count > 0 || sm_is_picked(srcs, num, entry)) {
+                /*the pinned sectors are read in place by the views*/
+                continue;
+            }
+
+            if (!least || SM_USING_SLICE(entry) < SM_USING_SLICE(least)) {
+                least = entry;
+            }
         }
+
+        if (!least || used + SM_USING_SLICE(least) > JEKV_ENTRY_COUNT) {
+            break;
+        }
+
+        used += SM_USING_SLICE(least);
+        srcs[num++] = least;
     }
-    /* STEP2 : Set dirst sector status to deleting, it seted before*/
 
-    /* STEP3 : Copy dirtiest sector to the GC sector*/
-    jekv_log_debug("GC-3:copy");
-    err = jekv_sector_copy(new_sec, it);
-    if (err != JEKV_ERR_OK) {
-        return err;
+    return num;
+}
+
+/*pick the sector of the most droped slices, its items are moved out of them*/
+static int sm_pick_dirtiest(jekv_sector_manager_t *sm, jekv_sector_t **srcs)
+{
+    jekv_sector_t *entry    = NULL;
+    jekv_sector_t *dirtiest = NULL;
+
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        if (entry->droped_slice + jekv_pack_get_gc_gain(entry) > 0 && entry->pin_count == 0 &&
+            (!dirtiest || entry->droped_slice + jekv_pack_get_gc_gain(entry) >
+                              dirtiest->droped_slice + jekv_pack_get_gc_gain(dirtiest))) {
+            dirtiest = entry;
+        }
     }
 
-    jekv_log_debug("GC-4:erase old");
+    if (!dirtiest) {
+        return 0;
+    }
 
-    /* STEP4 : erase the dirtiest secto*/
-    err = jekv_sector_erase(it);
-    if (err != JEKV_ERR_OK) {
-        return err;
+    srcs[0] = dirtiest;
+
+    return 1;
+}
+
+/*merge the sectors of the fewest using items to free whole sectors, JEKV_ERR_NO_SPACE if no two fit in one*/
+static int sm_reclaim_sectors(jekv_sector_manager_t *sm)
+{
+    int err;
+    int num;
+    jekv_sector_t *srcs[SM_MERGE_SRC_MAX];
+
+    if (dl_list_empty(&sm->idle)) {
+        return JEKV_ERR_NO_SPACE;
     }
 
-    /*remove the dirtiest sector from active*/
-    dl_list_del(&it->list);
+    if (sm->retired_groups) {
+        /*the items of the deleted groups are not copied after purged*/
+        err = jekv_sm_purge_groups(sm);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
 
-    /*Add the dirtiest sector to idle list*/
-    dl_list_add_tail(&sm->idle, &it->list);
+    num = sm_pick_merge(sm, srcs);
+    if (num < 2) {
+        jekv_log_debug("reclaim: nothing to merge");
+        return JEKV_ERR_NO_SPACE;
+    }
 
-    return JEKV_ERR_OK;
+    jekv_log_debug("reclaim: merge %d sectors", num);
+
+    return sm_merge_sectors(sm, srcs, num);
 }
 
 static int sm_garbage_collection(jekv_sector_manager_t *sm, int need_size)
 {
-    int err;
     jekv_sector_t *entry = NULL;
     jekv_sector_t *entry_next;
     jekv_sector_t *dirtiest = NULL;
 
-    jekv_sector_t *new_sec;
-
     int can_get_size;
     int most_dirty_size = 0;
 
+    if (sm->retired_groups) {
+        /*the items of the deleted groups are not counted as droped until they are purged*/
+        jekv_log_debug("GC:purge groups 0x%llx", (unsigned long long)sm->retired_groups);
+
+        if (jekv_sm_purge_groups(sm) != JEKV_ERR_OK) {
+            return JEKV_ERR_NO_SPACE;
+        }
+    }
+
     dl_list_for_each_safe(entry, entry_next, &sm->active, jekv_sector_t, list)
     {
+        if (entry->pin_count > 0) {
+            /*read in place by the views*/
+            continue;
+        }
+
         can_get_size = jekv_sm_get_gc_size(entry);
 
         if (can_get_size > most_dirty_size) {
@@ -334,69 +696,67 @@ static int sm_garbage_collection(jekv_sector_manager_t *sm, int need_size)
 
     if (most_dirty_size >= need_size) {
         jekv_log_debug("GC:get dirtiest=0x%x,size=%d", dirtiest->address, most_dirty_size);
-        jekv_log_debug("GC:active new sector");
 
-        /*prepare the GC sector*/
-        err = sm_active_sector(sm);
-        if (err != JEKV_ERR_OK) {
-            return err;
-        }
+        return sm_gc_sector(sm, dirtiest);
+    } else {
+        jekv_log_error("GC not do, need %d,only %d", need_size, most_dirty_size);
+        return JEKV_ERR_NO_SPACE;
+    }
+}
 
-        /* STEP1 : Set new sector status to using*/
-        jekv_log_debug("GC-1:set new using");
-        new_sec = dl_list_last(&sm->active, jekv_sector_t, list);
-        if (new_sec->state == JEKV_SECTOR_STATE_UNINIT) {
-            /*write sector header*/
-            err = jekv_sector_init(new_sec);
-            if (err != JEKV_ERR_OK) {
-                return err;
+#if CONFIG_JEKV_DEFER_DROP
+/*find an item of the key written after the item at index*/
+static bool sm_find_newer(jekv_sector_manager_t *sm, jekv_sector_t *sec, int index, jekv_item_t *item)
+{
+    jekv_sector_t *entry;
+    jekv_item_t newer;
+    char key[JEKV_MAX_KEY_LEN + 1];
+    int newer_index = index + jekv_item_get_span(item);
+
+    jekv_item_key_copy(key, item->name);
+
+    for (entry = sec; &entry->list != &sm->active; entry = dl_list_entry(entry->list.next, jekv_sector_t, list)) {
+        while (jekv_sector_find_item(entry, item->group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, key, &newer_index,
+                                     &newer, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY) == JEKV_ERR_OK) {
+            if (newer.type != JEKV_TYPE_BATCH) {
+                return true;
             }
-        }
 
-        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_1_NEW_SECTOR);
-
-        /* STEP2 : Set dirst sector status to deleting*/
-        jekv_log_debug("GC-2:set deletting");
-        err = jekv_sector_set_state(dirtiest, JEKV_SECTOR_STATE_DELETTING);
-        if (err != JEKV_ERR_OK) {
-            return err;
+            newer_index += jekv_item_get_span(&newer);
         }
 
-        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_2_SET_OLD_DELETING);
+        newer_index = 0;
+    }
 
-        /* STEP3 : Copy dirtiest sector to the GC sector*/
-        jekv_log_debug("GC-3:copy");
-        err = jekv_sector_copy(new_sec, dirtiest);
-        if (err != JEKV_ERR_OK) {
-            return err;
-        }
+    return false;
+}
 
-        jekv_log_debug("GC-4:erase old");
+/*the drop marks kept in RAM are lost at power off, the newest item of the key wins*/
+static void sm_check_superseded(jekv_sector_manager_t *sm)
+{
+    jekv_sector_t *entry = NULL;
+    jekv_item_t item;
+    int index;
 
-        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_3_COPY);
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        index = 0;
+
+        while (jekv_sector_find_item(entry, JEKV_GROUP_ID_ANY, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, NULL, &index,
+                                     &item, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY) == JEKV_ERR_OK) {
+            if (!JEKV_INDEX_IS_PACKED(index) && JEKV_ITEM_CAN_DEFER_DROP(&item) &&
+                sm_find_newer(sm, entry, index, &item)) {
+                jekv_log_debug("drop superseded %.*s in sec 0x%x", JEKV_MAX_KEY_LEN, item.name, entry->address);
+                jekv_sector_supersede_item(entry, index, &item);
+            }
 
-        /* STEP4 : erase the dirtiest secto*/
-        err = jekv_sector_erase(dirtiest);
-        if (err != JEKV_ERR_OK) {
-            return err;
+            index += jekv_item_get_span(&item);
         }
-
-        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_GC, JEKV_TRACE_GC_4_ERASE_OLD);
-
-        /*remove the dirtiest sector from active*/
-        dl_list_del(&dirtiest->list);
-
-        /*Add the dirtiest sector to idle list*/
-        dl_list_add_tail(&sm->idle, &dirtiest->list);
-
-        jekv_log_debug("GC:ok");
-
-        return JEKV_ERR_OK;
-    } else {
-        jekv_log_error("GC not do, need %d,only %d", need_size, most_dirty_size);
-        return JEKV_ERR_NO_SPACE;
     }
+
+    jekv_sm_flush_drops(sm);
 }
+#endif
 
 int jekv_sm_load(jekv_sector_manager_t *storage_manager, jekv_partition_t *pt)
 {
@@ -416,6 +776,10 @@ int jekv_sm_load(jekv_sector_manager_t *storage_manager, jekv_partition_t *pt)
         return err;
     }
 
+    /* Check the batch committed or not, before the last item check*/
+
+    sm_check_imcomplete_batch(sm);
+
     /* 1 : Check the last item wrote OK
        2 : Check whether the old data was deleted last time due to power failure
     */
@@ -426,6 +790,12 @@ int jekv_sm_load(jekv_sector_manager_t *storage_manager, jekv_partition_t *pt)
 
     sm_check_imcomplete_gc(sm);
 
+#if CONFIG_JEKV_DEFER_DROP
+    /* Check the superseded items whose drop marks are lost*/
+
+    sm_check_superseded(sm);
+#endif
+
     /* Check GC sector exist*/
     if (!pt->readonly && dl_list_empty(&sm->idle)) {
         /* The last sector use to GC but not do, roll back */
@@ -450,6 +820,7 @@ int jekv_sm_unload(jekv_sector_manager_t *sm)
     /*remove hash table for each sector*/
     dl_list_for_each(sec, &sm->active, jekv_sector_t, list)
     {
+        jekv_sector_flush_drops(sec);
         jekv_hash_clear(&sec->hash);
     }
 
@@ -483,6 +854,72 @@ int jekv_sm_request_sector(jekv_sector_manager_t *sm, int need_size)
     return err;
 }
 
+int jekv_sm_request_ring_sector(jekv_sector_manager_t *sm, jekv_sector_t **sector)
+{
+    int err;
+    jekv_sector_t *sec;
+
+    if (dl_list_len(&sm->idle) < 2) {
+        /*the KV GC keeps one idle sector only, free one by merging the KV sectors*/
+        err = sm_reclaim_sectors(sm);
+        if (err != JEKV_ERR_OK || dl_list_len(&sm->idle) < 2) {
+            jekv_log_debug("ring: no idle sector,err=%d", err);
+            return JEKV_ERR_NO_SPACE;
+        }
+    }
+
+    sec = dl_list_first(&sm->idle, jekv_sector_t, list);
+
+    if (sec->state != JEKV_SECTOR_STATE_UNINIT) {
+        err = jekv_sector_erase(sec);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    sec->serial_number = sm->serial_number++;
+
+    dl_list_del(&sec->list);
+    dl_list_add_tail(&sm->rings, &sec->list);
+
+    *sector = sec;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_sm_recycle_ring_sector(jekv_sector_manager_t *sm, jekv_sector_t *sec)
+{
+    int err;
+
+    err = jekv_sector_erase(sec);
+    if (err != JEKV_ERR_OK) {
+        /*erased again before use*/
+        dl_list_del(&sec->list);
+        dl_list_add_tail(&sm->idle, &sec->list);
+        return err;
+    }
+
+    sec->serial_number = sm->serial_number++;
+
+    dl_list_del(&sec->list);
+    dl_list_add_tail(&sm->rings, &sec->list);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_sm_release_ring_sector(jekv_sector_manager_t *sm, jekv_sector_t *sec)
+{
+    int err;
+
+    err = jekv_sector_erase(sec);
+
+    /*the sector is erased again before use if the erasing failed*/
+    dl_list_del(&sec->list);
+    dl_list_add_tail(&sm->idle, &sec->list);
+
+    return err;
+}
+
 int jekv_sm_find_item(jekv_sector_manager_t *sm, uint8_t group_id, jekv_type_t type, const char *key, int *item_index,
                         jekv_sector_t **sector, jekv_item_t *item, uint8_t seg_index, jekv_seg_start_t seg_start)
 {
@@ -502,13 +939,34 @@ int jekv_sm_find_item(jekv_sector_manager_t *sm, uint8_t group_id, jekv_type_t t
     return JEKV_ERR_NOT_FOUND;
 }
 
-int jekv_sm_check_write_blob_size(jekv_sector_manager_t *sm, uint32_t size)
+int jekv_sm_find_blob_seg(jekv_sector_manager_t *sm, uint8_t group_id, const char *key, const uint8_t *ver, int seg,
+                          int *item_index, jekv_sector_t **sector, jekv_item_t *item)
+{
+    int err;
+    jekv_sector_t *entry = NULL;
+
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        *item_index = 0;
+
+        err = jekv_sector_find_blob_seg(entry, group_id, key, item_index, item, JEKV_BLOB_SEG_ID(ver, seg),
+                                        JEKV_BLOB_SEG_PAGE(seg));
+        if (err == JEKV_ERR_OK) {
+            *sector = entry;
+            return JEKV_ERR_OK;
+        }
+    }
+
+    return JEKV_ERR_NOT_FOUND;
+}
+
+static int sm_check_write_blob_size(jekv_sector_manager_t *sm, uint32_t size)
 {
     jekv_sector_t *entry = NULL;
 
     int left_size      = size;
     int idle_num       = dl_list_len(&sm->idle);
-    int max_write_size = (sm->pt->sec_num - 1) * JEKV_SINGLE_ITEM_MAX_DATA_SIZE;
+    int max_write_size = (sm->pt->sec_num - 1 - dl_list_len(&sm->rings)) * JEKV_SINGLE_ITEM_MAX_DATA_SIZE;
     int free_size;
     int cur_seg_size;
     int seg_count = 0;
@@ -518,7 +976,7 @@ int jekv_sm_check_write_blob_size(jekv_sector_manager_t *sm, uint32_t size)
         return JEKV_ERR_NO_SPACE;
     }
 
-    if (left_size > JEKV_SEG_NUM_MAX * JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
+    if (left_size > JEKV_BLOB_SEG_NUM_MAX * JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
         return JEKV_ERR_INVALID_LENGTH;
     }
 
@@ -533,9 +991,10 @@ int jekv_sm_check_write_blob_size(jekv_sector_manager_t *sm, uint32_t size)
     /* check active sectors*/
     dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
     {
-        free_size = jekv_sm_get_gc_size(entry);
+        /*the droped slices of the pinned sector are not collected*/
+        free_size = entry->pin_count > 0 ? jekv_sm_get_free_size(entry) : jekv_sm_get_gc_size(entry);
 
-        if (left_size > 0 && seg_count >= JEKV_SEG_NUM_MAX) {
+        if (left_size > 0 && seg_count >= JEKV_BLOB_SEG_NUM_MAX) {
             jekv_log_debug("up to max segments");
             break;
         }
@@ -573,6 +1032,172 @@ int jekv_sm_check_write_blob_size(jekv_sector_manager_t *sm, uint32_t size)
     return JEKV_ERR_NO_SPACE;
 }
 
+int jekv_sm_check_write_blob_size(jekv_sector_manager_t *sm, uint32_t size)
+{
+    int err = sm_check_write_blob_size(sm, size);
+
+    if (err == JEKV_ERR_NO_SPACE && sm->retired_groups) {
+        /*the items of the deleted groups are counted after purged*/
+        err = jekv_sm_purge_groups(sm);
+        if (err == JEKV_ERR_OK) {
+            err = sm_check_write_blob_size(sm, size);
+        }
+    }
+
+    return err;
+}
+
+int jekv_sm_flush_drops(jekv_sector_manager_t *sm)
+{
+    int err;
+    jekv_sector_t *entry;
+
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        err = jekv_sector_flush_drops(entry);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
+uint64_t jekv_sm_get_groups(jekv_sector_manager_t *sm)
+{
+    jekv_sector_t *entry;
+    uint64_t groups = 0;
+
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        groups |= entry->hash.groups;
+    }
+
+    return groups;
+}
+
+int jekv_sm_purge_groups(jekv_sector_manager_t *sm)
+{
+    int err;
+    jekv_sector_t *entry;
+    jekv_item_t item;
+    int index;
+    uint8_t id;
+
+    dl_list_for_each(entry, &sm->active, jekv_sector_t, list)
+    {
+        for (id = 0; id < JEKV_GROUP_ID_MAX; id++) {
+            if (!(entry->hash.groups & sm->retired_groups & ((uint64_t)1 << id))) {
+                continue;
+            }
+
+            index = 0;
+
+            while (1) {
+                err = jekv_sector_find_item(entry, id, JEKV_TYPE_ANY, NULL, &index, &item, JEKV_SEG_ID_ANY,
+                                            JEKV_SEG_START_ANY);
+                if (err == JEKV_ERR_NOT_FOUND) {
+                    break;
+                } else if (err != JEKV_ERR_OK) {
+                    return err;
+                }
+
+                err = jekv_sector_erase_item(entry, index, &item, true);
+                if (err != JEKV_ERR_OK) {
+                    return err;
+                }
+
+                index += jekv_item_get_span(&item);
+            }
+        }
+
+        entry->hash.groups &= ~sm->retired_groups;
+    }
+
+    jekv_log_debug("purge groups 0x%llx", (unsigned long long)sm->retired_groups);
+
+    sm->retired_groups = 0;
+
+    return JEKV_ERR_OK;
+}
+
+/*count the merge of the sources to the compaction statistics*/
+static void sm_count_merge(jekv_compact_stat_t *stat, jekv_sector_t **srcs, int num)
+{
+    int i;
+
+    /*the header of the new sector*/
+    stat->written_bytes += JEKV_SLICE_SIZE;
+
+    for (i = 0; i < num; i++) {
+        jekv_log_debug("compact: sec=0x%x,droped=%d,live=%d", srcs[i]->address, srcs[i]->droped_slice,
+                       SM_USING_SLICE(srcs[i]));
+
+        stat->reclaimed_slices += srcs[i]->droped_slice;
+        stat->written_bytes += SM_USING_SLICE(srcs[i]) * JEKV_SLICE_SIZE;
+        stat->erased_sectors++;
+    }
+}
+
+int jekv_sm_compact(jekv_sector_manager_t *sm, jekv_compact_stat_t *stat)
+{
+    int err;
+    int i;
+    int num;
+    jekv_sector_t *entry = NULL;
+    jekv_sector_t *srcs[SM_MERGE_SRC_MAX];
+
+    if (sm->retired_groups) {
+        /*the items of the deleted groups are counted as droped after purged*/
+        err = jekv_sm_purge_groups(sm);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    /*every loop merges some sectors to one or cleans one, so the sector num is enough*/
+    for (i = 0; i < sm->pt->sec_num; i++) {
+        if (dl_list_empty(&sm->idle)) {
+            jekv_log_error("compact: no idle sector");
+            return JEKV_ERR_NO_SPACE;
+        }
+
+        /*the sectors of the fewest using items, merged to one*/
+        num = sm_pick_merge(sm, srcs);
+        if (num < 2) {
+            /*nothing to merge, clean the dirtiest sector*/
+            num = sm_pick_dirtiest(sm, srcs);
+            if (num == 0) {
+                break;
+            }
+        }
+
+        sm_count_merge(stat, srcs, num);
+
+        err = sm_merge_sectors(sm, srcs, num);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    /*erase the dirty idle sectors now, then requesting them later does not erase*/
+    dl_list_for_each(entry, &sm->idle, jekv_sector_t, list)
+    {
+        if (entry->state == JEKV_SECTOR_STATE_CRASH || entry->state == JEKV_SECTOR_STATE_INVALID) {
+            err = jekv_sector_erase(entry);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+
+            stat->erased_sectors++;
+        }
+    }
+
+    stat->idle_sectors = dl_list_len(&sm->idle);
+
+    return JEKV_ERR_OK;
+}
+
 int jekv_sm_get_status(jekv_sector_manager_t *sm, jekv_status_t *status)
 {
     jekv_sector_t *entry = NULL;
@@ -587,6 +1212,12 @@ int jekv_sm_get_status(jekv_sector_manager_t *sm, jekv_status_t *status)
         droped_slice += entry->droped_slice;
     }
 
+    /*the records of the rings and queues are not collected, they are using until the sector is reclaimed*/
+    dl_list_for_each(entry, &sm->rings, jekv_sector_t, list)
+    {
+        used_slice += entry->used_slice + 1;
+    }
+
     status->total_size  = sm->pt->sec_size * sm->pt->sec_num;
     status->using_size  = used_slice * JEKV_SLICE_SIZE;
     status->droped_size = droped_slice * JEKV_SLICE_SIZE;
@@ -8,6 +8,7 @@
 #include "jekv_porting.h"
 #include "jekv_partition.h"
 #include "jekv_sector.h"
+#include "jekv_pack.h"
 
 #ifndef __JEKV_SECTOR_MANAGER_H__
 #define __JEKV_SECTOR_MANAGER_H__
@@ -19,9 +20,11 @@ extern "C" {
 typedef struct {
     struct dl_list active;    /**< using sector list      */
     struct dl_list idle;      /**< idle sector list       */
+    struct dl_list rings;     /**< ring and queue sector list, in the serial order */
     jekv_partition_t *pt;     /**< partition infomation   */
     jekv_sector_t *sec_arr;   /**< sector infomation list */
     uint32_t serial_number;   /**< next serial number     */
+    uint64_t retired_groups;  /**< bits of the deleted group ids, their items are dropped by the next GC */
 
 } jekv_sector_manager_t;
 
@@ -34,8 +37,40 @@ int jekv_sm_request_sector(jekv_sector_manager_t *sm, int need_size);
 int jekv_sm_find_item(jekv_sector_manager_t *sm, uint8_t group_id, jekv_type_t type, const char *key, int *item_index,
                         jekv_sector_t **sector, jekv_item_t *item, uint8_t seg_index, jekv_seg_start_t seg_start);
 
+/*find the segment seg of the blob of the version bits*/
+int jekv_sm_find_blob_seg(jekv_sector_manager_t *sm, uint8_t group_id, const char *key, const uint8_t *ver, int seg,
+                          int *item_index, jekv_sector_t **sector, jekv_item_t *item);
+
 int jekv_sm_check_write_blob_size(jekv_sector_manager_t *sm, uint32_t size);
 
+/*take an idle sector for a ring or a queue, one idle sector is always kept for GC, the KV sectors are merged to free
+  one if no other is idle*/
+int jekv_sm_request_ring_sector(jekv_sector_manager_t *sm, jekv_sector_t **sector);
+
+/*erase the ring sector and move it to the ring list end, it is written as the newest sector of its ring*/
+int jekv_sm_recycle_ring_sector(jekv_sector_manager_t *sm, jekv_sector_t *sec);
+
+/*erase the ring or queue sector and give it back to the idle list*/
+int jekv_sm_release_ring_sector(jekv_sector_manager_t *sm, jekv_sector_t *sec);
+
+/*bits of the group ids of the items in the active sectors, the ids of the droped items may be left*/
+uint64_t jekv_sm_get_groups(jekv_sector_manager_t *sm);
+
+/*drop the items of the retired groups one by one, then their ids are free*/
+int jekv_sm_purge_groups(jekv_sector_manager_t *sm);
+
+/*program the drop marks kept in RAM of all the sectors*/
+int jekv_sm_flush_drops(jekv_sector_manager_t *sm);
+
+/*merge the using items of the sectors to as few sectors as they fit in, then erase the merged ones*/
+int jekv_sm_compact(jekv_sector_manager_t *sm, jekv_compact_stat_t *stat);
+
+/*the items of the retired group are not found by the key, the next GC drops them*/
+inline static bool jekv_sm_is_group_retired(jekv_sector_manager_t *sm, uint8_t group_id)
+{
+    return (sm->retired_groups & ((uint64_t)1 << group_id)) != 0;
+}
+
 inline static jekv_sector_t *jekv_sm_get_current_sector(jekv_sector_manager_t *sm)
 {
     return dl_list_last(&sm->active, jekv_sector_t, list);
@@ -43,7 +78,7 @@ inline static jekv_sector_t *jekv_sm_get_current_sector(jekv_sector_manager_t *s
 
 inline static int jekv_sm_get_gc_size(jekv_sector_t *sec)
 {
-    return (JEKV_ENTRY_COUNT - sec->used_slice + sec->droped_slice) * JEKV_SLICE_SIZE;
+    return (JEKV_ENTRY_COUNT - sec->used_slice + sec->droped_slice + jekv_pack_get_gc_gain(sec)) * JEKV_SLICE_SIZE;
 }
 
 inline static int jekv_sm_get_free_size(jekv_sector_t *sec)
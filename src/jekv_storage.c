@@ -1,31 +1,92 @@
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #define LOG_TAG "jekv_store"
 #include "jekv_porting.h"
 #include "jekv_base.h"
 #include "jekv_storage.h"
+#include "jekv_cache.h"
+#include "jekv_blob_map.h"
+#include "jekv_ring.h"
+#include "jekv_queue.h"
+#include "jekv_lz.h"
+#include "jekv_pack.h"
+#include "jekv_record.h"
 #include "jekv_debug.h"
 #include "jekv_log.h"
 
+/*rewrite the changed segments of a blob only, the unchanged ones are shared with the new blob*/
+#ifndef CONFIG_JEKV_BLOB_DELTA_WRITE
+#define CONFIG_JEKV_BLOB_DELTA_WRITE 1
+#endif
+
+/*program the value over the old one when it only clears bits, as flags and bitmaps*/
+#ifndef CONFIG_JEKV_ITEM_REWRITE
+#define CONFIG_JEKV_ITEM_REWRITE 1
+#endif
+
 typedef struct {
     struct dl_list list;               /**< blob check list          */
     char name[JEKV_MAX_KEY_LEN + 1];   /**< blob desc name           */
     uint8_t group_id;                  /**< group id                 */
-    uint8_t seg_count;                 /**< segment count            */
-    uint8_t count_seg_cnt;             /**< calculated segment count */
-    uint8_t seg_start;                 /**< segment start            */
+    uint16_t seg_count;                /**< segment count            */
+    uint16_t count_seg_cnt;            /**< calculated segment count */
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE]; /**< segment version bits   */
     uint32_t desc_data_size;           /**< blob data all size       */
     uint32_t count_data_size;          /**< calculated segment size  */
+    jekv_sector_t *sec;                /**< sector of the descriptor */
+    int index;                         /**< slice index of the desc  */
 } jekv_blob_into_t;
 
+static uint8_t storage_find_free_id(uint64_t id_map)
+{
+    uint8_t i;
+
+    for (i = 1; i < JEKV_GROUP_ID_MAX; i++) {
+        if (!(id_map & (((uint64_t)1) << i))) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*
+get an id not used by the groups nor the retired ones, the retired ids are given back when their items are gone,
+return JEKV_GROUP_ID_ANY if no id is free
+*/
+static uint8_t storage_get_free_id(jekv_storage_t *storage, uint64_t id_map)
+{
+    jekv_sector_manager_t *sm = &storage->sm;
+    uint8_t id;
+
+    id = storage_find_free_id(id_map | sm->retired_groups);
+    if (id != JEKV_GROUP_ID_ANY) {
+        return id;
+    }
+
+    /*the items may be dropped by GC*/
+    sm->retired_groups &= jekv_sm_get_groups(sm);
+
+    id = storage_find_free_id(id_map | sm->retired_groups);
+    if (id != JEKV_GROUP_ID_ANY || !sm->retired_groups) {
+        return id;
+    }
+
+    if (jekv_sm_purge_groups(sm) != JEKV_ERR_OK) {
+        return JEKV_GROUP_ID_ANY;
+    }
+
+    return storage_find_free_id(id_map);
+}
+
 /*
 find group id or find a free id for new group
 */
 static int storage_find_group(jekv_storage_t *storage, const char *group, uint8_t *id)
 {
     jekv_group_t *entry = NULL;
-    uint32_t i;
 
     uint64_t id_map = 0;
 
@@ -40,19 +101,25 @@ static int storage_find_group(jekv_storage_t *storage, const char *group, uint8_
         id_map |= ((uint64_t)1) << entry->id;
     }
 
-    /* Get a free id */
-    for (i = 1; i < JEKV_GROUP_ID_MAX; i++) {
-        if (!(id_map & (((uint64_t)1) << i))) {
-            break;
-        }
-    }
-
-    *id = i;
-    jekv_log_debug("get free id=%d", i);
+    *id = storage_get_free_id(storage, id_map);
+    jekv_log_debug("get free id=%d", *id);
 
     return JEKV_ERR_FAIL;
 }
 
+static uint64_t storage_get_id_map(jekv_storage_t *storage)
+{
+    jekv_group_t *entry = NULL;
+    uint64_t id_map     = 0;
+
+    dl_list_for_each(entry, &storage->group_list, jekv_group_t, list)
+    {
+        id_map |= ((uint64_t)1) << entry->id;
+    }
+
+    return id_map;
+}
+
 static int storage_add_group(jekv_storage_t *storage, uint8_t group_id, const char *group_name, int max_size)
 {
     jekv_group_t *group_node;
@@ -115,7 +182,7 @@ static int storage_cmp_find_item(jekv_storage_t *storage, jekv_sector_t *find_se
         return JEKV_ERR_FAIL;
     }
 
-    if (size != find_item->length) {
+    if (size != JEKV_ITEM_VALUE_SIZE(find_item) || JEKV_ITEM_IS_COUNTER(find_item)) {
         return JEKV_ERR_FAIL;
     }
 
@@ -124,7 +191,7 @@ static int storage_cmp_find_item(jekv_storage_t *storage, jekv_sector_t *find_se
     } else {
         uint8_t *p = JEKV_MALLOC(size);
         if (p) {
-            err = jekv_pt_read(find_sector->pt, find_sector->address + (item_index + 2) * JEKV_SLICE_SIZE, p, size);
+            err = jekv_sector_read_item_data(find_sector, item_index, find_item, p, size);
             jekv_log_debug("read data, index=%d,size=%d,err=%d", item_index, size, err);
             if (err == JEKV_ERR_OK) {
                 err = (memcmp(data, p, size) == 0 ? JEKV_ERR_OK : JEKV_ERR_FAIL);
@@ -165,19 +232,31 @@ static int storage_blob_init_info(jekv_storage_t *storage, struct dl_list *info)
 
             /*record blob infomation*/
 
+            if (jekv_sector_read_blob_ver(it, item_index, &item, blob->ver) != JEKV_ERR_OK) {
+                /*bad descriptor extension, the segments are dropped by storage_blob_check_drop*/
+                jekv_log_debug("erase blob desc %.*s, bad ext", JEKV_MAX_KEY_LEN, item.name);
+                jekv_sector_erase_item(it, item_index, &item, true);
+
+                JEKV_FREE(blob);
+                item_index += jekv_item_get_span(&item);
+                continue;
+            }
+
             dl_list_init(&blob->list);
 
             memcpy(blob->name, item.name, JEKV_MAX_KEY_LEN);
             blob->name[JEKV_MAX_KEY_LEN] = 0;
 
             blob->group_id       = item.group_id;
-            blob->seg_count      = item.seg_count;
-            blob->seg_start      = item.seg_start;
+            blob->seg_count      = JEKV_ITEM_BLOB_SEG_COUNT(&item);
             blob->desc_data_size = item.all_size;
 
             blob->count_seg_cnt   = 0;
             blob->count_data_size = 0;
 
+            blob->sec   = it;
+            blob->index = item_index;
+
             dl_list_add_tail(info, &blob->list);
 
             /*goto next item*/
@@ -211,7 +290,6 @@ static int storage_blob_check_match(jekv_storage_t *storage, struct dl_list *inf
     jekv_item_t item;
     jekv_blob_into_t *desc = NULL;
     jekv_blob_into_t *desc_next;
-    jekv_sector_t *found_sec = NULL;
 
     jekv_log_debug("blob check match");
 
@@ -232,17 +310,16 @@ static int storage_blob_check_match(jekv_storage_t *storage, struct dl_list *inf
                 break;
             }
 
+            /*the unchanged segments are shared by the old and the new descriptor, count for both*/
             dl_list_for_each(desc, info, jekv_blob_into_t, list)
             {
                 if (!strncmp(item.name, desc->name, JEKV_MAX_KEY_LEN) && item.group_id == desc->group_id &&
-                    item.seg_id >= desc->seg_start &&
-                    item.seg_id < (desc->seg_start == JEKV_SEG_START_VER_1 ? JEKV_SEG_START_ANY : JEKV_SEG_START_VER_1)) {
+                    jekv_blob_ver_match(desc->ver, desc->seg_count, &item)) {
                     /*statistic segments count and segments size*/
                     jekv_log_debug("count seg: %.*s, desc=%s,seg_id=%d,gid=[%d,%d]", JEKV_MAX_KEY_LEN, item.name, desc->name,
                                  item.seg_id, item.group_id, desc->group_id);
                     desc->count_seg_cnt++;
                     desc->count_data_size += item.length;
-                    break;
                 }
             }
 
@@ -258,12 +335,12 @@ static int storage_blob_check_match(jekv_storage_t *storage, struct dl_list *inf
             jekv_log_debug("blob mismatch,name=%s,count=%u,%u, size=%u,%u", desc->name, desc->count_seg_cnt, desc->seg_count,
                         desc->count_data_size, desc->desc_data_size);
 
-            /*erase blob descriptor*/
-            err = jekv_sm_find_item(&storage->sm, desc->group_id, JEKV_TYPE_BLOB, desc->name, &item_index, &found_sec,
-                                      &item, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+            /*erase blob descriptor, the old one of the same blob may be kept*/
+            err = jekv_sector_find_item(desc->sec, desc->group_id, JEKV_TYPE_BLOB, desc->name, &desc->index, &item,
+                                        JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
             if (err == JEKV_ERR_OK) {
                 jekv_log_debug("erase blob desc %s", desc->name);
-                jekv_sector_erase_item(found_sec, item_index, &item, true);
+                jekv_sector_erase_item(desc->sec, desc->index, &item, true);
             }
 
             /*remove from list and delete it*/
@@ -277,6 +354,52 @@ static int storage_blob_check_match(jekv_storage_t *storage, struct dl_list *inf
     return JEKV_ERR_OK;
 }
 
+/*
+    power off after the new descriptor is written and before the old one is erased,
+    keep the newer one. The descriptors are listed from the oldest sector.
+*/
+static int storage_blob_check_dup(jekv_storage_t *storage, struct dl_list *info)
+{
+    int err;
+    jekv_item_t item;
+    jekv_blob_into_t *desc = NULL;
+    jekv_blob_into_t *desc_next;
+    jekv_blob_into_t *newer;
+    bool found;
+
+    dl_list_for_each_safe(desc, desc_next, info, jekv_blob_into_t, list)
+    {
+        found = false;
+
+        /*look for the same blob after it*/
+        for (newer = dl_list_entry(desc->list.next, jekv_blob_into_t, list); &newer->list != info;
+             newer = dl_list_entry(newer->list.next, jekv_blob_into_t, list)) {
+            if (!strncmp(newer->name, desc->name, JEKV_MAX_KEY_LEN) && newer->group_id == desc->group_id) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            continue;
+        }
+
+        jekv_log_debug("blob dup, erase old desc %s", desc->name);
+
+        /*erase old descriptor, the segments are dropped by storage_blob_check_drop*/
+        err = jekv_sector_find_item(desc->sec, desc->group_id, JEKV_TYPE_BLOB, desc->name, &desc->index, &item,
+                                    JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+        if (err == JEKV_ERR_OK) {
+            jekv_sector_erase_item(desc->sec, desc->index, &item, true);
+        }
+
+        dl_list_del(&desc->list);
+        JEKV_FREE(desc);
+    }
+
+    return JEKV_ERR_OK;
+}
+
 static int storage_blob_check_drop(jekv_storage_t *storage, struct dl_list *info)
 {
     int err;
@@ -309,8 +432,7 @@ static int storage_blob_check_drop(jekv_storage_t *storage, struct dl_list *info
             {
                 /*look for the blob descriptor*/
                 if (!strncmp(item.name, desc->name, strnlen(desc->name, JEKV_MAX_KEY_LEN)) &&
-                    item.group_id == desc->group_id && item.seg_id >= desc->seg_start &&
-                    item.seg_id < (desc->seg_start == JEKV_SEG_START_VER_1 ? JEKV_SEG_START_ANY : JEKV_SEG_START_VER_1)) {
+                    item.group_id == desc->group_id && jekv_blob_ver_match(desc->ver, desc->seg_count, &item)) {
                     /*match*/
                     found = 1;
                     break;
@@ -354,6 +476,12 @@ static int storage_blob_check(jekv_storage_t *storage)
         goto BLOB_CHECK_END;
     }
 
+    /*check and erase the old descriptor of the same blob*/
+    err = storage_blob_check_dup(storage, &info);
+    if (err != JEKV_ERR_OK) {
+        goto BLOB_CHECK_END;
+    }
+
     /*check and erase the droped segments*/
     err = storage_blob_check_drop(storage, &info);
     if (err != JEKV_ERR_OK) {
@@ -380,8 +508,17 @@ int jekv_storage_init(jekv_partition_t *pt, jekv_storage_t **storage)
         return JEKV_ERR_NO_MEM;
     }
 
+    err = jekv_port_rwlock_create(&store->lock);
+    if (err != JEKV_ERR_OK) {
+        JEKV_FREE(store);
+        return err;
+    }
+
     store->pt = *pt;
     dl_list_init(&store->group_list);
+    dl_list_init(&store->blob_maps);
+    dl_list_init(&store->rings);
+    dl_list_init(&store->queues);
 
     /*sector manager load */
     err = jekv_sm_load(&store->sm, &store->pt);
@@ -395,12 +532,34 @@ int jekv_storage_init(jekv_partition_t *pt, jekv_storage_t **storage)
         return err;
     }
 
+    /*the ids of the items without group are the deleted groups*/
+    store->sm.retired_groups = jekv_sm_get_groups(&store->sm) & ~storage_get_id_map(store) &
+                               ~(((uint64_t)1 << JEKV_GROUP_ITSELF_ID) | ((uint64_t)1 << JEKV_GROUP_ID_ANY));
+
     /* check blob data*/
     err = storage_blob_check(store);
     if (err != JEKV_ERR_OK) {
         return err;
     }
 
+    /* locate blob segments*/
+    err = jekv_blob_map_load(store);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /* build the ring logs*/
+    err = jekv_ring_load(store);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /* build the queues*/
+    err = jekv_queue_load(store);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
     *storage = store;
 
     jekv_log_debug("pt=%s", store->pt.name);
@@ -410,6 +569,7 @@ int jekv_storage_init(jekv_partition_t *pt, jekv_storage_t **storage)
 
 int jekv_storage_deinit(jekv_storage_t *storage)
 {
+    int err;
     jekv_group_t *entry;
     jekv_group_t *next;
 
@@ -423,10 +583,21 @@ int jekv_storage_deinit(jekv_storage_t *storage)
         JEKV_FREE(entry);
     }
 
+    /*save the dirty items, the storage is freed even if it fails*/
+    err = jekv_cache_deinit(storage);
+
+    jekv_blob_map_deinit(storage);
+
+    jekv_ring_deinit(storage);
+
+    jekv_queue_deinit(storage);
+
     /*unload*/
     jekv_sm_unload(&storage->sm);
 
-    return JEKV_ERR_OK;
+    jekv_port_rwlock_delete(storage->lock);
+
+    return err;
 }
 
 int jekv_storage_open_group(jekv_storage_t *storage, const char *group, bool create_new, uint8_t *group_id)
@@ -530,34 +701,56 @@ static int storage_get_non_blob_write_req_size(jekv_type_t type, uint32_t size)
     return request_size;
 }
 
-static int storage_write_blob_desc(jekv_sector_t *sec, uint8_t group_id, const char *key, uint32_t size, uint8_t seg_count,
-                                   jekv_seg_start_t seg_start)
+/*
+    write the non-blob item, raw_length: the value size if the data is compressed, 0 if not.
+    rewrite: the value can be programmed in place later.
+*/
+static int storage_write_value(jekv_sector_t *sec, uint8_t group_id, jekv_type_t type, const char *key,
+                               const void *data, uint32_t size, uint32_t raw_length, bool rewrite)
 {
-    jekv_item_t desc_item;
-
-    desc_item.all_size  = size;
-    desc_item.seg_count = seg_count;
-    desc_item.seg_start = seg_start;
-    desc_item.resv2     = 0xffff;
+    if (raw_length) {
+        return jekv_sector_write_lz_item(sec, group_id, type, key, data, size, raw_length);
+    }
 
-    jekv_log_debug("write desc, key=%s,size=%u,seg_count=%d,seg_start=%d", key, size, seg_count, seg_start);
+    if (rewrite) {
+        return jekv_sector_write_rewrite_item(sec, group_id, type, key, data, size);
+    }
 
-    return jekv_sector_write_item(sec, group_id, JEKV_TYPE_BLOB, key, desc_item.data, sizeof(desc_item.data),
-                                    JEKV_SEG_ID_ANY);
+    return jekv_sector_write_item(sec, group_id, type, key, data, size, JEKV_SEG_ID_ANY);
 }
 
-static int storage_cmp_blob(jekv_storage_t *storage, jekv_item_t *item, const void *data, uint32_t size)
+static int storage_write_blob_desc(jekv_storage_t *storage, jekv_sector_t *sec, uint8_t group_id, const char *key,
+                                   uint32_t size, int seg_count, const uint8_t *ver)
 {
-    int seg_count = item->seg_count;
-    int seg_start = item->seg_start;
+    int err;
+    int index = sec->next_free_slice;
+    jekv_item_t desc;
+    jekv_blob_map_t *map;
+
+    jekv_log_debug("write desc, key=%s,size=%u,seg_count=%d", key, size, seg_count);
+
+    err = jekv_sector_write_blob_desc(sec, group_id, key, size, seg_count, ver);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    /*build the segment map of the new blob*/
+    if (jekv_pt_read_item(sec->pt, sec->address + (index + 1) * JEKV_SLICE_SIZE, &desc) == JEKV_ERR_OK) {
+        jekv_blob_map_get(storage, sec, index, &desc, &map);
+    }
+
+    return JEKV_ERR_OK;
+}
 
+#if !CONFIG_JEKV_BLOB_DELTA_WRITE
+static int storage_cmp_blob(jekv_storage_t *storage, jekv_sector_t *find_sector, int found_index, jekv_item_t *item,
+                            const void *data, uint32_t size)
+{
+    jekv_blob_map_t *map;
     uint32_t offset = 0;
-    jekv_item_t seg;
-    jekv_sector_t *seg_sec;
-    int seg_index;
     int i = 0;
 
-    int err = JEKV_ERR_NOT_FOUND;
+    int err;
 
     uint8_t *pdata;
 
@@ -567,143 +760,104 @@ static int storage_cmp_blob(jekv_storage_t *storage, jekv_item_t *item, const vo
         return JEKV_ERR_FAIL;
     }
 
+    err = jekv_blob_map_get(storage, find_sector, found_index, item, &map);
+    if (err != JEKV_ERR_OK) {
+        return JEKV_ERR_FAIL;
+    }
+
     pdata = JEKV_MALLOC(JEKV_SINGLE_ITEM_MAX_DATA_SIZE);
     if (!pdata) {
         return JEKV_ERR_NO_MEM;
     }
 
-    for (i = 0; i < seg_count; i++) {
-        seg_index = 0;
-        seg_sec   = NULL;
-
-        /*look for segments data */
-        err = jekv_sm_find_item(&storage->sm, item->group_id, (jekv_type_t)JEKV_TYPE_BLOB_SEG, item->name, &seg_index, &seg_sec, &seg,
-                                  seg_start + i, (jekv_seg_start_t)seg_start);
-        if (err != JEKV_ERR_OK) {
-            jekv_log_debug("not found %d", i);
-            break;
-        }
-
-        /*check segments data size */
-        if (seg.length + offset > size) {
-            jekv_log_debug("size out %u,%u", seg.length + offset, size);
-            break;
-        }
-
+    for (i = 0; i < map->seg_count; i++) {
         /*read blob segments data*/
-        err = jekv_sector_read_item_data(seg_sec, seg_index, &seg, pdata, seg.length);
+        err = jekv_blob_map_read(map, i, 0, pdata, map->segs[i].length);
         if (err != JEKV_ERR_OK) {
             break;
         }
 
         /*compare blob segments data*/
-        if (memcmp(pdata, (uint8_t *)data + offset, seg.length)) {
+        if (memcmp(pdata, (uint8_t *)data + offset, map->segs[i].length)) {
             /*not same*/
             jekv_log_debug("seg same err");
             break;
         }
 
-        offset += seg.length;
+        offset += map->segs[i].length;
     }
 
     JEKV_FREE(pdata);
 
-    if (i == seg_count && offset == size) {
+    if (i == map->seg_count && offset == size) {
         /*all segements same*/
         return JEKV_ERR_OK;
     } else {
         /*not same*/
-        jekv_log_debug("blob cmp cnt=%u:%u,size=%u:%u", i, seg_count, offset, size);
+        jekv_log_debug("blob cmp cnt=%u:%u,size=%u:%u", i, map->seg_count, offset, size);
         return JEKV_ERR_FAIL;
     }
 }
+#endif
 
-static int storage_read_blob(jekv_storage_t *storage, jekv_item_t *item, void *data, uint32_t size)
+static int storage_read_blob(jekv_storage_t *storage, jekv_sector_t *find_sector, int found_index, jekv_item_t *item,
+                             void *data, uint32_t size)
 {
-    int seg_count = item->seg_count;
-    int seg_start = item->seg_start;
-
+    jekv_blob_map_t *map;
     uint32_t offset = 0;
-    jekv_item_t seg;
-    jekv_sector_t *seg_sec;
-    int seg_index;
     int i = 0;
 
-    int err = JEKV_ERR_NOT_FOUND;
-
-    for (i = 0; i < seg_count; i++) {
-        seg_index = 0;
-        seg_sec   = NULL;
-
-        jekv_log_debug("read seg: %d,[seg_index=%d,seg_start=%d]", i, seg_start + i, seg_start);
+    int err;
 
-        /*look for segments*/
-        err = jekv_sm_find_item(&storage->sm, item->group_id, (jekv_type_t)JEKV_TYPE_BLOB_SEG, item->name, &seg_index, &seg_sec, &seg,
-                                  seg_start + i, (jekv_seg_start_t)seg_start);
-        if (err != JEKV_ERR_OK) {
-            jekv_log_debug("find seg %d, err=%d", i, err);
-            return err;
-        }
+    /*segments count and size are checked when the map is built*/
+    err = jekv_blob_map_get(storage, find_sector, found_index, item, &map);
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("blob map err=%d", err);
+        return err;
+    }
 
-        /*check segments length*/
-        if (seg.length + offset > size) {
-            jekv_log_debug("bad length");
-            return JEKV_ERR_INVALID_LENGTH;
-        }
+    if (item->all_size != size) {
+        return JEKV_ERR_INVALID_LENGTH;
+    }
 
-        jekv_log_debug("start read seg %d, size=%d", i, seg.length);
+    for (i = 0; i < map->seg_count; i++) {
+        jekv_log_debug("start read seg %d, size=%d", i, map->segs[i].length);
 
         /*read segments data*/
-        err = jekv_sector_read_item_data(seg_sec, seg_index, &seg, (uint8_t *)data + offset, seg.length);
+        err = jekv_blob_map_read(map, i, 0, (uint8_t *)data + offset, map->segs[i].length);
         if (err != JEKV_ERR_OK) {
             return err;
         }
 
-        offset += seg.length;
+        offset += map->segs[i].length;
     }
 
-    jekv_log_debug("i=%d,seg_count=%d,offset=%d,size=%d", i, seg_count, offset, size);
-
-    if (i == seg_count && offset == size) {
-        /*read all segments data ok*/
-        return JEKV_ERR_OK;
-    } else {
-        if (offset > 0) {
-            return JEKV_ERR_INVALID_LENGTH;
-        } else {
-            return JEKV_ERR_NOT_FOUND;
-        }
-    }
+    return JEKV_ERR_OK;
 }
 
-static int storage_erase_blob(jekv_storage_t *storage, jekv_sector_t *find_sector, int found_index, jekv_item_t *item)
+static int storage_erase_blob_segs(jekv_storage_t *storage, uint8_t group_id, const char *key, const uint8_t *ver,
+                                   int seg_count, const uint8_t *keep)
 {
-    int seg_count = item->seg_count;
-    int seg_start = item->seg_start;
-
     jekv_item_t seg;
     jekv_sector_t *seg_sec;
     int seg_index;
     int i = 0;
 
-    int err = JEKV_ERR_NOT_FOUND;
-
-    /*delete blob descriptor*/
-    jekv_log_debug("erase desc %.*s:%d ", JEKV_MAX_KEY_LEN, item->name, i);
-    err = jekv_sector_erase_item(find_sector, found_index, item, true);
-
-    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_ERASE_OLD_DESC);
+    int err;
 
     for (i = 0; i < seg_count; i++) {
-        seg_index = 0;
-        seg_sec   = NULL;
+        seg_sec = NULL;
+
+        if (keep && JEKV_BLOB_SEG_VER(keep, i) == JEKV_BLOB_SEG_VER(ver, i)) {
+            /*referenced by the new descriptor*/
+            continue;
+        }
 
         /*look for segments*/
-        err = jekv_sm_find_item(&storage->sm, item->group_id, (jekv_type_t)JEKV_TYPE_BLOB_SEG, item->name, &seg_index, &seg_sec, &seg,
-                                  seg_start + i, (jekv_seg_start_t)seg_start);
+        err = jekv_sm_find_blob_seg(&storage->sm, group_id, key, ver, i, &seg_index, &seg_sec, &seg);
         if (err != JEKV_ERR_OK) {
-            jekv_log_debug("find erase seg %.*s:%d err", JEKV_MAX_KEY_LEN, item->name, i);
-            break;
+            jekv_log_debug("find erase seg %.*s:%d err", JEKV_MAX_KEY_LEN, key, i);
+            continue;
         }
 
         /*delete segments*/
@@ -711,11 +865,48 @@ static int storage_erase_blob(jekv_storage_t *storage, jekv_sector_t *find_secto
         jekv_sector_erase_item(seg_sec, seg_index, &seg, true);
     }
 
+    return JEKV_ERR_OK;
+}
+
+/*erase the blob, the segments of the same version in keep are shared with the new blob and kept*/
+static int storage_erase_blob(jekv_storage_t *storage, jekv_sector_t *find_sector, int found_index, jekv_item_t *item,
+                              const uint8_t *keep)
+{
+    int err;
+    jekv_blob_map_t *map;
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE];
+
+    err = jekv_blob_map_get(storage, find_sector, found_index, item, &map);
+    if (err != JEKV_ERR_OK && jekv_sector_read_blob_ver(find_sector, found_index, item, ver) != JEKV_ERR_OK) {
+        /*the segments are dropped at next mount*/
+        jekv_log_debug("erase desc %.*s, no version", JEKV_MAX_KEY_LEN, item->name);
+        return jekv_sector_erase_item(find_sector, found_index, item, true);
+    }
+
+    /*delete blob descriptor*/
+    jekv_log_debug("erase desc %.*s", JEKV_MAX_KEY_LEN, item->name);
+    jekv_sector_erase_item(find_sector, found_index, item, true);
+
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_ERASE_OLD_DESC);
+
+    if (err != JEKV_ERR_OK) {
+        /*some segments are lost, erase the others*/
+        return storage_erase_blob_segs(storage, item->group_id, item->name, ver, JEKV_ITEM_BLOB_SEG_COUNT(item), keep);
+    }
+
+    err = jekv_blob_map_erase_segs(map, keep);
+
+    jekv_blob_map_remove(storage, find_sector, found_index);
+
     return err;
 }
 
+/*
+    write the data as the segments from seg_first, then the descriptor of the blob of all_size.
+    the segments id are got from the version bits.
+*/
 static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data, uint32_t dataSize,
-                              jekv_seg_start_t seg_start)
+                              const uint8_t *ver, int seg_first, uint32_t all_size)
 {
     int err = JEKV_ERR_OK;
 
@@ -727,7 +918,7 @@ static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const c
     int offset    = 0;
     int cur_seg_size;
 
-    uint8_t seg_id = seg_start;
+    int seg = seg_first;
 
     /*get current sector*/
     sec = jekv_sm_get_current_sector(&storage->sm);
@@ -737,7 +928,7 @@ static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const c
     }
 
     if ((sec->droped_slice > 0 && left_size + JEKV_SLICE_SIZE > jekv_sm_get_free_size(sec)) ||
-        left_size > (JEKV_SEG_NUM_MAX - 1) * JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
+        left_size > (JEKV_BLOB_SEG_NUM_MAX - 1) * JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
         /*
         sector is dirty and need split: request a sector first, let the segments are written to the slimed secctors,
         so the free size and the gc size are same. then the check size and the write size are matched.
@@ -751,7 +942,7 @@ static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const c
 
     while (1) {
         /*too many segments*/
-        if (seg_id - seg_start >= JEKV_SEG_NUM_MAX && left_size > 0) {
+        if (seg >= JEKV_BLOB_SEG_NUM_MAX && left_size > 0) {
             jekv_log_debug("too many segs");
             break;
         }
@@ -765,20 +956,20 @@ static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const c
             /*check data write*/
             if (left_size + JEKV_SLICE_SIZE <= free_size) {
                 /*can write all left data*/
-                jekv_log_debug("blob w: %d,left=%d", seg_id, left_size);
-                err = jekv_sector_write_item(sec, group_id, JEKV_TYPE_BLOB_SEG, key, (uint8_t *)data + offset, left_size,
-                                               seg_id++);
+                jekv_log_debug("blob w: %d,left=%d", seg, left_size);
+                err = jekv_sector_write_blob_seg(sec, group_id, key, (uint8_t *)data + offset, left_size, ver, seg);
                 if (err != JEKV_ERR_OK) {
                     return err;
                 }
+                seg++;
                 left_size = 0;
 
-                if (sec->next_free_slice + 1 <= JEKV_ENTRY_COUNT) {
+                if (sec->next_free_slice + jekv_item_get_blob_desc_span(ver, seg) <= JEKV_ENTRY_COUNT) {
                     jekv_log_debug("blob w: desc");
 
                     JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_WRITE_ALL_SEG);
 
-                    return storage_write_blob_desc(sec, group_id, key, dataSize, seg_id - seg_start, (jekv_seg_start_t)seg_start);
+                    return storage_write_blob_desc(storage, sec, group_id, key, all_size, seg, ver);
                 } else {
                     jekv_log_debug("blob w: skip desc");
                     /*need write desc next loop*/
@@ -788,13 +979,20 @@ static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const c
 
                 if (free_size >= JEKV_BLOB_MIN_SEG_SIZE + JEKV_SLICE_SIZE) {
                     cur_seg_size = free_size - JEKV_SLICE_SIZE;
+
+                    if (seg + 1 >= JEKV_SEG_NUM_MAX && left_size - cur_seg_size < JEKV_BLOB_PAGE_SEG_MIN_SIZE) {
+                        /*the next segment is out of the first page, its data can't be in the item*/
+                        cur_seg_size = left_size - JEKV_BLOB_PAGE_SEG_MIN_SIZE;
+                    }
+
                     /*write_segment*/
-                    jekv_log_debug("blob w: %d,left=%d", seg_id, cur_seg_size);
-                    err = jekv_sector_write_item(sec, group_id, JEKV_TYPE_BLOB_SEG, key, (uint8_t *)data + offset,
-                                                   cur_seg_size, seg_id++);
+                    jekv_log_debug("blob w: %d,left=%d", seg, cur_seg_size);
+                    err = jekv_sector_write_blob_seg(sec, group_id, key, (uint8_t *)data + offset, cur_seg_size, ver,
+                                                     seg);
                     if (err != JEKV_ERR_OK) {
                         return err;
                     }
+                    seg++;
                     offset += cur_seg_size;
                     left_size -= cur_seg_size;
 
@@ -806,13 +1004,13 @@ static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const c
                 }
             }
 
-        } else if (free_size >= JEKV_SLICE_SIZE) {
+        } else if (free_size >= jekv_item_get_blob_desc_span(ver, seg) * JEKV_SLICE_SIZE) {
             /*check write descriptor*/
             jekv_log_debug("blob w: desc");
 
             JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_WRITE_ALL_SEG);
 
-            return storage_write_blob_desc(sec, group_id, key, dataSize, seg_id - seg_start, (jekv_seg_start_t)seg_start);
+            return storage_write_blob_desc(storage, sec, group_id, key, all_size, seg, ver);
         }
 
         jekv_log_debug("blob write: request next sector, left=%d", left_size);
@@ -840,215 +1038,1721 @@ static int storage_write_blob(jekv_storage_t *storage, uint8_t group_id, const c
     return JEKV_ERR_NO_SPACE;
 }
 
-int jekv_storage_write_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key,
-                              const void *data, uint32_t size)
+#if CONFIG_JEKV_BLOB_DELTA_WRITE
+/*
+    find the unchanged segments of the old blob, they keep their versions in the new version bits.
+    the segments are compared by crc first, then by data.
+    return the unchanged segments count and the size to write.
+*/
+static int storage_blob_delta_plan(jekv_blob_map_t *map, const void *data, uint32_t size, uint8_t *ver,
+                                   uint32_t *write_size)
 {
-    int err;
-    jekv_sector_t *find_sector = NULL;
-    jekv_sector_t *cur_sector  = NULL;
-    int found_item_index         = 0;
-    int request_size;
-
-    jekv_item_t item;
-    jekv_seg_start_t seg_start = JEKV_SEG_START_VER_0;
+    uint8_t *pdata;
+    uint32_t offset = 0;
+    uint32_t kept   = 0;
+    uint32_t len;
+    int keep_cnt = 0;
+    int i;
 
-    err = jekv_sm_find_item(&storage->sm, group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, key, &found_item_index, &find_sector, &item,
-                              JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    jekv_blob_ver_next(map->ver, map->seg_count, ver);
 
-    if (!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)) {
-        return err;
+    pdata = JEKV_MALLOC(JEKV_SINGLE_ITEM_MAX_DATA_SIZE);
+    if (!pdata) {
+        return JEKV_ERR_NO_MEM;
     }
 
-    jekv_log_debug("find %s err=%d", key, err);
-
-    if (type == JEKV_TYPE_BLOB) {
-        /*compare old blob*/
-        if (find_sector && type == item.type) {
-            err = storage_cmp_blob(storage, &item, data, size);
-            if (err == JEKV_ERR_OK) {
-                jekv_log_debug("blob: found same, not write");
-                return err;
-            }
-
-            /*find old blob*/
-            if (item.seg_start == JEKV_SEG_START_VER_0) {
-                seg_start = JEKV_SEG_START_VER_1;
-            } else {
-                seg_start = JEKV_SEG_START_VER_0;
-            }
+    for (i = 0; i < map->seg_count && offset < size; i++) {
+        len = map->segs[i].length;
 
-            jekv_log_debug("blob write: cmp old,err=%d,old_start=%d,new_start=%d", err, item.seg_start, seg_start);
+        if (i >= JEKV_SEG_NUM_MAX && size - offset < JEKV_BLOB_PAGE_SEG_MIN_SIZE) {
+            /*the cut segment out of the first page is too small, rewrite all*/
+            keep_cnt = 0;
+            break;
         }
 
-        /*check free space is enough*/
-        err = jekv_sm_check_write_blob_size(&storage->sm, size);
-        if (err != JEKV_ERR_OK) {
-            jekv_log_error("blob write: fail,size=%u,err=%d", size, err);
-            return err;
+        if (len <= size - offset && jekv_port_crc32(UINT32_MAX, (const uint8_t *)data + offset, len) == map->segs[i].crc &&
+            jekv_blob_map_read(map, i, 0, pdata, len) == JEKV_ERR_OK &&
+            !memcmp(pdata, (const uint8_t *)data + offset, len)) {
+            /*unchanged*/
+            jekv_blob_ver_set(ver, i, JEKV_BLOB_SEG_VER(map->ver, i));
+            keep_cnt++;
+            kept += len;
         }
 
-        jekv_log_debug("%s","blob write: check space ok");
+        offset += len;
+    }
 
-        /* write blob*/
-        err = storage_write_blob(storage, group_id, key, data, size, seg_start);
-        if (err != JEKV_ERR_OK) {
-            jekv_log_debug("%s","write blob fail");
-            return err;
-        }
+    JEKV_FREE(pdata);
 
-        jekv_log_debug("%s","blob write: OK");
+    if (i >= JEKV_SEG_NUM_MAX && offset < size && size - offset < JEKV_BLOB_PAGE_SEG_MIN_SIZE) {
+        /*the appended segment out of the first page is too small, rewrite all*/
+        keep_cnt = 0;
+    }
 
-    } else {
-        /*same value data, not need write again*/
-        if (find_sector && type == item.type) {
-            err = storage_cmp_find_item(storage, find_sector, found_item_index, &item, data, size);
-            if (err == JEKV_ERR_OK) {
-                jekv_log_debug("%s","found same, do nothing");
-                return err;
-            }
-            jekv_log_debug("cmp %s err=%d", key, err);
-        }
+    *write_size = size - kept;
 
-        cur_sector = jekv_sm_get_current_sector(&storage->sm);
-        if (!cur_sector) {
-            jekv_log_error("%s","no valid sector");
-            return JEKV_ERR_OK;
+    jekv_log_debug("blob delta: keep=%d/%d,write=%u", keep_cnt, map->seg_count, *write_size);
+
+    return keep_cnt;
+}
+
+/*write a segment of the fixed size, request a sector if the current one is full*/
+static int storage_write_blob_seg(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data,
+                                  uint32_t size, const uint8_t *ver, int seg)
+{
+    int err;
+    jekv_sector_t *sec;
+
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s", "no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    err = jekv_sector_write_blob_seg(sec, group_id, key, data, size, ver, seg);
+    if (err != JEKV_ERR_SECTOR_FULL) {
+        return err;
+    }
+
+    err = jekv_sm_request_sector(&storage->sm, JEKV_SLICE_SIZE + size);
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("%s", "blob seg w: req fail");
+        return JEKV_ERR_NO_SPACE;
+    }
+
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s", "no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    return jekv_sector_write_blob_seg(sec, group_id, key, data, size, ver, seg);
+}
+
+/*
+    write the changed segments of the old blob range with their old sizes, then the data after the old blob
+    and the descriptor. The map is not rebuilt during the writes, the segment sizes in it are still valid.
+*/
+static int storage_write_blob_delta(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data,
+                                    uint32_t size, jekv_blob_map_t *map, const uint8_t *ver)
+{
+    int err;
+    uint32_t offset = 0;
+    uint32_t len;
+    int i;
+
+    for (i = 0; i < map->seg_count && offset < size; i++) {
+        len = map->segs[i].length;
+        if (len > size - offset) {
+            len = size - offset;
+        }
+
+        if (JEKV_BLOB_SEG_VER(ver, i) != JEKV_BLOB_SEG_VER(map->ver, i)) {
+            jekv_log_debug("blob delta w: %d,size=%u", i, len);
+
+            err = storage_write_blob_seg(storage, group_id, key, (const uint8_t *)data + offset, len, ver, i);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+
+            JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_WRITE_A_SEG);
+        }
+
+        offset += len;
+    }
+
+    return storage_write_blob(storage, group_id, key, (const uint8_t *)data + offset, size - offset, ver, i, size);
+}
+#endif
+
+/*find the delta seq of the record*/
+static int storage_find_delta(jekv_storage_t *storage, uint8_t group_id, const char *key, int seq,
+                              jekv_sector_t **sec, int *index, jekv_item_t *item)
+{
+    *index = 0;
+
+    return jekv_sm_find_item(&storage->sm, group_id, JEKV_TYPE_BINARY, key, index, sec, item, (uint8_t)seq,
+                             JEKV_SEG_START_ANY);
+}
+
+/*
+    apply the deltas of the record to its data from the folded sequence, data: NULL to check them only.
+    end: the sequence after the last delta, stale: the delta of end is stale.
+*/
+static int storage_apply_deltas(jekv_storage_t *storage, uint8_t group_id, const char *key, const jekv_item_t *rec,
+                                uint8_t *data, uint32_t size, int *end, bool *stale)
+{
+    int err = JEKV_ERR_OK;
+    jekv_sector_t *sec;
+    int index;
+    jekv_item_t item;
+    uint8_t *delta = NULL;
+    uint8_t gen    = JEKV_ITEM_REC_GEN(rec);
+    int seq;
+
+    *stale = false;
+
+    for (seq = JEKV_ITEM_REC_FOLDED(rec); gen && seq < JEKV_RECORD_SEQ_MAX; seq++) {
+        err = storage_find_delta(storage, group_id, key, seq, &sec, &index, &item);
+        if (err != JEKV_ERR_OK) {
+            break;
+        }
+
+        if (item.length > size + JEKV_RECORD_DELTA_HEAD_SIZE) {
+            *stale = true;
+            break;
+        }
+
+        if (!delta) {
+            delta = JEKV_MALLOC(size + JEKV_RECORD_DELTA_HEAD_SIZE);
+            if (!delta) {
+                return JEKV_ERR_NO_MEM;
+            }
+        }
+
+        err = jekv_sector_read_item_data(sec, index, &item, delta, item.length);
+        if (err != JEKV_ERR_OK) {
+            break;
+        }
+
+        if (jekv_record_apply_delta(data, size, gen, delta, item.length) != JEKV_ERR_OK) {
+            *stale = true;
+            break;
+        }
+    }
+
+    if (delta) {
+        JEKV_FREE(delta);
+    }
+
+    *end = seq;
+
+    jekv_log_debug("record %s: gen=%u,deltas %u~%d,stale=%d", key, gen, JEKV_ITEM_REC_FOLDED(rec), seq, *stale);
+
+    return err == JEKV_ERR_NOT_FOUND ? JEKV_ERR_OK : err;
+}
+
+/*erase the deltas of the record from seq, the last one first so the left ones are still a sequence*/
+static int storage_erase_deltas(jekv_storage_t *storage, uint8_t group_id, const char *key, int seq)
+{
+    int err;
+    jekv_sector_t *sec;
+    int index;
+    jekv_item_t item;
+    int end = seq;
+
+    while (end < JEKV_RECORD_SEQ_MAX &&
+           storage_find_delta(storage, group_id, key, end, &sec, &index, &item) == JEKV_ERR_OK) {
+        end++;
+    }
+
+    while (end-- > seq) {
+        err = storage_find_delta(storage, group_id, key, end, &sec, &index, &item);
+        if (err == JEKV_ERR_OK) {
+            err = jekv_sector_erase_item(sec, index, &item, true);
+        }
+
+        if (!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)) {
+            return err;
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
+/*
+    The old item is moved when its sector is collected by GC during the write,
+    look it up again. The moved copy is always in front of the new written item.
+*/
+static int storage_relocate_old_item(jekv_storage_t *storage, jekv_sector_t **find_sector, uint32_t find_sn,
+                                     int *found_item_index, jekv_item_t *item)
+{
+    int err;
+    jekv_sector_t *entry = NULL;
+    jekv_item_t old;
+    int index;
+
+    dl_list_for_each(entry, &storage->sm.active, jekv_sector_t, list)
+    {
+        if (entry == *find_sector && entry->serial_number == find_sn) {
+            /*not moved*/
+            return JEKV_ERR_OK;
+        }
+    }
+
+    jekv_log_debug("old item %.*s moved by GC", JEKV_MAX_KEY_LEN, item->name);
+
+    dl_list_for_each(entry, &storage->sm.active, jekv_sector_t, list)
+    {
+        index = 0;
+
+        while (1) {
+            err = jekv_sector_find_item(entry, item->group_id, (jekv_type_t)item->type, item->name, &index, &old,
+                                        JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+            if (err != JEKV_ERR_OK) {
+                break;
+            }
+
+            if (old.type != JEKV_TYPE_BLOB || old.seg_start == item->seg_start) {
+                *find_sector      = entry;
+                *found_item_index = index;
+                *item             = old;
+                return JEKV_ERR_OK;
+            }
+
+            index += jekv_item_get_span(&old);
+        }
+    }
+
+    return JEKV_ERR_NOT_FOUND;
+}
+
+/*erase the item superseded by the new written one, keep: version bits of the new blob*/
+static int storage_erase_old_item(jekv_storage_t *storage, jekv_sector_t *find_sector, uint32_t find_sn,
+                                  int found_item_index, jekv_item_t *item, const uint8_t *keep)
+{
+    int err;
+
+    err = storage_relocate_old_item(storage, &find_sector, find_sn, &found_item_index, item);
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("old item lost, err=%d", err);
+        return JEKV_ERR_OK;
+    }
+
+    if (item->type == JEKV_TYPE_BLOB) {
+        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_MODIFY_NEW);
+
+        /*erase old blob data*/
+        err = storage_erase_blob(storage, find_sector, found_item_index, item, keep);
+
+        jekv_log_debug("blob erase old: err=%d", err);
+
+    } else {
+        /*erase old value*/
+        JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_WRITE, JEKV_TRACE_BEFPRE_ERASE_OLD);
+
+        err = jekv_sector_supersede_item(find_sector, found_item_index, item);
+
+        jekv_log_debug("erase old type=%d: err=%d", item->type, err);
+
+        if (err == JEKV_ERR_OK && JEKV_ITEM_IS_RECORD(item)) {
+            /*the deltas of the old record*/
+            char key[JEKV_MAX_KEY_LEN + 1];
+
+            jekv_item_key_copy(key, item->name);
+            err = storage_erase_deltas(storage, item->group_id, key, JEKV_ITEM_REC_FOLDED(item));
+        }
+    }
+
+    return err;
+}
+
+/*write the non-blob item to the current sector, request a new sector if it is full*/
+static int storage_write_non_blob(jekv_storage_t *storage, jekv_sector_t *cur_sector, uint8_t group_id,
+                                  jekv_type_t type, const char *key, const void *data, uint32_t size,
+                                  uint32_t raw_length, bool rewrite)
+{
+    int err;
+    int request_size;
+
+    err = storage_write_value(cur_sector, group_id, type, key, data, size, raw_length, rewrite);
+    if (err == JEKV_ERR_SECTOR_FULL) {
+        /*full*/
+        jekv_log_debug("%s","write cur sec full");
+
+        request_size = storage_get_non_blob_write_req_size(type, size) + (rewrite ? JEKV_SLICE_SIZE : 0);
+
+        /*request a sector*/
+        err = jekv_sm_request_sector(&storage->sm, request_size);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        /*get current sector*/
+        cur_sector = jekv_sm_get_current_sector(&storage->sm);
+        if (!cur_sector) {
+            jekv_log_debug("%s","no valid sector");
+            return JEKV_ERR_FAIL;
+        }
+
+        /*write item*/
+        err = storage_write_value(cur_sector, group_id, type, key, data, size, raw_length, rewrite);
+        if (err != JEKV_ERR_OK) {
+            jekv_log_debug("write next sec, err=%d", err);
+        } else {
+            jekv_log_debug("%s","write next sec ok");
+        }
+
+    } else if (err != JEKV_ERR_OK) {
+        /*error*/
+        jekv_log_debug("write error, err=%d", err);
+    } else {
+        /*OK*/
+        jekv_log_debug("%s","write to cur sec ok");
+    }
+
+    return err;
+}
+
+/*
+    compress the string or binary value if the partition is configured and it saves a slice at least.
+    return the compressed value, NULL to write the raw value.
+*/
+static uint8_t *storage_compress_value(jekv_storage_t *storage, jekv_type_t type, const void *data, uint32_t size,
+                                       uint32_t *lz_size)
+{
+    uint8_t *lz;
+
+    if (storage->compress_size == 0 || size < storage->compress_size || size <= JEKV_SLICE_SIZE ||
+        (type != JEKV_TYPE_STRING && type != JEKV_TYPE_BINARY)) {
+        return NULL;
+    }
+
+    lz = JEKV_MALLOC(size);
+    if (!lz) {
+        return NULL;
+    }
+
+    /*the compressed value is in the data slices, no room for the raw length if it is in the item*/
+    *lz_size = jekv_lz_compress(data, size, lz, (size - 1) / JEKV_SLICE_SIZE * JEKV_SLICE_SIZE);
+    if (*lz_size <= 8) {
+        JEKV_FREE(lz);
+        return NULL;
+    }
+
+    jekv_log_debug("compress %u -> %u", size, *lz_size);
+
+    return lz;
+}
+
+int jekv_storage_write_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key,
+                              const void *data, uint32_t size)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    jekv_sector_t *cur_sector  = NULL;
+    int found_item_index         = 0;
+    uint32_t find_sn             = 0;
+
+    jekv_item_t item;
+#if CONFIG_JEKV_BLOB_DELTA_WRITE
+    jekv_blob_map_t *map = NULL;
+#endif
+    uint8_t old_ver[JEKV_BLOB_VER_MAP_SIZE];
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE];
+    uint32_t write_size;
+    int keep_cnt = 0;
+    bool rewrite = false;
+    uint8_t *lz  = NULL;
+    uint32_t lz_size;
+
+    if (storage->cache.enabled) {
+        if (jekv_cache_fit(type, size)) {
+            return jekv_cache_write(storage, group_id, type, key, data, size);
+        }
+
+        /*blob or an item too large for a batch is written to flash directly, remove the cached value*/
+        jekv_cache_remove(storage, group_id, key);
+    }
+
+    err = jekv_sm_find_item(&storage->sm, group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, key, &found_item_index, &find_sector, &item,
+                              JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+
+    if (!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)) {
+        return err;
+    }
+
+    jekv_log_debug("find %s err=%d", key, err);
+
+    if (find_sector) {
+        find_sn = find_sector->serial_number;
+    }
+
+    if (type == JEKV_TYPE_BLOB) {
+        if (size > JEKV_BLOB_SEG_NUM_MAX * JEKV_SINGLE_ITEM_MAX_DATA_SIZE) {
+            return JEKV_ERR_INVALID_LENGTH;
+        }
+
+        /*the new segments use the versions not used by the old blob*/
+        jekv_blob_ver_next(NULL, 0, ver);
+        write_size = size;
+
+        /*compare old blob*/
+        if (find_sector && type == item.type) {
+#if CONFIG_JEKV_BLOB_DELTA_WRITE
+            err = jekv_blob_map_get(storage, find_sector, found_item_index, &item, &map);
+            if (err == JEKV_ERR_OK) {
+                keep_cnt = storage_blob_delta_plan(map, data, size, ver, &write_size);
+                if (keep_cnt == map->seg_count && size == item.all_size) {
+                    jekv_log_debug("blob: found same, not write");
+                    return JEKV_ERR_OK;
+                }
+
+                if (keep_cnt <= 0) {
+                    /*no segment is kept, rewrite all*/
+                    keep_cnt   = 0;
+                    write_size = size;
+                }
+            }
+#else
+            err = storage_cmp_blob(storage, find_sector, found_item_index, &item, data, size);
+            if (err == JEKV_ERR_OK) {
+                jekv_log_debug("blob: found same, not write");
+                return err;
+            }
+#endif
+            if (keep_cnt == 0 && jekv_sector_read_blob_ver(find_sector, found_item_index, &item, old_ver) == JEKV_ERR_OK) {
+                jekv_blob_ver_next(old_ver, JEKV_ITEM_BLOB_SEG_COUNT(&item), ver);
+            }
+
+            jekv_log_debug("blob write: cmp old,err=%d,keep=%d", err, keep_cnt);
+        }
+
+        /*check free space is enough*/
+        err = jekv_sm_check_write_blob_size(&storage->sm, write_size);
+        if (err != JEKV_ERR_OK) {
+            jekv_log_error("blob write: fail,size=%u,err=%d", size, err);
+            return err;
+        }
+
+        jekv_log_debug("%s","blob write: check space ok");
+
+        /* write blob*/
+#if CONFIG_JEKV_BLOB_DELTA_WRITE
+        if (keep_cnt > 0) {
+            err = storage_write_blob_delta(storage, group_id, key, data, size, map, ver);
+        } else
+#endif
+        {
+            err = storage_write_blob(storage, group_id, key, data, size, ver, 0, size);
+        }
+        if (err != JEKV_ERR_OK) {
+            jekv_log_debug("%s","write blob fail");
+            return err;
+        }
+
+        jekv_log_debug("%s","blob write: OK");
+
+    } else {
+        /*same value data, not need write again. The record is rewritten without its deltas*/
+        if (find_sector && type == item.type && !JEKV_ITEM_IS_RECORD(&item)) {
+            err = storage_cmp_find_item(storage, find_sector, found_item_index, &item, data, size);
+            if (err == JEKV_ERR_OK) {
+                jekv_log_debug("%s","found same, do nothing");
+                return err;
+            }
+            jekv_log_debug("cmp %s err=%d", key, err);
+
+#if CONFIG_JEKV_ITEM_REWRITE
+            if (size == item.length && !JEKV_ITEM_IS_COUNTER(&item) && !JEKV_ITEM_IS_LZ(&item)) {
+                err = jekv_sector_rewrite_item(find_sector, found_item_index, &item, data, size);
+                if (err == JEKV_ERR_OK) {
+                    jekv_log_debug("%s","rewrite in place ok");
+                    return err;
+                }
+
+                /*only bits are cleared, the new item is rewritable*/
+                rewrite = err == JEKV_ERR_NO_SPACE;
+            }
+#endif
+        }
+
+        cur_sector = jekv_sm_get_current_sector(&storage->sm);
+        if (!cur_sector) {
+            jekv_log_error("%s","no valid sector");
+            return JEKV_ERR_OK;
+        }
+
+        lz = rewrite ? NULL : storage_compress_value(storage, type, data, size, &lz_size);
+        if (lz) {
+            err = storage_write_non_blob(storage, cur_sector, group_id, type, key, lz, lz_size, size, false);
+            JEKV_FREE(lz);
+        } else {
+            err = storage_write_non_blob(storage, cur_sector, group_id, type, key, data, size, 0, rewrite);
+        }
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    if (find_sector) {
+        err = storage_erase_old_item(storage, find_sector, find_sn, found_item_index, &item,
+                                     type == JEKV_TYPE_BLOB ? ver : NULL);
+    }
+
+    return err;
+}
+
+int jekv_storage_append_blob(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data,
+                             uint32_t size)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index       = 0;
+    uint32_t find_sn;
+    jekv_item_t item;
+    jekv_blob_map_t *map;
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE];
+    uint8_t *pdata = NULL;
+    uint32_t all_size;
+    int seg_first;
+    int i;
+
+    err = jekv_sm_find_item(&storage->sm, group_id, JEKV_TYPE_BLOB, key, &found_item_index, &find_sector, &item,
+                            JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (err == JEKV_ERR_NOT_FOUND) {
+        /*new blob*/
+        return jekv_storage_write_item(storage, group_id, JEKV_TYPE_BLOB, key, data, size);
+    } else if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (storage->cache.enabled) {
+        jekv_cache_remove(storage, group_id, key);
+    }
+
+    find_sn = find_sector->serial_number;
+
+    err = jekv_blob_map_get(storage, find_sector, found_item_index, &item, &map);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    all_size  = item.all_size + size;
+    seg_first = map->seg_count;
+
+    /*the old segments are kept, the new ones use the other versions*/
+    jekv_blob_ver_next(map->ver, map->seg_count, ver);
+    for (i = 0; i < map->seg_count; i++) {
+        jekv_blob_ver_set(ver, i, JEKV_BLOB_SEG_VER(map->ver, i));
+    }
+
+    if (seg_first > 0 && ((map->segs[seg_first - 1].length < JEKV_BLOB_MIN_SEG_SIZE &&
+                           size <= JEKV_SINGLE_ITEM_MAX_DATA_SIZE) ||
+                          (seg_first >= JEKV_SEG_NUM_MAX && size < JEKV_BLOB_PAGE_SEG_MIN_SIZE))) {
+        /*
+            merge the small last segment with the appended data, so the small appends don't use up the segments.
+            the data too small for a segment out of the first page is merged too.
+        */
+        seg_first--;
+
+        pdata = JEKV_MALLOC(map->segs[seg_first].length + size);
+        if (!pdata) {
+            return JEKV_ERR_NO_MEM;
+        }
+
+        err = jekv_blob_map_read(map, seg_first, 0, pdata, map->segs[seg_first].length);
+        if (err != JEKV_ERR_OK) {
+            JEKV_FREE(pdata);
+            return err;
+        }
+
+        memcpy(pdata + map->segs[seg_first].length, data, size);
+
+        data = pdata;
+        size += map->segs[seg_first].length;
+
+        jekv_blob_ver_set(ver, seg_first, !JEKV_BLOB_SEG_VER(map->ver, seg_first));
+    }
+
+    jekv_log_debug("blob append %s: seg_first=%d,size=%u,all_size=%u", key, seg_first, size, all_size);
+
+    err = jekv_sm_check_write_blob_size(&storage->sm, size);
+    if (err == JEKV_ERR_OK) {
+        err = storage_write_blob(storage, group_id, key, data, size, ver, seg_first, all_size);
+    }
+
+    if (pdata) {
+        JEKV_FREE(pdata);
+    }
+
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("blob append fail, err=%d", err);
+        return err;
+    }
+
+    return storage_erase_old_item(storage, find_sector, find_sn, found_item_index, &item, ver);
+}
+
+/*write a new counter of the base value, request a sector if the current one is full*/
+static int storage_write_counter(jekv_storage_t *storage, uint8_t group_id, const char *key, uint32_t base)
+{
+    int err;
+    jekv_sector_t *sec;
+
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s","no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    err = jekv_sector_write_counter(sec, group_id, key, base);
+    if (err != JEKV_ERR_SECTOR_FULL) {
+        return err;
+    }
+
+    err = jekv_sm_request_sector(&storage->sm, JEKV_SLICE_SIZE + JEKV_COUNTER_BITS_SIZE);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s","no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    return jekv_sector_write_counter(sec, group_id, key, base);
+}
+
+int jekv_storage_add_counter(jekv_storage_t *storage, uint8_t group_id, const char *key, uint32_t step,
+                             uint32_t *value)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index       = 0;
+    uint32_t find_sn;
+    jekv_item_t item;
+    uint32_t base = 0;
+
+    if (storage->cache.enabled && jekv_cache_find(storage, group_id, key)) {
+        /*the cached value is the latest, write it back first*/
+        err = jekv_cache_flush(storage);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    err = jekv_sm_find_item(&storage->sm, group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, key, &found_item_index,
+                            &find_sector, &item, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)) {
+        return err;
+    }
+
+    if (find_sector && item.type == JEKV_TYPE_UINT32) {
+        if (JEKV_ITEM_IS_COUNTER(&item)) {
+            /*clear bits in place*/
+            err = jekv_sector_add_counter(find_sector, found_item_index, &item, step, value);
+            if (err != JEKV_ERR_NO_SPACE) {
+                return err;
+            }
+
+            jekv_log_debug("counter %s: all bits cleared", key);
+        }
+
+        err = jekv_sector_read_item_data(find_sector, found_item_index, &item, &base, sizeof(base));
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    find_sn = find_sector ? find_sector->serial_number : 0;
+
+    /*the new counter starts from the current value*/
+    err = storage_write_counter(storage, group_id, key, base + step);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    *value = base + step;
+
+    if (find_sector) {
+        err = storage_erase_old_item(storage, find_sector, find_sn, found_item_index, &item, NULL);
+    }
+
+    return err;
+}
+
+/*write the record of the generation gen or its delta seq, request a sector if the current one is full*/
+static int storage_write_record_value(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data,
+                                      uint32_t size, uint8_t gen, uint8_t seq)
+{
+    int err;
+    jekv_sector_t *sec;
+
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s","no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    if (seq == JEKV_SEG_ID_ANY) {
+        err = jekv_sector_write_record(sec, group_id, key, data, size, gen);
+    } else {
+        err = jekv_sector_write_item(sec, group_id, JEKV_TYPE_BINARY, key, data, size, seq);
+    }
+    if (err != JEKV_ERR_SECTOR_FULL) {
+        return err;
+    }
+
+    err = jekv_sm_request_sector(&storage->sm, storage_get_non_blob_write_req_size(JEKV_TYPE_BINARY, size));
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s","no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    if (seq == JEKV_SEG_ID_ANY) {
+        return jekv_sector_write_record(sec, group_id, key, data, size, gen);
+    }
+
+    return jekv_sector_write_item(sec, group_id, JEKV_TYPE_BINARY, key, data, size, seq);
+}
+
+int jekv_storage_write_record(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data,
+                              uint32_t size)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index       = 0;
+    uint32_t find_sn           = 0;
+    jekv_item_t item;
+    uint8_t gen = jekv_record_next_gen(0);
+
+    if (storage->cache.enabled) {
+        /*the record is written to flash directly, remove the cached value*/
+        jekv_cache_remove(storage, group_id, key);
+    }
+
+    err = jekv_sm_find_item(&storage->sm, group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, key, &found_item_index,
+                            &find_sector, &item, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)) {
+        return err;
+    }
+
+    if (find_sector) {
+        find_sn = find_sector->serial_number;
+        gen     = jekv_record_next_gen(JEKV_ITEM_REC_GEN(&item));
+    }
+
+    /*the deltas of the old generation are stale once the new record is written*/
+    err = storage_write_record_value(storage, group_id, key, data, size, gen, JEKV_SEG_ID_ANY);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    jekv_log_debug("record %s: write gen=%u", key, gen);
+
+    if (find_sector) {
+        err = storage_erase_old_item(storage, find_sector, find_sn, found_item_index, &item, NULL);
+    }
+
+    return err;
+}
+
+int jekv_storage_update_record(jekv_storage_t *storage, uint8_t group_id, const char *key, uint32_t size,
+                               uint16_t offset, const void *data, uint32_t len)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index       = 0;
+    jekv_item_t item;
+    uint8_t *buf;
+    uint8_t gen;
+    int folded;
+    int end;
+    bool stale;
+
+    if (storage->cache.enabled && jekv_cache_find(storage, group_id, key)) {
+        /*the cached value is the latest, write it back first*/
+        err = jekv_cache_flush(storage);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    err = jekv_sm_find_item(&storage->sm, group_id, JEKV_TYPE_BINARY, key, &found_item_index, &find_sector, &item,
+                            JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (JEKV_ITEM_VALUE_SIZE(&item) != size) {
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    gen    = JEKV_ITEM_REC_GEN(&item);
+    folded = JEKV_ITEM_REC_FOLDED(&item);
+
+    err = storage_apply_deltas(storage, group_id, key, &item, NULL, size, &end, &stale);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (gen && end - folded < CONFIG_JEKV_RECORD_DELTA_MAX && end < JEKV_RECORD_SEQ_MAX) {
+        buf = JEKV_MALLOC(JEKV_RECORD_DELTA_HEAD_SIZE + len);
+        if (!buf) {
+            return JEKV_ERR_NO_MEM;
+        }
+
+        /*the stale deltas take the sequence of the new one*/
+        err = stale ? storage_erase_deltas(storage, group_id, key, end) : JEKV_ERR_OK;
+        if (err == JEKV_ERR_OK) {
+            err = storage_write_record_value(storage, group_id, key, buf,
+                                             jekv_record_make_delta(buf, gen, offset, data, len), gen, (uint8_t)end);
+        }
+
+        JEKV_FREE(buf);
+
+        jekv_log_debug("record %s: delta %d,offset=%u,len=%u,err=%d", key, end, offset, len, err);
+
+        return err;
+    }
+
+    /*the plain binary has no delta generation, or the deltas are full, write the whole record*/
+    buf = JEKV_MALLOC(size);
+    if (!buf) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    err = jekv_sector_read_item_data(find_sector, found_item_index, &item, buf, size);
+    if (err == JEKV_ERR_OK) {
+        err = storage_apply_deltas(storage, group_id, key, &item, buf, size, &end, &stale);
+    }
+
+    if (err == JEKV_ERR_OK) {
+        memcpy(buf + offset, data, len);
+        err = jekv_storage_write_record(storage, group_id, key, buf, size);
+    }
+
+    JEKV_FREE(buf);
+
+    jekv_log_debug("record %s: fold deltas %d~%d,err=%d", key, folded, end, err);
+
+    return err;
+}
+
+bool jekv_storage_is_read_shared(jekv_storage_t *storage, jekv_type_t type)
+{
+    /*the cache may be flushed by its timer, a bad blob is dropped and the blob maps are built by the read*/
+    return !storage->cache.enabled && type != JEKV_TYPE_BLOB;
+}
+
+int jekv_storage_read_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key, void *data,
+                             uint32_t *size)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index         = 0;
+    uint32_t data_size;
+    jekv_item_t item;
+    jekv_batch_op_t *cached;
+
+    if (storage->cache.enabled) {
+        jekv_cache_check_timer(storage);
+
+        cached = jekv_cache_find(storage, group_id, key);
+        if (cached) {
+            return jekv_cache_read(cached, type, data, size);
+        }
+    }
+
+    err = jekv_sm_find_item(&storage->sm, group_id, type, key, &found_item_index, &find_sector, &item, JEKV_SEG_ID_ANY,
+                              JEKV_SEG_START_ANY);
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("read %s not found", key);
+        return err;
+    }
+
+    /*get data size*/
+    data_size = (type == JEKV_TYPE_BLOB ? item.all_size : JEKV_ITEM_VALUE_SIZE(&item));
+
+    /*check read size*/
+    if (*size < data_size) {
+        *size = data_size;
+        return JEKV_ERR_VALUE_TOO_LONG;
+    }
+
+    *size = data_size;
+
+    if (type == JEKV_TYPE_BLOB) {
+        jekv_log_debug("%s","start read blob:");
+
+        /*read blob segments*/
+        err = storage_read_blob(storage, find_sector, found_item_index, &item, data, data_size);
+
+        if (err == JEKV_ERR_NOT_FOUND || err == JEKV_ERR_INVALID_LENGTH) {
+            /*read blob segments fail, delete item*/
+            jekv_sector_erase_item(find_sector, found_item_index, &item, true);
+        }
+    } else {
+        /*read non blob items*/
+        err = jekv_sector_read_item_data(find_sector, found_item_index, &item, data, data_size);
+
+        if (err == JEKV_ERR_OK && JEKV_ITEM_IS_RECORD(&item)) {
+            int end;
+            bool stale;
+
+            err = storage_apply_deltas(storage, group_id, key, &item, data, data_size, &end, &stale);
+        }
+    }
+
+    return err;
+}
+
+int jekv_storage_get_view(jekv_storage_t *storage, uint8_t group_id, const char *key, const void **data,
+                          uint32_t *size, jekv_sector_t **sector)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index         = 0;
+    jekv_item_t item;
+    jekv_blob_map_t *map;
+    uint32_t address;
+    uint32_t length;
+
+    if (storage->cache.enabled && jekv_cache_find(storage, group_id, key)) {
+        /*the value in flash is out of date, write back the cache first*/
+        err = jekv_cache_flush(storage);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+    }
+
+    err = jekv_sm_find_item(&storage->sm, group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, key, &found_item_index,
+                            &find_sector, &item, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("view %s not found", key);
+        return err;
+    }
+
+    if (item.type == JEKV_TYPE_BLOB) {
+        err = jekv_blob_map_get(storage, find_sector, found_item_index, &item, &map);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        if (map->seg_count != 1) {
+            /*the data of the segments is not continuous*/
+            return JEKV_ERR_INVALID_LENGTH;
+        }
+
+        find_sector      = map->segs[0].sec;
+        found_item_index = map->segs[0].index;
+        length           = map->segs[0].length;
+    } else if (JEKV_ITEM_IS_COUNTER(&item) || JEKV_ITEM_IS_LZ(&item) || JEKV_ITEM_IS_RECORD(&item)) {
+        /*the value is counted from the bits, decompressed or merged with the deltas*/
+        return JEKV_ERR_NOT_SUPPORT;
+    } else {
+        length = item.length;
+    }
+
+    if (JEKV_INDEX_IS_PACKED(found_item_index)) {
+        /*data is in the record of the packed item*/
+        address = jekv_pack_get_value_address(find_sector, found_item_index, &item);
+    } else if (length <= 8) {
+        /*data is in the item*/
+        address = find_sector->address + (found_item_index + 1) * JEKV_SLICE_SIZE + offsetof(jekv_item_t, data);
+    } else {
+        /*skip sector header and item itself*/
+        address = find_sector->address + (found_item_index + 2) * JEKV_SLICE_SIZE;
+    }
+
+    *data = jekv_pt_mmap(&storage->pt, address, length);
+    if (!*data) {
+        return JEKV_ERR_NOT_SUPPORT;
+    }
+
+    *size   = length;
+    *sector = find_sector;
+
+    return JEKV_ERR_OK;
+}
+
+typedef struct {
+    jekv_sector_t *sec; /**< found sector       */
+    int index;          /**< found slice index  */
+    uint32_t desc;      /**< descriptor index   */
+    jekv_item_t item;   /**< found item         */
+} jekv_read_slot_t;
+
+static int storage_cmp_read_slot(const void *a, const void *b)
+{
+    const jekv_read_slot_t *sa = a;
+    const jekv_read_slot_t *sb = b;
+
+    if (sa->sec->address != sb->sec->address) {
+        return sa->sec->address < sb->sec->address ? -1 : 1;
+    }
+
+    return sa->index - sb->index;
+}
+
+int jekv_storage_read_items(jekv_storage_t *storage, uint8_t group_id, const char *keys[], jekv_get_desc_t descs[],
+                            uint32_t count)
+{
+    uint32_t i;
+    uint32_t found = 0;
+    jekv_read_slot_t *slots;
+    jekv_read_slot_t *slot;
+    jekv_get_desc_t *desc;
+    jekv_batch_op_t *cached;
+
+    slots = JEKV_MALLOC(count * sizeof(*slots));
+    if (!slots) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    if (storage->cache.enabled) {
+        jekv_cache_check_timer(storage);
+    }
+
+    /*look up all the keys first*/
+    for (i = 0; i < count; i++) {
+        desc = &descs[i];
+
+        if (desc->type == JEKV_TYPE_BLOB) {
+            /*blob segments are spread, read it alone*/
+            desc->err = jekv_storage_read_item(storage, group_id, desc->type, keys[i], desc->data, &desc->length);
+            continue;
+        }
+
+        cached = storage->cache.enabled ? jekv_cache_find(storage, group_id, keys[i]) : NULL;
+        if (cached) {
+            desc->err = jekv_cache_read(cached, desc->type, desc->data, &desc->length);
+            continue;
+        }
+
+        slot        = &slots[found];
+        slot->index = 0;
+        slot->desc  = i;
+
+        desc->err = jekv_sm_find_item(&storage->sm, group_id, desc->type, keys[i], &slot->index, &slot->sec, &slot->item,
+                                      JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+        if (desc->err != JEKV_ERR_OK) {
+            continue;
+        }
+
+        if (desc->length < JEKV_ITEM_VALUE_SIZE(&slot->item)) {
+            desc->length = JEKV_ITEM_VALUE_SIZE(&slot->item);
+            desc->err    = JEKV_ERR_VALUE_TOO_LONG;
+            continue;
+        }
+
+        found++;
+    }
+
+    /*read the data in flash order*/
+    qsort(slots, found, sizeof(*slots), storage_cmp_read_slot);
+
+    for (i = 0; i < found; i++) {
+        slot = &slots[i];
+        desc = &descs[slot->desc];
+
+        desc->length = JEKV_ITEM_VALUE_SIZE(&slot->item);
+        desc->err    = jekv_sector_read_item_data(slot->sec, slot->index, &slot->item, desc->data, desc->length);
+
+        if (desc->err == JEKV_ERR_OK && JEKV_ITEM_IS_RECORD(&slot->item)) {
+            int end;
+            bool stale;
+
+            desc->err = storage_apply_deltas(storage, group_id, keys[slot->desc], &slot->item, desc->data,
+                                             desc->length, &end, &stale);
+        }
+    }
+
+    JEKV_FREE(slots);
+
+    jekv_log_debug("read items: count=%u,found=%u", count, found);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_storage_del_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index         = 0;
+
+    jekv_item_t item;
+    bool cached;
+
+    /*the dirty value may be not saved yet*/
+    cached = (jekv_cache_remove(storage, group_id, key) == JEKV_ERR_OK);
+
+    err = jekv_sm_find_item(&storage->sm, group_id, type, key, &found_item_index, &find_sector, &item, JEKV_SEG_ID_ANY,
+                              JEKV_SEG_START_ANY);
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("read %s not found", key);
+        return (cached && err == JEKV_ERR_NOT_FOUND) ? JEKV_ERR_OK : err;
+    }
+
+    /*the older values of the key are droped in flash before the last one*/
+    err = jekv_sm_flush_drops(&storage->sm);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (item.type == JEKV_TYPE_BLOB) {
+        /* erase blob */
+        err = storage_erase_blob(storage, find_sector, found_item_index, &item, NULL);
+    } else {
+        /* erase item */
+        err = jekv_sector_erase_item(find_sector, found_item_index, &item, true);
+        jekv_log_debug("del %s,err=%d", key, err);
+
+        if (err == JEKV_ERR_OK && JEKV_ITEM_IS_RECORD(&item)) {
+            err = storage_erase_deltas(storage, group_id, key, JEKV_ITEM_REC_FOLDED(&item));
+        }
+    }
+
+    return err;
+}
+
+int jekv_storage_read_blob_range(jekv_storage_t *storage, uint8_t group_id, const char *key, jekv_blob_cursor_t *cursor,
+                                 uint32_t offset, void *data, uint32_t *size)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index       = 0;
+    jekv_item_t item;
+    jekv_blob_map_t *map;
+    uint32_t seg_len;
+    uint32_t left;
+    uint32_t pos;
+    uint32_t len;
+
+    err = jekv_sm_find_item(&storage->sm, group_id, JEKV_TYPE_BLOB, key, &found_item_index, &find_sector, &item,
+                            JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    if (cursor->all_size == 0) {
+        err = jekv_blob_map_get(storage, find_sector, found_item_index, &item, &map);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        cursor->all_size   = item.all_size;
+        cursor->seg_count  = map->seg_count;
+        cursor->seg_index  = 0;
+        cursor->seg_offset = 0;
+        memcpy(cursor->ver, map->ver, sizeof(cursor->ver));
+    } else {
+        err = jekv_blob_map_get(storage, find_sector, found_item_index, &item, &map);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        if (cursor->all_size != item.all_size || cursor->seg_count != map->seg_count ||
+            memcmp(cursor->ver, map->ver, sizeof(cursor->ver))) {
+            /*the blob is rewritten*/
+            jekv_log_debug("blob %s changed", key);
+            return JEKV_ERR_NOT_FOUND;
+        }
+    }
+
+    if (offset > cursor->all_size) {
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    if (*size > cursor->all_size - offset) {
+        *size = cursor->all_size - offset;
+    }
+
+    if (offset < cursor->seg_offset) {
+        /*restart from the first segment*/
+        cursor->seg_index  = 0;
+        cursor->seg_offset = 0;
+    }
+
+    left = *size;
+    pos  = offset;
+
+    while (left > 0) {
+        if (cursor->seg_index >= cursor->seg_count) {
+            return JEKV_ERR_INVALID_LENGTH;
+        }
+
+        seg_len = map->segs[cursor->seg_index].length;
+
+        if (pos < cursor->seg_offset + seg_len) {
+            /*read the part in this segment*/
+            len = cursor->seg_offset + seg_len - pos;
+            if (len > left) {
+                len = left;
+            }
+
+            err = jekv_blob_map_read(map, cursor->seg_index, pos - cursor->seg_offset, data, len);
+            if (err != JEKV_ERR_OK) {
+                return err;
+            }
+
+            data = (uint8_t *)data + len;
+            pos += len;
+            left -= len;
+        }
+
+        if (pos >= cursor->seg_offset + seg_len) {
+            /*goto next segment*/
+            cursor->seg_offset += seg_len;
+            cursor->seg_index++;
+        }
+    }
+
+    jekv_log_debug("read blob %s, offset=%u,size=%u", key, offset, *size);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_storage_blob_stream_open(jekv_storage_t *storage, jekv_blob_stream_t *stream)
+{
+    int err;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index       = 0;
+    jekv_item_t item;
+    uint8_t old_ver[JEKV_BLOB_VER_MAP_SIZE];
+
+    jekv_blob_ver_next(NULL, 0, stream->ver);
+    stream->seg_count = 0;
+    stream->size      = 0;
+    stream->buf_len   = 0;
+
+    err = jekv_sm_find_item(&storage->sm, stream->group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, stream->key,
+                            &found_item_index, &find_sector, &item, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)) {
+        return err;
+    }
+
+    /*the new segments use the other versions, the old blob is kept until the new descriptor is written*/
+    if (err == JEKV_ERR_OK && item.type == JEKV_TYPE_BLOB &&
+        jekv_sector_read_blob_ver(find_sector, found_item_index, &item, old_ver) == JEKV_ERR_OK) {
+        jekv_blob_ver_next(old_ver, JEKV_ITEM_BLOB_SEG_COUNT(&item), stream->ver);
+    }
+
+    jekv_log_debug("stream open %s", stream->key);
+
+    return JEKV_ERR_OK;
+}
+
+/*
+    write the buffered data as one segment, a segment is not smaller than JEKV_BLOB_MIN_SEG_SIZE
+    unless it is the last one. The data not fit in the sector is kept in the buffer.
+    Before the last one, JEKV_BLOB_PAGE_SEG_MIN_SIZE bytes are kept at least for the segment out of the first page.
+*/
+static int storage_blob_stream_write_seg(jekv_storage_t *storage, jekv_blob_stream_t *stream, bool last)
+{
+    int err;
+    jekv_sector_t *sec;
+    int seg_size;
+    int left;
+
+    if (stream->seg_count >= JEKV_BLOB_SEG_NUM_MAX) {
+        jekv_log_debug("stream: too many segs");
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s", "no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    seg_size = jekv_sm_get_free_size(sec) - JEKV_SLICE_SIZE;
+
+    if (seg_size < (int)stream->buf_len && seg_size < JEKV_BLOB_MIN_SEG_SIZE) {
+        /*request a sector*/
+        err = jekv_sm_request_sector(&storage->sm, JEKV_SLICE_SIZE + JEKV_BLOB_MIN_SEG_SIZE);
+        if (err != JEKV_ERR_OK) {
+            jekv_log_debug("%s", "stream w: req fail");
+            return JEKV_ERR_NO_SPACE;
         }
 
-        err = jekv_sector_write_item(cur_sector, group_id, type, key, data, size, JEKV_SEG_ID_ANY);
-        if (err == JEKV_ERR_SECTOR_FULL) {
-            /*full*/
-            jekv_log_debug("%s","write cur sec full");
+        sec = jekv_sm_get_current_sector(&storage->sm);
+        if (!sec) {
+            jekv_log_error("%s", "no valid sector");
+            return JEKV_ERR_FAIL;
+        }
 
-            request_size = storage_get_non_blob_write_req_size(type, size);
+        seg_size = jekv_sm_get_free_size(sec) - JEKV_SLICE_SIZE;
 
-            /*request a sector*/
-            err = jekv_sm_request_sector(&storage->sm, request_size);
-            if (err != JEKV_ERR_OK) {
-                return err;
-            }
+        if (seg_size < (int)stream->buf_len && seg_size < JEKV_BLOB_MIN_SEG_SIZE) {
+            return JEKV_ERR_NO_SPACE;
+        }
+    }
 
-            /*get current sector*/
-            cur_sector = jekv_sm_get_current_sector(&storage->sm);
-            if (!cur_sector) {
-                jekv_log_debug("%s","no valid sector");
-                return JEKV_ERR_OK;
+    if (seg_size > (int)stream->buf_len) {
+        seg_size = stream->buf_len;
+    }
+
+    left = stream->buf_len - seg_size;
+    if (stream->seg_count + 1 >= JEKV_SEG_NUM_MAX && (!last || left > 0) && left < JEKV_BLOB_PAGE_SEG_MIN_SIZE) {
+        seg_size -= JEKV_BLOB_PAGE_SEG_MIN_SIZE - left;
+    }
+
+    jekv_log_debug("stream w: %d,size=%d", stream->seg_count, seg_size);
+
+    err = jekv_sector_write_blob_seg(sec, stream->group_id, stream->key, stream->buf, seg_size, stream->ver,
+                                     stream->seg_count);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    stream->seg_count++;
+    stream->buf_len -= seg_size;
+    memmove(stream->buf, stream->buf + seg_size, stream->buf_len);
+
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_WRITE_A_SEG);
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_storage_blob_stream_write(jekv_storage_t *storage, jekv_blob_stream_t *stream, const void *data, uint32_t size)
+{
+    int err;
+    jekv_sector_t *sec;
+    int seg_size;
+    uint32_t len;
+
+    while (size > 0) {
+        sec = jekv_sm_get_current_sector(&storage->sm);
+        if (!sec) {
+            jekv_log_error("%s", "no valid sector");
+            return JEKV_ERR_FAIL;
+        }
+
+        /*fill the left space of current sector, or a whole new sector*/
+        seg_size = jekv_sm_get_free_size(sec) - JEKV_SLICE_SIZE;
+        if (seg_size < JEKV_BLOB_MIN_SEG_SIZE) {
+            seg_size = JEKV_SINGLE_ITEM_MAX_DATA_SIZE;
+        }
+
+        if ((int)stream->buf_len < seg_size) {
+            len = seg_size - stream->buf_len;
+            if (len > size) {
+                len = size;
             }
 
-            /*write item*/
-            err = jekv_sector_write_item(cur_sector, group_id, type, key, data, size, JEKV_SEG_ID_ANY);
+            memcpy(stream->buf + stream->buf_len, data, len);
+
+            stream->buf_len += len;
+            stream->size += len;
+            data = (const uint8_t *)data + len;
+            size -= len;
+        }
+
+        if ((int)stream->buf_len >= seg_size) {
+            err = storage_blob_stream_write_seg(storage, stream, false);
             if (err != JEKV_ERR_OK) {
-                jekv_log_debug("write next sec, err=%d", err);
                 return err;
-            } else {
-                jekv_log_debug("%s","write next sec ok");
             }
+        }
+    }
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_storage_blob_stream_close(jekv_storage_t *storage, jekv_blob_stream_t *stream)
+{
+    int err;
+    jekv_sector_t *sec;
+    jekv_sector_t *find_sector = NULL;
+    int found_item_index       = 0;
+    uint32_t find_sn           = 0;
+    jekv_item_t item;
 
-        } else if (err != JEKV_ERR_OK) {
-            /*error*/
-            jekv_log_debug("write error, err=%d", err);
+    if (stream->size == 0) {
+        return JEKV_ERR_INVALID_LENGTH;
+    }
+
+    /*write the left data*/
+    while (stream->buf_len > 0) {
+        err = storage_blob_stream_write_seg(storage, stream, true);
+        if (err != JEKV_ERR_OK) {
             return err;
-        } else {
-            /*OK*/
-            jekv_log_debug("%s","write to cur sec ok");
         }
     }
 
+    /*the blob is newer than the cached value*/
+    jekv_cache_remove(storage, stream->group_id, stream->key);
+
+    err = jekv_sm_find_item(&storage->sm, stream->group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, stream->key,
+                            &found_item_index, &find_sector, &item, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+    if (!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)) {
+        return err;
+    }
+
     if (find_sector) {
-        if (item.type == JEKV_TYPE_BLOB) {
-            JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_MODIFY_NEW);
+        find_sn = find_sector->serial_number;
+    }
+
+    /*write descriptor*/
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec || jekv_sm_get_free_size(sec) < jekv_item_get_blob_desc_span(stream->ver, stream->seg_count) * JEKV_SLICE_SIZE) {
+        err = jekv_sm_request_sector(&storage->sm, JEKV_SLICE_SIZE);
+        if (err != JEKV_ERR_OK) {
+            return JEKV_ERR_NO_SPACE;
+        }
 
-            /*erase old blob data*/
-            err = storage_erase_blob(storage, find_sector, found_item_index, &item);
+        sec = jekv_sm_get_current_sector(&storage->sm);
+        if (!sec) {
+            jekv_log_error("%s", "no valid sector");
+            return JEKV_ERR_FAIL;
+        }
+    }
 
-            jekv_log_debug("blob erase old: err=%d", err);
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BLOB, JEKV_TRACE_AFTER_WRITE_ALL_SEG);
 
-        } else {
-            /*erase old value*/
-            JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_WRITE, JEKV_TRACE_BEFPRE_ERASE_OLD);
+    err = storage_write_blob_desc(storage, sec, stream->group_id, stream->key, stream->size, stream->seg_count,
+                                  stream->ver);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
 
-            err = jekv_sector_erase_item(find_sector, found_item_index, &item, true);
+    jekv_log_debug("stream close %s, size=%u,seg_count=%d", stream->key, stream->size, stream->seg_count);
 
-            jekv_log_debug("erase old type=%d: err=%d", item.type, err);
-        }
+    if (find_sector) {
+        err = storage_erase_old_item(storage, find_sector, find_sn, found_item_index, &item, stream->ver);
     }
 
     return err;
 }
 
-int jekv_storage_read_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key, void *data,
-                             uint32_t *size)
+int jekv_storage_blob_stream_abort(jekv_storage_t *storage, jekv_blob_stream_t *stream)
+{
+    /*the segments without descriptor are dropped*/
+    storage_erase_blob_segs(storage, stream->group_id, stream->key, stream->ver, stream->seg_count, NULL);
+
+    stream->seg_count = 0;
+    stream->size      = 0;
+    stream->buf_len   = 0;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_storage_get_batch_span(jekv_batch_op_t *op)
+{
+    if (op->type == JEKV_TYPE_ANY || op->size <= 8) {
+        return 1;
+    }
+
+    return 1 + (op->size + JEKV_SLICE_SIZE - 1) / JEKV_SLICE_SIZE;
+}
+
+static int storage_drop_batch_record(jekv_sector_t *sec, int index)
 {
     int err;
-    jekv_sector_t *find_sector = NULL;
-    int found_item_index         = 0;
-    uint32_t data_size;
     jekv_item_t item;
 
-    err = jekv_sm_find_item(&storage->sm, group_id, type, key, &found_item_index, &find_sector, &item, JEKV_SEG_ID_ANY,
-                              JEKV_SEG_START_ANY);
+    err = jekv_pt_read_item(sec->pt, sec->address + (index + 1) * JEKV_SLICE_SIZE, &item);
     if (err != JEKV_ERR_OK) {
-        jekv_log_debug("read %s not found", key);
         return err;
     }
 
-    /*get data size*/
-    data_size = (type == JEKV_TYPE_BLOB ? item.all_size : item.length);
-
-    /*check read size*/
-    if (*size < data_size) {
-        *size = data_size;
-        return JEKV_ERR_VALUE_TOO_LONG;
+    if (item.state != JEKV_ITEM_STATE_USING) {
+        return JEKV_ERR_OK;
     }
 
-    *size = data_size;
+    return jekv_sector_erase_item(sec, index, &item, true);
+}
 
-    if (type == JEKV_TYPE_BLOB) {
-        jekv_log_debug("%s","start read blob:");
+/*drop the written records of a not committed batch, the begin record is the last one*/
+static void storage_drop_batch(jekv_sector_t *sec, int begin_index)
+{
+    int index = begin_index + 1;
+    jekv_item_t item;
 
-        /*read blob segments*/
-        err = storage_read_blob(storage, &item, data, data_size);
+    while (index < sec->next_free_slice) {
+        if (jekv_pt_read_item(sec->pt, sec->address + (index + 1) * JEKV_SLICE_SIZE, &item) != JEKV_ERR_OK) {
+            break;
+        }
 
-        if (err == JEKV_ERR_NOT_FOUND || err == JEKV_ERR_INVALID_LENGTH) {
-            /*read blob segments fail, delete item*/
-            jekv_sector_erase_item(find_sector, found_item_index, &item, true);
+        if (item.state == JEKV_ITEM_STATE_USING) {
+            jekv_sector_erase_item(sec, index, &item, true);
         }
-    } else {
-        /*read non blob items*/
-        err = jekv_sector_read_item_data(find_sector, found_item_index, &item, data, data_size);
+
+        index += jekv_item_get_span(&item);
     }
 
-    return err;
+    storage_drop_batch_record(sec, begin_index);
 }
 
-int jekv_storage_del_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key)
+/*
+    batch layout in one sector:
+    | BEGIN(count, span) | op records ... | COMMIT |
+    The batch is committed when the COMMIT record is written, then the superseded items, the delete records,
+    the BEGIN and COMMIT records are droped. A BEGIN record still using at load is checked by sector manager.
+*/
+int jekv_storage_write_batch(jekv_storage_t *storage, struct dl_list *ops)
 {
     int err;
+    jekv_batch_op_t *op        = NULL;
+    jekv_sector_t *sec         = NULL;
     jekv_sector_t *find_sector = NULL;
-    int found_item_index         = 0;
 
-    jekv_item_t item;
+    int need_slice = 2;
+    int begin_index;
+    uint8_t group_id;
+    uint8_t count  = 0;
+    uint8_t span   = 0;
+    uint8_t rec[2];
+    uint8_t mark = 0;
 
-    err = jekv_sm_find_item(&storage->sm, group_id, type, key, &found_item_index, &find_sector, &item, JEKV_SEG_ID_ANY,
-                              JEKV_SEG_START_ANY);
+    dl_list_for_each(op, ops, jekv_batch_op_t, list)
+    {
+        need_slice += jekv_storage_get_batch_span(op);
+    }
+
+    if (need_slice > JEKV_ENTRY_COUNT) {
+        jekv_log_debug("batch too large, need=%d", need_slice);
+        return JEKV_ERR_NO_SPACE;
+    }
+
+    if (dl_list_empty(ops)) {
+        return JEKV_ERR_OK;
+    }
+
+    /*the begin and commit records are saved in the group of the first operation*/
+    group_id = dl_list_first(ops, jekv_batch_op_t, list)->group_id;
+
+    /*all the records of a batch are written to one sector*/
+    sec = jekv_sm_get_current_sector(&storage->sm);
+    if (!sec) {
+        jekv_log_error("%s","no valid sector");
+        return JEKV_ERR_FAIL;
+    }
+
+    if (sec->state == JEKV_SECTOR_STATE_FULL || sec->next_free_slice + need_slice > JEKV_ENTRY_COUNT) {
+        err = jekv_sm_request_sector(&storage->sm, need_slice * JEKV_SLICE_SIZE);
+        if (err != JEKV_ERR_OK) {
+            return err;
+        }
+
+        sec = jekv_sm_get_current_sector(&storage->sm);
+        if (!sec || sec->next_free_slice + need_slice > JEKV_ENTRY_COUNT) {
+            return JEKV_ERR_NO_SPACE;
+        }
+    }
+
+    /*look up the superseded items once, the sectors are not moved until the batch end*/
+    dl_list_for_each(op, ops, jekv_batch_op_t, list)
+    {
+        op->old_sec   = NULL;
+        op->old_index = 0;
+        op->new_index = -1;
+
+        err = jekv_sm_find_item(&storage->sm, op->group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, op->key, &op->old_index,
+                                &find_sector, &op->old, JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
+        if (err == JEKV_ERR_OK) {
+            op->old_sec = find_sector;
+        } else if (err != JEKV_ERR_NOT_FOUND) {
+            return err;
+        }
+
+        if (op->type == JEKV_TYPE_ANY) {
+            if (!op->old_sec) {
+                /*nothing to delete*/
+                continue;
+            }
+        } else if (op->old_sec && op->type == op->old.type &&
+                   storage_cmp_find_item(storage, op->old_sec, op->old_index, &op->old, op->data, op->size) == JEKV_ERR_OK) {
+            /*same value data, not need write again*/
+            op->old_sec = NULL;
+            continue;
+        }
+
+        op->new_index = 0;
+        count++;
+        span += jekv_storage_get_batch_span(op);
+    }
+
+    if (count == 0) {
+        jekv_log_debug("%s","batch: nothing changed");
+        return JEKV_ERR_OK;
+    }
+
+    begin_index = sec->next_free_slice;
+    rec[0]      = count;
+    rec[1]      = span;
+
+    err = jekv_sector_write_item(sec, group_id, (jekv_type_t)JEKV_TYPE_BATCH, JEKV_BATCH_REC_NAME, rec, sizeof(rec),
+                                 JEKV_BATCH_REC_BEGIN);
     if (err != JEKV_ERR_OK) {
-        jekv_log_debug("read %s not found", key);
         return err;
     }
 
-    if (item.type == JEKV_TYPE_BLOB) {
-        /* erase blob */
-        err = storage_erase_blob(storage, find_sector, found_item_index, &item);
-    } else {
-        /* erase item */
-        err = jekv_sector_erase_item(find_sector, found_item_index, &item, true);
-        jekv_log_debug("del %s,err=%d", key, err);
+    dl_list_for_each(op, ops, jekv_batch_op_t, list)
+    {
+        if (op->new_index < 0) {
+            continue;
+        }
+
+        op->new_index = sec->next_free_slice;
+
+        if (op->type == JEKV_TYPE_ANY) {
+            err = jekv_sector_write_item(sec, op->group_id, (jekv_type_t)JEKV_TYPE_BATCH, op->key, &mark, sizeof(mark),
+                                         JEKV_BATCH_REC_DEL);
+        } else {
+            err = jekv_sector_write_item(sec, op->group_id, op->type, op->key, op->data, op->size, JEKV_SEG_ID_ANY);
+        }
+
+        if (err != JEKV_ERR_OK) {
+            jekv_log_debug("batch write %s fail, err=%d", op->key, err);
+            storage_drop_batch(sec, begin_index);
+            return err;
+        }
+    }
+
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BATCH, JEKV_TRACE_BATCH_BEFORE_COMMIT);
+
+    /*commit point*/
+    err = jekv_sector_write_item(sec, group_id, (jekv_type_t)JEKV_TYPE_BATCH, JEKV_BATCH_REC_NAME, &mark, sizeof(mark),
+                                 JEKV_BATCH_REC_COMMIT);
+    if (err != JEKV_ERR_OK) {
+        storage_drop_batch(sec, begin_index);
+        return err;
+    }
+
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BATCH, JEKV_TRACE_BATCH_AFTER_COMMIT);
+
+    dl_list_for_each(op, ops, jekv_batch_op_t, list)
+    {
+        if (op->new_index >= 0 && op->type == JEKV_TYPE_ANY) {
+            /*the older values of the deleted keys are droped in flash before the last ones*/
+            jekv_sm_flush_drops(&storage->sm);
+            break;
+        }
+    }
+
+    /*drop the superseded items and the delete records*/
+    dl_list_for_each(op, ops, jekv_batch_op_t, list)
+    {
+        if (op->new_index < 0) {
+            continue;
+        }
+
+        if (op->old_sec) {
+            if (op->old.type == JEKV_TYPE_BLOB) {
+                storage_erase_blob(storage, op->old_sec, op->old_index, &op->old, NULL);
+            } else {
+                jekv_sector_erase_item(op->old_sec, op->old_index, &op->old, true);
+            }
+        }
+
+        if (op->type == JEKV_TYPE_ANY) {
+            storage_drop_batch_record(sec, op->new_index);
+        }
     }
 
+    JEKV_TRACE_POWER_OFF(JEKV_TRACE_TYPE_BATCH, JEKV_TRACE_BATCH_AFTER_DROP_OLD);
+
+    /*begin record first, a commit record without begin is droped at load*/
+    storage_drop_batch_record(sec, begin_index);
+
+    err = storage_drop_batch_record(sec, begin_index + 1 + span);
+
+    jekv_log_debug("batch: count=%d,span=%d,err=%d", count, span, err);
+
     return err;
 }
 
-int jekv_storage_del_group(jekv_storage_t *storage, uint8_t group_id)
+/*drop the items of the group one by one*/
+static int storage_purge_group(jekv_storage_t *storage, uint8_t group_id)
 {
     int err;
     jekv_sector_t *entry = NULL;
@@ -1057,6 +2761,11 @@ int jekv_storage_del_group(jekv_storage_t *storage, uint8_t group_id)
 
     int start_index = 0;
 
+    err = jekv_sm_flush_drops(&storage->sm);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
     /* Look up group list */
     dl_list_for_each_safe(entry, next, &storage->sm.active, jekv_sector_t, list)
     {
@@ -1076,7 +2785,7 @@ int jekv_storage_del_group(jekv_storage_t *storage, uint8_t group_id)
             /*del blob segment*/
             if (item.type == JEKV_TYPE_BLOB) {
                 jekv_log_error("%s","del blob item");
-                err = storage_erase_blob(storage, entry, start_index, &item);
+                err = storage_erase_blob(storage, entry, start_index, &item, NULL);
 
             } else {
                 /*del normal item itself*/
@@ -1090,11 +2799,65 @@ int jekv_storage_del_group(jekv_storage_t *storage, uint8_t group_id)
     return JEKV_ERR_OK;
 }
 
+int jekv_storage_del_group(jekv_storage_t *storage, uint8_t group_id, uint8_t *new_id)
+{
+    int err;
+    jekv_group_t *group = jekv_storage_find_group_by_id(storage, group_id);
+    uint8_t id;
+
+    *new_id = group_id;
+
+    jekv_cache_remove_group(storage, group_id);
+
+    /*the ring and queue sectors of the group are erased*/
+    err = jekv_ring_del_group(storage, group_id);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    err = jekv_queue_del_group(storage, group_id);
+    if (err != JEKV_ERR_OK) {
+        return err;
+    }
+
+    id = (group ? storage_get_free_id(storage, storage_get_id_map(storage)) : JEKV_GROUP_ID_ANY);
+    if (id == JEKV_GROUP_ID_ANY) {
+        /*no id to move to*/
+        return storage_purge_group(storage, group_id);
+    }
+
+    /*
+        the group item is the tombstone, the group is moved to a new id by one write, the items of the old id
+        are not found any more and dropped by GC
+    */
+    err = jekv_storage_write_item(storage, JEKV_GROUP_ITSELF_ID, JEKV_TYPE_UINT8, group->name, &id, sizeof(id));
+    if (err != JEKV_ERR_OK) {
+        jekv_log_debug("del group,write fail %s", group->name);
+        return err;
+    }
+
+    jekv_blob_map_remove_group(storage, group_id);
+
+    group->id = id;
+    storage->sm.retired_groups |= ((uint64_t)1) << group_id;
+    *new_id = id;
+
+    jekv_log_debug("del group %s, id %d -> %d", group->name, group_id, id);
+
+    return JEKV_ERR_OK;
+}
+
 int jekv_storage_find_key(jekv_storage_t *storage, uint8_t group_id, const char *key, jekv_item_t *item)
 {
     int err;
     jekv_sector_t *find_sector = NULL;
     int found_item_index         = 0;
+    jekv_batch_op_t *cached      = jekv_cache_find(storage, group_id, key);
+
+    if (cached) {
+        return jekv_item_init(item, JEKV_ITEM_STATE_USING, group_id, cached->type, key, NULL, cached->size,
+                              JEKV_SEG_ID_ANY);
+    }
 
     err = jekv_sm_find_item(&storage->sm, group_id, (jekv_type_t)JEKV_TYPE_ANY_WITHOUT_SEG, key, &found_item_index, &find_sector, item,
                               JEKV_SEG_ID_ANY, JEKV_SEG_START_ANY);
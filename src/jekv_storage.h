@@ -7,6 +7,7 @@
 #include "jekv_porting.h"
 #include "jekv_partition.h"
 #include "jekv_sector_manager.h"
+#include "jekv_epoch.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,6 +19,18 @@ typedef struct {
     uint8_t id;                        /**< group id         */
 } jekv_group_t;
 
+/**
+  * @brief  kv write back cache structure
+  */
+typedef struct {
+    struct dl_list entries;  /**< dirty items, jekv_batch_op_t */
+    uint32_t dirty_size;     /**< dirty data size              */
+    uint32_t threshold;      /**< flush when dirty size reach  */
+    uint32_t interval_ms;    /**< flush interval, 0: no timer  */
+    uint32_t last_flush;     /**< last flush time, in ms       */
+    bool enabled;            /**< write back enabled           */
+} jekv_cache_t;
+
 /**
   * @brief  kv storage structure
   */
@@ -26,20 +39,105 @@ typedef struct {
     jekv_partition_t pt;        /**< kv partition information   */
     jekv_sector_manager_t sm;   /**< sector manager information */
     struct dl_list group_list;  /**< group list                 */
+    jekv_cache_t cache;         /**< write back cache           */
+    struct dl_list blob_maps;   /**< blob segment maps          */
+    struct dl_list rings;       /**< ring logs                  */
+    struct dl_list queues;      /**< queues                     */
+    uint32_t compress_size;     /**< compress the string and binary values from this size, 0: off */
+    jekv_port_rwlock_t lock;    /**< storage lock, shared by the reads of the values */
+    uint32_t users;             /**< operations entered the storage, counted under the global lock */
+#if CONFIG_JEKV_EPOCH_READ
+    uint32_t written;           /**< epoch mark, set while the storage is held exclusively */
+#endif
 } jekv_storage_t;
 
+/**
+  * @brief  batch operation
+  */
+typedef struct {
+    struct dl_list list;             /**< batch operation link node         */
+    char key[JEKV_MAX_KEY_LEN + 1];  /**< item key                          */
+    uint8_t group_id;                /**< group id                          */
+    jekv_type_t type;                /**< item type, JEKV_TYPE_ANY: delete   */
+    uint32_t size;                   /**< data size                         */
+    uint8_t *data;                   /**< data                              */
+
+    jekv_sector_t *old_sec;          /**< sector of the superseded item     */
+    int old_index;                   /**< slice index of superseded item    */
+    jekv_item_t old;                 /**< superseded item                   */
+    int new_index;                   /**< slice index of the written record */
+} jekv_batch_op_t;
+
+/**
+  * @brief  blob stream writing state
+  */
+typedef struct {
+    char key[JEKV_MAX_KEY_LEN + 1];  /**< blob key                      */
+    uint8_t group_id;                /**< group id                      */
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE]; /**< segment versions of the new blob */
+    uint16_t seg_count;              /**< written segment count         */
+    uint32_t size;                   /**< received data size            */
+    uint32_t buf_len;                /**< buffered data size            */
+    uint8_t *buf;                    /**< buffer of one segment         */
+} jekv_blob_stream_t;
+
+/**
+  * @brief  blob reading position, the segment containing the position is kept
+  *         so the next read starts from it.
+  */
+typedef struct {
+    uint32_t all_size;   /**< blob data size, 0: not opened       */
+    uint8_t ver[JEKV_BLOB_VER_MAP_SIZE]; /**< segment versions of the blob */
+    uint16_t seg_count;  /**< segment count of the blob           */
+    uint16_t seg_index;  /**< segment containing the position     */
+    uint32_t seg_offset; /**< blob offset of the segment          */
+} jekv_blob_cursor_t;
+
 int jekv_storage_init(jekv_partition_t *pt, jekv_storage_t **storage);
 int jekv_storage_deinit(jekv_storage_t *storage);
 
 int jekv_storage_open_group(jekv_storage_t *storage, const char *group, bool create_new, uint8_t *group_id);
-int jekv_storage_del_group(jekv_storage_t *storage, uint8_t group_id);
+/*drop all the items of the group, the group is moved to new_id*/
+int jekv_storage_del_group(jekv_storage_t *storage, uint8_t group_id, uint8_t *new_id);
 
 int jekv_storage_write_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key,
                               const void *data, uint32_t size);
+int jekv_storage_append_blob(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data,
+                             uint32_t size);
+int jekv_storage_add_counter(jekv_storage_t *storage, uint8_t group_id, const char *key, uint32_t step,
+                             uint32_t *value);
+/*write the whole record of a new delta generation*/
+int jekv_storage_write_record(jekv_storage_t *storage, uint8_t group_id, const char *key, const void *data,
+                              uint32_t size);
+
+/*write the field of the record as a delta, the whole record is written when the deltas are full*/
+int jekv_storage_update_record(jekv_storage_t *storage, uint8_t group_id, const char *key, uint32_t size,
+                               uint16_t offset, const void *data, uint32_t len);
+
+/*the read of the type changes nothing, it can be done under the shared storage lock*/
+bool jekv_storage_is_read_shared(jekv_storage_t *storage, jekv_type_t type);
+
 int jekv_storage_read_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key, void *data,
                              uint32_t *size);
+int jekv_storage_read_items(jekv_storage_t *storage, uint8_t group_id, const char *keys[], jekv_get_desc_t descs[],
+                            uint32_t count);
 int jekv_storage_del_item(jekv_storage_t *storage, uint8_t group_id, jekv_type_t type, const char *key);
 
+/*get the mapped flash address of the value, the value is read in place until its sector is erased*/
+int jekv_storage_get_view(jekv_storage_t *storage, uint8_t group_id, const char *key, const void **data,
+                          uint32_t *size, jekv_sector_t **sector);
+
+int jekv_storage_read_blob_range(jekv_storage_t *storage, uint8_t group_id, const char *key, jekv_blob_cursor_t *cursor,
+                                 uint32_t offset, void *data, uint32_t *size);
+
+int jekv_storage_blob_stream_open(jekv_storage_t *storage, jekv_blob_stream_t *stream);
+int jekv_storage_blob_stream_write(jekv_storage_t *storage, jekv_blob_stream_t *stream, const void *data, uint32_t size);
+int jekv_storage_blob_stream_close(jekv_storage_t *storage, jekv_blob_stream_t *stream);
+int jekv_storage_blob_stream_abort(jekv_storage_t *storage, jekv_blob_stream_t *stream);
+
+int jekv_storage_get_batch_span(jekv_batch_op_t *op);
+int jekv_storage_write_batch(jekv_storage_t *storage, struct dl_list *ops);
+
 int jekv_storage_find_key(jekv_storage_t *storage, uint8_t group_id, const char *key, jekv_item_t *item);
 
 jekv_group_t *jekv_storage_find_group_by_name(jekv_storage_t *storage, const char *group_name);
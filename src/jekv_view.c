@@ -0,0 +1,59 @@
+#include <string.h>
+#include <stdlib.h>
+
+#define LOG_TAG "jekv_view"
+#include "jekv_porting.h"
+#include "jekv_base.h"
+#include "jekv_view.h"
+#include "jekv_log.h"
+
+int jekv_view_pin_info_create(jekv_handle_info_t *handle, const char *key, const void **data, uint32_t *size,
+                              jekv_view_pin_t *pin)
+{
+    int err;
+    jekv_view_pin_info_t *p;
+    jekv_sector_t *sec = NULL;
+
+    p = JEKV_CALLOC(1, sizeof(*p));
+    if (!p) {
+        return JEKV_ERR_NO_MEM;
+    }
+
+    err = jekv_storage_get_view(handle->storage, handle->group_id, key, data, size, &sec);
+    if (err != JEKV_ERR_OK) {
+        JEKV_FREE(p);
+        return err;
+    }
+
+    /*GC skips the pinned sector, the value stays in place*/
+    sec->pin_count++;
+
+    memcpy(p->partition, handle->storage->pt.name, sizeof(p->partition));
+    p->address    = sec->address;
+    p->generation = sec->generation;
+
+    jekv_log_debug("pin sec=0x%x,count=%d", sec->address, sec->pin_count);
+
+    *pin = (jekv_view_pin_t)p;
+
+    return JEKV_ERR_OK;
+}
+
+int jekv_view_pin_info_release(jekv_storage_t *storage, jekv_view_pin_info_t *pin)
+{
+    jekv_sector_t *sec;
+
+    if (storage && pin->address / storage->pt.sec_size < storage->pt.sec_num) {
+        sec = &storage->sm.sec_arr[pin->address / storage->pt.sec_size];
+
+        /*the sector is reloaded if the partition is deinitialized, the pin is gone then*/
+        if (sec->generation == pin->generation && sec->pin_count > 0) {
+            sec->pin_count--;
+            jekv_log_debug("unpin sec=0x%x,count=%d", sec->address, sec->pin_count);
+        }
+    }
+
+    JEKV_FREE(pin);
+
+    return JEKV_ERR_OK;
+}
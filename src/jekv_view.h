@@ -0,0 +1,35 @@
+#ifndef __JEKV_VIEW_H__
+#define __JEKV_VIEW_H__
+
+#include <stdint.h>
+
+#include "jekv_base.h"
+#include "jekv_porting.h"
+#include "jekv_storage.h"
+#include "jekv_handler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief  kv view pin information structure, the sector is found by the partition name and address
+  *         so the pin is released safely after the partition is deinitialized.
+  */
+typedef struct jekv_view_pin_info_t {
+    char partition[JEKV_PARTITION_NAME_SIZE]; /**< partition of the value       */
+    uint32_t address;                         /**< sector address of the value  */
+    uint32_t generation;                      /**< erase count of the sector    */
+} jekv_view_pin_info_t;
+
+int jekv_view_pin_info_create(jekv_handle_info_t *handle, const char *key, const void **data, uint32_t *size,
+                              jekv_view_pin_t *pin);
+
+/*storage: the partition of the pin, NULL if it is deinitialized*/
+int jekv_view_pin_info_release(jekv_storage_t *storage, jekv_view_pin_info_t *pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "jekv_base.h"
+#include "jekv_easy.h"
+
+/*
+    the compaction merges the sectors the churn left almost empty, they are idle after it
+*/
+
+#define KEY_NUM    10
+#define VALUE_SIZE 100
+#define ROUND_NUM  300
+
+static int check_values(jekv_handle_t handle, int round)
+{
+    uint8_t value[VALUE_SIZE];
+    uint8_t expect[VALUE_SIZE];
+    uint32_t size;
+    char key[16];
+    int err;
+    int i;
+
+    for(i = 0; i < KEY_NUM; i++){
+        snprintf(key, sizeof(key), "k%d", i);
+        memset(expect, round + i, sizeof(expect));
+
+        size = sizeof(value);
+        err = jekv_get_binary(handle, key, value, &size);
+        if(err || size != VALUE_SIZE || memcmp(value, expect, VALUE_SIZE)){
+            printf("get %s err=%d size=%u\n", key, err, size);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    jekv_handle_t handle;
+    jekv_compact_stat_t stat;
+    jekv_status_t status;
+    uint8_t value[VALUE_SIZE];
+    char key[16];
+    int round;
+    int err;
+    int bad = 0;
+    int i;
+
+    remove("./jekv.db");
+
+    err = jekv_init(JEKV_DEF_PARTITION);
+    err |= jekv_open(JEKV_DEF_PARTITION, "compact", JEKV_OP_READ_WRITE, &handle);
+    if(err){
+        printf("init err=%d\n", err);
+        return 1;
+    }
+
+    /*cycle the store through all its sectors*/
+    for(round = 0; round < ROUND_NUM; round++){
+        for(i = 0; i < KEY_NUM; i++){
+            snprintf(key, sizeof(key), "k%d", i);
+            memset(value, round + i, sizeof(value));
+
+            err = jekv_set_binary(handle, key, value, sizeof(value));
+            if(err){
+                printf("set %s err=%d\n", key, err);
+                return 1;
+            }
+        }
+    }
+
+    round--;
+
+    jekv_get_status(JEKV_DEF_PARTITION, &status);
+    printf("before: using=%u droped=%u\n", status.using_size, status.droped_size);
+
+    err = jekv_compact(JEKV_DEF_PARTITION, &stat);
+    printf("compact err=%d reclaimed=%u written=%u erased=%u idle=%u\n", err, stat.reclaimed_slices,
+           stat.written_bytes, stat.erased_sectors, stat.idle_sectors);
+
+    /*the live values fit in one sector, all the others but the GC sector are idle*/
+    if(err || stat.idle_sectors < JKEV_PARTITION_SIZE / JEKV_SECTOR_SIZE - 2){
+        bad++;
+    }
+
+    jekv_get_status(JEKV_DEF_PARTITION, &status);
+    printf("after: using=%u droped=%u\n", status.using_size, status.droped_size);
+
+    if(status.droped_size != 0){
+        bad++;
+    }
+
+    bad += check_values(handle, round);
+
+    /*the merged sectors are loaded again*/
+    jekv_close(handle);
+    jekv_deinit(JEKV_DEF_PARTITION);
+
+    err = jekv_init(JEKV_DEF_PARTITION);
+    err |= jekv_open(JEKV_DEF_PARTITION, "compact", JEKV_OP_READ_WRITE, &handle);
+    if(err){
+        printf("reload err=%d\n", err);
+        return 1;
+    }
+
+    bad += check_values(handle, round);
+
+    jekv_close(handle);
+    jekv_deinit(JEKV_DEF_PARTITION);
+
+    printf("bad=%d\n", bad);
+
+    return bad ? 1 : 0;
+}
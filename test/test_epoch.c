@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "jekv_porting.h"
+#include "jekv_epoch.h"
+
+/*
+    the writer waits for the readers entered before it, the readers entering all the time don't hold it
+*/
+
+#define READER_NUM 4
+#define SYNC_NUM   100
+#define TIMEOUT_MS 20000
+
+static volatile int g_stop;
+static volatile int g_synced;
+
+static void* reader_task(void* arg)
+{
+    volatile int i;
+    uint32_t slot;
+
+    while(!g_stop){
+        slot = jekv_epoch_enter();
+        for(i = 0; i < 50; i++){
+        }
+        jekv_epoch_leave(slot);
+    }
+
+    return NULL;
+}
+
+static void* sync_task(void* arg)
+{
+    jekv_epoch_synchronize();
+    g_synced = 1;
+
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t readers[READER_NUM];
+    pthread_t writer;
+    uint32_t start;
+    uint32_t slot;
+    int bad = 0;
+    int n;
+    int i;
+
+    /*the reader in the epoch is waited for*/
+    slot = jekv_epoch_enter();
+    pthread_create(&writer, NULL, sync_task, NULL);
+
+    usleep(100 * 1000);
+    if(g_synced){
+        printf("synchronized before the reader left\n");
+        bad++;
+    }
+
+    jekv_epoch_leave(slot);
+    pthread_join(writer, NULL);
+
+    /*the readers entering after the writer are not waited for*/
+    for(i = 0; i < READER_NUM; i++){
+        pthread_create(&readers[i], NULL, reader_task, NULL);
+    }
+
+    start = jekv_port_get_time_ms();
+
+    for(n = 0; n < SYNC_NUM && jekv_port_get_time_ms() - start < TIMEOUT_MS; n++){
+        usleep(200);
+        jekv_epoch_synchronize();
+    }
+
+    g_stop = 1;
+    for(i = 0; i < READER_NUM; i++){
+        pthread_join(readers[i], NULL);
+    }
+
+    printf("syncs=%d used=%ums bad=%d\n", n, jekv_port_get_time_ms() - start, bad);
+
+    return (n == SYNC_NUM && bad == 0) ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "jekv_base.h"
+#include "jekv_easy.h"
+
+/*
+    a queue created after the KV churn takes the sectors freed by merging the KV sectors
+*/
+
+#define KEY_NUM      10
+#define VALUE_SIZE   100
+#define ROUND_NUM    300
+#define MESSAGE_SIZE 1000
+#define MESSAGE_NUM  12
+
+static int check_values(jekv_handle_t handle)
+{
+    uint8_t value[VALUE_SIZE];
+    uint8_t expect[VALUE_SIZE];
+    uint32_t size;
+    char key[16];
+    int err;
+    int i;
+
+    for(i = 0; i < KEY_NUM; i++){
+        snprintf(key, sizeof(key), "k%d", i);
+        memset(expect, ROUND_NUM - 1 + i, sizeof(expect));
+
+        size = sizeof(value);
+        err = jekv_get_binary(handle, key, value, &size);
+        if(err || size != VALUE_SIZE || memcmp(value, expect, VALUE_SIZE)){
+            printf("get %s err=%d size=%u\n", key, err, size);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int reload(jekv_handle_t *handle)
+{
+    int err;
+
+    jekv_close(*handle);
+    jekv_deinit(JEKV_DEF_PARTITION);
+
+    err = jekv_init(JEKV_DEF_PARTITION);
+    err |= jekv_open(JEKV_DEF_PARTITION, "queue", JEKV_OP_READ_WRITE, handle);
+    if(err){
+        printf("reload err=%d\n", err);
+    }
+
+    return err;
+}
+
+int main(void)
+{
+    jekv_handle_t handle;
+    jekv_queue_t queue;
+    uint8_t value[VALUE_SIZE];
+    uint8_t message[MESSAGE_SIZE];
+    uint8_t expect[MESSAGE_SIZE];
+    uint32_t size;
+    uint32_t count;
+    char key[16];
+    int round;
+    int err;
+    int bad = 0;
+    int i;
+
+    remove("./jekv.db");
+
+    err = jekv_init(JEKV_DEF_PARTITION);
+    err |= jekv_open(JEKV_DEF_PARTITION, "queue", JEKV_OP_READ_WRITE, &handle);
+    if(err){
+        printf("init err=%d\n", err);
+        return 1;
+    }
+
+    /*the KV GC leaves one idle sector*/
+    for(round = 0; round < ROUND_NUM; round++){
+        for(i = 0; i < KEY_NUM; i++){
+            snprintf(key, sizeof(key), "k%d", i);
+            memset(value, round + i, sizeof(value));
+
+            err = jekv_set_binary(handle, key, value, sizeof(value));
+            if(err){
+                printf("set %s err=%d\n", key, err);
+                return 1;
+            }
+        }
+    }
+
+    /*the messages fill 3 sectors*/
+    err = jekv_queue_open(handle, "msg", &queue);
+    if(err){
+        printf("queue open err=%d\n", err);
+        return 1;
+    }
+
+    for(i = 0; i < MESSAGE_NUM; i++){
+        memset(message, i, sizeof(message));
+
+        err = jekv_queue_push(queue, message, sizeof(message));
+        if(err){
+            printf("push %d err=%d\n", i, err);
+            bad++;
+            break;
+        }
+    }
+
+    jekv_queue_close(queue);
+
+    bad += check_values(handle);
+
+    /*the merged sectors and the queue are loaded again*/
+    if(reload(&handle)){
+        return 1;
+    }
+
+    bad += check_values(handle);
+
+    err = jekv_queue_open(handle, "msg", &queue);
+    if(err){
+        printf("queue open err=%d\n", err);
+        return 1;
+    }
+
+    for(i = 0; i < MESSAGE_NUM; i++){
+        memset(expect, i, sizeof(expect));
+
+        size = sizeof(message);
+        err = jekv_queue_pop(queue, message, &size);
+        if(err || size != MESSAGE_SIZE || memcmp(message, expect, MESSAGE_SIZE)){
+            printf("pop %d err=%d size=%u\n", i, err, size);
+            bad++;
+            break;
+        }
+    }
+
+    err = jekv_queue_ack(queue);
+    err |= jekv_queue_count(queue, &count);
+    if(err || count != 0){
+        printf("ack err=%d count=%u\n", err, count);
+        bad++;
+    }
+
+    jekv_queue_close(queue);
+    jekv_close(handle);
+    jekv_deinit(JEKV_DEF_PARTITION);
+
+    printf("bad=%d\n", bad);
+
+    return bad ? 1 : 0;
+}
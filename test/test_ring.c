@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "jekv_base.h"
+#include "jekv_easy.h"
+
+/*
+    a ring created after the KV churn takes the sectors freed by merging the KV sectors
+*/
+
+#define KEY_NUM     10
+#define VALUE_SIZE  100
+#define ROUND_NUM   300
+#define RECORD_SIZE 1000
+#define RECORD_NUM  12
+
+static int check_values(jekv_handle_t handle)
+{
+    uint8_t value[VALUE_SIZE];
+    uint8_t expect[VALUE_SIZE];
+    uint32_t size;
+    char key[16];
+    int err;
+    int i;
+
+    for(i = 0; i < KEY_NUM; i++){
+        snprintf(key, sizeof(key), "k%d", i);
+        memset(expect, ROUND_NUM - 1 + i, sizeof(expect));
+
+        size = sizeof(value);
+        err = jekv_get_binary(handle, key, value, &size);
+        if(err || size != VALUE_SIZE || memcmp(value, expect, VALUE_SIZE)){
+            printf("get %s err=%d size=%u\n", key, err, size);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int check_records(jekv_handle_t handle)
+{
+    jekv_ring_t ring;
+    jekv_ring_cursor_t cursor;
+    uint8_t record[RECORD_SIZE];
+    uint8_t expect[RECORD_SIZE];
+    uint32_t size;
+    uint32_t seq;
+    int err;
+    int bad = 0;
+    int i;
+
+    err = jekv_ring_open(handle, "log", 4, &ring);
+    err |= jekv_ring_cursor_open(ring, JEKV_RING_OLDEST, &cursor);
+    if(err){
+        printf("cursor err=%d\n", err);
+        return 1;
+    }
+
+    for(i = 0; i < RECORD_NUM; i++){
+        memset(expect, i, sizeof(expect));
+
+        size = sizeof(record);
+        err = jekv_ring_cursor_read(cursor, record, &size, &seq);
+        if(err || size != RECORD_SIZE || memcmp(record, expect, RECORD_SIZE)){
+            printf("read %d err=%d size=%u seq=%u\n", i, err, size, seq);
+            bad++;
+            break;
+        }
+
+        if(i < RECORD_NUM - 1 && jekv_ring_cursor_next(cursor)){
+            bad++;
+            break;
+        }
+    }
+
+    jekv_ring_cursor_close(cursor);
+    jekv_ring_close(ring);
+
+    return bad;
+}
+
+int main(void)
+{
+    jekv_handle_t handle;
+    jekv_ring_t ring;
+    uint8_t value[VALUE_SIZE];
+    uint8_t record[RECORD_SIZE];
+    char key[16];
+    int round;
+    int err;
+    int bad = 0;
+    int i;
+
+    remove("./jekv.db");
+
+    err = jekv_init(JEKV_DEF_PARTITION);
+    err |= jekv_open(JEKV_DEF_PARTITION, "ring", JEKV_OP_READ_WRITE, &handle);
+    if(err){
+        printf("init err=%d\n", err);
+        return 1;
+    }
+
+    /*the KV GC leaves one idle sector*/
+    for(round = 0; round < ROUND_NUM; round++){
+        for(i = 0; i < KEY_NUM; i++){
+            snprintf(key, sizeof(key), "k%d", i);
+            memset(value, round + i, sizeof(value));
+
+            err = jekv_set_binary(handle, key, value, sizeof(value));
+            if(err){
+                printf("set %s err=%d\n", key, err);
+                return 1;
+            }
+        }
+    }
+
+    /*the records fill 3 sectors*/
+    err = jekv_ring_open(handle, "log", 4, &ring);
+    if(err){
+        printf("ring open err=%d\n", err);
+        return 1;
+    }
+
+    for(i = 0; i < RECORD_NUM; i++){
+        memset(record, i, sizeof(record));
+
+        err = jekv_ring_append(ring, record, sizeof(record), NULL);
+        if(err){
+            printf("append %d err=%d\n", i, err);
+            bad++;
+            break;
+        }
+    }
+
+    jekv_ring_close(ring);
+
+    bad += check_values(handle);
+    bad += check_records(handle);
+
+    /*the merged sectors and the ring are loaded again*/
+    jekv_close(handle);
+    jekv_deinit(JEKV_DEF_PARTITION);
+
+    err = jekv_init(JEKV_DEF_PARTITION);
+    err |= jekv_open(JEKV_DEF_PARTITION, "ring", JEKV_OP_READ_WRITE, &handle);
+    if(err){
+        printf("reload err=%d\n", err);
+        return 1;
+    }
+
+    bad += check_values(handle);
+    bad += check_records(handle);
+
+    jekv_close(handle);
+    jekv_deinit(JEKV_DEF_PARTITION);
+
+    printf("bad=%d\n", bad);
+
+    return bad ? 1 : 0;
+}
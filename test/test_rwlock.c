@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "jekv_base.h"
+#include "jekv_easy.h"
+#include "jekv_porting.h"
+
+/*
+    the writer must go on while the readers keep the partition busy
+*/
+
+#define READER_NUM 5
+#define SET_NUM    3000
+#define KEY_NUM    50
+#define TIMEOUT_MS 60000
+
+static int g_stop = 0;
+static int g_bad  = 0;
+static uint32_t g_gets = 0;
+
+static void* reader(void* arg)
+{
+    jekv_handle_t handle;
+    uint32_t value;
+    char key[16];
+    int n = 0;
+    int err;
+
+    if(jekv_open(JEKV_DEF_PARTITION, "rw", JEKV_OP_READ_ONLY, &handle)){
+        __atomic_add_fetch(&g_bad, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    while(!__atomic_load_n(&g_stop, __ATOMIC_RELAXED)){
+        snprintf(key, sizeof(key), "k%d", n++ % KEY_NUM);
+        err = jekv_get_u32(handle, key, &value);
+        if(!(err == JEKV_ERR_OK || err == JEKV_ERR_NOT_FOUND)){
+            printf("get %s err=%d\n", key, err);
+            __atomic_add_fetch(&g_bad, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_add_fetch(&g_gets, 1, __ATOMIC_RELAXED);
+    }
+
+    jekv_close(handle);
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t threads[READER_NUM];
+    jekv_handle_t handle;
+    uint32_t start;
+    uint32_t used = 0;
+    char key[16];
+    int sets = 0;
+    int err;
+    int i;
+
+    remove("./jekv.db");
+
+    err = jekv_init(JEKV_DEF_PARTITION);
+    err |= jekv_open(JEKV_DEF_PARTITION, "rw", JEKV_OP_READ_WRITE, &handle);
+    if(err){
+        printf("init err=%d\n", err);
+        return 1;
+    }
+
+    for(i = 0; i < READER_NUM; i++){
+        pthread_create(&threads[i], NULL, reader, NULL);
+    }
+
+    start = jekv_port_get_time_ms();
+
+    while(sets < SET_NUM){
+        snprintf(key, sizeof(key), "k%d", sets % KEY_NUM);
+        err = jekv_set_u32(handle, key, sets);
+        if(err){
+            printf("set %s err=%d\n", key, err);
+            g_bad++;
+            break;
+        }
+        sets++;
+
+        used = jekv_port_get_time_ms() - start;
+        if(used > TIMEOUT_MS){
+            break;
+        }
+    }
+
+    __atomic_store_n(&g_stop, 1, __ATOMIC_RELAXED);
+
+    for(i = 0; i < READER_NUM; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    jekv_close(handle);
+    jekv_deinit(JEKV_DEF_PARTITION);
+
+    printf("sets=%d gets=%u used=%ums bad=%d\n", sets, g_gets, used, g_bad);
+
+    return (sets == SET_NUM && !g_bad) ? 0 : 1;
+}